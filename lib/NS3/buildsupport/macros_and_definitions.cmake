@@ -163,6 +163,7 @@ macro(process_options)
     check_include("dirent.h"   "HAVE_DIRENT_H"   )
     check_include("stdlib.h"   "HAVE_STDLIB_H"   )
     check_include("signal.h"   "HAVE_SIGNAL_H"   )
+    check_include("sys/wait.h" "HAVE_SYS_WAIT_H" )
     check_function("getenv"    "HAVE_GETENV"     )
 
     #Enable NS3 logging if requested
@@ -26,7 +26,6 @@
  *          Pavel Boyko <boyko@iitp.ru>
  */
 #include "aodv-id-cache.h"
-#include <algorithm>
 
 namespace ns3 {
 namespace aodv {
@@ -34,26 +33,23 @@ bool
 IdCache::IsDuplicate (Ipv4Address addr, uint32_t id)
 {
   Purge ();
-  for (std::vector<UniqueId>::const_iterator i = m_idCache.begin ();
-       i != m_idCache.end (); ++i)
+  UniqueId uniqueId = std::make_pair (addr, id);
+  if (!m_idCache.insert (uniqueId).second)
     {
-      if (i->m_context == addr && i->m_id == id)
-        {
-          return true;
-        }
+      return true;
     }
-  struct UniqueId uniqueId =
-  {
-    addr, id, m_lifetime + Simulator::Now ()
-  };
-  m_idCache.push_back (uniqueId);
+  m_expiry.insert (std::make_pair (m_lifetime + Simulator::Now (), uniqueId));
   return false;
 }
 void
 IdCache::Purge ()
 {
-  m_idCache.erase (remove_if (m_idCache.begin (), m_idCache.end (),
-                              IsExpired ()), m_idCache.end ());
+  // An ID is never refreshed, so each one has exactly one expiration time
+  while (!m_expiry.empty () && m_expiry.begin ()->first < Simulator::Now ())
+    {
+      m_idCache.erase (m_expiry.begin ()->second);
+      m_expiry.erase (m_expiry.begin ());
+    }
 }
 
 uint32_t
@@ -31,7 +31,8 @@
 
 #include "ns3/ipv4-address.h"
 #include "ns3/simulator.h"
-#include <vector>
+#include <map>
+#include <set>
 
 namespace ns3 {
 namespace aodv {
@@ -80,34 +81,12 @@ public:
     return m_lifetime;
   }
 private:
-  /// Unique packet ID
-  struct UniqueId
-  {
-    /// ID is supposed to be unique in single address context (e.g. sender address)
-    Ipv4Address m_context;
-    /// The id
-    uint32_t m_id;
-    /// When record will expire
-    Time m_expire;
-  };
-  /**
-   * \brief IsExpired structure
-   */
-  struct IsExpired
-  {
-    /**
-     * \brief Check if the entry is expired
-     *
-     * \param u UniqueId entry
-     * \return true if expired, false otherwise
-     */
-    bool operator() (const struct UniqueId & u) const
-    {
-      return (u.m_expire < Simulator::Now ());
-    }
-  };
+  /// Unique packet ID: the ID is supposed to be unique in single address context (e.g. sender address)
+  typedef std::pair<Ipv4Address, uint32_t> UniqueId;
   /// Already seen IDs
-  std::vector<UniqueId> m_idCache;
+  std::set<UniqueId> m_idCache;
+  /// Already seen IDs, sorted by the time they expire
+  std::multimap<Time, UniqueId> m_expiry;
   /// Default lifetime for ID records
   Time m_lifetime;
 };
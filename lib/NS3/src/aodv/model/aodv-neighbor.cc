@@ -37,7 +37,8 @@ NS_LOG_COMPONENT_DEFINE ("AodvNeighbors");
 
 namespace aodv {
 Neighbors::Neighbors (Time delay)
-  : m_ntimer (Timer::CANCEL_ON_DESTROY)
+  : m_ntimer (Timer::CANCEL_ON_DESTROY),
+    m_nextExpireTime (Time::Max ())
 {
   m_ntimer.SetDelay (delay);
   m_ntimer.SetFunction (&Neighbors::Purge, this);
@@ -94,6 +95,7 @@ Neighbors::Update (Ipv4Address addr, Time expire)
   NS_LOG_LOGIC ("Open link to " << addr);
   Neighbor neighbor (addr, LookupMacAddress (addr), expire + Simulator::Now ());
   m_nb.push_back (neighbor);
+  m_nextExpireTime = std::min (m_nextExpireTime, neighbor.m_expireTime);
   Purge ();
 }
 
@@ -122,6 +124,15 @@ Neighbors::Purge ()
       return;
     }
 
+  // Expire times only grow, and ProcessTxError resets the bound when it closes
+  // a link, so there is nothing to remove until the earliest of them passes
+  if (m_nextExpireTime >= Simulator::Now ())
+    {
+      m_ntimer.Cancel ();
+      m_ntimer.Schedule ();
+      return;
+    }
+
   CloseNeighbor pred;
   if (!m_handleLinkFailure.IsNull ())
     {
@@ -135,6 +146,11 @@ Neighbors::Purge ()
         }
     }
   m_nb.erase (std::remove_if (m_nb.begin (), m_nb.end (), pred), m_nb.end ());
+  m_nextExpireTime = Time::Max ();
+  for (std::vector<Neighbor>::const_iterator j = m_nb.begin (); j != m_nb.end (); ++j)
+    {
+      m_nextExpireTime = std::min (m_nextExpireTime, j->m_expireTime);
+    }
   m_ntimer.Cancel ();
   m_ntimer.Schedule ();
 }
@@ -185,6 +201,8 @@ Neighbors::ProcessTxError (WifiMacHeader const & hdr)
       if (i->m_hardwareAddress == addr)
         {
           i->close = true;
+          // Have the next Purge scan the entries
+          m_nextExpireTime = Time::Min ();
         }
     }
   Purge ();
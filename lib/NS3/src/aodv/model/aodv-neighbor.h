@@ -105,6 +105,7 @@ public:
   void Clear ()
   {
     m_nb.clear ();
+    m_nextExpireTime = Time::Max ();
   }
 
   /**
@@ -152,6 +153,8 @@ private:
   Timer m_ntimer;
   /// vector of entries
   std::vector<Neighbor> m_nb;
+  /// No entry expires before this time, so Purge has nothing to remove until then
+  Time m_nextExpireTime;
   /// list of ARP cached to be used for layer 2 notifications processing
   std::vector<Ptr<ArpCache> > m_arp;
 
@@ -65,6 +65,7 @@ RequestQueue::Enqueue (QueueEntry & entry)
       m_queue.erase (m_queue.begin ());
     }
   m_queue.push_back (entry);
+  m_nextExpireTime = std::min (m_nextExpireTime, entry.GetExpireTime () + Simulator::Now ());
   return true;
 }
 
@@ -136,6 +137,12 @@ struct IsExpired
 void
 RequestQueue::Purge ()
 {
+  // Entries are removed but never refreshed, so the bound stays valid until
+  // the earliest entry expires
+  if (m_nextExpireTime >= Simulator::Now ())
+    {
+      return;
+    }
   IsExpired pred;
   for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
        != m_queue.end (); ++i)
@@ -147,6 +154,12 @@ RequestQueue::Purge ()
     }
   m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (), pred),
                  m_queue.end ());
+  m_nextExpireTime = Time::Max ();
+  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
+       != m_queue.end (); ++i)
+    {
+      m_nextExpireTime = std::min (m_nextExpireTime, i->GetExpireTime () + Simulator::Now ());
+    }
 }
 
 void
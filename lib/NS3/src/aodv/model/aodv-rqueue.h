@@ -188,7 +188,8 @@ public:
    */
   RequestQueue (uint32_t maxLen, Time routeToQueueTimeout)
     : m_maxLen (maxLen),
-      m_queueTimeout (routeToQueueTimeout)
+      m_queueTimeout (routeToQueueTimeout),
+      m_nextExpireTime (Time::Max ())
   {
   }
   /**
@@ -271,6 +272,8 @@ private:
   uint32_t m_maxLen;
   /// The maximum period of time that a routing protocol is allowed to buffer a packet for, seconds.
   Time m_queueTimeout;
+  /// No entry expires before this time, so Purge has nothing to drop until then
+  Time m_nextExpireTime;
   /**
    * Determine if queue matches a destination address
    * \param en The queue entry
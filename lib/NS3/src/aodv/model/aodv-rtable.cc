@@ -220,8 +220,7 @@ RoutingTable::LookupRoute (Ipv4Address id, RoutingTableEntry & rt)
       NS_LOG_LOGIC ("Route to " << id << " not found; m_ipv4AddressEntry is empty");
       return false;
     }
-  std::map<Ipv4Address, RoutingTableEntry>::const_iterator i =
-    m_ipv4AddressEntry.find (id);
+  EntryTable::const_iterator i = m_ipv4AddressEntry.find (id);
   if (i == m_ipv4AddressEntry.end ())
     {
       NS_LOG_LOGIC ("Route to " << id << " not found");
@@ -250,8 +249,11 @@ RoutingTable::DeleteRoute (Ipv4Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
   Purge ();
-  if (m_ipv4AddressEntry.erase (dst) != 0)
+  EntryTable::iterator i = m_ipv4AddressEntry.find (dst);
+  if (i != m_ipv4AddressEntry.end ())
     {
+      DequeueExpiry (i->first, i->second);
+      m_ipv4AddressEntry.erase (i);
       NS_LOG_LOGIC ("Route deletion to " << dst << " successful");
       return true;
     }
@@ -268,8 +270,12 @@ RoutingTable::AddRoute (RoutingTableEntry & rt)
     {
       rt.SetRreqCnt (0);
     }
-  std::pair<std::map<Ipv4Address, RoutingTableEntry>::iterator, bool> result =
+  std::pair<EntryTable::iterator, bool> result =
     m_ipv4AddressEntry.insert (std::make_pair (rt.GetDestination (), rt));
+  if (result.second)
+    {
+      QueueExpiry (result.first->first, result.first->second);
+    }
   return result.second;
 }
 
@@ -277,14 +283,15 @@ bool
 RoutingTable::Update (RoutingTableEntry & rt)
 {
   NS_LOG_FUNCTION (this);
-  std::map<Ipv4Address, RoutingTableEntry>::iterator i =
-    m_ipv4AddressEntry.find (rt.GetDestination ());
+  EntryTable::iterator i = m_ipv4AddressEntry.find (rt.GetDestination ());
   if (i == m_ipv4AddressEntry.end ())
     {
       NS_LOG_LOGIC ("Route update to " << rt.GetDestination () << " fails; not found");
       return false;
     }
+  DequeueExpiry (i->first, i->second);
   i->second = rt;
+  QueueExpiry (i->first, i->second);
   if (i->second.GetFlag () != IN_SEARCH)
     {
       NS_LOG_LOGIC ("Route update to " << rt.GetDestination () << " set RreqCnt to 0");
@@ -297,8 +304,7 @@ bool
 RoutingTable::SetEntryState (Ipv4Address id, RouteFlags state)
 {
   NS_LOG_FUNCTION (this);
-  std::map<Ipv4Address, RoutingTableEntry>::iterator i =
-    m_ipv4AddressEntry.find (id);
+  EntryTable::iterator i = m_ipv4AddressEntry.find (id);
   if (i == m_ipv4AddressEntry.end ())
     {
       NS_LOG_LOGIC ("Route set entry state to " << id << " fails; not found");
@@ -316,8 +322,8 @@ RoutingTable::GetListOfDestinationWithNextHop (Ipv4Address nextHop, std::map<Ipv
   NS_LOG_FUNCTION (this);
   Purge ();
   unreachable.clear ();
-  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i =
-         m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+  for (EntryTable::const_iterator i = m_ipv4AddressEntry.begin ();
+       i != m_ipv4AddressEntry.end (); ++i)
     {
       if (i->second.GetNextHop () == nextHop)
         {
@@ -332,17 +338,16 @@ RoutingTable::InvalidateRoutesWithDst (const std::map<Ipv4Address, uint32_t> & u
 {
   NS_LOG_FUNCTION (this);
   Purge ();
-  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i =
-         m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+  for (std::map<Ipv4Address, uint32_t>::const_iterator j =
+         unreachable.begin (); j != unreachable.end (); ++j)
     {
-      for (std::map<Ipv4Address, uint32_t>::const_iterator j =
-             unreachable.begin (); j != unreachable.end (); ++j)
+      EntryTable::iterator i = m_ipv4AddressEntry.find (j->first);
+      if ((i != m_ipv4AddressEntry.end ()) && (i->second.GetFlag () == VALID))
         {
-          if ((i->first == j->first) && (i->second.GetFlag () == VALID))
-            {
-              NS_LOG_LOGIC ("Invalidate route with destination address " << i->first);
-              i->second.Invalidate (m_badLinkLifetime);
-            }
+          NS_LOG_LOGIC ("Invalidate route with destination address " << i->first);
+          DequeueExpiry (i->first, i->second);
+          i->second.Invalidate (m_badLinkLifetime);
+          QueueExpiry (i->first, i->second);
         }
     }
 }
@@ -355,14 +360,13 @@ RoutingTable::DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface)
     {
       return;
     }
-  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i =
-         m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); )
+  for (EntryTable::iterator i = m_ipv4AddressEntry.begin ();
+       i != m_ipv4AddressEntry.end (); )
     {
       if (i->second.GetInterface () == iface)
         {
-          std::map<Ipv4Address, RoutingTableEntry>::iterator tmp = i;
-          ++i;
-          m_ipv4AddressEntry.erase (tmp);
+          DequeueExpiry (i->first, i->second);
+          i = m_ipv4AddressEntry.erase (i);
         }
       else
         {
@@ -375,34 +379,27 @@ void
 RoutingTable::Purge ()
 {
   NS_LOG_FUNCTION (this);
-  if (m_ipv4AddressEntry.empty ())
+  Time now = Simulator::Now ();
+  ExpiryQueue::iterator i = m_expiryQueue.begin ();
+  while (i != m_expiryQueue.end () && i->first < now)
     {
-      return;
-    }
-  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i =
-         m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); )
-    {
-      if (i->second.GetLifeTime () < Seconds (0))
+      EntryTable::iterator j = m_ipv4AddressEntry.find (i->second);
+      NS_ASSERT (j != m_ipv4AddressEntry.end ());
+      if (j->second.GetFlag () == INVALID)
         {
-          if (i->second.GetFlag () == INVALID)
-            {
-              std::map<Ipv4Address, RoutingTableEntry>::iterator tmp = i;
-              ++i;
-              m_ipv4AddressEntry.erase (tmp);
-            }
-          else if (i->second.GetFlag () == VALID)
-            {
-              NS_LOG_LOGIC ("Invalidate route with destination address " << i->first);
-              i->second.Invalidate (m_badLinkLifetime);
-              ++i;
-            }
-          else
-            {
-              ++i;
-            }
+          m_expiryQueue.erase (i++);
+          m_ipv4AddressEntry.erase (j);
+        }
+      else if (j->second.GetFlag () == VALID)
+        {
+          NS_LOG_LOGIC ("Invalidate route with destination address " << j->first);
+          m_expiryQueue.erase (i++);
+          j->second.Invalidate (m_badLinkLifetime);
+          QueueExpiry (j->first, j->second);
         }
       else
         {
+          // Routes in search stay until their state changes
           ++i;
         }
     }
@@ -449,8 +446,7 @@ bool
 RoutingTable::MarkLinkAsUnidirectional (Ipv4Address neighbor, Time blacklistTimeout)
 {
   NS_LOG_FUNCTION (this << neighbor << blacklistTimeout.GetSeconds ());
-  std::map<Ipv4Address, RoutingTableEntry>::iterator i =
-    m_ipv4AddressEntry.find (neighbor);
+  EntryTable::iterator i = m_ipv4AddressEntry.find (neighbor);
   if (i == m_ipv4AddressEntry.end ())
     {
       NS_LOG_LOGIC ("Mark link unidirectional to  " << neighbor << " fails; not found");
@@ -466,7 +462,8 @@ RoutingTable::MarkLinkAsUnidirectional (Ipv4Address neighbor, Time blacklistTime
 void
 RoutingTable::Print (Ptr<OutputStreamWrapper> stream) const
 {
-  std::map<Ipv4Address, RoutingTableEntry> table = m_ipv4AddressEntry;
+  std::map<Ipv4Address, RoutingTableEntry> table (m_ipv4AddressEntry.begin (),
+                                                 m_ipv4AddressEntry.end ());
   Purge (table);
   *stream->GetStream () << "\nAODV Routing table\n"
                         << "Destination\tGateway\t\tInterface\tFlag\tExpire\t\tHops\n";
@@ -478,5 +475,27 @@ RoutingTable::Print (Ptr<OutputStreamWrapper> stream) const
   *stream->GetStream () << "\n";
 }
 
+void
+RoutingTable::QueueExpiry (Ipv4Address dst, RoutingTableEntry const & rt)
+{
+  m_expiryQueue.insert (std::make_pair (rt.GetLifeTime () + Simulator::Now (), dst));
+}
+
+void
+RoutingTable::DequeueExpiry (Ipv4Address dst, RoutingTableEntry const & rt)
+{
+  std::pair<ExpiryQueue::iterator, ExpiryQueue::iterator> range =
+    m_expiryQueue.equal_range (rt.GetLifeTime () + Simulator::Now ());
+  for (ExpiryQueue::iterator i = range.first; i != range.second; ++i)
+    {
+      if (i->second == dst)
+        {
+          m_expiryQueue.erase (i);
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Route to " << dst << " not queued");
+}
+
 }
 }
@@ -31,6 +31,7 @@
 #include <stdint.h>
 #include <cassert>
 #include <map>
+#include <unordered_map>
 #include <sys/types.h>
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-route.h"
@@ -384,6 +385,9 @@ private:
 /**
  * \ingroup aodv
  * \brief The Routing table used by AODV protocol
+ *
+ * The entries are hashed by destination address, and queued by the time
+ * their lifetime ends, so that Purge only visits the expired entries.
  */
 class RoutingTable
 {
@@ -468,6 +472,7 @@ public:
   void Clear ()
   {
     m_ipv4AddressEntry.clear ();
+    m_expiryQueue.clear ();
   }
   /// Delete all outdated entries and invalidate valid entry if Lifetime is expired
   void Purge ();
@@ -484,8 +489,14 @@ public:
   void Print (Ptr<OutputStreamWrapper> stream) const;
 
 private:
+  /// Container for the routing table entries, by destination address
+  typedef std::unordered_map<Ipv4Address, RoutingTableEntry, Ipv4AddressHash> EntryTable;
+  /// Container for the destination addresses, by the time the lifetime of their entry ends
+  typedef std::multimap<Time, Ipv4Address> ExpiryQueue;
   /// The routing table
-  std::map<Ipv4Address, RoutingTableEntry> m_ipv4AddressEntry;
+  EntryTable m_ipv4AddressEntry;
+  /// The end of the lifetime of every entry in the routing table
+  ExpiryQueue m_expiryQueue;
   /// Deletion time for invalid routes
   Time m_badLinkLifetime;
   /**
@@ -493,6 +504,18 @@ private:
    * \param table the routing table entry to purge
    */
   void Purge (std::map<Ipv4Address, RoutingTableEntry> &table) const;
+  /**
+   * Queue the end of the lifetime of a routing table entry
+   * \param dst the destination address of the entry
+   * \param rt the routing table entry
+   */
+  void QueueExpiry (Ipv4Address dst, RoutingTableEntry const & rt);
+  /**
+   * Remove the end of the lifetime of a routing table entry from the queue
+   * \param dst the destination address of the entry
+   * \param rt the routing table entry, with the lifetime it was queued with
+   */
+  void DequeueExpiry (Ipv4Address dst, RoutingTableEntry const & rt);
 };
 
 }  // namespace aodv
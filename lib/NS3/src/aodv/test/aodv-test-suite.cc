@@ -641,6 +641,92 @@ struct AodvRtableTest : public TestCase
   }
 };
 
+/**
+ * \ingroup aodv-test
+ * \ingroup tests
+ *
+ * \brief Unit test for the expiration of AODV routing table entries
+ */
+struct AodvRtablePurgeTest : public TestCase
+{
+  AodvRtablePurgeTest () : TestCase ("Rtable purge"),
+                           rtable (Seconds (3))
+  {
+  }
+  virtual void DoRun ();
+  /**
+   * Check the state of a route
+   * \param dst the destination of the route
+   * \param found whether the route is expected in the routing table
+   * \param flag the expected state of the route
+   */
+  void CheckRoute (Ipv4Address dst, bool found, RouteFlags flag);
+  /// Mark the route in search as valid
+  void StopSearch ();
+
+  /// Routing table
+  RoutingTable rtable;
+};
+
+void
+AodvRtablePurgeTest::DoRun ()
+{
+  Ptr<NetDevice> dev;
+  Ipv4InterfaceAddress iface;
+  RoutingTableEntry rt1 (dev, Ipv4Address ("1.1.1.1"), true, 1, iface, 1, Ipv4Address ("1.1.1.1"), Seconds (5));
+  RoutingTableEntry rt2 (dev, Ipv4Address ("2.2.2.2"), true, 1, iface, 1, Ipv4Address ("1.1.1.1"), Seconds (10));
+  RoutingTableEntry rt3 (dev, Ipv4Address ("3.3.3.3"), true, 1, iface, 1, Ipv4Address ("1.1.1.1"), Seconds (1));
+  RoutingTableEntry rt4 (dev, Ipv4Address ("4.4.4.4"), true, 1, iface, 1, Ipv4Address ("1.1.1.1"), Seconds (1));
+  rt4.SetFlag (IN_SEARCH);
+  rtable.AddRoute (rt1);
+  rtable.AddRoute (rt2);
+  rtable.AddRoute (rt3);
+  rtable.AddRoute (rt4);
+  // Shorten the lifetime of the second route and extend the one of the third
+  rt2.SetLifeTime (Seconds (2));
+  NS_TEST_EXPECT_MSG_EQ (rtable.Update (rt2), true, "Route exists");
+  rt3.SetLifeTime (Seconds (8));
+  NS_TEST_EXPECT_MSG_EQ (rtable.Update (rt3), true, "Route exists");
+
+  Simulator::Schedule (Seconds (1.5), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("1.1.1.1"), true, VALID);
+  Simulator::Schedule (Seconds (1.5), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("2.2.2.2"), true, VALID);
+  Simulator::Schedule (Seconds (1.5), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("3.3.3.3"), true, VALID);
+  Simulator::Schedule (Seconds (1.5), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("4.4.4.4"), true, IN_SEARCH);
+  Simulator::Schedule (Seconds (1.5), &AodvRtablePurgeTest::StopSearch, this);
+  // Expired valid routes are invalidated for the bad link lifetime
+  Simulator::Schedule (Seconds (2.5), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("2.2.2.2"), true, INVALID);
+  Simulator::Schedule (Seconds (2.5), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("3.3.3.3"), true, VALID);
+  Simulator::Schedule (Seconds (2.5), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("4.4.4.4"), true, INVALID);
+  // Expired invalid routes are deleted
+  Simulator::Schedule (Seconds (5.75), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("1.1.1.1"), true, INVALID);
+  Simulator::Schedule (Seconds (5.75), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("2.2.2.2"), false, INVALID);
+  Simulator::Schedule (Seconds (5.75), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("3.3.3.3"), true, VALID);
+  Simulator::Schedule (Seconds (5.75), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("4.4.4.4"), false, INVALID);
+  Simulator::Schedule (Seconds (8.5), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("1.1.1.1"), true, INVALID);
+  Simulator::Schedule (Seconds (8.5), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("3.3.3.3"), true, INVALID);
+  Simulator::Schedule (Seconds (9), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("1.1.1.1"), false, INVALID);
+  Simulator::Schedule (Seconds (12), &AodvRtablePurgeTest::CheckRoute, this, Ipv4Address ("3.3.3.3"), false, INVALID);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+AodvRtablePurgeTest::CheckRoute (Ipv4Address dst, bool found, RouteFlags flag)
+{
+  RoutingTableEntry rt;
+  NS_TEST_EXPECT_MSG_EQ (rtable.LookupRoute (dst, rt), found, "Route to " << dst << " at " << Simulator::Now ().GetSeconds ());
+  if (found)
+    {
+      NS_TEST_EXPECT_MSG_EQ (rt.GetFlag (), flag, "Route to " << dst << " at " << Simulator::Now ().GetSeconds ());
+    }
+}
+
+void
+AodvRtablePurgeTest::StopSearch ()
+{
+  NS_TEST_EXPECT_MSG_EQ (rtable.SetEntryState (Ipv4Address ("4.4.4.4"), VALID), true, "Route exists");
+}
+
 /**
  * \ingroup aodv-test
  * \ingroup tests
@@ -662,6 +748,7 @@ public:
     AddTestCase (new AodvRqueueTest, TestCase::QUICK);
     AddTestCase (new AodvRtableEntryTest, TestCase::QUICK);
     AddTestCase (new AodvRtableTest, TestCase::QUICK);
+    AddTestCase (new AodvRtablePurgeTest, TestCase::QUICK);
   }
 } g_aodvTestSuite; ///< the test suite
 
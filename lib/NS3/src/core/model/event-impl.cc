@@ -21,6 +21,8 @@
 #include "event-impl.h"
 #include "log.h"
 
+#include <new>
+
 /**
  * \file
  * \ingroup events
@@ -31,6 +33,147 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+/**
+ * \ingroup events
+ * \defgroup eventpool Event allocation pool.
+ *
+ * Events are rounded up to a multiple of EVENT_POOL_GRANULARITY bytes;
+ * each size class has its own per-thread free list.  Events larger
+ * than the largest size class use the global allocator.
+ */
+/**
+ * \ingroup eventpool
+ * @{
+ */
+/** Size class granularity, in bytes. */
+static const std::size_t EVENT_POOL_GRANULARITY = 16;
+/** Number of size classes. */
+static const std::size_t EVENT_POOL_CLASSES = 16;
+/** Maximum number of free blocks held in each size class. */
+static const uint32_t EVENT_POOL_MAX_FREE = 4096;
+
+/** A free block, linked in the free list of its size class. */
+struct EventFreeBlock
+{
+  EventFreeBlock *next;  /**< Next free block. */
+};
+
+/**
+ * The per-thread pool state.
+ *
+ * This is trivially destructible, so it remains usable while the
+ * thread-local objects with destructors are destroyed.
+ */
+struct EventPool
+{
+  EventFreeBlock *free[EVENT_POOL_CLASSES];  /**< The free lists. */
+  uint32_t nFree[EVENT_POOL_CLASSES];        /**< Free list lengths. */
+  uint64_t allocations;                      /**< Number of allocations. */
+  uint64_t hits;                             /**< Allocations from a free list. */
+  bool releaserActive;                       /**< Has the releaser been created. */
+  bool released;                             /**< Has the releaser run. */
+};
+
+/** The pool of the current thread. */
+static thread_local EventPool g_eventPool;
+
+/** Release the free blocks of the current thread when it exits. */
+struct EventPoolReleaser
+{
+  /** Destructor. */
+  ~EventPoolReleaser ()
+  {
+    EventPool &pool = g_eventPool;
+    for (std::size_t c = 0; c < EVENT_POOL_CLASSES; ++c)
+      {
+        while (pool.free[c] != 0)
+          {
+            EventFreeBlock *block = pool.free[c];
+            pool.free[c] = block->next;
+            ::operator delete (block);
+          }
+        pool.nFree[c] = 0;
+      }
+    // Events destroyed after this point bypass the pool.
+    pool.released = true;
+  }
+  bool active;  /**< Written on first use, to construct the releaser. */
+};
+
+/** The releaser of the current thread. */
+static thread_local EventPoolReleaser g_eventPoolReleaser;
+/**@}*/
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  EventPool &pool = g_eventPool;
+  pool.allocations++;
+  std::size_t c = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (c >= EVENT_POOL_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  EventFreeBlock *block = pool.free[c];
+  if (block != 0)
+    {
+      pool.free[c] = block->next;
+      pool.nFree[c]--;
+      pool.hits++;
+      return block;
+    }
+  return ::operator new ((c + 1) * EVENT_POOL_GRANULARITY);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  EventPool &pool = g_eventPool;
+  std::size_t c = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (c >= EVENT_POOL_CLASSES || pool.released || pool.nFree[c] >= EVENT_POOL_MAX_FREE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  if (!pool.releaserActive)
+    {
+      pool.releaserActive = true;
+      g_eventPoolReleaser.active = true;
+    }
+  EventFreeBlock *block = static_cast<EventFreeBlock *> (p);
+  block->next = pool.free[c];
+  pool.free[c] = block;
+  pool.nFree[c]++;
+}
+
+EventImpl::PoolStats
+EventImpl::GetPoolStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  const EventPool &pool = g_eventPool;
+  PoolStats stats;
+  stats.allocations = pool.allocations;
+  stats.hits = pool.hits;
+  stats.cached = 0;
+  for (std::size_t c = 0; c < EVENT_POOL_CLASSES; ++c)
+    {
+      stats.cached += pool.nFree[c];
+    }
+  return stats;
+}
+
+void
+EventImpl::ResetPoolStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_eventPool.allocations = 0;
+  g_eventPool.hits = 0;
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -40,6 +41,13 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated from per-thread free lists, one per size class,
+ * so that once a simulation reaches its steady state scheduling an
+ * event does not call the global allocator: the arguments bound by
+ * MakeEvent() are members of the event object, and share its block.
+ * The blocks released by a thread are kept by that thread, whichever
+ * thread allocated them.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -66,6 +74,34 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate an event from the free list of its size class.
+   * \param [in] size The size of the event object.
+   * \returns The event storage.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release an event to the free list of its size class.
+   * \param [in] p The event storage.
+   * \param [in] size The size of the event object.
+   */
+  static void operator delete (void *p, std::size_t size);
+
+  /** Event allocation statistics of a thread. */
+  struct PoolStats
+  {
+    uint64_t allocations;  /**< Number of events allocated. */
+    uint64_t hits;         /**< Allocations served by the free lists. */
+    uint64_t cached;       /**< Number of free blocks held. */
+  };
+  /**
+   * Get the event allocation statistics of the calling thread.
+   * \returns The statistics.
+   */
+  static PoolStats GetPoolStats (void);
+  /** Reset the allocation counters of the calling thread. */
+  static void ResetPoolStats (void);
+
 protected:
   /**
    * Implementation for Invoke().
@@ -0,0 +1,364 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+/**
+ * \ingroup scheduler
+ * Buckets with more events than this are spread over a new rung
+ * rather than sorted.
+ */
+static const uint32_t LADDER_THRESHOLD = 50;
+
+/**
+ * \ingroup scheduler
+ * Maximum number of rungs.
+ */
+static const uint32_t LADDER_MAX_RUNGS = 8;
+
+/**
+ * \ingroup scheduler
+ * Compare (greater than) two events, to keep the Bottom sorted by
+ * decreasing key.
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \c a > \c b
+ */
+static bool
+EventGreater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key > b.key;
+}
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (~0),
+    m_topMax (0),
+    m_nRungs (0),
+    m_count (0)
+{
+  NS_LOG_FUNCTION (this);
+  // Rungs are referenced while a new one is pushed: never reallocate.
+  m_rungs.resize (LADDER_MAX_RUNGS);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::CurrentStart (const Rung &rung) const
+{
+  return rung.start + rung.current * rung.width;
+}
+
+uint32_t
+LadderScheduler::FindRung (uint64_t ts) const
+{
+  uint32_t i = 0;
+  while (i < m_nRungs && ts < CurrentStart (m_rungs[i]))
+    {
+      i++;
+    }
+  return i;
+}
+
+LadderScheduler::Rung &
+LadderScheduler::PushRung (uint64_t start, uint64_t width, uint32_t nBuckets)
+{
+  NS_LOG_FUNCTION (this << start << width << nBuckets);
+  NS_ASSERT (m_nRungs < LADDER_MAX_RUNGS);
+  Rung &rung = m_rungs[m_nRungs];
+  m_nRungs++;
+  // A rung is only popped once all its buckets are empty, so the
+  // buckets kept from a previous use can be reused as is.
+  if (rung.buckets.size () < nBuckets)
+    {
+      rung.buckets.resize (nBuckets);
+    }
+  rung.nBuckets = nBuckets;
+  rung.start = start;
+  rung.width = width;
+  rung.current = 0;
+  rung.count = 0;
+  return rung;
+}
+
+void
+LadderScheduler::Spread (Bucket &events, uint64_t start, uint64_t span)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << span);
+  uint64_t n = events.size ();
+  uint64_t width = (span + n - 1) / n;
+  uint32_t nBuckets = (span + width - 1) / width;
+  Rung &rung = PushRung (start, width, nBuckets);
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      rung.buckets[(i->key.m_ts - start) / width].push_back (*i);
+    }
+  rung.count = n;
+  events.clear ();
+}
+
+void
+LadderScheduler::SortToBottom (Bucket &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (m_bottom.empty ());
+  m_bottom.assign (events.begin (), events.end ());
+  std::sort (m_bottom.begin (), m_bottom.end (), &EventGreater);
+  events.clear ();
+}
+
+void
+LadderScheduler::RefillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty () && m_count > 0)
+    {
+      if (m_nRungs == 0)
+        {
+          // Start a new epoch from the Top.
+          NS_ASSERT (!m_top.empty ());
+          uint64_t min = m_topMin;
+          uint64_t max = m_topMax;
+          m_topMin = ~0;
+          m_topMax = 0;
+          if (min == max)
+            {
+              m_topStart = max + 1;
+              SortToBottom (m_top);
+            }
+          else
+            {
+              Spread (m_top, min, max - min + 1);
+              const Rung &rung = m_rungs[0];
+              m_topStart = rung.start + rung.nBuckets * rung.width;
+            }
+          continue;
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      NS_ASSERT (rung.current < rung.nBuckets);
+      Bucket &bucket = rung.buckets[rung.current];
+      uint64_t start = CurrentStart (rung);
+      rung.current++;
+      rung.count -= bucket.size ();
+
+      bool spread = bucket.size () > LADDER_THRESHOLD
+        && m_nRungs < LADDER_MAX_RUNGS
+        && rung.width > 1;
+      if (spread)
+        {
+          // Do not bother spreading events which cannot be separated.
+          spread = false;
+          uint64_t ts = bucket.front ().key.m_ts;
+          for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+            {
+              if (i->key.m_ts != ts)
+                {
+                  spread = true;
+                  break;
+                }
+            }
+        }
+      if (spread)
+        {
+          Spread (bucket, start, rung.width);
+        }
+      else
+        {
+          SortToBottom (bucket);
+        }
+    }
+}
+
+void
+LadderScheduler::RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev)
+{
+  for (Bucket::iterator i = bucket.begin (); i != bucket.end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == i->impl);
+          *i = bucket.back ();
+          bucket.pop_back ();
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  if (m_count == 0)
+    {
+      m_nRungs = 0;
+      m_topStart = ts + 1;
+      m_topMin = ~0;
+      m_topMax = 0;
+      m_bottom.push_back (ev);
+    }
+  else if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+    }
+  else
+    {
+      uint32_t i = FindRung (ts);
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          rung.buckets[(ts - rung.start) / rung.width].push_back (ev);
+          rung.count++;
+        }
+      else
+        {
+          Bucket::iterator pos = std::lower_bound (m_bottom.begin (), m_bottom.end (),
+                                                   ev, &EventGreater);
+          m_bottom.insert (pos, ev);
+          m_count++;
+          if (m_bottom.size () > LADDER_THRESHOLD
+              && m_nRungs < LADDER_MAX_RUNGS
+              && m_bottom.front ().key.m_ts != m_bottom.back ().key.m_ts)
+            {
+              // Keep the sorted insertions cheap: move the Bottom to a
+              // new rung and refill it with the first bucket only.
+              uint64_t start = m_bottom.back ().key.m_ts;
+              uint64_t end = m_nRungs > 0 ? CurrentStart (m_rungs[m_nRungs - 1]) : m_topStart;
+              Spread (m_bottom, start, end - start);
+              RefillBottom ();
+            }
+          return;
+        }
+    }
+  m_count++;
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_count == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_count--;
+  if (m_bottom.empty ())
+    {
+      RefillBottom ();
+    }
+  NS_LOG_LOGIC ("remove ts=" << ev.key.m_ts << ", uid=" << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      RemoveFromBucket (m_top, ev);
+      if (m_top.empty ())
+        {
+          m_topMin = ~0;
+          m_topMax = 0;
+        }
+    }
+  else
+    {
+      uint32_t i = FindRung (ts);
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          RemoveFromBucket (rung.buckets[(ts - rung.start) / rung.width], ev);
+          rung.count--;
+        }
+      else
+        {
+          Bucket::iterator pos = std::lower_bound (m_bottom.begin (), m_bottom.end (),
+                                                   ev, &EventGreater);
+          NS_ASSERT (pos != m_bottom.end () && pos->key.m_uid == ev.key.m_uid);
+          m_bottom.erase (pos);
+        }
+    }
+  m_count--;
+  if (m_bottom.empty ())
+    {
+      RefillBottom ();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler is an implementation of the Ladder Queue
+ * described in:
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation", W. T. Tang, R. S. M. Goh, I. L.-J. Thng,
+ * ACM TOMACS, 15(3), 2005.
+ *
+ * The events are kept in three tiers, each covering a contiguous,
+ * disjoint range of timestamps:
+ *  - the Top, an unsorted vector which holds all the events later than
+ *    the range covered by the ladder;
+ *  - the Ladder, a stack of rungs of unsorted buckets.  When the ladder
+ *    is empty, the Top is spread over a new rung whose bucket width is
+ *    derived from the timestamp spread of the Top.  A bucket with too
+ *    many events is spread over a new, finer rung instead of being
+ *    sorted, so the bucket widths adapt to the event distribution;
+ *  - the Bottom, a small sorted vector holding the earliest events.
+ *
+ * Insertion is a constant time append to the Top or to a bucket, except
+ * for the events earlier than the current ladder bucket, which are
+ * inserted in the Bottom; a Bottom which grows beyond a few tens of
+ * events is itself spread over a new rung.  Events are only sorted in
+ * buckets which hold at most a few tens of events unless all their
+ * events share the same timestamp (or the ladder is full), which makes
+ * both Insert and RemoveNext O(1) amortized.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Unsorted event container. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    /** The buckets. */
+    std::vector<Bucket> buckets;
+    /** Number of buckets in use. */
+    uint32_t nBuckets;
+    /** Timestamp of the start of the first bucket. */
+    uint64_t start;
+    /** Width of each bucket. */
+    uint64_t width;
+    /** Index of the first bucket which has not been dequeued. */
+    uint32_t current;
+    /** Number of events in the rung. */
+    uint32_t count;
+  };
+
+  /**
+   * Get the start of the first bucket which has not been dequeued.
+   * \param [in] rung The rung.
+   * \returns The start timestamp of the current bucket of \p rung.
+   */
+  inline uint64_t CurrentStart (const Rung &rung) const;
+  /**
+   * Find the rung which covers a timestamp.
+   * \param [in] ts The timestamp.
+   * \returns The rung index, or the number of rungs if \p ts
+   *          belongs to the Bottom.
+   */
+  uint32_t FindRung (uint64_t ts) const;
+  /**
+   * Push a new rung on the ladder.
+   * \param [in] start The start of the first bucket.
+   * \param [in] width The bucket width.
+   * \param [in] nBuckets The number of buckets.
+   * \returns The new rung.
+   */
+  Rung & PushRung (uint64_t start, uint64_t width, uint32_t nBuckets);
+  /**
+   * Spread events over a new rung covering <tt>[start, start+span)</tt>.
+   * \param [in,out] events The events to move; cleared on return.
+   * \param [in] start The start of the range.
+   * \param [in] span The length of the range.
+   */
+  void Spread (Bucket &events, uint64_t start, uint64_t span);
+  /**
+   * Sort events and move them to the (empty) Bottom.
+   * \param [in,out] events The events to move; cleared on return.
+   */
+  void SortToBottom (Bucket &events);
+  /** Refill the empty Bottom from the ladder or from the Top. */
+  void RefillBottom (void);
+  /**
+   * Remove an event from an unsorted container.
+   * \param [in,out] bucket The container.
+   * \param [in] ev The event to remove.
+   */
+  void RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev);
+
+  /** The Top tier. */
+  Bucket m_top;
+  /** The Top covers all the timestamps larger or equal to this one. */
+  uint64_t m_topStart;
+  /** Smallest timestamp in the Top. */
+  uint64_t m_topMin;
+  /** Largest timestamp in the Top. */
+  uint64_t m_topMax;
+  /** The rungs; only the first m_nRungs are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** The Bottom tier, sorted by decreasing key. */
+  Bucket m_bottom;
+  /** Total number of events. */
+  uint32_t m_count;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
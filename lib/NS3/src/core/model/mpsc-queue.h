@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::MpscQueue declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief A lock-free, multiple producer, single consumer FIFO queue.
+ *
+ * Any number of threads may call Push() concurrently; a single thread
+ * calls IsEmpty() and Pop().  The values pushed by each producer are
+ * popped in the order they were pushed.
+ *
+ * This is D. Vyukov's intrusive MPSC queue: Push() is a single atomic
+ * exchange, and never waits for the consumer or the other producers.
+ * The queue nodes are taken from a pool allocated by the constructor
+ * and returned to it by Pop(), so that Push() does not allocate memory
+ * until more than \c capacity values are waiting to be popped.
+ *
+ * A value pushed while another producer is between the two steps of
+ * its own Push() may not be visible to the consumer until that producer
+ * completes.
+ *
+ * \tparam T \explicit The type of the values, which must be default
+ *           constructible and copyable.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] capacity The number of preallocated nodes.
+   */
+  MpscQueue (uint32_t capacity = 1024);
+  /** Destructor.  Values still in the queue are discarded. */
+  ~MpscQueue ();
+
+  /**
+   * Push a value; may be called from any thread.
+   * \param [in] value The value.
+   */
+  void Push (const T &value);
+  /**
+   * Check if the queue has a value ready to be popped; consumer only.
+   *
+   * This is a single relaxed atomic load.
+   * \returns \c true if there is no value to pop.
+   */
+  bool IsEmpty (void) const;
+  /**
+   * Pop the oldest value; consumer only.
+   * \param [out] value The value popped.
+   * \returns \c true if a value was popped.
+   */
+  bool Pop (T &value);
+
+private:
+  /** A queue node. */
+  struct Node
+  {
+    /** Next node towards the head of the queue. */
+    std::atomic<Node *> next;
+    /** Next free node index plus one, or zero. */
+    std::atomic<uint32_t> nextFree;
+    /** Index of this node in the pool plus one, or zero if allocated. */
+    uint32_t index;
+    /** The value. */
+    T value;
+  };
+
+  /**
+   * Take a node from the pool, or allocate one if it is empty.
+   * \returns The node.
+   */
+  Node * AllocateNode (void);
+  /**
+   * Return a node to the pool, or delete it if it was allocated.
+   * \param [in] node The node.
+   */
+  void FreeNode (Node *node);
+  /**
+   * Append a node to the queue.
+   * \param [in] node The node.
+   */
+  void PushNode (Node *node);
+
+  /** Copy constructor, not implemented. */
+  MpscQueue (const MpscQueue &);
+  /**
+   * Assignment, not implemented.
+   * \returns The queue.
+   */
+  MpscQueue & operator = (const MpscQueue &);
+
+  /** The last node pushed. */
+  std::atomic<Node *> m_head;
+  /** The oldest node, owned by the consumer. */
+  Node *m_tail;
+  /** Placeholder node, which keeps the queue non empty. */
+  Node m_stub;
+  /** The preallocated nodes. */
+  std::vector<Node> m_pool;
+  /**
+   * Top of the free node stack: a node index plus one in the low 32
+   * bits, and a modification count in the high 32 bits to protect the
+   * concurrent pops against ABA.
+   */
+  std::atomic<uint64_t> m_free;
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MpscQueue<T>::MpscQueue (uint32_t capacity)
+  : m_pool (capacity)
+{
+  m_stub.next.store (0, std::memory_order_relaxed);
+  m_stub.index = 0;
+  m_head.store (&m_stub, std::memory_order_relaxed);
+  m_tail = &m_stub;
+  for (uint32_t i = 0; i < capacity; ++i)
+    {
+      m_pool[i].index = i + 1;
+      m_pool[i].nextFree.store (i + 1 < capacity ? i + 2 : 0, std::memory_order_relaxed);
+    }
+  m_free.store (capacity > 0 ? 1 : 0, std::memory_order_release);
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue ()
+{
+  T value;
+  while (Pop (value))
+    {
+    }
+}
+
+template <typename T>
+typename MpscQueue<T>::Node *
+MpscQueue<T>::AllocateNode (void)
+{
+  uint64_t top = m_free.load (std::memory_order_acquire);
+  while ((top & 0xffffffff) != 0)
+    {
+      Node *node = &m_pool[(top & 0xffffffff) - 1];
+      uint64_t next = ((top >> 32) + 1) << 32;
+      next |= node->nextFree.load (std::memory_order_relaxed);
+      if (m_free.compare_exchange_weak (top, next,
+                                        std::memory_order_acquire,
+                                        std::memory_order_acquire))
+        {
+          return node;
+        }
+    }
+  Node *node = new Node;
+  node->index = 0;
+  return node;
+}
+
+template <typename T>
+void
+MpscQueue<T>::FreeNode (Node *node)
+{
+  if (node->index == 0)
+    {
+      delete node;
+      return;
+    }
+  uint64_t top = m_free.load (std::memory_order_relaxed);
+  uint64_t next;
+  do
+    {
+      node->nextFree.store (top & 0xffffffff, std::memory_order_relaxed);
+      next = (((top >> 32) + 1) << 32) | node->index;
+    }
+  while (!m_free.compare_exchange_weak (top, next,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed));
+}
+
+template <typename T>
+void
+MpscQueue<T>::PushNode (Node *node)
+{
+  node->next.store (0, std::memory_order_relaxed);
+  Node *prev = m_head.exchange (node, std::memory_order_acq_rel);
+  // Between the exchange and this store the consumer cannot see the
+  // nodes pushed after prev.
+  prev->next.store (node, std::memory_order_release);
+}
+
+template <typename T>
+void
+MpscQueue<T>::Push (const T &value)
+{
+  Node *node = AllocateNode ();
+  node->value = value;
+  PushNode (node);
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty (void) const
+{
+  // m_tail holds the next value, unless it is the stub.
+  return m_tail == &m_stub && m_stub.next.load (std::memory_order_relaxed) == 0;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Pop (T &value)
+{
+  Node *tail = m_tail;
+  Node *next = tail->next.load (std::memory_order_acquire);
+  if (tail == &m_stub)
+    {
+      if (next == 0)
+        {
+          return false;
+        }
+      m_tail = next;
+      tail = next;
+      next = next->next.load (std::memory_order_acquire);
+    }
+  if (next == 0)
+    {
+      if (tail != m_head.load (std::memory_order_acquire))
+        {
+          // A producer has not completed its Push () yet.
+          return false;
+        }
+      // tail is the last node: push the stub behind it, so that tail
+      // can be removed.
+      PushNode (&m_stub);
+      next = tail->next.load (std::memory_order_acquire);
+      if (next == 0)
+        {
+          return false;
+        }
+    }
+  m_tail = next;
+  value = tail->value;
+  FreeNode (tail);
+  return true;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_QUEUE_H */
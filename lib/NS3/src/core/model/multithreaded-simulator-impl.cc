@@ -0,0 +1,990 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "simulator.h"
+#include "multithreaded-simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "config.h"
+#include "uinteger.h"
+
+#include "ptr.h"
+#include "assert.h"
+#include "abort.h"
+#include "log.h"
+
+#include <algorithm>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MultithreadedSimulatorImpl implementation.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+thread_local MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_threadPartition = 0;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("ThreadCount",
+                   "The number of threads (and event partitions) to use; "
+                   "0 uses one thread per hardware thread.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_threadCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("LookAhead",
+                   "The lookahead, i.e., the minimum delay of any event "
+                   "scheduled for another context; zero runs sequentially.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_userLookAhead),
+                   MakeTimeChecker (Seconds (0)))
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_windowGeneration (0),
+    m_pendingWorkers (0),
+    m_workersExit (false)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = false;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_uid = 4;
+  m_parallel = false;
+  m_lookAheadValid = false;
+  m_threadCount = 0;
+  m_lookAhead = 0;
+  m_windowEnd.m_ts = 0;
+  m_windowEnd.m_uid = 0;
+  m_windowEnd.m_context = 0;
+  // Until the first parallel Run, a single partition holds every event,
+  // exactly like the event list of DefaultSimulatorImpl.
+  m_partitions.push_back (CreatePartition ());
+  m_global = CreatePartition ();
+  m_main = SystemThread::Self ();
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      delete *i;
+    }
+  delete m_global;
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  ProcessEventsWithContext ();
+
+  std::vector<Partition *> partitions = m_partitions;
+  partitions.push_back (m_global);
+  for (std::vector<Partition *>::iterator i = partitions.begin (); i != partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      while (partition->events != 0 && !partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      partition->events = 0;
+    }
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::CreatePartition (void) const
+{
+  Partition *partition = new Partition ();
+  if (m_schedulerFactory.GetTypeId ().GetUid () != 0)
+    {
+      partition->events = m_schedulerFactory.Create<Scheduler> ();
+    }
+  partition->index = 0;
+  // before ::Run is entered, the currentUid will be zero
+  partition->currentUid = 0;
+  partition->currentTs = 0;
+  partition->currentContext = Simulator::NO_CONTEXT;
+  partition->unscheduledEvents = 0;
+  partition->stop = false;
+  partition->provisional = 0;
+  partition->windowProvisional = 0;
+  partition->heldUidsLimit = 1024;
+  return partition;
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_schedulerFactory = schedulerFactory;
+
+  std::vector<Partition *> partitions = m_partitions;
+  partitions.push_back (m_global);
+  for (std::vector<Partition *>::iterator i = partitions.begin (); i != partitions.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if ((*i)->events != 0)
+        {
+          while (!(*i)->events->IsEmpty ())
+            {
+              Scheduler::Event next = (*i)->events->RemoveNext ();
+              scheduler->Insert (next);
+            }
+        }
+      (*i)->events = scheduler;
+    }
+}
+
+// System ID for non-distributed simulation is always zero
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  if (!m_parallel)
+    {
+      return m_partitions[0];
+    }
+  if (context == Simulator::NO_CONTEXT)
+    {
+      return m_global;
+    }
+  return m_partitions[context % m_partitions.size ()];
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrentPartition (void) const
+{
+  Partition *partition = m_threadPartition;
+  if (partition != 0)
+    {
+      return partition;
+    }
+  // Outside of a window, the main thread runs the events without context.
+  return m_parallel ? m_global : m_partitions[0];
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint32_t context, uint64_t ts, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = m_uid;
+  m_uid++;
+  NS_ABORT_MSG_IF (m_parallel && m_uid >= PROVISIONAL_UID, "Too many events for the parallel uids");
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::InsertProvisional (uint32_t context, uint64_t ts, EventImpl *event)
+{
+  Partition *partition = m_threadPartition;
+  NS_ASSERT (!partition->executed.empty ());
+  // The provisional uids of the partitions are interleaved, so that they
+  // are unique, and come after all the final uids.
+  uint32_t n = m_partitions.size ();
+  CreatedEvent created;
+  created.provisional = PROVISIONAL_UID | static_cast<uint32_t> ((partition->provisional * n + partition->index) & ~PROVISIONAL_UID);
+  created.final = 0;
+  partition->provisional++;
+  partition->executed.back ().children++;
+  if (context == partition->currentContext && ts < m_windowEnd.m_ts)
+    {
+      Scheduler::Event ev;
+      ev.impl = event;
+      ev.key.m_ts = ts;
+      ev.key.m_context = context;
+      ev.key.m_uid = created.provisional;
+      partition->unscheduledEvents++;
+      partition->events->Insert (ev);
+      created.held = NOT_HELD;
+    }
+  else
+    {
+      EventWithContext ev;
+      ev.context = context;
+      ev.timestamp = ts;
+      ev.source = partition->currentContext;
+      ev.event = event;
+      created.held = partition->outbox.size ();
+      partition->outbox.push_back (ev);
+    }
+  partition->created.push_back (created);
+  return created.provisional;
+}
+
+MultithreadedSimulatorImpl::CreatedEvent *
+MultithreadedSimulatorImpl::FindCreated (Partition *partition, uint32_t uid) const
+{
+  uint32_t n = m_partitions.size ();
+  uint32_t first = static_cast<uint32_t> ((partition->windowProvisional * n + partition->index) & ~PROVISIONAL_UID);
+  uint32_t offset = ((uid & ~PROVISIONAL_UID) - first) & ~PROVISIONAL_UID;
+  if (offset % n != 0 || offset / n >= partition->created.size ())
+    {
+      return 0;
+    }
+  CreatedEvent *created = &partition->created[offset / n];
+  return created->provisional == uid ? created : 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetFinalUid (Partition *partition, uint32_t uid) const
+{
+  if (uid < PROVISIONAL_UID)
+    {
+      return uid;
+    }
+  CreatedEvent *created = FindCreated (partition, uid);
+  NS_ASSERT (created != 0);
+  return created->final;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->currentTs);
+  partition->unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  if (m_threadPartition != 0)
+    {
+      ExecutedEvent executed;
+      executed.ts = next.key.m_ts;
+      executed.uid = next.key.m_uid;
+      executed.children = 0;
+      partition->executed.push_back (executed);
+    }
+  partition->currentTs = next.key.m_ts;
+  partition->currentContext = next.key.m_context;
+  partition->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (Partition *partition)
+{
+  m_threadPartition = partition;
+  while (!partition->events->IsEmpty ()
+         && partition->events->PeekNext ().key < m_windowEnd)
+    {
+      ProcessOneEvent (partition);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return m_global->events->IsEmpty ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContext.IsEmpty ())
+    {
+      return;
+    }
+
+  uint64_t currentTs = GetCurrentPartition ()->currentTs;
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
+    {
+      Insert (GetPartition (event.context), event.context,
+              currentTs + event.timestamp, event.event);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOutboxes (void)
+{
+  // Merge the events run by the partitions by their final keys, which is
+  // the order a single thread would have run them in, and number the
+  // events they scheduled in that order.  An event scheduled and run
+  // during the window has its final uid by the time it comes first in
+  // its partition, since the event which scheduled it ran before.
+  uint32_t n = m_partitions.size ();
+  std::vector<uint32_t> executed (n, 0);
+  std::vector<uint32_t> created (n, 0);
+  std::vector<Scheduler::EventKey> keys (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Partition *partition = m_partitions[i];
+      if (!partition->executed.empty ())
+        {
+          keys[i].m_ts = partition->executed[0].ts;
+          keys[i].m_uid = GetFinalUid (partition, partition->executed[0].uid);
+        }
+    }
+  while (true)
+    {
+      Partition *next = 0;
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          if (executed[i] < m_partitions[i]->executed.size ()
+              && (next == 0 || keys[i] < keys[next->index]))
+            {
+              next = m_partitions[i];
+            }
+        }
+      if (next == 0)
+        {
+          break;
+        }
+      uint32_t i = next->index;
+      const ExecutedEvent &event = next->executed[executed[i]++];
+      for (uint32_t j = 0; j < event.children; ++j)
+        {
+          next->created[created[i]++].final = m_uid++;
+        }
+      NS_ABORT_MSG_IF (m_uid >= PROVISIONAL_UID, "Too many events for the parallel uids");
+      if (executed[i] < next->executed.size ())
+        {
+          keys[i].m_ts = next->executed[executed[i]].ts;
+          keys[i].m_uid = GetFinalUid (next, next->executed[executed[i]].uid);
+        }
+    }
+
+  std::vector<Partition *> targets = m_partitions;
+  targets.push_back (m_global);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      if (!partition->executed.empty ())
+        {
+          partition->currentUid = GetFinalUid (partition, partition->executed.back ().uid);
+        }
+      for (std::vector<CreatedEvent>::const_iterator j = partition->created.begin (); j != partition->created.end (); ++j)
+        {
+          if (j->held == NOT_HELD || partition->outbox[j->held].event == 0)
+            {
+              continue;
+            }
+          const EventWithContext &held = partition->outbox[j->held];
+          if (held.timestamp < m_windowEnd.m_ts)
+            {
+              NS_FATAL_ERROR ("Event scheduled by context " << held.source <<
+                              " for context " << held.context <<
+                              " at " << TimeStep (held.timestamp) <<
+                              " violates the lookahead " << TimeStep (m_lookAhead));
+            }
+          Partition *target = GetPartition (held.context);
+          Scheduler::Event ev;
+          ev.impl = held.event;
+          ev.key.m_ts = held.timestamp;
+          ev.key.m_context = held.context;
+          ev.key.m_uid = j->final;
+          target->unscheduledEvents++;
+          target->events->Insert (ev);
+          // The EventId of the event has its provisional uid.
+          HeldUid uid;
+          uid.ts = held.timestamp;
+          uid.final = j->final;
+          target->heldUids[j->provisional] = uid;
+        }
+      partition->executed.clear ();
+      partition->created.clear ();
+      partition->outbox.clear ();
+      partition->windowProvisional = partition->provisional;
+    }
+
+  // The events before the current time of their partition have run, or
+  // have been removed, and are expired whatever their uid.
+  for (std::vector<Partition *>::iterator i = targets.begin (); i != targets.end (); ++i)
+    {
+      Partition *partition = *i;
+      if (partition->heldUids.size () <= partition->heldUidsLimit)
+        {
+          continue;
+        }
+      for (HeldUids::iterator j = partition->heldUids.begin (); j != partition->heldUids.end (); )
+        {
+          if (j->second.ts < partition->currentTs)
+            {
+              j = partition->heldUids.erase (j);
+            }
+          else
+            {
+              ++j;
+            }
+        }
+      partition->heldUidsLimit = std::max<std::size_t> (1024, 2 * partition->heldUids.size ());
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::CalculateLookAhead (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_userLookAhead.IsStrictlyPositive ())
+    {
+      return Seconds (0);
+    }
+  // The packets, the nodes and their devices are reference counted and
+  // pooled without any synchronization, so the events of the nodes
+  // cannot run on several threads.
+  Config::MatchContainer nodes = Config::LookupMatches ("/NodeList/*");
+  if (nodes.GetN () > 0)
+    {
+      NS_LOG_WARN ("the simulation has " << nodes.GetN () << " nodes, which are "
+                   "not thread-safe: running sequentially");
+      return Seconds (0);
+    }
+  return m_userLookAhead;
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t n = m_threadCount;
+  if (n == 0)
+    {
+      n = std::max (std::thread::hardware_concurrency (), 1U);
+    }
+
+  Partition *staging = m_partitions[0];
+  m_partitions.clear ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Partition *partition = CreatePartition ();
+      partition->index = i;
+      partition->currentTs = staging->currentTs;
+      m_partitions.push_back (partition);
+    }
+  m_global->currentTs = staging->currentTs;
+  m_parallel = true;
+
+  // The keys are kept: they are all final.
+  while (!staging->events->IsEmpty ())
+    {
+      Scheduler::Event next = staging->events->RemoveNext ();
+      Partition *partition = GetPartition (next.key.m_context);
+      partition->events->Insert (next);
+      partition->unscheduledEvents++;
+    }
+  delete staging;
+}
+
+void
+MultithreadedSimulatorImpl::WorkerThread (std::pair<MultithreadedSimulatorImpl *, uint32_t> worker)
+{
+  MultithreadedSimulatorImpl *self = worker.first;
+  Partition *partition = self->m_partitions[worker.second];
+  uint32_t generation = 0;
+  while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock (self->m_windowMutex);
+        while (self->m_windowGeneration == generation)
+          {
+            self->m_windowStart.wait (lock);
+          }
+        generation = self->m_windowGeneration;
+        if (self->m_workersExit)
+          {
+            return;
+          }
+      }
+      self->ProcessWindow (partition);
+      std::lock_guard<std::mutex> lock (self->m_windowMutex);
+      self->m_pendingWorkers--;
+      if (self->m_pendingWorkers == 0)
+        {
+          self->m_windowDone.notify_one ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunSequential (void)
+{
+  Partition *partition = m_partitions[0];
+  while (!partition->events->IsEmpty () && !m_stop)
+    {
+      ProcessOneEvent (partition);
+      ProcessEventsWithContext ();
+    }
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  NS_ASSERT (!partition->events->IsEmpty () || partition->unscheduledEvents == 0);
+}
+
+void
+MultithreadedSimulatorImpl::RunParallel (void)
+{
+  uint32_t n = m_partitions.size ();
+  uint64_t maxTs = GetMaximumSimulationTime ().GetTimeStep ();
+
+  m_windowGeneration = 0;
+  m_workersExit = false;
+  for (uint32_t i = 1; i < n; ++i)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (
+          MakeBoundCallback (&MultithreadedSimulatorImpl::WorkerThread,
+                             std::make_pair (this, i)));
+      thread->Start ();
+      m_workers.push_back (thread);
+    }
+
+  while (!m_stop)
+    {
+      ProcessEventsWithContext ();
+
+      bool empty = true;
+      Scheduler::EventKey next;
+      for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          if (!(*i)->events->IsEmpty ()
+              && (empty || (*i)->events->PeekNext ().key < next))
+            {
+              empty = false;
+              next = (*i)->events->PeekNext ().key;
+            }
+        }
+
+      // Events without context run alone, when they come first.
+      if (!m_global->events->IsEmpty ())
+        {
+          if (empty || m_global->events->PeekNext ().key < next)
+            {
+              ProcessOneEvent (m_global);
+              continue;
+            }
+        }
+      if (empty)
+        {
+          break;
+        }
+
+      m_windowEnd.m_ts = next.m_ts > maxTs - m_lookAhead ? maxTs : next.m_ts + m_lookAhead;
+      m_windowEnd.m_uid = 0;
+      if (!m_global->events->IsEmpty () && m_global->events->PeekNext ().key < m_windowEnd)
+        {
+          m_windowEnd = m_global->events->PeekNext ().key;
+        }
+
+      {
+        std::lock_guard<std::mutex> lock (m_windowMutex);
+        m_pendingWorkers = n - 1;
+        m_windowGeneration++;
+      }
+      m_windowStart.notify_all ();
+      ProcessWindow (m_partitions[0]);
+      m_threadPartition = 0;
+      {
+        std::unique_lock<std::mutex> lock (m_windowMutex);
+        while (m_pendingWorkers != 0)
+          {
+            m_windowDone.wait (lock);
+          }
+      }
+
+      for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          m_global->currentTs = std::max (m_global->currentTs, (*i)->currentTs);
+          if ((*i)->stop)
+            {
+              (*i)->stop = false;
+              m_stop = true;
+            }
+        }
+      ProcessOutboxes ();
+    }
+
+  {
+    std::lock_guard<std::mutex> lock (m_windowMutex);
+    m_workersExit = true;
+    m_windowGeneration++;
+  }
+  m_windowStart.notify_all ();
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_workers.begin (); i != m_workers.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_workers.clear ();
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  int unscheduledEvents = m_global->unscheduledEvents;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      unscheduledEvents += (*i)->unscheduledEvents;
+    }
+  NS_ASSERT (!IsFinished () || m_stop || unscheduledEvents == 0);
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Set the current threadId as the main threadId
+  m_main = SystemThread::Self ();
+  m_stop = false;
+
+  if (!m_lookAheadValid)
+    {
+      m_lookAhead = CalculateLookAhead ().GetTimeStep ();
+      m_lookAheadValid = true;
+      NS_LOG_LOGIC ("lookahead " << TimeStep (m_lookAhead));
+      if (m_lookAhead > 0)
+        {
+          CreatePartitions ();
+        }
+    }
+  ProcessEventsWithContext ();
+
+  if (m_parallel)
+    {
+      RunParallel ();
+    }
+  else
+    {
+      RunSequential ();
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return TimeStep (m_parallel ? m_lookAhead : 0);
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  Partition *partition = m_threadPartition;
+  if (partition != 0)
+    {
+      partition->stop = true;
+    }
+  else
+    {
+      m_stop = true;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  Simulator::Schedule (delay, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  NS_ASSERT_MSG (m_threadPartition != 0 || SystemThread::Equals (m_main),
+                 "Simulator::Schedule Thread-unsafe invocation!");
+
+  Partition *partition = GetCurrentPartition ();
+  Time tAbsolute = delay + TimeStep (partition->currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (partition->currentTs));
+  uint64_t ts = (uint64_t) tAbsolute.GetTimeStep ();
+  uint32_t uid;
+  if (m_threadPartition != 0)
+    {
+      uid = InsertProvisional (partition->currentContext, ts, event);
+    }
+  else
+    {
+      uid = Insert (partition, partition->currentContext, ts, event);
+    }
+  return EventId (event, ts, partition->currentContext, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+
+  if (m_threadPartition == 0 && !SystemThread::Equals (m_main))
+    {
+      EventWithContext ev;
+      ev.context = context;
+      // Current time added in ProcessEventsWithContext()
+      ev.timestamp = delay.GetTimeStep ();
+      ev.source = Simulator::NO_CONTEXT;
+      ev.event = event;
+      m_eventsWithContext.Push (ev);
+      return;
+    }
+
+  Partition *partition = GetCurrentPartition ();
+  Time tAbsolute = delay + TimeStep (partition->currentTs);
+  if (m_threadPartition != 0)
+    {
+      InsertProvisional (context, (uint64_t) tAbsolute.GetTimeStep (), event);
+    }
+  else
+    {
+      Insert (GetPartition (context), context, (uint64_t) tAbsolute.GetTimeStep (), event);
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_ASSERT_MSG (m_threadPartition != 0 || SystemThread::Equals (m_main),
+                 "Simulator::ScheduleNow Thread-unsafe invocation!");
+
+  Partition *partition = GetCurrentPartition ();
+  uint32_t uid;
+  if (m_threadPartition != 0)
+    {
+      uid = InsertProvisional (partition->currentContext, partition->currentTs, event);
+    }
+  else
+    {
+      uid = Insert (partition, partition->currentContext, partition->currentTs, event);
+    }
+  return EventId (event, partition->currentTs, partition->currentContext, uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_ASSERT_MSG (m_threadPartition == 0 && SystemThread::Equals (m_main),
+                 "Simulator::ScheduleDestroy Thread-unsafe invocation!");
+
+  EventId id (Ptr<EventImpl> (event, false), GetCurrentPartition ()->currentTs, 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetCurrentPartition ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrentPartition ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = GetPartition (id.GetContext ());
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  if (m_parallel && event.key.m_uid >= PROVISIONAL_UID)
+    {
+      CreatedEvent *created = m_threadPartition != 0 ? FindCreated (m_threadPartition, event.key.m_uid) : 0;
+      if (created != 0 && created->held != NOT_HELD)
+        {
+          // Held by the current window: drop it from the outbox.
+          EventWithContext &held = m_threadPartition->outbox[created->held];
+          held.event->Cancel ();
+          held.event->Unref ();
+          held.event = 0;
+          return;
+        }
+      if (created == 0)
+        {
+          HeldUids::iterator i = partition->heldUids.find (event.key.m_uid);
+          NS_ASSERT (i != partition->heldUids.end ());
+          event.key.m_uid = i->second.final;
+          partition->heldUids.erase (i);
+        }
+    }
+  NS_ASSERT_MSG (m_threadPartition == 0 || m_threadPartition == partition,
+                 "Simulator::Remove of an event owned by another thread");
+  partition->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0 ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  uint32_t uid = id.GetUid ();
+  if (m_parallel && uid >= PROVISIONAL_UID)
+    {
+      CreatedEvent *created = m_threadPartition != 0 ? FindCreated (m_threadPartition, uid) : 0;
+      if (created != 0)
+        {
+          if (created->held != NOT_HELD)
+            {
+              return m_threadPartition->outbox[created->held].event == 0;
+            }
+        }
+      else
+        {
+          // Scheduled by an earlier window: only the events it held are
+          // still known, by their final uid.
+          const HeldUids &heldUids = GetPartition (id.GetContext ())->heldUids;
+          HeldUids::const_iterator i = heldUids.find (uid);
+          if (i == heldUids.end () || i->second.ts != id.GetTs ())
+            {
+              return true;
+            }
+          uid = i->second.final;
+        }
+    }
+  // Events are compared with the last event run by the partition which
+  // owns them.
+  const Partition *partition = GetPartition (id.GetContext ());
+  return id.GetTs () < partition->currentTs ||
+         (id.GetTs () == partition->currentTs && uid <= partition->currentUid);
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrentPartition ()->currentContext;
+}
+
+} // namespace ns3
@@ -0,0 +1,364 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "system-thread.h"
+#include "mpsc-queue.h"
+#include "object-factory.h"
+#include "nstime.h"
+
+#include "ptr.h"
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MultithreadedSimulatorImpl declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * A conservative, shared-memory parallel simulator implementation.
+ *
+ * Events are partitioned by their execution context:
+ * context \c c belongs to partition <tt>c % ThreadCount</tt>, and each
+ * partition owns its own Scheduler.  The simulation then advances in
+ * time windows <tt>[T, T + lookahead)</tt>, where \c T is the earliest
+ * pending timestamp; inside a window every partition executes its own
+ * events on its own thread.  The lookahead is set by the \c LookAhead
+ * attribute.  When it is zero, or when the simulation has nodes, the
+ * implementation runs all events on the main thread, exactly like
+ * DefaultSimulatorImpl.
+ *
+ * The events run in the order of DefaultSimulatorImpl: by timestamp,
+ * then by the order in which they were scheduled, as if a single thread
+ * had run them.  The uid of an event, which gives that order, depends on
+ * the events run before the one scheduling it on every thread, so the
+ * events scheduled during a window first get a provisional uid, ordered
+ * within their partition only.  At the end of the window, the main thread
+ * merges the events each partition ran by their final keys, and gives
+ * the events they scheduled their final uids in that order.  The events
+ * due at or after the end of the window, including all those scheduled
+ * for another context, are held until then.  The EventId of an event
+ * keeps its provisional uid, which is translated when needed.  Each
+ * context thus sees its events in the order of DefaultSimulatorImpl,
+ * with any number of threads.  Events without a context
+ * (Simulator::NO_CONTEXT) run on the main thread between two windows,
+ * once every context event with a smaller key has been executed.
+ *
+ * Models are only safe to run in parallel if all the state touched by an
+ * event belongs to the context of that event.  The packets (their uid
+ * counter, the pools and free lists of their buffers, metadata and tags,
+ * and the copy-on-write data shared by their copies), the nodes and
+ * their devices are not thread-safe, so a simulation which has nodes is
+ * always run sequentially: the parallel windows are only used by models
+ * built directly on the simulator.  Cross-context events must be
+ * scheduled at least one lookahead in the future; a violation aborts the
+ * simulation.  Simulator::Stop called from a context event takes effect
+ * at the end of the current window.  Since the provisional uids take the
+ * upper half of the uids, a parallel run is limited to 2^31 events.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * Get the lookahead used by the last call to Run.
+   * \return The lookahead, zero if the simulation ran sequentially.
+   */
+  Time GetLookAhead (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** An event scheduled for a context owned by another partition. */
+  struct EventWithContext {
+    /** The target event context. */
+    uint32_t context;
+    /** Absolute event timestamp. */
+    uint64_t timestamp;
+    /** The context which scheduled the event. */
+    uint32_t source;
+    /** The event implementation, zero once removed. */
+    EventImpl *event;
+  };
+  /** Container type for the events held until the end of a window. */
+  typedef std::vector<struct EventWithContext> Outbox;
+
+  /** An event run by a partition during the current window. */
+  struct ExecutedEvent {
+    /** The event timestamp. */
+    uint64_t ts;
+    /** The event uid, final or provisional. */
+    uint32_t uid;
+    /** The number of events it scheduled. */
+    uint32_t children;
+  };
+
+  /** An event scheduled by a partition during the current window. */
+  struct CreatedEvent {
+    /** The provisional uid of the event. */
+    uint32_t provisional;
+    /** The index of the event in the outbox, or NOT_HELD. */
+    uint32_t held;
+    /** The final uid of the event, once the window is over. */
+    uint32_t final;
+  };
+
+  /** The final uid of an event held until the end of a window. */
+  struct HeldUid {
+    /** The event timestamp. */
+    uint64_t ts;
+    /** The final uid. */
+    uint32_t final;
+  };
+  /** Container type for the final uids of the held events, by provisional uid. */
+  typedef std::unordered_map<uint32_t, struct HeldUid> HeldUids;
+
+  /** The events and the execution state of a set of contexts. */
+  struct Partition {
+    /** The event priority queue. */
+    Ptr<Scheduler> events;
+    /** The index of the partition. */
+    uint32_t index;
+    /** Unique id of the current event. */
+    uint32_t currentUid;
+    /** Timestamp of the current event. */
+    uint64_t currentTs;
+    /** Execution context of the current event. */
+    uint32_t currentContext;
+    /** Number of events inserted but not yet executed. */
+    int unscheduledEvents;
+    /** Flag set by Stop() while the partition runs a window. */
+    bool stop;
+    /** Number of provisional uids given so far. */
+    uint64_t provisional;
+    /** Number of provisional uids given before the current window. */
+    uint64_t windowProvisional;
+    /** Events run during the current window, in order. */
+    std::vector<struct ExecutedEvent> executed;
+    /** Events scheduled during the current window, in order. */
+    std::vector<struct CreatedEvent> created;
+    /** Events scheduled during the current window, held until its end. */
+    Outbox outbox;
+    /** The final uids of the held events of this partition's contexts. */
+    HeldUids heldUids;
+    /** Size of heldUids above which the expired entries are dropped. */
+    std::size_t heldUidsLimit;
+  };
+
+  /** Marks a created event which is not in the outbox. */
+  static const uint32_t NOT_HELD = 0xffffffff;
+  /** The first provisional uid; the final uids are below. */
+  static const uint32_t PROVISIONAL_UID = 0x80000000;
+
+  /**
+   * Entry point of the worker threads.
+   * \param [in] worker The simulator and the index of the partition to run.
+   */
+  static void WorkerThread (std::pair<MultithreadedSimulatorImpl *, uint32_t> worker);
+
+  /**
+   * Create an empty partition.
+   * \return The new partition.
+   */
+  Partition * CreatePartition (void) const;
+  /**
+   * Get the partition which owns a context.
+   * \param [in] context The event context.
+   * \return The owning partition.
+   */
+  Partition * GetPartition (uint32_t context) const;
+  /**
+   * Get the partition running on the calling thread.
+   * \return The current partition.
+   */
+  Partition * GetCurrentPartition (void) const;
+  /**
+   * Insert an event in a partition with the next final uid.
+   * \param [in] partition The target partition.
+   * \param [in] context The event context.
+   * \param [in] ts The absolute event timestamp.
+   * \param [in] event The event implementation.
+   * \return The uid of the inserted event.
+   */
+  uint32_t Insert (Partition *partition, uint32_t context, uint64_t ts, EventImpl *event);
+  /**
+   * Schedule an event from the window running on the calling thread,
+   * with a provisional uid.
+   * \param [in] context The event context.
+   * \param [in] ts The absolute event timestamp.
+   * \param [in] event The event implementation.
+   * \return The provisional uid of the event.
+   */
+  uint32_t InsertProvisional (uint32_t context, uint64_t ts, EventImpl *event);
+  /**
+   * Find an event scheduled by a partition during the current window.
+   * \param [in] partition The partition.
+   * \param [in] uid The provisional uid of the event.
+   * \return The event, or zero if the partition did not schedule it
+   *         during the current window.
+   */
+  CreatedEvent * FindCreated (Partition *partition, uint32_t uid) const;
+  /**
+   * Get the final uid of an event.
+   * \param [in] partition The partition which ran the event.
+   * \param [in] uid The uid of the event, final or provisional.
+   * \return The final uid.
+   */
+  uint32_t GetFinalUid (Partition *partition, uint32_t uid) const;
+  /**
+   * Process the next event of a partition.
+   * \param [in] partition The partition.
+   */
+  void ProcessOneEvent (Partition *partition);
+  /**
+   * Process all the events of a partition earlier than the window end.
+   * \param [in] partition The partition.
+   */
+  void ProcessWindow (Partition *partition);
+  /** Move events from a different thread into the event queues. */
+  void ProcessEventsWithContext (void);
+  /**
+   * Give the events scheduled during the window their final uids, and
+   * hand the held events to their partitions.
+   */
+  void ProcessOutboxes (void);
+  /**
+   * Check whether the simulation can run in parallel.
+   * \return The lookahead, zero if the simulation must run sequentially.
+   */
+  Time CalculateLookAhead (void) const;
+  /** Split the events into one partition per thread. */
+  void CreatePartitions (void);
+  /** Run the simulation in parallel time windows. */
+  void RunParallel (void);
+  /** Run the simulation on the main thread. */
+  void RunSequential (void);
+
+  /** Container type for the events from a different thread. */
+  typedef MpscQueue<struct EventWithContext> EventsWithContext;
+  /**
+   * The events from a different thread, pushed by that thread without
+   * locking.
+   */
+  EventsWithContext m_eventsWithContext;
+
+  /** Container type for the events to run at Simulator::Destroy() */
+  typedef std::list<EventId> DestroyEvents;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+  /** Flag calling for the end of the simulation. */
+  bool m_stop;
+  /** Next final event unique id. */
+  uint32_t m_uid;
+
+  /** The scheduler factory, used to create the partition schedulers. */
+  ObjectFactory m_schedulerFactory;
+  /**
+   * The context partitions.  Before the first parallel Run a single
+   * partition holds all the events.
+   */
+  std::vector<Partition *> m_partitions;
+  /** The partition of the events without context. */
+  Partition *m_global;
+  /** Whether the events are split across several partitions. */
+  bool m_parallel;
+  /** Whether the lookahead has already been computed. */
+  bool m_lookAheadValid;
+
+  /** Number of threads requested. */
+  uint32_t m_threadCount;
+  /** Lookahead set by the user. */
+  Time m_userLookAhead;
+  /** Lookahead in use, in time steps. */
+  uint64_t m_lookAhead;
+  /**
+   * End of the current window, exclusive: the window runs the events
+   * with a smaller key.  Its uid is that of the next event without
+   * context when it bounds the window, zero otherwise.
+   */
+  Scheduler::EventKey m_windowEnd;
+
+  /** Worker threads, one per partition beyond the first. */
+  std::vector<Ptr<SystemThread> > m_workers;
+  /** Protects the window state shared with the workers. */
+  std::mutex m_windowMutex;
+  /** Signals the workers that a window starts. */
+  std::condition_variable m_windowStart;
+  /** Signals the main thread that the workers finished the window. */
+  std::condition_variable m_windowDone;
+  /** Incremented by the main thread to start a window. */
+  uint32_t m_windowGeneration;
+  /** Number of workers which have not finished the current window. */
+  uint32_t m_pendingWorkers;
+  /** Flag asking the workers to exit. */
+  bool m_workersExit;
+
+  /** Main execution thread. */
+  SystemThread::ThreadId m_main;
+
+  /** The partition running on the calling thread, if any. */
+  static thread_local Partition *m_threadPartition;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
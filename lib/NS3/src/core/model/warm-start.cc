@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "warm-start.h"
+#include "simulator.h"
+#include "simulator-impl.h"
+#include "default-simulator-impl.h"
+#include "abort.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/types.h>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::WarmStart implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WarmStart");
+
+/**
+ * \ingroup simulator
+ * The branch of this process, -1 in the original process.
+ */
+static int32_t g_warmStartBranch = -1;
+
+/**
+ * \ingroup simulator
+ * The exit status of each branch, in the original process.
+ */
+static std::vector<int> g_warmStartStatus;
+
+void
+WarmStart::Fork (const Time &delay, uint32_t branches,
+                 Callback<void, uint32_t> configure, uint32_t maxRunning)
+{
+  NS_LOG_FUNCTION (delay << branches << maxRunning);
+  NS_ABORT_MSG_IF (branches == 0, "WarmStart::Fork needs at least one branch");
+  Simulator::Schedule (delay, &WarmStart::DoFork, branches, configure, maxRunning);
+}
+
+int32_t
+WarmStart::GetBranch (void)
+{
+  return g_warmStartBranch;
+}
+
+int
+WarmStart::GetExitStatus (uint32_t branch)
+{
+  NS_LOG_FUNCTION (branch);
+  NS_ABORT_MSG_UNLESS (branch < g_warmStartStatus.size (),
+                       "No exit status for branch " << branch);
+  return g_warmStartStatus[branch];
+}
+
+#ifdef HAVE_SYS_WAIT_H
+
+/**
+ * \ingroup simulator
+ * Wait for any of the running branches.
+ *
+ * Only the branches are reaped: the other children of the process,
+ * started by the program itself, are left to it.
+ *
+ * \param [in,out] running The running branches, by process id.
+ */
+static void
+WaitBranch (std::map<pid_t, uint32_t> &running)
+{
+  while (true)
+    {
+      for (std::map<pid_t, uint32_t>::iterator i = running.begin (); i != running.end (); ++i)
+        {
+          int status;
+          pid_t pid = waitpid (i->first, &status, WNOHANG);
+          if (pid < 0 && errno == EINTR)
+            {
+              pid = 0;
+            }
+          NS_ABORT_MSG_IF (pid < 0, "waitpid failed: " << std::strerror (errno));
+          if (pid == i->first)
+            {
+              g_warmStartStatus[i->second] = WIFEXITED (status) ? WEXITSTATUS (status) : -1;
+              NS_LOG_LOGIC ("branch " << i->second << " exited with " << g_warmStartStatus[i->second]);
+              running.erase (i);
+              return;
+            }
+        }
+      // Sleep until a child exits, without reaping it.
+      siginfo_t info;
+      info.si_pid = 0;
+      if (waitid (P_ALL, 0, &info, WEXITED | WNOWAIT) < 0)
+        {
+          NS_ABORT_MSG_IF (errno != EINTR, "waitid failed: " << std::strerror (errno));
+          continue;
+        }
+      if (running.find (info.si_pid) == running.end ())
+        {
+          // Another child of the program exited and waits to be
+          // reaped by it: poll the branches instead.
+          usleep (10000);
+        }
+    }
+}
+
+void
+WarmStart::DoFork (uint32_t branches, Callback<void, uint32_t> configure,
+                   uint32_t maxRunning)
+{
+  NS_LOG_FUNCTION (branches << maxRunning);
+  NS_ABORT_MSG_UNLESS (Simulator::GetImplementation ()->GetInstanceTypeId ()
+                       == DefaultSimulatorImpl::GetTypeId (),
+                       "WarmStart requires ns3::DefaultSimulatorImpl");
+
+  // Do not let the branches print the buffered output again.
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::clog.flush ();
+  std::fflush (0);
+
+  g_warmStartStatus.assign (branches, -1);
+  std::map<pid_t, uint32_t> running;
+  for (uint32_t branch = 0; branch < branches; ++branch)
+    {
+      if (maxRunning > 0 && running.size () >= maxRunning)
+        {
+          WaitBranch (running);
+        }
+      pid_t pid = fork ();
+      NS_ABORT_MSG_IF (pid < 0, "fork failed: " << std::strerror (errno));
+      if (pid == 0)
+        {
+          g_warmStartBranch = branch;
+          g_warmStartStatus.clear ();
+          NS_LOG_LOGIC ("branch " << branch << " started");
+          if (!configure.IsNull ())
+            {
+              configure (branch);
+            }
+          return;
+        }
+      running[pid] = branch;
+    }
+  while (!running.empty ())
+    {
+      WaitBranch (running);
+    }
+  Simulator::Stop ();
+}
+
+#else /* HAVE_SYS_WAIT_H */
+
+void
+WarmStart::DoFork (uint32_t branches, Callback<void, uint32_t> configure,
+                   uint32_t maxRunning)
+{
+  NS_FATAL_ERROR ("WarmStart is not supported on this platform");
+}
+
+#endif /* HAVE_SYS_WAIT_H */
+
+} // namespace ns3
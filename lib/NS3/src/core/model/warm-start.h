@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef WARM_START_H
+#define WARM_START_H
+
+#include "nstime.h"
+#include "callback.h"
+
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::WarmStart declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \brief Share a warm-up phase between several runs of a simulation.
+ *
+ * Scenarios which spend a long simulated time converging (routing
+ * tables, queues, caches) before any measurement is taken can run
+ * that warm-up once, and then branch into several runs which differ
+ * only by what happens after it, typically one per point of a
+ * parameter sweep:
+ *
+ * \code
+ *   void Configure (uint32_t branch)
+ *   {
+ *     Config::Set ("/NodeList/0/ApplicationList/0/$ns3::OnOffApplication/DataRate",
+ *                  DataRateValue (rates[branch]));
+ *     RngSeedManager::SetRun (branch + 1); // for the streams created from now on
+ *   }
+ *
+ *   WarmStart::Fork (Seconds (120), nRates, MakeCallback (&Configure));
+ *   Simulator::Stop (Seconds (300));
+ *   Simulator::Run ();
+ *   if (WarmStart::GetBranch () < 0)
+ *     {
+ *       // The original process: all the branches have completed.
+ *       return 0;
+ *     }
+ *   // A branch: write the results of branch WarmStart::GetBranch ().
+ * \endcode
+ *
+ * The state of the simulation is captured by forking the process: each
+ * branch is a child process which starts with an exact copy of the
+ * event queue, of every object and of the random number streams, so no
+ * model needs to support serialization.  The original process waits for
+ * the branches, then stops its own simulation.
+ *
+ * Only the thread which runs the simulation survives in a branch, so
+ * this requires ns3::DefaultSimulatorImpl, and no model (such as an
+ * emulated device) may run threads of its own.  Open files are shared
+ * by the branches; they should be opened after the fork.
+ */
+class WarmStart
+{
+public:
+  /**
+   * Branch the simulation once the warm-up is over.
+   *
+   * \param [in] delay The end of the warm-up, relative to the current
+   *             simulation time.
+   * \param [in] branches The number of branches.
+   * \param [in] configure Called in each branch with its index, right
+   *             after the fork.
+   * \param [in] maxRunning The maximum number of branches running at
+   *             the same time, or zero for no limit.
+   */
+  static void Fork (const Time &delay, uint32_t branches,
+                    Callback<void, uint32_t> configure,
+                    uint32_t maxRunning = 0);
+  /**
+   * Get the branch of the calling process.
+   * \returns The branch index, or -1 in the original process.
+   */
+  static int32_t GetBranch (void);
+  /**
+   * Get the exit status of a branch, in the original process once
+   * its simulation has stopped.
+   * \param [in] branch The branch index.
+   * \returns The exit status, or -1 if the branch did not exit normally.
+   */
+  static int GetExitStatus (uint32_t branch);
+
+private:
+  /**
+   * Fork the branches and wait for them.
+   * \param [in] branches The number of branches.
+   * \param [in] configure The branch configuration callback.
+   * \param [in] maxRunning The maximum number of branches running at
+   *             the same time, or zero for no limit.
+   */
+  static void DoFork (uint32_t branches, Callback<void, uint32_t> configure,
+                      uint32_t maxRunning);
+};
+
+} // namespace ns3
+
+#endif /* WARM_START_H */
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/mpsc-queue.h"
+#include "ns3/system-thread.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/** A value tagged with the producer which pushed it. */
+struct MpscQueueTestValue
+{
+  uint32_t producer;  /**< The producer index. */
+  uint32_t sequence;  /**< The value index for this producer. */
+};
+
+/**
+ * Check that values pushed concurrently by several threads are all
+ * popped once, in the order of each producer.
+ */
+class MpscQueueTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] capacity The number of preallocated queue nodes.
+   */
+  MpscQueueTestCase (uint32_t capacity);
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Push the values of a producer.
+   * \param [in] test The test case.
+   * \param [in] producer The producer index.
+   */
+  static void Produce (MpscQueueTestCase *test, uint32_t producer);
+  /**
+   * Pop all the available values.
+   * \returns \c false if a value was out of order.
+   */
+  bool Consume (void);
+
+  /** The queue under test. */
+  MpscQueue<MpscQueueTestValue> m_queue;
+  /** Next expected sequence number of each producer. */
+  std::vector<uint32_t> m_next;
+};
+
+/** Number of producer threads. */
+static const uint32_t MPSC_PRODUCERS = 4;
+/** Number of values pushed by each producer. */
+static const uint32_t MPSC_VALUES = 100000;
+
+MpscQueueTestCase::MpscQueueTestCase (uint32_t capacity)
+  : TestCase ("Check the MPSC queue order with a pool of " +
+              std::to_string (capacity) + " nodes"),
+    m_queue (capacity),
+    m_next (MPSC_PRODUCERS, 0)
+{
+}
+
+void
+MpscQueueTestCase::Produce (MpscQueueTestCase *test, uint32_t producer)
+{
+  for (uint32_t i = 0; i < MPSC_VALUES; ++i)
+    {
+      MpscQueueTestValue value;
+      value.producer = producer;
+      value.sequence = i;
+      test->m_queue.Push (value);
+    }
+}
+
+bool
+MpscQueueTestCase::Consume (void)
+{
+  MpscQueueTestValue value;
+  while (m_queue.Pop (value))
+    {
+      if (value.producer >= MPSC_PRODUCERS || value.sequence != m_next[value.producer])
+        {
+          return false;
+        }
+      m_next[value.producer]++;
+    }
+  return true;
+}
+
+void
+MpscQueueTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_queue.IsEmpty (), true, "New queue not empty");
+
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < MPSC_PRODUCERS; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&MpscQueueTestCase::Produce, this, i)));
+      threads.back ()->Start ();
+    }
+
+  // Pop concurrently with the producers.
+  bool ordered = true;
+  uint32_t popped = 0;
+  while (ordered && popped < MPSC_PRODUCERS * MPSC_VALUES)
+    {
+      ordered = Consume ();
+      popped = 0;
+      for (uint32_t i = 0; i < MPSC_PRODUCERS; ++i)
+        {
+          popped += m_next[i];
+        }
+    }
+  for (uint32_t i = 0; i < MPSC_PRODUCERS; ++i)
+    {
+      threads[i]->Join ();
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (ordered, true, "Values popped out of order");
+  NS_TEST_EXPECT_MSG_EQ (popped, MPSC_PRODUCERS * MPSC_VALUES, "Values lost");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.IsEmpty (), true, "Queue not empty");
+  MpscQueueTestValue value;
+  NS_TEST_EXPECT_MSG_EQ (m_queue.Pop (value), false, "Value popped from an empty queue");
+}
+
+/**
+ * The MPSC queue TestSuite.
+ */
+class MpscQueueTestSuite : public TestSuite
+{
+public:
+  MpscQueueTestSuite ()
+    : TestSuite ("mpsc-queue")
+  {
+    AddTestCase (new MpscQueueTestCase (1024), TestCase::QUICK);
+    // Most pushes have to allocate their node.
+    AddTestCase (new MpscQueueTestCase (4), TestCase::QUICK);
+  }
+} g_mpscQueueTestSuite;
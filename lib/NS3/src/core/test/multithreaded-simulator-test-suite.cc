@@ -0,0 +1,324 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * A set of contexts exchanging events with ties on their timestamps.
+ *
+ * Every context folds the events it receives into a running hash,
+ * so any difference in the per-context event order changes the result.
+ * Each context also keeps a timer, which it restarts or removes, and
+ * whose expiry is folded into the hash.
+ */
+class ContextExchange
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] contexts The number of contexts.
+   * \param [in] lookAhead The minimum delay between contexts.
+   */
+  ContextExchange (uint32_t contexts, Time lookAhead);
+  /** Schedule the initial events and run the simulation. */
+  void Run (void);
+
+  /** Per-context hash of the events received. */
+  std::vector<uint64_t> m_hash;
+  /** Per-context number of events received. */
+  std::vector<uint32_t> m_count;
+  /** Snapshot of the hashes taken by an event without context. */
+  std::vector<uint64_t> m_snapshot;
+
+private:
+  /**
+   * Receive a value.
+   * \param [in] value The value.
+   */
+  void Receive (uint32_t value);
+  /** Copy the hashes of all contexts. */
+  void Snapshot (void);
+  /** Fold the expiry of the timer of the current context. */
+  void Timeout (void);
+
+  /** Per-context timer. */
+  std::vector<EventId> m_timer;
+  /** The minimum delay between contexts. */
+  Time m_lookAhead;
+};
+
+ContextExchange::ContextExchange (uint32_t contexts, Time lookAhead)
+  : m_hash (contexts, 0),
+    m_count (contexts, 0),
+    m_timer (contexts),
+    m_lookAhead (lookAhead)
+{
+}
+
+void
+ContextExchange::Receive (uint32_t value)
+{
+  uint32_t context = Simulator::GetContext ();
+  uint64_t hash = m_hash[context] * 1099511628211ULL + value + Simulator::Now ().GetNanoSeconds ();
+  m_hash[context] = hash;
+  m_count[context]++;
+  if (m_count[context] > 200)
+    {
+      return;
+    }
+  // The timer may have been scheduled in an earlier window.
+  hash = hash * 31 + m_timer[context].IsExpired ();
+  m_hash[context] = hash;
+  if (hash % 5 == 0)
+    {
+      Simulator::Remove (m_timer[context]);
+    }
+  else if (hash % 5 == 1)
+    {
+      m_timer[context] = Simulator::Schedule (MicroSeconds (3) + NanoSeconds (hash % 3), &ContextExchange::Timeout, this);
+    }
+  // Same-context events, some of them sharing the current timestamp.
+  Simulator::Schedule (NanoSeconds (hash % 2), &ContextExchange::Receive, this, value + 1);
+  // Cross-context events, landing on a coarse grid to create ties
+  // between senders.
+  uint32_t n = m_hash.size ();
+  Time delay = m_lookAhead + MicroSeconds ((hash >> 8) % 3);
+  Simulator::ScheduleWithContext ((context + 1) % n, delay, &ContextExchange::Receive, this, value);
+  Simulator::ScheduleWithContext ((context + n - 1) % n, delay, &ContextExchange::Receive, this, value + 7);
+}
+
+void
+ContextExchange::Timeout (void)
+{
+  uint32_t context = Simulator::GetContext ();
+  m_hash[context] = m_hash[context] * 1099511628211ULL + 1 + Simulator::Now ().GetNanoSeconds ();
+}
+
+void
+ContextExchange::Snapshot (void)
+{
+  m_snapshot = m_hash;
+}
+
+void
+ContextExchange::Run (void)
+{
+  for (uint32_t i = 0; i < m_hash.size (); ++i)
+    {
+      Simulator::ScheduleWithContext (i, MicroSeconds (i % 2), &ContextExchange::Receive, this, i);
+    }
+  Simulator::Schedule (MicroSeconds (50), &ContextExchange::Snapshot, this);
+  Simulator::Stop (MilliSeconds (1));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that the event order seen by each context does not depend
+ * on the number of threads.
+ */
+class MultithreadedSimulatorDeterminismTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorDeterminismTestCase ();
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+private:
+  /**
+   * Run the exchange.
+   * \param [in] threads The number of threads.
+   * \return The finished exchange.
+   */
+  ContextExchange RunExchange (uint32_t threads);
+};
+
+MultithreadedSimulatorDeterminismTestCase::MultithreadedSimulatorDeterminismTestCase ()
+  : TestCase ("Check that the results do not depend on the number of threads")
+{
+}
+
+ContextExchange
+MultithreadedSimulatorDeterminismTestCase::RunExchange (uint32_t threads)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::LookAhead", TimeValue (MicroSeconds (5)));
+  ContextExchange exchange (16, MicroSeconds (5));
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_EXPECT_MSG_NE (impl, 0, "Wrong simulator implementation");
+  exchange.Run ();
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLookAhead (), MicroSeconds (5), "Unexpected lookahead");
+  return exchange;
+}
+
+void
+MultithreadedSimulatorDeterminismTestCase::DoRun (void)
+{
+  ContextExchange reference = RunExchange (1);
+  NS_TEST_ASSERT_MSG_EQ (reference.m_snapshot.size (), 16, "Event without context not run");
+  for (uint32_t i = 0; i < 16; ++i)
+    {
+      NS_TEST_ASSERT_MSG_GT (reference.m_count[i], 200, "Context " << i << " did not run");
+    }
+
+  uint32_t threads[] = { 2, 3, 4 };
+  for (uint32_t t = 0; t < sizeof (threads) / sizeof (threads[0]); ++t)
+    {
+      ContextExchange exchange = RunExchange (threads[t]);
+      for (uint32_t i = 0; i < 16; ++i)
+        {
+          NS_TEST_EXPECT_MSG_EQ (exchange.m_count[i], reference.m_count[i],
+                                 "Context " << i << " with " << threads[t] << " threads");
+          NS_TEST_EXPECT_MSG_EQ (exchange.m_hash[i], reference.m_hash[i],
+                                 "Context " << i << " with " << threads[t] << " threads");
+          NS_TEST_EXPECT_MSG_EQ (exchange.m_snapshot[i], reference.m_snapshot[i],
+                                 "Context " << i << " with " << threads[t] << " threads");
+        }
+    }
+}
+
+void
+MultithreadedSimulatorDeterminismTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::Reset ();
+}
+
+/**
+ * Check that without lookahead the events run exactly as with
+ * DefaultSimulatorImpl.
+ */
+class MultithreadedSimulatorSequentialTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorSequentialTestCase ();
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+MultithreadedSimulatorSequentialTestCase::MultithreadedSimulatorSequentialTestCase ()
+  : TestCase ("Check that the simulation runs sequentially without lookahead")
+{
+}
+
+void
+MultithreadedSimulatorSequentialTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  ContextExchange reference (8, Seconds (0));
+  reference.Run ();
+
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (4));
+  ContextExchange exchange (8, Seconds (0));
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Wrong simulator implementation");
+  exchange.Run ();
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLookAhead (), Seconds (0), "Unexpected lookahead");
+
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (exchange.m_count[i], reference.m_count[i], "Context " << i);
+      NS_TEST_EXPECT_MSG_EQ (exchange.m_hash[i], reference.m_hash[i], "Context " << i);
+    }
+}
+
+void
+MultithreadedSimulatorSequentialTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::Reset ();
+}
+
+/**
+ * Check that with a lookahead each context sees its events in the order
+ * of DefaultSimulatorImpl, with any number of threads.
+ */
+class MultithreadedSimulatorDefaultOrderTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorDefaultOrderTestCase ();
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+MultithreadedSimulatorDefaultOrderTestCase::MultithreadedSimulatorDefaultOrderTestCase ()
+  : TestCase ("Check that the parallel event order is that of DefaultSimulatorImpl")
+{
+}
+
+void
+MultithreadedSimulatorDefaultOrderTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  ContextExchange reference (16, MicroSeconds (5));
+  reference.Run ();
+  NS_TEST_ASSERT_MSG_EQ (reference.m_snapshot.size (), 16, "Event without context not run");
+
+  uint32_t threads[] = { 1, 2, 4 };
+  for (uint32_t t = 0; t < sizeof (threads) / sizeof (threads[0]); ++t)
+    {
+      Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+      Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (threads[t]));
+      Config::SetDefault ("ns3::MultithreadedSimulatorImpl::LookAhead", TimeValue (MicroSeconds (5)));
+      ContextExchange exchange (16, MicroSeconds (5));
+      Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+      NS_TEST_ASSERT_MSG_NE (impl, 0, "Wrong simulator implementation");
+      exchange.Run ();
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLookAhead (), MicroSeconds (5), "Unexpected lookahead");
+      for (uint32_t i = 0; i < 16; ++i)
+        {
+          NS_TEST_EXPECT_MSG_EQ (exchange.m_count[i], reference.m_count[i],
+                                 "Context " << i << " with " << threads[t] << " threads");
+          NS_TEST_EXPECT_MSG_EQ (exchange.m_hash[i], reference.m_hash[i],
+                                 "Context " << i << " with " << threads[t] << " threads");
+          NS_TEST_EXPECT_MSG_EQ (exchange.m_snapshot[i], reference.m_snapshot[i],
+                                 "Context " << i << " with " << threads[t] << " threads");
+        }
+    }
+}
+
+void
+MultithreadedSimulatorDefaultOrderTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::Reset ();
+}
+
+/**
+ * The multithreaded simulator TestSuite.
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator")
+  {
+    AddTestCase (new MultithreadedSimulatorDeterminismTestCase (), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorSequentialTestCase (), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorDefaultOrderTestCase (), TestCase::QUICK);
+  }
+} g_multithreadedSimulatorTestSuite;
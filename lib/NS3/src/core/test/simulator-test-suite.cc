@@ -19,10 +19,14 @@
  */
 #include "ns3/test.h"
 #include "ns3/simulator.h"
+#include "ns3/event-impl.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+
+#include <set>
 
 using namespace ns3;
 
@@ -459,6 +463,204 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check that a scheduler returns the events in order under a random
+ * mix of insertions and removals, with timestamps spread over several
+ * orders of magnitude.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] schedulerFactory The factory of the scheduler to test.
+   */
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Linear congruential generator, to keep the test reproducible.
+   * \return A pseudo-random number.
+   */
+  uint32_t Random (void);
+  /**
+   * Get a delay with a heavy tail and many ties.
+   * \return The delay.
+   */
+  uint64_t RandomDelay (void);
+
+  /** The scheduler factory. */
+  ObjectFactory m_schedulerFactory;
+  /** The generator state. */
+  uint64_t m_state;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the event order of " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_state (1)
+{
+}
+
+uint32_t
+SchedulerOrderTestCase::Random (void)
+{
+  m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return m_state >> 33;
+}
+
+uint64_t
+SchedulerOrderTestCase::RandomDelay (void)
+{
+  uint32_t kind = Random () % 100;
+  if (kind < 20)
+    {
+      return 0;
+    }
+  else if (kind < 80)
+    {
+      return Random () % 100;
+    }
+  else if (kind < 98)
+    {
+      return Random () % 1000000;
+    }
+  return (uint64_t)Random () * 1000;
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  std::set<Scheduler::EventKey> pending;
+  uint32_t uid = 0;
+  uint64_t now = 0;
+  for (uint32_t i = 0; i < 100000; ++i)
+    {
+      uint32_t op = Random () % 16;
+      if (op < 9 || pending.empty ())
+        {
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_ts = now + RandomDelay ();
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          scheduler->Insert (ev);
+          pending.insert (ev.key);
+        }
+      else if (op < 15)
+        {
+          NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "Scheduler lost events");
+          Scheduler::Event next = scheduler->PeekNext ();
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, ev.key.m_uid, "PeekNext and RemoveNext disagree");
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, pending.begin ()->m_uid, "Wrong event order");
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_ts, pending.begin ()->m_ts, "Wrong event order");
+          now = ev.key.m_ts;
+          pending.erase (pending.begin ());
+        }
+      else
+        {
+          Scheduler::EventKey key;
+          key.m_ts = now + RandomDelay ();
+          key.m_uid = 0;
+          key.m_context = 0;
+          std::set<Scheduler::EventKey>::iterator it = pending.lower_bound (key);
+          if (it == pending.end ())
+            {
+              --it;
+            }
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key = *it;
+          scheduler->Remove (ev);
+          pending.erase (it);
+        }
+    }
+  while (!pending.empty ())
+    {
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, pending.begin ()->m_uid, "Wrong event order");
+      pending.erase (pending.begin ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "Scheduler not empty");
+}
+
+/**
+ * Check that the events of a simulation in steady state are all
+ * allocated from the event pool.
+ */
+class SimulatorEventPoolTestCase : public TestCase
+{
+public:
+  SimulatorEventPoolTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Reschedule itself until the count is reached.
+   * \param [in] a Argument bound in the small events.
+   */
+  void Small (uint32_t a);
+  /**
+   * Reschedule itself until the count is reached.
+   * \param [in] a Argument bound in the large events.
+   * \param [in] b Argument bound in the large events.
+   * \param [in] c Argument bound in the large events.
+   */
+  void Large (uint64_t a, uint64_t b, uint64_t c);
+
+  /** Number of events to run in each chain. */
+  uint32_t m_count;
+};
+
+SimulatorEventPoolTestCase::SimulatorEventPoolTestCase ()
+  : TestCase ("Check that the events are allocated from the event pool"),
+    m_count (0)
+{
+}
+
+void
+SimulatorEventPoolTestCase::Small (uint32_t a)
+{
+  if (a < m_count)
+    {
+      Simulator::Schedule (NanoSeconds (1), &SimulatorEventPoolTestCase::Small, this, a + 1);
+    }
+}
+
+void
+SimulatorEventPoolTestCase::Large (uint64_t a, uint64_t b, uint64_t c)
+{
+  if (a < m_count)
+    {
+      Simulator::Schedule (NanoSeconds (1), &SimulatorEventPoolTestCase::Large, this, a + 1, b, c);
+    }
+}
+
+void
+SimulatorEventPoolTestCase::DoRun (void)
+{
+  // Warm up the pool.
+  m_count = 10;
+  Simulator::Schedule (NanoSeconds (1), &SimulatorEventPoolTestCase::Small, this, 0);
+  Simulator::Schedule (NanoSeconds (1), &SimulatorEventPoolTestCase::Large, this, 0, 0, 0);
+  Simulator::Run ();
+
+  EventImpl::ResetPoolStats ();
+  m_count = 1000;
+  Simulator::Schedule (NanoSeconds (1), &SimulatorEventPoolTestCase::Small, this, 0);
+  Simulator::Schedule (NanoSeconds (1), &SimulatorEventPoolTestCase::Large, this, 0, 0, 0);
+  Simulator::Run ();
+  EventImpl::PoolStats stats = EventImpl::GetPoolStats ();
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (stats.allocations, 2002, "Events not counted");
+  NS_TEST_EXPECT_MSG_EQ (stats.hits, stats.allocations, "Events not allocated from the pool");
+  NS_TEST_EXPECT_MSG_GT (stats.cached, 0, "Events not released to the pool");
+  Simulator::Destroy ();
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +677,16 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+
+    AddTestCase (new SimulatorEventPoolTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
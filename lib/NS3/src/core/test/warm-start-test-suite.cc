@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/warm-start.h"
+
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/types.h>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+using namespace ns3;
+
+#ifdef HAVE_SYS_WAIT_H
+
+/**
+ * Check that each branch continues from the warm-up state with its
+ * own configuration, and that the original process collects their
+ * exit status, and only theirs.
+ */
+class WarmStartTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] maxRunning The maximum number of branches running at once.
+   */
+  WarmStartTestCase (uint32_t maxRunning);
+  virtual void DoRun (void);
+
+private:
+  /** Count one tick, and schedule the next one. */
+  void Tick (void);
+  /**
+   * Configure a branch.
+   * \param [in] branch The branch index.
+   */
+  void Configure (uint32_t branch);
+
+  /** Number of ticks. */
+  uint32_t m_ticks;
+  /** Parameter set by Configure. */
+  uint32_t m_parameter;
+  /** The maximum number of branches running at once. */
+  uint32_t m_maxRunning;
+};
+
+WarmStartTestCase::WarmStartTestCase (uint32_t maxRunning)
+  : TestCase ("Check that the branches continue the warmed up simulation"),
+    m_ticks (0),
+    m_parameter (0),
+    m_maxRunning (maxRunning)
+{
+}
+
+void
+WarmStartTestCase::Tick (void)
+{
+  m_ticks++;
+  Simulator::Schedule (MilliSeconds (1), &WarmStartTestCase::Tick, this);
+}
+
+void
+WarmStartTestCase::Configure (uint32_t branch)
+{
+  m_parameter = branch + 1;
+}
+
+void
+WarmStartTestCase::DoRun (void)
+{
+  m_ticks = 0;
+  m_parameter = 0;
+  // A child of the program, which WarmStart must leave to it.
+  pid_t child = fork ();
+  NS_TEST_ASSERT_MSG_NE (child, -1, "fork failed");
+  if (child == 0)
+    {
+      _exit (42);
+    }
+  Simulator::Schedule (MilliSeconds (1), &WarmStartTestCase::Tick, this);
+  WarmStart::Fork (MicroSeconds (10500), 3,
+                   MakeCallback (&WarmStartTestCase::Configure, this), m_maxRunning);
+  Simulator::Stop (MicroSeconds (20500));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  if (WarmStart::GetBranch () >= 0)
+    {
+      // Report the state of the branch and leave the test runner.
+      _exit (m_ticks * 10 + m_parameter);
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (m_ticks, 10, "The original process ran past the fork");
+  int status = 0;
+  NS_TEST_EXPECT_MSG_EQ (waitpid (child, &status, 0), child, "The child of the program was reaped");
+  NS_TEST_EXPECT_MSG_EQ (WIFEXITED (status), true, "The child of the program did not exit");
+  NS_TEST_EXPECT_MSG_EQ (WEXITSTATUS (status), 42, "Wrong exit status for the child of the program");
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (WarmStart::GetExitStatus (i), (int)(20 * 10 + i + 1),
+                             "Wrong state in branch " << i);
+    }
+}
+
+#endif /* HAVE_SYS_WAIT_H */
+
+/**
+ * The warm start TestSuite.
+ */
+class WarmStartTestSuite : public TestSuite
+{
+public:
+  WarmStartTestSuite ()
+    : TestSuite ("warm-start")
+  {
+#ifdef HAVE_SYS_WAIT_H
+    AddTestCase (new WarmStartTestCase (0), TestCase::QUICK);
+    AddTestCase (new WarmStartTestCase (1), TestCase::QUICK);
+#endif
+  }
+} g_warmStartTestSuite;
@@ -39,6 +39,7 @@
 #include <vector>
 #include <functional>
 #include <iomanip>
+#include <limits>
 
 #include "ns3/simulator.h"
 #include "ns3/ipv4-route.h"
@@ -73,6 +74,18 @@ bool CompareRoutesExpire (const DsrRouteCacheEntry &a, const DsrRouteCacheEntry
   return a.GetExpireTime () > b.GetExpireTime ();
 }
 
+/**
+ * Order of the Dijkstra heap: the shortest distance comes first, and among
+ * the nodes as distant, the one with the highest address
+ * \param a the first (distance, node id) pair
+ * \param b the second (distance, node id) pair
+ * \return true if a comes after b
+ */
+static bool CompareHeapEntries (const std::pair<uint32_t, uint32_t> &a, const std::pair<uint32_t, uint32_t> &b)
+{
+  return (a.first > b.first) || ((a.first == b.first) && (a.second < b.second));
+}
+
 void Link::Print () const
 {
   NS_LOG_DEBUG (m_low << "----" << m_high);
@@ -148,6 +161,8 @@ DsrRouteCache::DsrRouteCache ()
   : m_vector (0),
     m_maxEntriesEachDst (3),
     m_isLinkCache (false),
+    m_bestRoutesSource (0),
+    m_maxLinkCacheLen (0),
     m_ntimer (Timer::CANCEL_ON_DESTROY),
     m_delay (MilliSeconds (100))
 {
@@ -320,111 +335,70 @@ DsrRouteCache::RebuildBestRouteTable (Ipv4Address source)
   /**
    * \brief The following are initialize-single-source
    */
-  // @d shortest-path estimate
-  std::map<Ipv4Address, uint32_t> d;
-  // @pre preceding node
-  std::map<Ipv4Address, Ipv4Address> pre;
-  for (std::map<Ipv4Address, std::map<Ipv4Address, uint32_t> >::iterator i = m_netGraph.begin (); i != m_netGraph.end (); ++i)
+  uint32_t n = m_netGraphNodes.size ();
+  m_bestRoutesDistance.assign (n, std::numeric_limits<uint32_t>::max ());
+  m_bestRoutesPre.assign (n, n);
+  m_bestRoutesPreStability.assign (n, Time ());
+  m_bestRoutesDone.assign (n, false);
+  m_bestRoutesHeap.clear ();
+  std::vector<Ipv4Address>::const_iterator i = std::lower_bound (m_netGraphNodes.begin (), m_netGraphNodes.end (), source);
+  if (i == m_netGraphNodes.end () || *i != source)
     {
-      if (i->second.find (source) != i->second.end ())
-        {
-          d[i->first] = i->second[source];
-          pre[i->first] = source;
-        }
-      else
-        {
-          d[i->first] = MAXWEIGHT;
-          pre[i->first] = Ipv4Address ("255.255.255.255");
-        }
+      m_bestRoutesSource = n;
+      return;
     }
-  d[source] = 0;
+  m_bestRoutesSource = i - m_netGraphNodes.begin ();
+  m_bestRoutesDistance[m_bestRoutesSource] = 0;
+  m_bestRoutesHeap.push_back (std::make_pair (0, m_bestRoutesSource));
+}
+
+void
+DsrRouteCache::SettleBestRoute (uint32_t id)
+{
+  NS_LOG_FUNCTION (this << id);
   /**
    * \brief The following is the core of Dijkstra algorithm
    */
-  // the node set which shortest distance has been calculated, if true calculated
-  std::map<Ipv4Address, bool> s;
-  double temp = MAXWEIGHT;
-  Ipv4Address tempip = Ipv4Address ("255.255.255.255");
-  for (uint32_t i = 0; i < m_netGraph.size (); i++)
+  while (!m_bestRoutesDone[id] && !m_bestRoutesHeap.empty ())
     {
-      temp = MAXWEIGHT;
-      for (std::map<Ipv4Address,uint32_t>::const_iterator j = d.begin (); j != d.end (); ++j)
+      std::pop_heap (m_bestRoutesHeap.begin (), m_bestRoutesHeap.end (), CompareHeapEntries);
+      uint32_t u = m_bestRoutesHeap.back ().second;
+      uint32_t du = m_bestRoutesHeap.back ().first;
+      m_bestRoutesHeap.pop_back ();
+      if (m_bestRoutesDone[u] || du != m_bestRoutesDistance[u])
         {
-          Ipv4Address ip = j->first;
-          if (s.find (ip) == s.end ())
-            {
-              /*
-               * \brief The followings are for comparison
-               */
-              if (j->second <= temp)
-                {
-                  temp = j->second;
-                  tempip = ip;
-                }
-            }
+          // outdated heap entry
+          continue;
         }
-      if (!tempip.IsBroadcast ())
+      m_bestRoutesDone[u] = true;
+      for (uint32_t e = m_netGraphOffsets[u]; e < m_netGraphOffsets[u + 1]; e++)
         {
-          s[tempip] = true;
-          for (std::map<Ipv4Address, uint32_t>::const_iterator k = m_netGraph[tempip].begin (); k != m_netGraph[tempip].end (); ++k)
+          uint32_t k = m_netGraphEdges[e];
+          uint32_t dk = du + m_netGraphWeights[e];
+          if (m_bestRoutesDone[k])
             {
-              if (s.find (k->first) == s.end () && d[k->first] > d[tempip] + k->second)
-                {
-                  d[k->first] = d[tempip] + k->second;
-                  pre[k->first] = tempip;
-                }
-              /*
-               *  Selects the shortest-length route that has the longest expected lifetime
-               *  (highest minimum timeout of any link in the route)
-               *  For the computation overhead and complexity
-               *  Here I just implement kind of greedy strategy to select link with the longest expected lifetime when there is two options
-               */
-              else if (d[k->first] == d[tempip] + k->second)
-                {
-                  std::map<Link, DsrLinkStab>::iterator oldlink = m_linkCache.find (Link (k->first, pre[k->first]));
-                  std::map<Link, DsrLinkStab>::iterator newlink = m_linkCache.find (Link (k->first, tempip));
-                  if (oldlink != m_linkCache.end () && newlink != m_linkCache.end ())
-                    {
-                      if (oldlink->second.GetLinkStability () < newlink->second.GetLinkStability ())
-                        {
-                          NS_LOG_INFO ("Select the link with longest expected lifetime");
-                          d[k->first] = d[tempip] + k->second;
-                          pre[k->first] = tempip;
-                        }
-                    }
-                  else
-                    {
-                      NS_LOG_INFO ("Link Stability Info Corrupt");
-                    }
-                }
+              continue;
             }
-        }
-    }
-  // clean the best route table
-  m_bestRoutesTable_link.clear ();
-  for (std::map<Ipv4Address, Ipv4Address>::iterator i = pre.begin (); i != pre.end (); ++i)
-    {
-      // loop for all vertexes
-      DsrRouteCacheEntry::IP_VECTOR route;
-      Ipv4Address iptemp = i->first;
-
-      if (!i->second.IsBroadcast () && iptemp != source)
-        {
-          while (iptemp != source)
+          if (m_bestRoutesDistance[k] > dk)
             {
-              route.push_back (iptemp);
-              iptemp = pre[iptemp];
+              m_bestRoutesDistance[k] = dk;
+              m_bestRoutesPre[k] = u;
+              m_bestRoutesPreStability[k] = m_netGraphStability[e];
+              m_bestRoutesHeap.push_back (std::make_pair (dk, k));
+              std::push_heap (m_bestRoutesHeap.begin (), m_bestRoutesHeap.end (), CompareHeapEntries);
             }
-          route.push_back (source);
-          // Reverse the route
-          DsrRouteCacheEntry::IP_VECTOR reverseroute;
-          for (DsrRouteCacheEntry::IP_VECTOR::reverse_iterator j = route.rbegin (); j != route.rend (); ++j)
+          /*
+           *  Selects the shortest-length route that has the longest expected lifetime
+           *  (highest minimum timeout of any link in the route)
+           *  For the computation overhead and complexity
+           *  Here I just implement kind of greedy strategy to select link with the longest expected lifetime when there is two options
+           */
+          else if (m_bestRoutesDistance[k] == dk && m_bestRoutesPreStability[k] < m_netGraphStability[e])
             {
-              reverseroute.push_back (*j);
+              NS_LOG_INFO ("Select the link with longest expected lifetime");
+              m_bestRoutesPre[k] = u;
+              m_bestRoutesPreStability[k] = m_netGraphStability[e];
             }
-          NS_LOG_LOGIC ("Add newly calculated best routes");
-          PrintVector (reverseroute);
-          m_bestRoutesTable_link[i->first] = reverseroute;
         }
     }
 }
@@ -435,30 +409,36 @@ DsrRouteCache::LookupRoute_Link (Ipv4Address id, DsrRouteCacheEntry & rt)
   NS_LOG_FUNCTION (this << id);
   /// We need to purge the link node cache
   PurgeLinkNode ();
-  std::map<Ipv4Address, DsrRouteCacheEntry::IP_VECTOR>::const_iterator i = m_bestRoutesTable_link.find (id);
-  if (i == m_bestRoutesTable_link.end ())
+  std::vector<Ipv4Address>::const_iterator i = std::lower_bound (m_netGraphNodes.begin (), m_netGraphNodes.end (), id);
+  if (i == m_netGraphNodes.end () || *i != id || m_bestRoutesSource == m_netGraphNodes.size ())
     {
       NS_LOG_INFO ("No route find to " << id);
       return false;
     }
-  else
+  uint32_t dst = i - m_netGraphNodes.begin ();
+  SettleBestRoute (dst);
+  if (!m_bestRoutesDone[dst] || dst == m_bestRoutesSource)
     {
-      if (i->second.size () < 2)
-        {
-          NS_LOG_LOGIC ("Route to " << id << " error");
-          return false;
-        }
+      NS_LOG_INFO ("No route find to " << id);
+      return false;
+    }
 
-      DsrRouteCacheEntry newEntry; // Create the route entry
-      newEntry.SetVector (i->second);
-      newEntry.SetDestination (id);
-      newEntry.SetExpireTime (RouteCacheTimeout);
-      NS_LOG_INFO ("Route to " << id << " found with the length " << i->second.size ());
-      rt = newEntry;
-      std::vector<Ipv4Address> path = rt.GetVector ();
-      PrintVector (path);
-      return true;
+  DsrRouteCacheEntry::IP_VECTOR route;
+  for (uint32_t k = dst; k != m_bestRoutesSource; k = m_bestRoutesPre[k])
+    {
+      route.push_back (m_netGraphNodes[k]);
     }
+  route.push_back (m_netGraphNodes[m_bestRoutesSource]);
+  std::reverse (route.begin (), route.end ());
+
+  DsrRouteCacheEntry newEntry; // Create the route entry
+  newEntry.SetVector (route);
+  newEntry.SetDestination (id);
+  newEntry.SetExpireTime (RouteCacheTimeout);
+  NS_LOG_INFO ("Route to " << id << " found with the length " << route.size ());
+  rt = newEntry;
+  PrintVector (route);
+  return true;
 }
 
 void
@@ -472,6 +452,7 @@ DsrRouteCache::PurgeLinkNode ()
       if (i->second.GetLinkStability () <= Seconds (0))
         {
           ++i;
+          ForgetLink (itmp->first);
           m_linkCache.erase (itmp);
         }
       else
@@ -500,14 +481,92 @@ void
 DsrRouteCache::UpdateNetGraph ()
 {
   NS_LOG_FUNCTION (this);
-  m_netGraph.clear ();
+  m_netGraphNodes.clear ();
+  for (std::map<Link, DsrLinkStab>::iterator i = m_linkCache.begin (); i != m_linkCache.end (); ++i)
+    {
+      m_netGraphNodes.push_back (i->first.m_low);
+      m_netGraphNodes.push_back (i->first.m_high);
+    }
+  std::sort (m_netGraphNodes.begin (), m_netGraphNodes.end ());
+  m_netGraphNodes.erase (std::unique (m_netGraphNodes.begin (), m_netGraphNodes.end ()), m_netGraphNodes.end ());
+
+  // Count the edges of each node, then fill them in
+  std::vector<std::pair<uint32_t, uint32_t> > links;
+  links.reserve (m_linkCache.size ());
+  m_netGraphOffsets.assign (m_netGraphNodes.size () + 1, 0);
   for (std::map<Link, DsrLinkStab>::iterator i = m_linkCache.begin (); i != m_linkCache.end (); ++i)
+    {
+      uint32_t low = std::lower_bound (m_netGraphNodes.begin (), m_netGraphNodes.end (), i->first.m_low) - m_netGraphNodes.begin ();
+      uint32_t high = std::lower_bound (m_netGraphNodes.begin (), m_netGraphNodes.end (), i->first.m_high) - m_netGraphNodes.begin ();
+      links.push_back (std::make_pair (low, high));
+      m_netGraphOffsets[low + 1]++;
+      if (high != low)
+        {
+          m_netGraphOffsets[high + 1]++;
+        }
+    }
+  for (uint32_t i = 0; i < m_netGraphNodes.size (); i++)
+    {
+      m_netGraphOffsets[i + 1] += m_netGraphOffsets[i];
+    }
+  uint32_t edges = m_netGraphOffsets.back ();
+  m_netGraphEdges.resize (edges);
+  m_netGraphWeights.resize (edges);
+  m_netGraphStability.resize (edges);
+  std::vector<uint32_t> next (m_netGraphOffsets.begin (), m_netGraphOffsets.end () - 1);
+  std::map<Link, DsrLinkStab>::iterator stab = m_linkCache.begin ();
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator i = links.begin (); i != links.end (); ++i, ++stab)
     {
       // Here the weight is set as 1
       /// \todo May need to set different weight for different link here later
       uint32_t weight = 1;
-      m_netGraph[i->first.m_low][i->first.m_high] = weight;
-      m_netGraph[i->first.m_high][i->first.m_low] = weight;
+      Time stability = stab->second.GetLinkStability ();
+      uint32_t e = next[i->first]++;
+      m_netGraphEdges[e] = i->second;
+      m_netGraphWeights[e] = weight;
+      m_netGraphStability[e] = stability;
+      if (i->second != i->first)
+        {
+          e = next[i->second]++;
+          m_netGraphEdges[e] = i->first;
+          m_netGraphWeights[e] = weight;
+          m_netGraphStability[e] = stability;
+        }
+    }
+  // The best routes are only valid for the graph they were computed on
+  m_bestRoutesSource = m_netGraphNodes.size ();
+}
+
+void
+DsrRouteCache::TouchLink (Link const & link)
+{
+  NS_LOG_FUNCTION (this);
+  std::map<Link, std::list<Link>::iterator>::iterator i = m_linkUsePos.find (link);
+  if (i != m_linkUsePos.end ())
+    {
+      m_linkUse.splice (m_linkUse.begin (), m_linkUse, i->second);
+      return;
+    }
+  m_linkUse.push_front (link);
+  m_linkUsePos[link] = m_linkUse.begin ();
+  while (m_maxLinkCacheLen != 0 && m_linkUse.size () > m_maxLinkCacheLen)
+    {
+      NS_LOG_LOGIC ("Link cache full, evict the least recently used link");
+      m_linkCache.erase (m_linkUse.back ());
+      m_linkUsePos.erase (m_linkUse.back ());
+      m_linkUse.pop_back ();
+    }
+}
+
+void
+DsrRouteCache::ForgetLink (Link const & link)
+{
+  NS_LOG_FUNCTION (this);
+  std::map<Link, std::list<Link>::iterator>::iterator i = m_linkUsePos.find (link);
+  if (i != m_linkUsePos.end ())
+    {
+      m_linkUse.erase (i->second);
+      m_linkUsePos.erase (i);
     }
 }
 
@@ -597,6 +656,7 @@ DsrRouteCache::AddRoute_Link (DsrRouteCacheEntry::IP_VECTOR nodelist, Ipv4Addres
           stab.SetLinkStability (m_minLifeTime);
         }
       m_linkCache[link] = stab;
+      TouchLink (link);
       NS_LOG_DEBUG ("Add a new link");
       link.Print ();
       NS_LOG_DEBUG ("Link Info");
@@ -623,6 +683,7 @@ DsrRouteCache::UseExtends (DsrRouteCacheEntry::IP_VECTOR rt)
       Link link (*i, *(i + 1));
       if (m_linkCache.find (link) != m_linkCache.end ())
         {
+          TouchLink (link);
           if (m_linkCache[link].GetLinkStability () < m_useExtends)
             {
               m_linkCache[link].SetLinkStability (m_useExtends);
@@ -787,9 +848,11 @@ DsrRouteCache::DeleteAllRoutesIncludeLink (Ipv4Address errorSrc, Ipv4Address unr
       // erase the two kind of links to make sure the link is removed from the link cache
       NS_LOG_DEBUG ("Erase the route");
       m_linkCache.erase (link1);
+      ForgetLink (link1);
       /// \todo get rid of this one
       NS_LOG_DEBUG ("The link cache size " << m_linkCache.size ());
       m_linkCache.erase (link2);
+      ForgetLink (link2);
       NS_LOG_DEBUG ("The link cache size " << m_linkCache.size ());
 
       std::map<Ipv4Address, DsrNodeStab>::iterator i = m_nodeCache.find (errorSrc);
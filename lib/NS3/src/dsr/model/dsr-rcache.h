@@ -34,6 +34,7 @@
 #define DSR_RCACHE_H
 
 #include <map>
+#include <list>
 #include <stdint.h>
 #include <cassert>
 #include <sys/types.h>
@@ -462,6 +463,23 @@ public:
   {
     m_maxEntriesEachDst = entries;
   }
+  /**
+   * Get the maximum number of links in the link cache
+   * \returns the maximum number of links, 0 for no limit
+   */
+  uint32_t GetMaxLinkCacheLen () const
+  {
+    return m_maxLinkCacheLen;
+  }
+  /**
+   * Set the maximum number of links in the link cache, the least recently
+   * used links being evicted first
+   * \param len the maximum number of links, 0 for no limit
+   */
+  void SetMaxLinkCacheLen (uint32_t len)
+  {
+    m_maxLinkCacheLen = len;
+  }
   /**
    * Get bad link lifetime function
    * \returns the bad link lifetime
@@ -771,15 +789,34 @@ private:
    */
   #define MAXWEIGHT 0xFFFF;
   /**
-   * Current network graph state for this node, double is weight, which is calculated by the node information
-   * and link information, any time some changes of link cache and node cache
-   * change the weight and then recompute the best choice for each node
+   * Current network graph state for this node, as adjacency arrays over node ids
+   * given in address order: the edges of node i are the ones from m_netGraphOffsets[i]
+   * to m_netGraphOffsets[i + 1]. Any time the link cache changes, the graph is rebuilt
+   * and so are the best routes.
+   */
+  std::vector<Ipv4Address> m_netGraphNodes;                                        ///< address of each node id
+  std::vector<uint32_t> m_netGraphOffsets;                                         ///< first edge of each node id
+  std::vector<uint32_t> m_netGraphEdges;                                           ///< node id at the end of each edge
+  std::vector<uint32_t> m_netGraphWeights;                                         ///< weight of each edge
+  std::vector<Time> m_netGraphStability;                                           ///< link stability of each edge when the graph was built
+
+  /**
+   * The state of the Dijkstra algorithm computing the best routes from m_netGraphNodes.
+   * It only runs until the destination looked up is reached, and carries on from there
+   * for the next lookups, until the graph changes.
    */
-  std::map<Ipv4Address, std::map<Ipv4Address, uint32_t> > m_netGraph;
+  uint32_t m_bestRoutesSource;                                                     ///< node id of the source, or the number of nodes
+  std::vector<uint32_t> m_bestRoutesDistance;                                      ///< shortest-path estimate of each node id
+  std::vector<uint32_t> m_bestRoutesPre;                                           ///< preceding node id on the best route
+  std::vector<Time> m_bestRoutesPreStability;                                      ///< stability of the link from the preceding node
+  std::vector<bool> m_bestRoutesDone;                                              ///< whether the best route to each node id is known
+  std::vector<std::pair<uint32_t, uint32_t> > m_bestRoutesHeap;                    ///< heap of (distance, node id) still to visit
 
-  std::map<Ipv4Address, DsrRouteCacheEntry::IP_VECTOR> m_bestRoutesTable_link;     ///< for link route cache
   std::map<Link, DsrLinkStab> m_linkCache;                                         ///< The data structure to store link info
   std::map<Ipv4Address, DsrNodeStab> m_nodeCache;                                  ///< The data structure to store node info
+  uint32_t m_maxLinkCacheLen;                                                      ///< The maximum number of links in the link cache, 0 for no limit
+  std::list<Link> m_linkUse;                                                       ///< The links of the link cache, most recently used first
+  std::map<Link, std::list<Link>::iterator> m_linkUsePos;                          ///< The position of each link in m_linkUse
   /**
    * \brief used by LookupRoute when LinkCache
    * \param id the ip address we are looking for
@@ -799,6 +836,22 @@ private:
    * \return true if success
    */
   bool DecStability (Ipv4Address node);
+  /**
+   * \brief Marks a link of the link cache as the most recently used one, and evicts
+   * the least recently used links if the link cache is full
+   * \param link the link
+   */
+  void TouchLink (Link const & link);
+  /**
+   * \brief Forgets about the use of a link removed from the link cache
+   * \param link the link
+   */
+  void ForgetLink (Link const & link);
+  /**
+   * \brief Runs the Dijkstra algorithm on m_netGraphNodes until the best route to a node is known
+   * \param id the node id
+   */
+  void SettleBestRoute (uint32_t id);
 
 public:
   /**
@@ -821,8 +874,9 @@ public:
   bool AddRoute_Link (DsrRouteCacheEntry::IP_VECTOR nodelist, Ipv4Address node);
   /**
    *  \brief Rebuild the best route table
-   *  \note Use MAXWEIGHT to represeant maximum weight, use the IPv4 broadcast
-   *        address of 255.255.255.255 to represent a null preceding address
+   *
+   *  The routes are computed from the current network graph when they are
+   *  looked up, so this only resets them.
    *  \param source The source address used for computing the routes
    */
   void RebuildBestRouteTable (Ipv4Address source);
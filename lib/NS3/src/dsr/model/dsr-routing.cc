@@ -171,6 +171,13 @@ TypeId DsrRouting::GetTypeId ()
                    UintegerValue (20),
                    MakeUintegerAccessor (&DsrRouting::m_maxEntriesEachDst),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxLinkCacheLen",
+                   "Maximum number of links that can be stored in the "
+                   "link cache, the least recently used ones being evicted "
+                   "first; 0 means no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DsrRouting::m_maxLinkCacheLen),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("SendBuffInterval",
                    "How often to check send buffer for packet with route.",
                    TimeValue (Seconds (500)),
@@ -480,6 +487,7 @@ void DsrRouting::Start ()
               routeCache->SetMaxCacheLen (m_maxCacheLen);
               routeCache->SetCacheTimeout (m_maxCacheTime);
               routeCache->SetMaxEntriesEachDst (m_maxEntriesEachDst);
+              routeCache->SetMaxLinkCacheLen (m_maxLinkCacheLen);
               // Parameters for link cache
               routeCache->SetStabilityDecrFactor (m_stabilityDecrFactor);
               routeCache->SetStabilityIncrFactor (m_stabilityIncrFactor);
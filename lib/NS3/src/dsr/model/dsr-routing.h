@@ -741,6 +741,8 @@ private:
 
   uint32_t  m_maxEntriesEachDst;                        ///< Max number of route entries to save for each destination
 
+  uint32_t  m_maxLinkCacheLen;                          ///< Max number of links in the link cache
+
   DsrMaintainBuffer m_maintainBuffer;                   ///< The declaration of maintain buffer
 
   uint32_t m_requestId;                                 ///< The id assigned to each route request
@@ -438,6 +438,75 @@ DsrCacheEntryTest::DoRun ()
   NS_TEST_EXPECT_MSG_EQ (rcache->DeleteRoute (Ipv4Address ("1.1.1.1")), false, "trivial");
 }
 // -----------------------------------------------------------------------------
+/**
+ * \ingroup dsr-test
+ * \ingroup tests
+ *
+ * \class DsrLinkCacheTest
+ * \brief Unit test for DSR link cache
+ */
+class DsrLinkCacheTest : public TestCase
+{
+public:
+  DsrLinkCacheTest ();
+  ~DsrLinkCacheTest ();
+  virtual void
+  DoRun (void);
+};
+DsrLinkCacheTest::DsrLinkCacheTest ()
+  : TestCase ("DSR link cache")
+{
+}
+DsrLinkCacheTest::~DsrLinkCacheTest ()
+{
+}
+void
+DsrLinkCacheTest::DoRun ()
+{
+  Ptr<dsr::DsrRouteCache> rcache = CreateObject<dsr::DsrRouteCache> ();
+  rcache->SetCacheType ("LinkCache");
+  rcache->SetInitStability (Seconds (25));
+  rcache->SetMinLifeTime (Seconds (1));
+  rcache->SetStabilityDecrFactor (2);
+  rcache->SetStabilityIncrFactor (4);
+  rcache->SetCacheTimeout (Seconds (300));
+
+  std::vector<Ipv4Address> ip;
+  ip.push_back (Ipv4Address ("0.0.0.1"));
+  ip.push_back (Ipv4Address ("0.0.0.2"));
+  ip.push_back (Ipv4Address ("0.0.0.3"));
+  ip.push_back (Ipv4Address ("0.0.0.4"));
+  NS_TEST_EXPECT_MSG_EQ (rcache->AddRoute_Link (ip, Ipv4Address ("0.0.0.1")), true, "trivial");
+  std::vector<Ipv4Address> ip2;
+  ip2.push_back (Ipv4Address ("0.0.0.1"));
+  ip2.push_back (Ipv4Address ("0.0.0.5"));
+  ip2.push_back (Ipv4Address ("0.0.0.4"));
+  NS_TEST_EXPECT_MSG_EQ (rcache->AddRoute_Link (ip2, Ipv4Address ("0.0.0.1")), true, "trivial");
+
+  dsr::DsrRouteCacheEntry entry;
+  NS_TEST_EXPECT_MSG_EQ (rcache->LookupRoute (Ipv4Address ("0.0.0.4"), entry), true, "Route to 0.0.0.4");
+  NS_TEST_EXPECT_MSG_EQ (entry.GetVector ().size (), 3, "Shortest route to 0.0.0.4");
+  NS_TEST_EXPECT_MSG_EQ (entry.GetVector ()[1], Ipv4Address ("0.0.0.5"), "Shortest route to 0.0.0.4");
+  NS_TEST_EXPECT_MSG_EQ (rcache->LookupRoute (Ipv4Address ("0.0.0.3"), entry), true, "Route to 0.0.0.3");
+  NS_TEST_EXPECT_MSG_EQ (entry.GetVector ().size (), 3, "Shortest route to 0.0.0.3");
+  NS_TEST_EXPECT_MSG_EQ (rcache->LookupRoute (Ipv4Address ("0.0.0.1"), entry), false, "No route to the source");
+  NS_TEST_EXPECT_MSG_EQ (rcache->LookupRoute (Ipv4Address ("0.0.0.6"), entry), false, "No route to unknown node");
+
+  rcache->DeleteAllRoutesIncludeLink (Ipv4Address ("0.0.0.5"), Ipv4Address ("0.0.0.4"), Ipv4Address ("0.0.0.1"));
+  NS_TEST_EXPECT_MSG_EQ (rcache->LookupRoute (Ipv4Address ("0.0.0.4"), entry), true, "Route to 0.0.0.4");
+  NS_TEST_EXPECT_MSG_EQ (entry.GetVector ().size (), 4, "Route to 0.0.0.4 without the broken link");
+
+  // The links from 0.0.0.1 are the least recently used ones
+  rcache->SetMaxLinkCacheLen (3);
+  std::vector<Ipv4Address> ip3;
+  ip3.push_back (Ipv4Address ("0.0.0.2"));
+  ip3.push_back (Ipv4Address ("0.0.0.3"));
+  ip3.push_back (Ipv4Address ("0.0.0.4"));
+  ip3.push_back (Ipv4Address ("0.0.0.6"));
+  NS_TEST_EXPECT_MSG_EQ (rcache->AddRoute_Link (ip3, Ipv4Address ("0.0.0.1")), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (rcache->LookupRoute (Ipv4Address ("0.0.0.4"), entry), false, "Evicted link to 0.0.0.2");
+}
+// -----------------------------------------------------------------------------
 /**
  * \ingroup dsr-test
  * \ingroup tests
@@ -591,6 +660,7 @@ public:
     AddTestCase (new DsrAckReqHeaderTest, TestCase::QUICK);
     AddTestCase (new DsrAckHeaderTest, TestCase::QUICK);
     AddTestCase (new DsrCacheEntryTest, TestCase::QUICK);
+    AddTestCase (new DsrLinkCacheTest, TestCase::QUICK);
     AddTestCase (new DsrSendBuffTest, TestCase::QUICK);
   }
 } g_dsrTestSuite;
@@ -82,6 +82,10 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * When the GlobalRoutingIncrementalSpf global value is true, only the
+   * routers whose shortest paths the topology change may affect run a new
+   * SPF calculation; the others rebuild their routes from their previous
+   * shortest path trees.
    */
   static void RecomputeRoutingTables (void);
 private:
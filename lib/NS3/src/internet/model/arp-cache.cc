@@ -17,6 +17,7 @@
  *
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
+#include <algorithm>
 #include "ns3/assert.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
@@ -57,8 +58,8 @@ ArpCache::GetTypeId (void)
                    MakeTimeChecker ())
     .AddAttribute ("WaitReplyTimeout",
                    "When this timeout expires, "
-                   "the cache entries will be scanned and "
-                   "entries in WaitReply state will resend ArpRequest "
+                   "the cache entries in WaitReply state "
+                   "will resend ArpRequest "
                    "unless MaxRetries has been exceeded, "
                    "in which case the entry is marked dead",
                    TimeValue (Seconds (1)),
@@ -195,12 +196,14 @@ void
 ArpCache::HandleWaitReplyTimeout (void)
 {
   NS_LOG_FUNCTION (this);
-  ArpCache::Entry* entry;
   bool restartWaitReplyTimer = false;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
+  // Iterate over a copy, as the entries marked dead leave the list
+  std::vector<ArpCache::Entry *> waiting (m_waitReplyEntries.begin (), m_waitReplyEntries.end ());
+  std::vector<Ipv4PayloadHeaderPair> pending;
+  for (std::vector<ArpCache::Entry *>::const_iterator i = waiting.begin (); i != waiting.end (); i++)
     {
-      entry = (*i).second;
-      if (entry != 0 && entry->IsWaitReply ())
+      ArpCache::Entry *entry = *i;
+      if (entry->IsWaitReply ())
         {
           if (entry->GetRetries () < m_maxRetries)
             {
@@ -220,17 +223,16 @@ ArpCache::HandleWaitReplyTimeout (void)
                             entry->GetRetries ());
               entry->MarkDead ();
               entry->ClearRetries ();
-              Ipv4PayloadHeaderPair pending = entry->DequeuePending ();
-              while (pending.first != 0)
+              pending.clear ();
+              entry->DequeueAllPending (pending);
+              for (std::vector<Ipv4PayloadHeaderPair>::iterator j = pending.begin (); j != pending.end (); j++)
                 {
                   // add the Ipv4 header for tracing purposes
-                  pending.first->AddHeader (pending.second);
-                  m_dropTrace (pending.first);
-                  pending = entry->DequeuePending ();
+                  j->first->AddHeader (j->second);
+                  m_dropTrace (j->first);
                 }
             }
         }
-
     }
   if (restartWaitReplyTimer)
     {
@@ -244,11 +246,11 @@ void
 ArpCache::Flush (void)
 {
   NS_LOG_FUNCTION (this);
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
+  for (CacheI i = m_arpCache.GetSlots ().begin (); i != m_arpCache.GetSlots ().end (); i++)
     {
-      delete (*i).second;
+      delete i->value;
     }
-  m_arpCache.erase (m_arpCache.begin (), m_arpCache.end ());
+  m_arpCache.Clear ();
   if (m_waitReplyTimer.IsRunning ())
     {
       NS_LOG_LOGIC ("Stopping WaitReplyTimer at " << Simulator::Now ().GetSeconds () << " due to ArpCache flush");
@@ -262,9 +264,13 @@ ArpCache::PrintArpCache (Ptr<OutputStreamWrapper> stream)
   NS_LOG_FUNCTION (this << stream);
   std::ostream* os = stream->GetStream ();
 
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  for (CacheI i = m_arpCache.GetSlots ().begin (); i != m_arpCache.GetSlots ().end (); i++)
     {
-      *os << i->first << " dev ";
+      if (i->value == 0)
+        {
+          continue;
+        }
+      *os << i->key << " dev ";
       std::string found = Names::FindName (m_device);
       if (Names::FindName (m_device) != "")
         {
@@ -275,17 +281,17 @@ ArpCache::PrintArpCache (Ptr<OutputStreamWrapper> stream)
           *os << static_cast<int> (m_device->GetIfIndex ());
         }
 
-      *os << " lladdr " << i->second->GetMacAddress ();
+      *os << " lladdr " << i->value->GetMacAddress ();
 
-      if (i->second->IsAlive ())
+      if (i->value->IsAlive ())
         {
           *os << " REACHABLE\n";
         }
-      else if (i->second->IsWaitReply ())
+      else if (i->value->IsWaitReply ())
         {
           *os << " DELAY\n";
         }
-      else if (i->second->IsPermanent ())
+      else if (i->value->IsPermanent ())
 	{
 	  *os << " PERMANENT\n";
 	}
@@ -302,10 +308,10 @@ ArpCache::LookupInverse (Address to)
   NS_LOG_FUNCTION (this << to);
 
   std::list<ArpCache::Entry *> entryList;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  for (CacheI i = m_arpCache.GetSlots ().begin (); i != m_arpCache.GetSlots ().end (); i++)
     {
-      ArpCache::Entry *entry = (*i).second;
-      if (entry->GetMacAddress () == to)
+      ArpCache::Entry *entry = i->value;
+      if (entry != 0 && entry->GetMacAddress () == to)
         {
           entryList.push_back (entry);
         }
@@ -318,22 +324,17 @@ ArpCache::Entry *
 ArpCache::Lookup (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  CacheI it = m_arpCache.find (to);
-  if (it != m_arpCache.end ())
-    {
-      return it->second;
-    }
-  return 0;
+  return m_arpCache.Find (to);
 }
 
 ArpCache::Entry *
 ArpCache::Add (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  NS_ASSERT (m_arpCache.find (to) == m_arpCache.end ());
+  NS_ASSERT (m_arpCache.Find (to) == 0);
 
   ArpCache::Entry *entry = new ArpCache::Entry (this);
-  m_arpCache[to] = entry;
+  m_arpCache.Insert (to, entry);
   entry->SetIpv4Address (to);
   return entry;
 }
@@ -342,16 +343,13 @@ void
 ArpCache::Remove (ArpCache::Entry *entry)
 {
   NS_LOG_FUNCTION (this << entry);
-  
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+
+  if (m_arpCache.Find (entry->GetIpv4Address ()) == entry)
     {
-      if ((*i).second == entry)
-        {
-          m_arpCache.erase (i);
-          entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
-          delete entry;
-          return;
-        }
+      m_arpCache.Erase (entry->GetIpv4Address ());
+      entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
+      delete entry;
+      return;
     }
   NS_LOG_WARN ("Entry not found in this ARP Cache");
 }
@@ -359,11 +357,19 @@ ArpCache::Remove (ArpCache::Entry *entry)
 ArpCache::Entry::Entry (ArpCache *arp)
   : m_arp (arp),
     m_state (ALIVE),
+    m_pendingHead (0),
+    m_pendingSize (0),
     m_retries (0)
 {
   NS_LOG_FUNCTION (this << arp);
 }
 
+ArpCache::Entry::~Entry ()
+{
+  NS_LOG_FUNCTION (this);
+  SetState (DEAD);
+}
+
 
 bool 
 ArpCache::Entry::IsDead (void)
@@ -396,7 +402,7 @@ ArpCache::Entry::MarkDead (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_state == ALIVE || m_state == WAIT_REPLY || m_state == DEAD);
-  m_state = DEAD;
+  SetState (DEAD);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -406,7 +412,7 @@ ArpCache::Entry::MarkAlive (Address macAddress)
   NS_LOG_FUNCTION (this << macAddress);
   NS_ASSERT (m_state == WAIT_REPLY);
   m_macAddress = macAddress;
-  m_state = ALIVE;
+  SetState (ALIVE);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -416,7 +422,7 @@ ArpCache::Entry::MarkPermanent (void)
   NS_LOG_FUNCTION (this << m_macAddress);
   NS_ASSERT (!m_macAddress.IsInvalid ());
 
-  m_state = PERMANENT;
+  SetState (PERMANENT);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -429,11 +435,11 @@ ArpCache::Entry::UpdateWaitReply (Ipv4PayloadHeaderPair waiting)
    * we dump the previously waiting packet and
    * replace it with this one.
    */
-  if (m_pending.size () >= m_arp->m_pendingQueueSize)
+  if (m_pendingSize >= m_arp->m_pendingQueueSize)
     {
       return false;
     }
-  m_pending.push_back (waiting);
+  EnqueuePending (waiting);
   return true;
 }
 void 
@@ -441,11 +447,11 @@ ArpCache::Entry::MarkWaitReply (Ipv4PayloadHeaderPair waiting)
 {
   NS_LOG_FUNCTION (this << waiting.first);
   NS_ASSERT (m_state == ALIVE || m_state == DEAD);
-  NS_ASSERT (m_pending.empty ());
+  NS_ASSERT (m_pendingSize == 0);
   NS_ASSERT_MSG (waiting.first, "Can not add a null packet to the ARP queue");
 
-  m_state = WAIT_REPLY;
-  m_pending.push_back (waiting);
+  SetState (WAIT_REPLY);
+  EnqueuePending (waiting);
   UpdateSeen ();
   m_arp->StartWaitReplyTimer ();
 }
@@ -499,6 +505,20 @@ ArpCache::Entry::GetTimeout (void) const
       /* NOTREACHED */
     }
 }
+void
+ArpCache::Entry::SetState (ArpCacheEntryState_e state)
+{
+  NS_LOG_FUNCTION (this << state);
+  if (state == WAIT_REPLY && m_state != WAIT_REPLY)
+    {
+      m_waitReply = m_arp->m_waitReplyEntries.insert (m_arp->m_waitReplyEntries.end (), this);
+    }
+  else if (state != WAIT_REPLY && m_state == WAIT_REPLY)
+    {
+      m_arp->m_waitReplyEntries.erase (m_waitReply);
+    }
+  m_state = state;
+}
 bool 
 ArpCache::Entry::IsExpired (void) const
 {
@@ -516,23 +536,58 @@ ArpCache::Ipv4PayloadHeaderPair
 ArpCache::Entry::DequeuePending (void)
 {
   NS_LOG_FUNCTION (this);
-  if (m_pending.empty ())
+  if (m_pendingSize == 0)
     {
       Ipv4Header h;
       return Ipv4PayloadHeaderPair (0, h);
     }
   else
     {
-      Ipv4PayloadHeaderPair p = m_pending.front ();
-      m_pending.pop_front ();
+      Ipv4PayloadHeaderPair p = m_pending[m_pendingHead];
+      m_pending[m_pendingHead].first = 0;
+      m_pendingHead = (m_pendingHead + 1) % m_pending.size ();
+      m_pendingSize--;
       return p;
     }
 }
+void
+ArpCache::Entry::DequeueAllPending (std::vector<Ipv4PayloadHeaderPair> &pending)
+{
+  NS_LOG_FUNCTION (this);
+  for (; m_pendingSize > 0; m_pendingSize--)
+    {
+      pending.push_back (m_pending[m_pendingHead]);
+      m_pending[m_pendingHead].first = 0;
+      m_pendingHead = (m_pendingHead + 1) % m_pending.size ();
+    }
+}
+void
+ArpCache::Entry::EnqueuePending (Ipv4PayloadHeaderPair waiting)
+{
+  NS_LOG_FUNCTION (this << waiting.first);
+  if (m_pendingSize == m_pending.size ())
+    {
+      // The ring is full: unroll it and let it grow
+      std::rotate (m_pending.begin (), m_pending.begin () + m_pendingHead, m_pending.end ());
+      m_pendingHead = 0;
+      m_pending.push_back (waiting);
+    }
+  else
+    {
+      m_pending[(m_pendingHead + m_pendingSize) % m_pending.size ()] = waiting;
+    }
+  m_pendingSize++;
+}
 void 
 ArpCache::Entry::ClearPendingPacket (void)
 {
   NS_LOG_FUNCTION (this);
-  m_pending.clear ();
+  for (; m_pendingSize > 0; m_pendingSize--)
+    {
+      m_pending[m_pendingHead].first = 0;
+      m_pendingHead = (m_pendingHead + 1) % m_pending.size ();
+    }
+  m_pendingHead = 0;
 }
 void 
 ArpCache::Entry::UpdateSeen (void)
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 #include "ns3/simulator.h"
 #include "ns3/callback.h"
 #include "ns3/packet.h"
@@ -32,8 +33,8 @@
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 #include "ns3/traced-callback.h"
-#include "ns3/sgi-hashmap.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/open-addressing-table.h"
 
 namespace ns3 {
 
@@ -192,6 +193,7 @@ public:
      * \param arp The ArpCache this entry belongs to
      */
     Entry (ArpCache *arp);
+    ~Entry ();
 
     /**
      * \brief Changes the state of this entry to dead
@@ -266,6 +268,11 @@ public:
      *            packets are pending.
      */
     Ipv4PayloadHeaderPair DequeuePending (void);
+    /**
+     * \brief Move all the pending packets to a vector, oldest first
+     * \param pending the vector the pending packets are appended to
+     */
+    void DequeueAllPending (std::vector<Ipv4PayloadHeaderPair> &pending);
     /**
      * \brief Clear the pending packet list
      */
@@ -305,25 +312,41 @@ private:
      * \returns the entry timeout
      */
     Time GetTimeout (void) const;
+    /**
+     * \brief Change the state of the entry
+     *
+     * Keeps the list of entries in WAIT_REPLY state of the cache up to date.
+     *
+     * \param state the new state
+     */
+    void SetState (ArpCacheEntryState_e state);
+    /**
+     * \brief Add a packet at the end of the pending packets
+     * \param waiting the packet and its IPv4 header
+     */
+    void EnqueuePending (Ipv4PayloadHeaderPair waiting);
 
     ArpCache *m_arp; //!< pointer to the ARP cache owning the entry
     ArpCacheEntryState_e m_state; //!< state of the entry
     Time m_lastSeen; //!< last moment a packet from that address has been seen
     Address m_macAddress; //!< entry's MAC address
     Ipv4Address m_ipv4Address; //!< entry's IP address
-    std::list<Ipv4PayloadHeaderPair> m_pending; //!< list of pending packets for the entry's IP
+    std::vector<Ipv4PayloadHeaderPair> m_pending; //!< ring of pending packets for the entry's IP
+    uint32_t m_pendingHead; //!< index of the oldest pending packet in m_pending
+    uint32_t m_pendingSize; //!< number of pending packets
     uint32_t m_retries; //!< rerty counter
+    std::list<Entry *>::iterator m_waitReply; //!< position in the list of entries in WAIT_REPLY state
   };
 
 private:
   /**
    * \brief ARP Cache container
    */
-  typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash> Cache;
+  typedef OpenAddressingTable<Ipv4Address, ArpCache::Entry, Ipv4AddressHash> Cache;
   /**
    * \brief ARP Cache container iterator
    */
-  typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash>::iterator CacheI;
+  typedef std::vector<Cache::Slot>::const_iterator CacheI;
 
   virtual void DoDispose (void);
 
@@ -344,6 +367,11 @@ private:
   void HandleWaitReplyTimeout (void);
   uint32_t m_pendingQueueSize; //!< number of packets waiting for a resolution
   Cache m_arpCache; //!< the ARP cache
+  /**
+   * The entries in WAIT_REPLY state, in the order they started waiting,
+   * so that the wait reply timeout does not scan the whole cache
+   */
+  std::list<ArpCache::Entry *> m_waitReplyEntries;
   TracedCallback<Ptr<const Packet> > m_dropTrace; //!< trace for packets dropped by the ARP cache queue
 };
 
@@ -232,12 +232,13 @@ ArpL3Protocol::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t pro
                                        << " for waiting entry -- flush");
                   Address from_mac = arp.GetSourceHardwareAddress ();
                   entry->MarkAlive (from_mac);
-                  ArpCache::Ipv4PayloadHeaderPair pending = entry->DequeuePending ();
-                  while (pending.first != 0)
+                  std::vector<ArpCache::Ipv4PayloadHeaderPair> pending;
+                  entry->DequeueAllPending (pending);
+                  for (std::vector<ArpCache::Ipv4PayloadHeaderPair>::iterator it = pending.begin ();
+                       it != pending.end (); it++)
                     {
-                      cache->GetInterface ()->Send (pending.first, pending.second,
+                      cache->GetInterface ()->Send (it->first, it->second,
                                                     arp.GetSourceIpv4Address ());
-                      pending = entry->DequeuePending ();
                     }
                 } 
               else 
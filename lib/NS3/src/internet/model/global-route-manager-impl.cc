@@ -27,9 +27,15 @@
 #include <queue>
 #include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <functional>
+#include <atomic>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/node-list.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
@@ -39,11 +45,35 @@
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
 #include "ipv4-global-routing.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \ingroup globalrouting
+ * The number of threads computing the routes of the routers.
+ */
+static GlobalValue g_spfThreads ("GlobalRoutingSpfThreads",
+                                 "The number of threads computing the routes of the "
+                                 "routers in parallel, 1 to compute them in the calling thread",
+                                 UintegerValue (1),
+                                 MakeUintegerChecker<uint32_t> (1));
+
+/**
+ * \ingroup globalrouting
+ * Whether to keep the shortest-path trees, to recompute the routes incrementally.
+ */
+static GlobalValue g_incrementalSpf ("GlobalRoutingIncrementalSpf",
+                                     "Keep the shortest-path tree of each router, so that "
+                                     "RecomputeRoutingTables only runs the SPF calculation of "
+                                     "the routers whose tree may go through a changed link",
+                                     BooleanValue (false),
+                                     MakeBooleanChecker ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -423,6 +453,7 @@ SPFVertex::ClearVertexProcessed (void)
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
   :
     m_database (),
+    m_linkData (),
     m_extdatabase ()
 {
   NS_LOG_FUNCTION (this);
@@ -446,6 +477,7 @@ GlobalRouteManagerLSDB::~GlobalRouteManagerLSDB ()
     }
   NS_LOG_LOGIC ("clear map");
   m_database.clear ();
+  m_linkData.clear ();
 }
 
 void
@@ -470,7 +502,32 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     } 
   else
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+      std::pair<LSDBMap_t::iterator, bool> result = m_database.insert (LSDBPair_t (addr, lsa));
+      if (!result.second)
+        {
+          return;
+        }
+//
+// Index the transit network link records, keeping the LSA which comes first
+// in the database for each link data.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          LinkDataMap_t::iterator k = m_linkData.find (lr->GetLinkData ());
+          if (k == m_linkData.end ())
+            {
+              m_linkData.insert (std::make_pair (lr->GetLinkData (), result.first));
+            }
+          else if (addr < k->second->first)
+            {
+              k->second = result.first;
+            }
+        }
     }
 }
 
@@ -495,13 +552,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,26 +565,28 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of its transit network link records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LinkDataMap_t::const_iterator i = m_linkData.find (addr);
+  if (i != m_linkData.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return i->second->second;
     }
   return 0;
 }
 
+GlobalRouteManagerLSDB::Iterator
+GlobalRouteManagerLSDB::Begin (void) const
+{
+  return m_database.begin ();
+}
+
+GlobalRouteManagerLSDB::Iterator
+GlobalRouteManagerLSDB::End (void) const
+{
+  return m_database.end ();
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerImpl Implementation
@@ -539,7 +595,9 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_rootRouter (0),
+    m_keepTrees (false)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -592,6 +650,7 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
         }
       NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
     }
+  m_spfTrees.clear ();
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
@@ -697,9 +756,69 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 {
   NS_LOG_FUNCTION (this);
 //
-// Walk the list of nodes in the system.
+// Walk the list of nodes in the system, and run the SPF calculation for each
+// of the routers.
 //
   NS_LOG_INFO ("About to start SPF calculation");
+  BooleanValue incremental;
+  g_incrementalSpf.GetValue (incremental);
+  m_keepTrees = incremental.Get ();
+  m_spfTrees.clear ();
+  std::vector<RootRouter> roots;
+  GetRootRouters (roots, false);
+  CalculateRoots (roots, false);
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::RecomputeRoutingTables ()
+{
+  NS_LOG_FUNCTION (this);
+  BooleanValue incremental;
+  g_incrementalSpf.GetValue (incremental);
+  if (!incremental.Get () || m_spfTrees.empty ())
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+//
+// Keep the old LSDB until it has been compared with the new one, to find
+// the routers whose shortest path trees may have changed.  The others
+// rebuild their routes from the trees of the previous calculation.
+//
+  GlobalRouteManagerLSDB *oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  m_keepTrees = true;
+  std::vector<RootRouter> roots;
+  GetRootRouters (roots, true);
+  SetReplayableRoots (oldLsdb, roots);
+  delete oldLsdb;
+  m_spfTrees.clear ();
+  CalculateRoots (roots, true);
+}
+
+/**
+ * Delete all the routes of a global routing protocol.
+ * \param gr the routing protocol
+ */
+static void
+DeleteAllRoutes (Ptr<Ipv4GlobalRouting> gr)
+{
+  // Each time we delete route 0, the route index shifts downward
+  for (uint32_t j = gr->GetNRoutes (); j > 0; j--)
+    {
+      gr->RemoveRoute (0);
+    }
+}
+
+void
+GlobalRouteManagerImpl::GetRootRouters (std::vector<RootRouter> &roots, bool deleteRoutes)
+{
+  NS_LOG_FUNCTION (this << deleteRoutes);
+  uint32_t systemId = MpiInterface::GetSystemId ();
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -710,24 +829,526 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
-
-      uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
+      if (rtr == 0)
         {
           continue;
         }
-
 //
-// if the node has a global router interface, then run the global routing
-// algorithms.
+// if the node has a global router interface and is assigned to our systemId
+// (distributed sim), then run the global routing algorithms.
 //
-      if (rtr && rtr->GetNumLSAs () )
+      if (node->GetSystemId () == systemId && rtr->GetNumLSAs ())
+        {
+          RootRouter root;
+          root.routerId = rtr->GetRouterId ();
+          root.ipv4 = node->GetObject<Ipv4> ();
+          root.routing = rtr->GetRoutingProtocol ();
+          root.replay = false;
+          roots.push_back (root);
+        }
+      else if (deleteRoutes)
         {
-          SPFCalculate (rtr->GetRouterId ());
+          DeleteAllRoutes (rtr->GetRoutingProtocol ());
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+GlobalRouteManagerImpl::RootRouter
+GlobalRouteManagerImpl::GetRootRouter (Ipv4Address routerId)
+{
+  NS_LOG_FUNCTION (this << routerId);
+  RootRouter root;
+  root.routerId = routerId;
+  root.replay = false;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr != 0 && rtr->GetRouterId () == routerId)
+        {
+          root.ipv4 = (*i)->GetObject<Ipv4> ();
+          root.routing = rtr->GetRoutingProtocol ();
+          break;
+        }
+    }
+  return root;
+}
+
+/**
+ * \ingroup globalrouting
+ *
+ * The SPF calculations shared by the threads of CalculateRoots.
+ */
+struct GlobalRouteManagerImpl::SPFJob
+{
+  std::vector<RootRouter> *roots; //!< the routers to compute the routes of
+  bool deleteRoutes;              //!< whether to delete their routes first
+  std::atomic<uint32_t> next;     //!< the index of the next router to take
+};
+
+void
+GlobalRouteManagerImpl::CalculateRoots (std::vector<RootRouter> &roots, bool deleteRoutes)
+{
+  NS_LOG_FUNCTION (this << roots.size () << deleteRoutes);
+  SPFJob job;
+  job.roots = &roots;
+  job.deleteRoutes = deleteRoutes;
+  job.next = 0;
+
+  UintegerValue nThreads;
+  g_spfThreads.GetValue (nThreads);
+  std::vector<GlobalRouteManagerImpl *> helpers;
+#ifdef HAVE_PTHREAD_H
+//
+// Each helper thread has a route manager of its own for the state of its
+// calculations, reading our LSDB.  The routers are handed out one at a
+// time, and each calculation only writes to the routing table of its root.
+//
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < nThreads.Get () && i < roots.size (); i++)
+    {
+      GlobalRouteManagerImpl *helper = new GlobalRouteManagerImpl ();
+      delete helper->m_lsdb;
+      helper->m_lsdb = m_lsdb;
+      helper->m_keepTrees = m_keepTrees;
+      helpers.push_back (helper);
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&GlobalRouteManagerImpl::SPFJobThread,
+                                                                          std::make_pair (helper, &job)));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+#else
+  if (nThreads.Get () > 1)
+    {
+      NS_LOG_WARN ("No thread support, running the SPF calculations in the calling thread");
+    }
+#endif
+  RunSPFJob (&job);
+#ifdef HAVE_PTHREAD_H
+  for (std::vector<Ptr<SystemThread> >::iterator i = threads.begin (); i != threads.end (); i++)
+    {
+      (*i)->Join ();
+    }
+#endif
+  for (std::vector<GlobalRouteManagerImpl *>::iterator i = helpers.begin (); i != helpers.end (); i++)
+    {
+      (*i)->m_lsdb = 0;
+      delete *i;
+    }
+
+  if (m_keepTrees)
+    {
+      for (std::vector<RootRouter>::iterator i = roots.begin (); i != roots.end (); i++)
+        {
+          std::swap (m_spfTrees[i->routerId], i->tree);
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::RunSPFJob (SPFJob *job)
+{
+  NS_LOG_FUNCTION (this << job);
+  for (uint32_t i = job->next++; i < job->roots->size (); i = job->next++)
+    {
+      RootRouter &root = (*job->roots)[i];
+      if (job->deleteRoutes && root.routing != 0)
+        {
+          DeleteAllRoutes (root.routing);
+        }
+      if (!root.replay || !SPFReplay (root))
+        {
+          SPFCalculate (root);
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFJobThread (std::pair<GlobalRouteManagerImpl *, SPFJob *> args)
+{
+  args.first->RunSPFJob (args.second);
+}
+
+namespace {
+
+/**
+ * \ingroup globalrouting
+ *
+ * An edge of the graph the SPF calculation runs on: a link from a router
+ * to another router or to a transit network, or from a transit network to
+ * one of its routers.  Two edges are the same if they lead to the same
+ * next hops.
+ */
+struct SPFEdge
+{
+  Ipv4Address from;  //!< the vertex ID of the router or network
+  Ipv4Address to;    //!< the vertex ID of the neighbor
+  uint32_t metric;   //!< the cost of the link
+  Ipv4Address data;  //!< the interface address of the link
+  uint32_t mask;     //!< the network mask of a network, zero for a router
+};
+
+/**
+ * \param a an edge
+ * \param b another edge
+ * \return true if a comes before b
+ */
+bool
+operator < (const SPFEdge &a, const SPFEdge &b)
+{
+  if (a.from != b.from)
+    {
+      return a.from < b.from;
+    }
+  if (a.to != b.to)
+    {
+      return a.to < b.to;
+    }
+  if (a.metric != b.metric)
+    {
+      return a.metric < b.metric;
+    }
+  if (a.data != b.data)
+    {
+      return a.data < b.data;
+    }
+  return a.mask < b.mask;
+}
+
+/**
+ * Get the edges of the graph described by an LSDB.
+ * \param lsdb the LSDB
+ * \param [out] edges the edges, in the order of the LSDB and of the link
+ *              records of each LSA
+ */
+void
+GetSPFEdges (const GlobalRouteManagerLSDB *lsdb, std::vector<SPFEdge> &edges)
+{
+  for (GlobalRouteManagerLSDB::Iterator i = lsdb->Begin (); i != lsdb->End (); i++)
+    {
+      GlobalRoutingLSA *lsa = i->second;
+      SPFEdge edge;
+      edge.from = lsa->GetLinkStateId ();
+      if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+        {
+          edge.mask = 0;
+          for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+            {
+              GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+                  || l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  edge.to = l->GetLinkId ();
+                  edge.metric = l->GetMetric ();
+                  edge.data = l->GetLinkData ();
+                  edges.push_back (edge);
+                }
+            }
+        }
+      else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+        {
+          edge.metric = 0;
+          edge.mask = lsa->GetNetworkLSANetworkMask ().Get ();
+          for (uint32_t j = 0; j < lsa->GetNAttachedRouters (); j++)
+            {
+              GlobalRoutingLSA *w = lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (j));
+              if (w != 0)
+                {
+                  edge.to = w->GetLinkStateId ();
+                  edge.data = lsa->GetAttachedRouter (j);
+                  edges.push_back (edge);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Remove some edges from a list, keeping the order of the others.
+ * \param edges the edges
+ * \param dropped the edges to remove, sorted; an edge listed n times is
+ *        removed n times
+ * \param [out] kept the other edges, in their order in the list
+ */
+void
+DropSPFEdges (const std::vector<SPFEdge> &edges, const std::vector<SPFEdge> &dropped,
+              std::vector<SPFEdge> &kept)
+{
+  std::map<SPFEdge, uint32_t> count;
+  for (std::vector<SPFEdge>::const_iterator i = dropped.begin (); i != dropped.end (); i++)
+    {
+      count[*i]++;
+    }
+  for (std::vector<SPFEdge>::const_iterator i = edges.begin (); i != edges.end (); i++)
+    {
+      std::map<SPFEdge, uint32_t>::iterator c = count.find (*i);
+      if (c != count.end () && c->second > 0)
+        {
+          c->second--;
+        }
+      else
+        {
+          kept.push_back (*i);
+        }
+    }
+}
+
+/**
+ * \param a a list of edges
+ * \param b another list of edges
+ * \return true if both lists have the same edges, in the same order
+ */
+bool
+SameSPFEdges (const std::vector<SPFEdge> &a, const std::vector<SPFEdge> &b)
+{
+  if (a.size () != b.size ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a.size (); i++)
+    {
+      if (a[i] < b[i] || b[i] < a[i])
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/**
+ * \ingroup globalrouting
+ *
+ * The graph described by an LSDB, giving the distances from all the
+ * vertices to a vertex, found with Dijkstra's algorithm on the reversed
+ * edges.
+ */
+class SPFGraph
+{
+public:
+  /**
+   * Constructor.
+   * \param edges the edges of the graph, sorted
+   */
+  SPFGraph (const std::vector<SPFEdge> &edges)
+  {
+    for (std::vector<SPFEdge>::const_iterator i = edges.begin (); i != edges.end (); i++)
+      {
+        uint32_t from = AddVertex (i->from);
+        uint32_t to = AddVertex (i->to);
+        m_incoming[to].push_back (std::make_pair (from, i->metric));
+        m_neighbors[from].push_back (to);
+      }
+  }
+  /**
+   * \param id a vertex ID
+   * \return the index of the vertex, or GetN () if it is not in the graph
+   */
+  uint32_t GetIndex (Ipv4Address id) const
+  {
+    std::map<Ipv4Address, uint32_t>::const_iterator i = m_index.find (id);
+    return i != m_index.end () ? i->second : GetN ();
+  }
+  /**
+   * \return the number of vertices
+   */
+  uint32_t GetN (void) const
+  {
+    return m_index.size ();
+  }
+  /**
+   * \param v the index of a vertex
+   * \return the indices of the vertices the edges from v reach
+   */
+  const std::vector<uint32_t> &GetNeighbors (uint32_t v) const
+  {
+    return m_neighbors[v];
+  }
+  /**
+   * \param from the index of a vertex
+   * \param to the ID of another vertex
+   * \return the distance from one vertex to the other, or
+   *         SPF_INFINITY if there is no path
+   */
+  uint32_t GetDistance (uint32_t from, Ipv4Address to)
+  {
+    uint32_t target = GetIndex (to);
+    if (from == GetN () || target == GetN ())
+      {
+        return SPF_INFINITY;
+      }
+    std::map<uint32_t, std::vector<uint32_t> >::iterator d = m_distances.find (target);
+    if (d == m_distances.end ())
+      {
+        d = m_distances.insert (std::make_pair (target, std::vector<uint32_t> ())).first;
+        FindDistances (target, d->second);
+      }
+    return d->second[from];
+  }
+
+private:
+  /**
+   * \param id a vertex ID
+   * \return the index of the vertex, added if it was not in the graph
+   */
+  uint32_t AddVertex (Ipv4Address id)
+  {
+    std::pair<std::map<Ipv4Address, uint32_t>::iterator, bool> i = m_index.insert (std::make_pair (id, GetN ()));
+    if (i.second)
+      {
+        m_incoming.push_back (std::vector<std::pair<uint32_t, uint32_t> > ());
+        m_neighbors.push_back (std::vector<uint32_t> ());
+      }
+    return i.first->second;
+  }
+  /**
+   * Find the distances from all the vertices to a vertex.
+   * \param target the index of the vertex
+   * \param [out] distances the distances, by vertex index
+   */
+  void FindDistances (uint32_t target, std::vector<uint32_t> &distances) const
+  {
+    typedef std::pair<uint64_t, uint32_t> Candidate;
+    distances.assign (GetN (), SPF_INFINITY);
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate> > candidates;
+    distances[target] = 0;
+    candidates.push (Candidate (0, target));
+    while (!candidates.empty ())
+      {
+        Candidate c = candidates.top ();
+        candidates.pop ();
+        if (c.first > distances[c.second])
+          {
+            continue;
+          }
+        const std::vector<std::pair<uint32_t, uint32_t> > &incoming = m_incoming[c.second];
+        for (uint32_t i = 0; i < incoming.size (); i++)
+          {
+            uint64_t distance = c.first + incoming[i].second;
+            if (distance < distances[incoming[i].first])
+              {
+                distances[incoming[i].first] = distance;
+                candidates.push (Candidate (distance, incoming[i].first));
+              }
+          }
+      }
+  }
+
+  std::map<Ipv4Address, uint32_t> m_index;                               //!< the vertex indices, by ID
+  std::vector<std::vector<std::pair<uint32_t, uint32_t> > > m_incoming;  //!< the edges to each vertex, with their metrics
+  std::vector<std::vector<uint32_t> > m_neighbors;                       //!< the vertices the edges from each vertex reach
+  std::map<uint32_t, std::vector<uint32_t> > m_distances;                //!< the distances to the vertices found so far
+};
+
+} // anonymous namespace
+
+void
+GlobalRouteManagerImpl::SetReplayableRoots (const GlobalRouteManagerLSDB *oldLsdb, std::vector<RootRouter> &roots)
+{
+  NS_LOG_FUNCTION (this << oldLsdb << roots.size ());
+//
+// Find the edges the new LSDB removed or added.  The shortest path tree of
+// a router can only change if one of these was on a shortest path from it,
+// or if it provides a path at most as short as the existing one.  A change
+// of the links of the router, or of those of its neighbors, also changes
+// the next hops it finds.
+//
+// The routes must also come in the order a full calculation would add
+// them, which is the order the vertices leave the candidate queue.  Among
+// vertices at the same distance, that is the order in which they reached
+// it, through the edges on shortest paths, examined in the order of the
+// link records.  Since these edges are kept, the order is too, as long as
+// the link records kept by each LSA are in the same order.
+//
+  std::vector<SPFEdge> oldOrder;
+  std::vector<SPFEdge> newOrder;
+  GetSPFEdges (oldLsdb, oldOrder);
+  GetSPFEdges (m_lsdb, newOrder);
+  std::vector<SPFEdge> oldEdges (oldOrder);
+  std::vector<SPFEdge> newEdges (newOrder);
+  std::sort (oldEdges.begin (), oldEdges.end ());
+  std::sort (newEdges.begin (), newEdges.end ());
+  std::vector<SPFEdge> removed;
+  std::vector<SPFEdge> added;
+  std::set_difference (oldEdges.begin (), oldEdges.end (), newEdges.begin (), newEdges.end (),
+                       std::back_inserter (removed));
+  std::set_difference (newEdges.begin (), newEdges.end (), oldEdges.begin (), oldEdges.end (),
+                       std::back_inserter (added));
+  NS_LOG_LOGIC (removed.size () << " links removed, " << added.size () << " links added");
+
+  std::vector<SPFEdge> oldKept;
+  std::vector<SPFEdge> newKept;
+  DropSPFEdges (oldOrder, removed, oldKept);
+  DropSPFEdges (newOrder, added, newKept);
+  if (!SameSPFEdges (oldKept, newKept))
+    {
+      NS_LOG_LOGIC ("The link records were reordered, recomputing all the trees");
+      return;
+    }
+
+  SPFGraph graph (oldEdges);
+  std::vector<bool> changed (graph.GetN () + 1, false);
+  for (std::vector<SPFEdge>::const_iterator e = removed.begin (); e != removed.end (); e++)
+    {
+      changed[graph.GetIndex (e->from)] = true;
+      changed[graph.GetIndex (e->to)] = true;
+    }
+  for (std::vector<SPFEdge>::const_iterator e = added.begin (); e != added.end (); e++)
+    {
+      changed[graph.GetIndex (e->from)] = true;
+      changed[graph.GetIndex (e->to)] = true;
+    }
+
+  uint32_t nReplays = 0;
+  for (std::vector<RootRouter>::iterator root = roots.begin (); root != roots.end (); root++)
+    {
+      std::map<Ipv4Address, SPFTree>::iterator tree = m_spfTrees.find (root->routerId);
+      if (tree == m_spfTrees.end () || tree->second.ids.empty ())
+        {
+          continue;
+        }
+      root->tree.ids.swap (tree->second.ids);
+      root->tree.exitsBegin.swap (tree->second.exitsBegin);
+      root->tree.exits.swap (tree->second.exits);
+      root->tree.childrenBegin.swap (tree->second.childrenBegin);
+      root->tree.children.swap (tree->second.children);
+
+      uint32_t r = graph.GetIndex (root->routerId);
+      bool replay = r != graph.GetN () && !changed[r];
+      for (uint32_t i = 0; replay && r != graph.GetN () && i < graph.GetNeighbors (r).size (); i++)
+        {
+          replay = !changed[graph.GetNeighbors (r)[i]];
+        }
+      for (std::vector<SPFEdge>::const_iterator e = removed.begin (); replay && e != removed.end (); e++)
+        {
+          uint64_t from = graph.GetDistance (r, e->from);
+          replay = from == SPF_INFINITY || from + e->metric != graph.GetDistance (r, e->to);
+        }
+      for (std::vector<SPFEdge>::const_iterator e = added.begin (); replay && e != added.end (); e++)
+        {
+          uint64_t from = graph.GetDistance (r, e->from);
+          replay = from == SPF_INFINITY || from + e->metric > graph.GetDistance (r, e->to);
+        }
+      root->replay = replay;
+      nReplays += replay;
+    }
+  NS_LOG_INFO ("Replaying the SPF trees of " << nReplays << " of " << roots.size () << " routers");
+}
+
+GlobalRoutingLSA::SPFStatus
+GlobalRouteManagerImpl::GetLSAStatus (GlobalRoutingLSA *lsa) const
+{
+  std::map<GlobalRoutingLSA *, GlobalRoutingLSA::SPFStatus>::const_iterator i = m_lsaStatus.find (lsa);
+  if (i == m_lsaStatus.end ())
+    {
+      return GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED;
+    }
+  return i->second;
+}
+
+void
+GlobalRouteManagerImpl::SetLSAStatus (GlobalRoutingLSA *lsa, GlobalRoutingLSA::SPFStatus status)
+{
+  m_lsaStatus[lsa] = status;
 }
 
 //
@@ -836,7 +1457,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If the link is to a router that is already in the shortest path first tree
 // then we have it covered -- ignore it.
 //
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
         {
           NS_LOG_LOGIC ("Skipping ->  LSA "<< 
                         w_lsa->GetLinkStateId () << " already in SPF tree");
@@ -861,7 +1482,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
       NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
 
 // Is there already vertex w in candidate list?
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
 // Calculate nexthop to w
 // We need to figure out how to actually get to the new router represented
@@ -873,7 +1494,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
           w = new SPFVertex (w_lsa);
           if (SPFNexthopCalculation (v, w, l, distance))
             {
-              w_lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+              SetLSAStatus (w_lsa, GlobalRoutingLSA::LSA_SPF_CANDIDATE);
 //
 // Push this new vertex onto the priority queue (ordered by distance from the
 // root node).
@@ -888,7 +1509,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
             NS_ASSERT_MSG (0, "SPFNexthopCalculation never " 
                            << "return false, but it does now!");
         }
-      else if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+      else if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
 //
 // We have already considered the link represented by <w>.  What wse have to
@@ -1247,7 +1868,8 @@ void
 GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
-  SPFCalculate (root);
+  RootRouter router = GetRootRouter (root);
+  SPFCalculate (router);
 }
 
 //
@@ -1320,9 +1942,7 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+                  Ptr<Ipv4GlobalRouting> gr = m_rootRouter->routing;
                   NS_ASSERT (gr);
                   gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
                                          FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1339,15 +1959,18 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
 
 // quagga ospf_spf_calculate
 void
-GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
+GlobalRouteManagerImpl::SPFCalculate (RootRouter &root)
 {
-  NS_LOG_FUNCTION (this << root);
+  NS_LOG_FUNCTION (this << root.routerId);
 
   SPFVertex *v;
 //
-// Initialize the Link State Database.
+// Initialize the status of the LSAs.  It is kept here rather than in the
+// Link State Database, which may be shared with other calculations.
 //
-  m_lsdb->Initialize ();
+  m_lsaStatus.clear ();
+  m_rootRouter = &root;
+  root.tree = SPFTree ();
 //
 // The candidate queue is a priority queue of SPFVertex objects, with the top
 // of the queue being the closest vertex in terms of distance from the root
@@ -1360,15 +1983,15 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // calculation.  Each router (and corresponding network) is a vertex in the
 // shortest path first (SPF) tree.
 //
-  v = new SPFVertex (m_lsdb->GetLSA (root));
+  v = new SPFVertex (m_lsdb->GetLSA (root.routerId));
 // 
 // This vertex is the root of the SPF tree and it is distance 0 from the root.
 // We also mark this vertex as being in the SPF tree.
 //
   m_spfroot= v;
   v->SetDistanceFromRoot (0);
-  v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
-  NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
+  SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  NS_LOG_LOGIC ("Starting SPFCalculate for node " << root.routerId);
 
 //
 // Optimize SPF calculation, for ns-3.
@@ -1377,12 +2000,18 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (root.routing != 0 && CheckForStubNode (root.routerId))
     {
-      NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
+      NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root.routerId);
       delete m_spfroot;
+      m_spfroot = 0;
+      m_rootRouter = 0;
       return;
     }
+  if (m_keepTrees)
+    {
+      m_spfOrder.push_back (v);
+    }
 
   for (;;)
     {
@@ -1428,7 +2057,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
 //
-      v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      if (m_keepTrees)
+        {
+          m_spfOrder.push_back (v);
+        }
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1444,12 +2077,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
 // RFC2328 16.1. (4). 
 //
-// This is the method that actually adds the routes.  It'll walk the list
-// of nodes in the system, looking for the node corresponding to the router
-// ID of the root of the tree -- that is the router we're building the routes
-// for.  It looks for the Ipv4 interface of that node and remembers it.  So
-// we are only actually adding routes to that one node at the root of the SPF 
-// tree.
+// This is the method that actually adds the routes, to the routing protocol
+// of the router at the root of the tree -- that is the router we're building
+// the routes for.  So we are only actually adding routes to that one node at
+// the root of the SPF tree.
 //
 // We're going to pop of a pointer to every vertex in the tree except the 
 // root in order of distance from the root.  For each of the vertices, we call
@@ -1486,13 +2117,16 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
     }  // end for loop
 
 // Second stage of SPF calculation procedure
-  SPFProcessStubs (m_spfroot);
-  for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
+  SPFAddStubsAndExternals ();
+
+//
+// Keep the shape of the tree, to rebuild the routes from it if a later
+// change of the topology does not affect it.
+//
+  if (m_keepTrees)
     {
-      m_spfroot->ClearVertexProcessed ();
-      GlobalRoutingLSA *extlsa = m_lsdb->GetExtLSA (i);
-      NS_LOG_LOGIC ("Processing External LSA with id " << extlsa->GetLinkStateId ());
-      ProcessASExternals (m_spfroot, extlsa);
+      SPFKeepTree (root.tree);
+      m_spfOrder.clear ();
     }
 
 //
@@ -1502,6 +2136,128 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_rootRouter = 0;
+  m_lsaStatus.clear ();
+}
+
+bool
+GlobalRouteManagerImpl::SPFReplay (RootRouter &root)
+{
+  NS_LOG_FUNCTION (this << root.routerId);
+  const SPFTree &tree = root.tree;
+  uint32_t n = tree.ids.size ();
+  NS_ASSERT (n > 0 && tree.ids[0] == root.routerId);
+//
+// The LSAs of the tree must still be there; the topology change may have
+// removed a router without affecting the distances from this one.
+//
+  std::vector<GlobalRoutingLSA *> lsas (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      lsas[i] = m_lsdb->GetLSA (tree.ids[i]);
+      if (lsas[i] == 0)
+        {
+          NS_LOG_LOGIC ("Vertex " << tree.ids[i] << " of the tree of " << root.routerId << " is gone");
+          return false;
+        }
+    }
+  NS_LOG_LOGIC ("Replaying SPF tree of node " << root.routerId);
+  std::vector<SPFVertex *> vertices (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      vertices[i] = new SPFVertex (lsas[i]);
+    }
+//
+// Link the vertices as they were.  The root exits and the parents of a
+// vertex are kept sorted, so merging them one by one gives the same lists,
+// and the children were added in the order they joined the tree.
+//
+  for (uint32_t i = 0; i < n; i++)
+    {
+      SPFVertex *v = vertices[i];
+      for (uint32_t j = tree.exitsBegin[i]; j < tree.exitsBegin[i + 1]; j++)
+        {
+          SPFVertex exit;
+          exit.SetRootExitDirection (tree.exits[j]);
+          v->MergeRootExitDirections (&exit);
+        }
+      for (uint32_t j = tree.childrenBegin[i]; j < tree.childrenBegin[i + 1]; j++)
+        {
+          SPFVertex *child = vertices[tree.children[j]];
+          SPFVertex parent;
+          parent.SetParent (v);
+          child->MergeParent (&parent);
+          v->AddChild (child);
+        }
+    }
+
+  m_rootRouter = &root;
+  m_spfroot = vertices[0];
+  for (uint32_t i = 1; i < n; i++)
+    {
+      if (vertices[i]->GetVertexType () == SPFVertex::VertexRouter)
+        {
+          SPFIntraAddRouter (vertices[i]);
+        }
+      else if (vertices[i]->GetVertexType () == SPFVertex::VertexNetwork)
+        {
+          SPFIntraAddTransit (vertices[i]);
+        }
+      else
+        {
+          NS_ASSERT_MSG (0, "illegal SPFVertex type");
+        }
+    }
+  SPFAddStubsAndExternals ();
+  delete m_spfroot;
+  m_spfroot = 0;
+  m_rootRouter = 0;
+  return true;
+}
+
+void
+GlobalRouteManagerImpl::SPFAddStubsAndExternals (void)
+{
+  NS_LOG_FUNCTION (this);
+  SPFProcessStubs (m_spfroot);
+  for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      m_spfroot->ClearVertexProcessed ();
+      GlobalRoutingLSA *extlsa = m_lsdb->GetExtLSA (i);
+      NS_LOG_LOGIC ("Processing External LSA with id " << extlsa->GetLinkStateId ());
+      ProcessASExternals (m_spfroot, extlsa);
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFKeepTree (SPFTree &tree) const
+{
+  NS_LOG_FUNCTION (this);
+  std::map<SPFVertex *, uint32_t> index;
+  for (uint32_t i = 0; i < m_spfOrder.size (); i++)
+    {
+      index[m_spfOrder[i]] = i;
+    }
+  tree = SPFTree ();
+  for (uint32_t i = 0; i < m_spfOrder.size (); i++)
+    {
+      SPFVertex *v = m_spfOrder[i];
+      tree.ids.push_back (v->GetVertexId ());
+      tree.exitsBegin.push_back (tree.exits.size ());
+      for (uint32_t j = 0; j < v->GetNRootExitDirections (); j++)
+        {
+          tree.exits.push_back (v->GetRootExitDirection (j));
+        }
+      tree.childrenBegin.push_back (tree.children.size ());
+      for (uint32_t j = 0; j < v->GetNChildren (); j++)
+        {
+          std::map<SPFVertex *, uint32_t>::const_iterator child = index.find (v->GetChild (j));
+          NS_ASSERT (child != index.end ());
+          tree.children.push_back (child->second);
+        }
+    }
+  tree.exitsBegin.push_back (tree.exits.size ());
+  tree.childrenBegin.push_back (tree.children.size ());
 }
 
 void
@@ -1555,63 +2311,31 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
     }
   NS_LOG_LOGIC ("External is on remote host: " 
                 << extlsa->GetAdvertisingRouter () << "; installing");
-
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routing protocol of the router at the root of the SPF tree was looked
+// up before the calculation.  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ipv4Address routerId = m_spfroot->GetVertexId ();
+  Ptr<Ipv4GlobalRouting> gr = m_rootRouter->routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No routing protocol for router " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for router " << routerId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 
 //
 // Here's why we did all of that work.  We're going to add a host route to the
@@ -1626,42 +2350,31 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
-
 // Processing logic from RFC 2328, page 166 and quagga ospf_spf_process_stubs ()
 // stub link records will exist for point-to-point interfaces and for
 // broadcast interfaces for which no neighboring router can be found
@@ -1729,60 +2442,29 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routing protocol of the router at the root of the SPF tree was looked
+// up before the calculation.  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = m_rootRouter->routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No routing protocol for router " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for router " << routerId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1796,46 +2478,36 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
 // Return the interface number corresponding to a given IP address and mask
-// This is a wrapper around GetInterfaceForPrefix(), but we first
-// have to find the right node pointer to pass to that function.
+// on the router at the root of the SPF tree.  This is a wrapper around
+// GetInterfaceForPrefix() on the Ipv4 interface of that router, looked up
+// before the calculation.
 // If no such interface is found, return -1 (note:  unit test framework
 // for routing assumes -1 to be a legal return value)
 //
@@ -1844,70 +2516,34 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 {
   NS_LOG_FUNCTION (this << a << amask);
 //
-// We have an IP address <a> and a vertex ID of the root of the SPF tree.
-// The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// We have an IP address <a> and the root of the SPF tree.  The question is
+// what interface index does this address correspond to on the router at the
+// root, which is the one we are building the routing table for.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4> ipv4 = m_rootRouter != 0 ? m_rootRouter->ipv4 : 0;
+  if (ipv4 == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
 //
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
+// Couldn't find it.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << m_spfroot->GetVertexId ());
+      return -1;
+    }
 //
 // Look through the interfaces on this node for one that has the IP address
 // we're looking for.  If we find one, return the corresponding interface
 // index, or -1 if not found.
 //
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+  int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+#endif 
+  return interface;
 }
 
 //
@@ -1944,60 +2580,29 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routing protocol of the router at the root of the SPF tree was looked
+// up before the calculation.  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = m_rootRouter->routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No routing protocol for router " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for router " << routerId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2611,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Router " << routerId <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,44 +2636,31 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
             }
-//
-// Done adding the routes for the selected node.
-//
-          return;
-        }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
 void
@@ -2089,95 +2681,55 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routing protocol of the router at the root of the SPF tree was looked
+// up before the calculation.  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = m_rootRouter->routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No routing protocol for router " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for router " << routerId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
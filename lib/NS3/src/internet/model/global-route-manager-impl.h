@@ -37,6 +37,7 @@ namespace ns3 {
 const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
+class Ipv4;
 class Ipv4GlobalRouting;
 
 /**
@@ -580,6 +581,9 @@ private:
 class GlobalRouteManagerLSDB
 {
 public:
+  /// Iterator over the Link State Advertisements of the database, by link state ID
+  typedef std::map<Ipv4Address, GlobalRoutingLSA*>::const_iterator Iterator;
+
 /**
  * @brief Construct an empty Global Router Manager Link State Database.
  *
@@ -606,6 +610,9 @@ public:
  *
  * @see GlobalRoutingLSA
  * @see Ipv4Address
+ * The link records of the LSA are indexed for GetLSAByLinkData, so the LSA
+ * must not be changed once inserted.
+ *
  * @param addr The IP address associated with the LSA.  Typically the Router 
  * ID.
  * @param lsa A pointer to the Link State Advertisement for the router.
@@ -641,13 +648,29 @@ public:
  */
   GlobalRoutingLSA* GetLSAByLinkData (Ipv4Address addr) const;
 
+/**
+ * @brief Get an iterator to the first Link State Advertisement of the
+ * database, not including the External Link State Advertisements.
+ *
+ * @returns the iterator
+ */
+  Iterator Begin (void) const;
+/**
+ * @brief Get an iterator past the last Link State Advertisement of the
+ * database.
+ *
+ * @returns the iterator
+ */
+  Iterator End (void) const;
+
 /**
  * @brief Set all LSA flags to an initialized state, for SPF computation
  *
  * This function walks the database and resets the status flags of all of the
- * contained Link State Advertisements to LSA_SPF_NOT_EXPLORED.  This is done
- * prior to each SPF calculation to reset the state of the SPFVertex structures
- * that will reference the LSAs during the calculation.
+ * contained Link State Advertisements to LSA_SPF_NOT_EXPLORED.  The SPF
+ * calculations of GlobalRouteManagerImpl no longer use these flags: they
+ * keep the status of the LSAs on their own, so that several of them can
+ * share the database.
  *
  * @see GlobalRoutingLSA
  * @see SPFVertex
@@ -679,7 +702,10 @@ private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
 
+  typedef std::map<Ipv4Address, LSDBMap_t::const_iterator> LinkDataMap_t; //!< container of link data / Link State Advertisements
+
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+  LinkDataMap_t m_linkData; //!< first LSA of m_database with a TransitNetwork link record, by link data
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -735,6 +761,19 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Recompute the routes after a change of the topology
+ *
+ * This is equivalent to DeleteGlobalRoutes, BuildGlobalRoutingDatabase
+ * and InitializeRoutes.  In incremental mode, the shortest-path trees of
+ * the last computation are kept, and the SPF calculation only runs again
+ * for the routers whose trees may be changed by the links which differ
+ * between the old and the new database.  The routes of the other routers
+ * are rebuilt from their trees, since they may still have routes to the
+ * changed networks.
+ */
+  virtual void RecomputeRoutingTables ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -766,8 +805,120 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /**
+   * \brief The shortest-path tree of a router, as kept in incremental mode
+   * to rebuild its routes without running the SPF calculation again.
+   *
+   * The vertices are listed in the order they were added to the tree, the
+   * root first, and refer to each other by their position in the list.
+   */
+  struct SPFTree
+  {
+    std::vector<Ipv4Address> ids;             //!< the IDs of the vertices
+    std::vector<uint32_t> exitsBegin;         //!< the first exit of each vertex in exits, then the number of exits
+    std::vector<SPFVertex::NodeExit_t> exits; //!< the root exit directions of the vertices
+    std::vector<uint32_t> childrenBegin;      //!< the first child of each vertex in children, then the number of children
+    std::vector<uint32_t> children;           //!< the children of the vertices
+  };
+
+  /**
+   * \brief A router to compute the routes of, with the objects its routes
+   * are written to, which are looked up once per computation.
+   */
+  struct RootRouter
+  {
+    Ipv4Address routerId;           //!< the router ID
+    Ptr<Ipv4> ipv4;                 //!< the IPv4 stack of the router, or 0 if not found
+    Ptr<Ipv4GlobalRouting> routing; //!< the routing protocol of the router, or 0 if not found
+    bool replay;                    //!< whether the routes can be rebuilt from the tree
+    SPFTree tree;                   //!< the shortest-path tree, in incremental mode
+  };
+
+  struct SPFJob;
+
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  RootRouter* m_rootRouter; //!< the router the routes are computed for
+  std::map<GlobalRoutingLSA*, GlobalRoutingLSA::SPFStatus> m_lsaStatus; //!< the LSAs which are candidates or in the SPF tree
+  std::vector<SPFVertex*> m_spfOrder; //!< the vertices, in the order they were added to the SPF tree
+  bool m_keepTrees; //!< whether to keep the shortest-path trees, in incremental mode
+  std::map<Ipv4Address, SPFTree> m_spfTrees; //!< the shortest-path trees of the last computation, by router ID
+
+  /**
+   * \brief Find the routers to compute the routes of: the nodes of this
+   * system with a GlobalRouter which has LSAs.
+   *
+   * \param [out] roots the routers
+   * \param deleteRoutes whether to delete the routes of the other routers
+   */
+  void GetRootRouters (std::vector<RootRouter> &roots, bool deleteRoutes);
+
+  /**
+   * \brief Find the node of a router.
+   *
+   * \param routerId the router ID
+   * \returns the router, without IPv4 stack nor routing protocol if no
+   * node has this router ID
+   */
+  RootRouter GetRootRouter (Ipv4Address routerId);
+
+  /**
+   * \brief Compute the routes of routers, using as many threads as the
+   * GlobalRoutingSpfThreads global value allows.
+   *
+   * The threads only write to the routing tables of their roots, and only
+   * read the LSDB.  The trees computed are kept in incremental mode.
+   *
+   * \param roots the routers
+   * \param deleteRoutes whether to delete the routes of the routers first
+   */
+  void CalculateRoots (std::vector<RootRouter> &roots, bool deleteRoutes);
+
+  /**
+   * \brief Compute the routes of the routers of a job which are not taken
+   * yet, until there are no more.
+   *
+   * \param job the job
+   */
+  void RunSPFJob (SPFJob *job);
+
+  /**
+   * \brief Body of the threads helping with a job.
+   *
+   * \param args the route manager of the thread and the job
+   */
+  static void SPFJobThread (std::pair<GlobalRouteManagerImpl *, SPFJob *> args);
+
+  /**
+   * \brief Decide which routers can rebuild their routes from their trees.
+   *
+   * A router needs a new SPF calculation if any link it or its neighbors
+   * advertise changed, if its tree used a link which was removed, or if
+   * an added link is at least as short a path to a vertex as its tree.
+   * The distances are those of the old database.  If an LSA changed the
+   * order of the link records it kept, no router is replayed, so that the
+   * routes are always added in the order of a full calculation.
+   *
+   * \param oldLsdb the database the trees were computed from
+   * \param roots the routers, with their trees
+   */
+  void SetReplayableRoots (const GlobalRouteManagerLSDB *oldLsdb, std::vector<RootRouter> &roots);
+
+  /**
+   * \brief Get the SPF status of an LSA in the current calculation.
+   *
+   * \param lsa the LSA
+   * \returns the status
+   */
+  GlobalRoutingLSA::SPFStatus GetLSAStatus (GlobalRoutingLSA *lsa) const;
+
+  /**
+   * \brief Set the SPF status of an LSA in the current calculation.
+   *
+   * \param lsa the LSA
+   * \param status the status
+   */
+  void SetLSAStatus (GlobalRoutingLSA *lsa, GlobalRoutingLSA::SPFStatus status);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -785,9 +936,32 @@ private:
    * \brief Calculate the shortest path first (SPF) tree
    *
    * Equivalent to quagga ospf_spf_calculate
-   * \param root the root node
+   * \param root the root router
+   */
+  void SPFCalculate (RootRouter &root);
+
+  /**
+   * \brief Add the routes of a router from its shortest-path tree, as the
+   * SPF calculation would, without the calculation.
+   *
+   * \param root the root router
+   * \returns false if the tree refers to LSAs missing from the LSDB, in
+   * which case nothing is done
+   */
+  bool SPFReplay (RootRouter &root);
+
+  /**
+   * \brief Add the routes of the second stage of the SPF calculation, to the
+   * stub networks and to the AS external networks, once the tree is built.
+   */
+  void SPFAddStubsAndExternals (void);
+
+  /**
+   * \brief Keep the shortest-path tree of the current calculation.
+   *
+   * \param [out] tree the tree
    */
-  void SPFCalculate (Ipv4Address root);
+  void SPFKeepTree (SPFTree &tree) const;
 
   /**
    * \brief Process Stub nodes
@@ -36,6 +36,13 @@ namespace ns3 {
  * and finally configure each of the node's forwarding tables.
  *
  * The design is guided by OSPFv2 \RFC{2328} section 16.1.1 and quagga ospfd.
+ *
+ * The routes of the routers are independent of each other once the
+ * database is built, so they can be computed by several threads (see the
+ * GlobalRoutingSpfThreads global value).  With the
+ * GlobalRoutingIncrementalSpf global value, RecomputeRoutingTables
+ * only runs the SPF computation again for the routers whose shortest
+ * paths may go through a link which changed.
  */
 class GlobalRouteManager
 {
@@ -65,6 +72,18 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Recompute the routes of all the nodes after a change of the
+ * topology.
+ *
+ * This deletes the routes, builds the routing database again and
+ * computes the routes from it, unless the GlobalRoutingIncrementalSpf
+ * global value is set, in which case the routes of the routers whose
+ * shortest paths are unchanged are rebuilt from their previous
+ * shortest-path trees.
+ */
+  static void RecomputeRoutingTables ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
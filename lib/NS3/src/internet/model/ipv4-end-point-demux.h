@@ -23,6 +23,9 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -40,6 +43,11 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are also indexed by a hash table, so that Lookup only
+ * examines those which may match a packet: the connected endpoints (with
+ * both a peer address and a peer port) by local port, peer address and
+ * peer port, and the other ones by local port.
  */
 
 class Ipv4EndPointDemux {
@@ -166,6 +174,52 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief Endpoints sharing a lookup key.
+   */
+  typedef std::vector<Ipv4EndPoint *> EndPointBucket;
+
+  /**
+   * \brief Get the lookup key of the endpoints which may receive packets
+   * from a peer.
+   *
+   * The connected endpoints are keyed by local port, peer address and peer
+   * port, the other ones only by local port.
+   *
+   * \param localPort the local port
+   * \param peerAddress the peer address, or any
+   * \param peerPort the peer port, or 0
+   * \returns the key
+   */
+  static uint64_t GetKey (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Get the lookup key of an endpoint.
+   * \param endPoint the endpoint
+   * \returns the key
+   */
+  static uint64_t GetKey (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add a new endpoint to the demux.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the lookup index and to the local port count.
+   * \param endPoint the endpoint
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the lookup index and from the local
+   * port count, before its peer or its local port changes.
+   * \param endPoint the endpoint
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
 
   /**
    * \brief Allocate an ephemeral port.
@@ -192,6 +246,16 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The IPv4 end points, by lookup key.
+   */
+  std::unordered_map<uint64_t, EndPointBucket> m_index;
+
+  /**
+   * \brief The number of IPv4 end points using each local port.
+   */
+  std::map<uint16_t, uint32_t> m_localPorts;
 };
 
 } // namespace ns3
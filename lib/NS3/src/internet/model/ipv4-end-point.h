@@ -32,6 +32,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \ingroup ipv4
@@ -88,6 +89,8 @@ public:
 
   /**
    * \brief Set the peer informations (address and port).
+   *
+   * The demux the endpoint was allocated by is updated.
    * \param address peer address
    * \param port peer port
    */
@@ -227,6 +230,14 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  friend class Ipv4EndPointDemux;
+
+  /**
+   * \brief The demux the endpoint was allocated by, which indexes it by
+   * peer (if any).
+   */
+  Ipv4EndPointDemux *m_demux;
 };
 
 } // namespace ns3
@@ -18,6 +18,7 @@
 
 #include <vector>
 #include <iomanip>
+#include <algorithm>
 #include "ns3/names.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -79,7 +80,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   NS_LOG_FUNCTION (this << dest << nextHop << interface);
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
-  m_hostRoutes.push_back (route);
+  AddRoute (route, m_hostRoutes, m_hostRouteIndex);
 }
 
 void 
@@ -89,7 +90,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   NS_LOG_FUNCTION (this << dest << interface);
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
-  m_hostRoutes.push_back (route);
+  AddRoute (route, m_hostRoutes, m_hostRouteIndex);
 }
 
 void 
@@ -104,7 +105,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         nextHop,
                                                         interface);
-  m_networkRoutes.push_back (route);
+  AddRoute (route, m_networkRoutes, m_networkRouteIndex);
 }
 
 void 
@@ -117,7 +118,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
   *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
                                                         networkMask,
                                                         interface);
-  m_networkRoutes.push_back (route);
+  AddRoute (route, m_networkRoutes, m_networkRouteIndex);
 }
 
 void 
@@ -132,7 +133,7 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         nextHop,
                                                         interface);
-  m_ASexternalRoutes.push_back (route);
+  AddRoute (route, m_ASexternalRoutes, m_ASexternalRouteIndex);
 }
 
 
@@ -145,73 +146,65 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   // store all available routes that bring packets to their destination
   typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
+  // the routes matching the destination, on any interface
+  RouteVec_t found;
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
+  FindRoutes (dest, m_hostRoutes, m_hostRouteIndex, found);
+  for (RouteVec_t::const_iterator i = found.begin (); 
+       i != found.end (); 
        i++) 
     {
       NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      if (oif != 0)
         {
-          if (oif != 0)
+          if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
+      allRoutes.push_back (*i);
+      NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
     }
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
+      FindRoutes (dest, m_networkRoutes, m_networkRouteIndex, found);
+      for (RouteVec_t::const_iterator j = found.begin (); 
+           j != found.end (); 
            j++) 
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          if (oif != 0)
             {
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
+          allRoutes.push_back (*j);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
         }
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
+      FindRoutes (dest, m_ASexternalRoutes, m_ASexternalRouteIndex, found);
+      for (RouteVec_t::const_iterator k = found.begin ();
+           k != found.end ();
            k++)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          NS_LOG_LOGIC ("Found external route" << *k);
+          if (oif != 0)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*k);
-              break;
             }
+          allRoutes.push_back (*k);
+          break;
         }
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
@@ -245,6 +238,72 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 }
 
+void
+Ipv4GlobalRouting::AddRoute (Ipv4RoutingTableEntry *route, std::list<Ipv4RoutingTableEntry *> &routes,
+                             RouteIndex &index)
+{
+  NS_LOG_FUNCTION (route);
+  routes.push_back (route);
+  if (RouteIndex::IsPrefix (route->GetDestNetworkMask ()))
+    {
+      index.Insert (route->GetDestNetwork (), route->GetDestNetworkMask (), route);
+    }
+}
+
+void
+Ipv4GlobalRouting::EraseRoute (std::list<Ipv4RoutingTableEntry *>::iterator i,
+                               std::list<Ipv4RoutingTableEntry *> &routes, RouteIndex &index)
+{
+  NS_LOG_FUNCTION (*i);
+  index.Remove ((*i)->GetDestNetwork (), (*i)->GetDestNetworkMask (), *i);
+  delete *i;
+  routes.erase (i);
+}
+
+void
+Ipv4GlobalRouting::FindRoutes (Ipv4Address dest, const std::list<Ipv4RoutingTableEntry *> &routes,
+                               const RouteIndex &index, std::vector<Ipv4RoutingTableEntry *> &found)
+{
+  NS_LOG_FUNCTION (dest);
+  found.clear ();
+  if (index.GetN () == routes.size ())
+    {
+      // The routes of several prefixes may match: merge them back in
+      // the order they were added, which is the order of the container.
+      const RouteIndex::Entries *matches[RouteIndex::MAX_MATCHES];
+      uint32_t nMatches = index.Match (dest, matches);
+      if (nMatches == 1)
+        {
+          for (RouteIndex::Entries::const_iterator i = matches[0]->begin (); i != matches[0]->end (); i++)
+            {
+              found.push_back (i->value);
+            }
+          return;
+        }
+      std::vector<std::pair<uint32_t, Ipv4RoutingTableEntry *> > ranked;
+      for (uint32_t m = 0; m < nMatches; m++)
+        {
+          for (RouteIndex::Entries::const_iterator i = matches[m]->begin (); i != matches[m]->end (); i++)
+            {
+              ranked.push_back (std::make_pair (i->rank, i->value));
+            }
+        }
+      std::sort (ranked.begin (), ranked.end ());
+      for (uint32_t r = 0; r < ranked.size (); r++)
+        {
+          found.push_back (ranked[r].second);
+        }
+      return;
+    }
+  for (std::list<Ipv4RoutingTableEntry *>::const_iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      if ((*i)->GetDestNetworkMask ().IsMatch (dest, (*i)->GetDestNetwork ()))
+        {
+          found.push_back (*i);
+        }
+    }
+}
+
 uint32_t 
 Ipv4GlobalRouting::GetNRoutes (void) const
 {
@@ -319,8 +378,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
-              delete *i;
-              m_hostRoutes.erase (i);
+              EraseRoute (i, m_hostRoutes, m_hostRouteIndex);
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
               return;
             }
@@ -336,8 +394,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
-          delete *j;
-          m_networkRoutes.erase (j);
+          EraseRoute (j, m_networkRoutes, m_networkRouteIndex);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -352,8 +409,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
-          delete *k;
-          m_ASexternalRoutes.erase (k);
+          EraseRoute (k, m_ASexternalRoutes, m_ASexternalRouteIndex);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -392,6 +448,9 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostRouteIndex.Clear ();
+  m_networkRouteIndex.Clear ();
+  m_ASexternalRouteIndex.Clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -537,9 +596,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -549,9 +606,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -561,9 +616,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -573,9 +626,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -28,6 +28,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-prefix-trie.h"
 
 namespace ns3 {
 
@@ -63,7 +64,9 @@ class Node;
  * and rebuilt in the middle of the simulation, while manually entered
  * routes into the Ipv4StaticRouting may need to be kept distinct.
  *
- * This class deals with Ipv4 unicast routes only.
+ * This class deals with Ipv4 unicast routes only.  The routes are
+ * indexed by destination prefix, so that the cost of a lookup does not
+ * grow with the number of routes.
  *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
@@ -260,6 +263,9 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /// index of Ipv4RoutingTableEntry by destination prefix
+  typedef Ipv4PrefixTrie<Ipv4RoutingTableEntry *> RouteIndex;
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -268,9 +274,43 @@ private:
    */
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Append a route to a container, and to its index if the route
+   * mask is a prefix.
+   * \param route the route
+   * \param routes the container
+   * \param index the index of the container
+   */
+  static void AddRoute (Ipv4RoutingTableEntry *route, std::list<Ipv4RoutingTableEntry *> &routes,
+                        RouteIndex &index);
+  /**
+   * \brief Remove a route from a container and from its index, and delete it.
+   * \param i the route
+   * \param routes the container
+   * \param index the index of the container
+   */
+  static void EraseRoute (std::list<Ipv4RoutingTableEntry *>::iterator i,
+                          std::list<Ipv4RoutingTableEntry *> &routes, RouteIndex &index);
+  /**
+   * \brief Find the routes of a container matching a destination.
+   *
+   * The index is used unless some routes of the container are missing
+   * from it, in which case the container is scanned.
+   *
+   * \param dest destination address
+   * \param routes the container
+   * \param index the index of the container
+   * \param [out] found the matching routes, in the order of the container
+   */
+  static void FindRoutes (Ipv4Address dest, const std::list<Ipv4RoutingTableEntry *> &routes,
+                          const RouteIndex &index, std::vector<Ipv4RoutingTableEntry *> &found);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
+  RouteIndex m_hostRouteIndex;         //!< Routes to hosts, by destination
+  RouteIndex m_networkRouteIndex;      //!< Routes to networks, by destination
+  RouteIndex m_ASexternalRouteIndex;   //!< External routes imported, by destination
 
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
@@ -22,6 +22,7 @@
 #include "loopback-net-device.h"
 #include "ipv4-l3-protocol.h"
 #include "ipv4-queue-disc-item.h"
+#include "tcp-gso-tag.h"
 #include "arp-l3-protocol.h"
 #include "arp-cache.h"
 #include "ns3/net-device.h"
@@ -224,8 +225,11 @@ Ipv4Interface::Send (Ptr<Packet> p, const Ipv4Header & hdr, Ipv4Address dest)
     {
       /// \todo additional checks needed here (such as whether multicast
       /// goes to loopback)?
-      p->AddHeader (hdr);
-      m_device->Send (p, m_device->GetBroadcast (), Ipv4L3Protocol::PROT_NUMBER);
+      std::vector<Ptr<Packet> > packets = Segment (p, hdr);
+      for (std::vector<Ptr<Packet> >::iterator i = packets.begin (); i != packets.end (); i++)
+        {
+          m_device->Send (*i, m_device->GetBroadcast (), Ipv4L3Protocol::PROT_NUMBER);
+        }
       return;
     } 
 
@@ -236,11 +240,14 @@ Ipv4Interface::Send (Ptr<Packet> p, const Ipv4Header & hdr, Ipv4Address dest)
     {
       if (dest == (*i).GetLocal ())
         {
-          p->AddHeader (hdr);
-          m_tc->Receive (m_device, p, Ipv4L3Protocol::PROT_NUMBER,
-                         m_device->GetBroadcast (),
-                         m_device->GetBroadcast (),
-                         NetDevice::PACKET_HOST);
+          std::vector<Ptr<Packet> > packets = Segment (p, hdr);
+          for (std::vector<Ptr<Packet> >::iterator j = packets.begin (); j != packets.end (); j++)
+            {
+              m_tc->Receive (m_device, *j, Ipv4L3Protocol::PROT_NUMBER,
+                             m_device->GetBroadcast (),
+                             m_device->GetBroadcast (),
+                             NetDevice::PACKET_HOST);
+            }
           return;
         }
     }
@@ -298,6 +305,31 @@ Ipv4Interface::Send (Ptr<Packet> p, const Ipv4Header & hdr, Ipv4Address dest)
     }
 }
 
+std::vector<Ptr<Packet> >
+Ipv4Interface::Segment (Ptr<Packet> p, const Ipv4Header &hdr)
+{
+  NS_LOG_FUNCTION (this << p);
+  std::vector<Ptr<Packet> > packets;
+  TcpGsoTag gsoTag;
+  if (p->PeekPacketTag (gsoTag))
+    {
+      Ptr<QueueDiscItem> item = Create<Ipv4QueueDiscItem> (p, m_device->GetBroadcast (), Ipv4L3Protocol::PROT_NUMBER, hdr);
+      std::vector<Ptr<QueueDiscItem> > segments = item->Segment ();
+      for (std::vector<Ptr<QueueDiscItem> >::iterator i = segments.begin (); i != segments.end (); i++)
+        {
+          (*i)->AddHeader ();
+          packets.push_back ((*i)->GetPacket ());
+        }
+      if (!packets.empty ())
+        {
+          return packets;
+        }
+    }
+  p->AddHeader (hdr);
+  packets.push_back (p);
+  return packets;
+}
+
 uint32_t
 Ipv4Interface::GetNAddresses (void) const
 {
@@ -23,6 +23,7 @@
 #define IPV4_INTERFACE_H
 
 #include <list>
+#include <vector>
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 
@@ -213,6 +214,16 @@ private:
    */
   void DoSetup (void);
 
+  /**
+   * \brief Add the IPv4 header to a packet which does not go through the
+   * traffic control layer, after splitting it into segments as that layer
+   * would if it is a TCP super-packet (see TcpGsoTag)
+   * \param p the packet
+   * \param hdr the IPv4 header
+   * \returns the packets to deliver
+   */
+  std::vector<Ptr<Packet> > Segment (Ptr<Packet> p, const Ipv4Header &hdr);
+
 
   /**
    * \brief Container for the Ipv4InterfaceAddresses.
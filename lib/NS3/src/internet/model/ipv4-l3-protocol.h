@@ -305,6 +305,8 @@ private:
    * \param ttl Time to Live
    * \param tos Type of Service
    * \param mayFragment true if the packet can be fragmented
+   * \param segments number of identifications to use, one per segment of
+   *        a TCP super-packet (see TcpGsoTag), or 1
    * \return newly created IPv4 header
    */
   Ipv4Header BuildHeader (
@@ -314,7 +316,8 @@ private:
     uint16_t payloadSize,
     uint8_t ttl,
     uint8_t tos,
-    bool mayFragment);
+    bool mayFragment,
+    uint16_t segments);
 
   /**
    * \brief Send packet with route.
@@ -0,0 +1,394 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_PREFIX_TRIE_H
+#define IPV4_PREFIX_TRIE_H
+
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+#include "ns3/assert.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Path-compressed binary trie of IPv4 prefixes, to find the
+ * prefixes matching an address without visiting all of them.
+ *
+ * Each prefix holds the values inserted for it, in insertion order.  A
+ * lookup walks down the bits of the address, and so visits at most 33
+ * nodes whatever the number of prefixes.  Each value is also tagged with
+ * its rank among all the values of the trie, so that the values of
+ * different prefixes can be put back in insertion order.
+ *
+ * Only contiguous masks (see IsPrefix) can be stored.
+ *
+ * \tparam T the type of the values, which must be comparable with ==
+ */
+template <typename T>
+class Ipv4PrefixTrie
+{
+public:
+  /**
+   * A value, with its insertion rank.
+   */
+  struct Entry
+  {
+    T value;       //!< the value
+    uint32_t rank; //!< the rank of the value among the values inserted in the trie
+  };
+  /// The values of a prefix, in insertion order
+  typedef std::vector<Entry> Entries;
+
+  /// The largest number of prefixes matching an address, /0 to /32
+  static const uint32_t MAX_MATCHES = 33;
+
+  Ipv4PrefixTrie ();
+  ~Ipv4PrefixTrie ();
+
+  /**
+   * \param mask a network mask
+   * \return true if the mask is made of leading ones only, and so can
+   *         be stored in the trie
+   */
+  static bool IsPrefix (Ipv4Mask mask);
+
+  /**
+   * Add a value to a prefix, after the values already there.
+   * \param network the network address; the bits outside the mask are ignored
+   * \param mask the network mask, which must be a prefix
+   * \param value the value
+   */
+  void Insert (Ipv4Address network, Ipv4Mask mask, const T &value);
+  /**
+   * Remove the first occurrence of a value from a prefix.
+   * \param network the network address; the bits outside the mask are ignored
+   * \param mask the network mask
+   * \param value the value
+   * \return true if the value was found
+   */
+  bool Remove (Ipv4Address network, Ipv4Mask mask, const T &value);
+  /**
+   * Remove all the values.
+   */
+  void Clear (void);
+  /**
+   * \return the number of values in the trie
+   */
+  uint32_t GetN (void) const;
+  /**
+   * Find the prefixes matching an address.
+   * \param address the address
+   * \param [out] matches the values of each matching prefix, from the
+   *        shortest prefix to the longest one; there is room for
+   *        MAX_MATCHES elements
+   * \return the number of matching prefixes holding values
+   */
+  uint32_t Match (Ipv4Address address, const Entries *matches[]) const;
+
+private:
+  /**
+   * A node of the trie: a prefix, and the subtrees of the longer
+   * prefixes which have the next bit set to 0 and to 1.  The nodes
+   * without values only join two subtrees.
+   */
+  struct Node
+  {
+    uint32_t prefix;  //!< the prefix bits, the others being zero
+    uint8_t length;   //!< the prefix length
+    Node *child[2];   //!< the subtrees, by the bit following the prefix
+    Entries entries;  //!< the values of the prefix
+  };
+
+  /**
+   * Copy constructor, not implemented.
+   * \param o the trie to copy
+   */
+  Ipv4PrefixTrie (const Ipv4PrefixTrie &o);
+  /**
+   * Assignment operator, not implemented.
+   * \param o the trie to copy
+   * \return this trie
+   */
+  Ipv4PrefixTrie &operator = (const Ipv4PrefixTrie &o);
+
+  /**
+   * \param prefix the prefix bits
+   * \param length the prefix length
+   * \return a new node without subtrees nor values
+   */
+  static Node *CreateNode (uint32_t prefix, uint8_t length);
+  /**
+   * Delete a node and its subtrees.
+   * \param node the node, or 0
+   */
+  static void DeleteNode (Node *node);
+  /**
+   * \param length a prefix length
+   * \return the mask of the prefix length
+   */
+  static uint32_t GetMask (uint8_t length);
+  /**
+   * \param key an address
+   * \param position the bit position, 0 being the most significant bit
+   * \return the bit of the address
+   */
+  static uint32_t GetBit (uint32_t key, uint8_t position);
+  /**
+   * \param a an address
+   * \param b another address
+   * \param maxLength the largest length of interest
+   * \return the length of the common prefix of the addresses, up to maxLength
+   */
+  static uint8_t GetCommonLength (uint32_t a, uint32_t b, uint8_t maxLength);
+
+  Node *m_root;    //!< The /0 prefix, which is never removed
+  uint32_t m_n;    //!< The number of values
+  uint32_t m_rank; //!< The rank of the next value
+};
+
+} // namespace ns3
+
+namespace ns3 {
+
+template <typename T>
+const uint32_t Ipv4PrefixTrie<T>::MAX_MATCHES;
+
+template <typename T>
+Ipv4PrefixTrie<T>::Ipv4PrefixTrie ()
+  : m_root (CreateNode (0, 0)),
+    m_n (0),
+    m_rank (0)
+{
+}
+
+template <typename T>
+Ipv4PrefixTrie<T>::~Ipv4PrefixTrie ()
+{
+  DeleteNode (m_root);
+}
+
+template <typename T>
+bool
+Ipv4PrefixTrie<T>::IsPrefix (Ipv4Mask mask)
+{
+  return mask.Get () == GetMask (mask.GetPrefixLength ());
+}
+
+template <typename T>
+void
+Ipv4PrefixTrie<T>::Insert (Ipv4Address network, Ipv4Mask mask, const T &value)
+{
+  NS_ASSERT_MSG (IsPrefix (mask), "Mask " << mask << " is not a prefix");
+  uint8_t length = mask.GetPrefixLength ();
+  uint32_t key = network.Get () & mask.Get ();
+  Node *node = m_root;
+  while (node->length < length)
+    {
+      Node **link = &node->child[GetBit (key, node->length)];
+      Node *child = *link;
+      if (child == 0)
+        {
+          node = CreateNode (key, length);
+          *link = node;
+          break;
+        }
+      uint8_t common = GetCommonLength (key, child->prefix, std::min (length, child->length));
+      if (common == child->length)
+        {
+          node = child;
+          continue;
+        }
+      // The new prefix branches off within the compressed path to child.
+      Node *branch = CreateNode (key & GetMask (common), common);
+      branch->child[GetBit (child->prefix, common)] = child;
+      *link = branch;
+      node = branch;
+      if (common < length)
+        {
+          node = CreateNode (key, length);
+          branch->child[GetBit (key, common)] = node;
+        }
+      break;
+    }
+  Entry entry;
+  entry.value = value;
+  entry.rank = m_rank++;
+  node->entries.push_back (entry);
+  m_n++;
+}
+
+template <typename T>
+bool
+Ipv4PrefixTrie<T>::Remove (Ipv4Address network, Ipv4Mask mask, const T &value)
+{
+  if (!IsPrefix (mask))
+    {
+      return false;
+    }
+  uint8_t length = mask.GetPrefixLength ();
+  uint32_t key = network.Get () & mask.Get ();
+  Node **parentLink = 0;
+  Node **link = &m_root;
+  while ((*link)->length < length)
+    {
+      Node **childLink = &(*link)->child[GetBit (key, (*link)->length)];
+      Node *child = *childLink;
+      if (child == 0 || child->length > length || (key & GetMask (child->length)) != child->prefix)
+        {
+          return false;
+        }
+      parentLink = link;
+      link = childLink;
+    }
+  Node *node = *link;
+  if (node->length != length)
+    {
+      return false;
+    }
+  typename Entries::iterator i;
+  for (i = node->entries.begin (); i != node->entries.end (); i++)
+    {
+      if (i->value == value)
+        {
+          break;
+        }
+    }
+  if (i == node->entries.end ())
+    {
+      return false;
+    }
+  node->entries.erase (i);
+  if (--m_n == 0)
+    {
+      m_rank = 0;
+    }
+
+  // Prune the node if it no longer holds values nor joins two subtrees,
+  // then its parent if that left it joining nothing.
+  if (node == m_root || !node->entries.empty () || (node->child[0] != 0 && node->child[1] != 0))
+    {
+      return true;
+    }
+  *link = node->child[0] != 0 ? node->child[0] : node->child[1];
+  node->child[0] = node->child[1] = 0;
+  DeleteNode (node);
+  Node *parent = *parentLink;
+  if (parent != m_root && parent->entries.empty () && *link == 0)
+    {
+      *parentLink = parent->child[0] != 0 ? parent->child[0] : parent->child[1];
+      parent->child[0] = parent->child[1] = 0;
+      DeleteNode (parent);
+    }
+  return true;
+}
+
+template <typename T>
+void
+Ipv4PrefixTrie<T>::Clear (void)
+{
+  DeleteNode (m_root);
+  m_root = CreateNode (0, 0);
+  m_n = 0;
+  m_rank = 0;
+}
+
+template <typename T>
+uint32_t
+Ipv4PrefixTrie<T>::GetN (void) const
+{
+  return m_n;
+}
+
+template <typename T>
+uint32_t
+Ipv4PrefixTrie<T>::Match (Ipv4Address address, const Entries *matches[]) const
+{
+  uint32_t key = address.Get ();
+  uint32_t n = 0;
+  const Node *node = m_root;
+  while (node != 0 && (key & GetMask (node->length)) == node->prefix)
+    {
+      if (!node->entries.empty ())
+        {
+          matches[n++] = &node->entries;
+        }
+      if (node->length == 32)
+        {
+          break;
+        }
+      node = node->child[GetBit (key, node->length)];
+    }
+  return n;
+}
+
+template <typename T>
+typename Ipv4PrefixTrie<T>::Node *
+Ipv4PrefixTrie<T>::CreateNode (uint32_t prefix, uint8_t length)
+{
+  Node *node = new Node ();
+  node->prefix = prefix;
+  node->length = length;
+  node->child[0] = 0;
+  node->child[1] = 0;
+  return node;
+}
+
+template <typename T>
+void
+Ipv4PrefixTrie<T>::DeleteNode (Node *node)
+{
+  if (node != 0)
+    {
+      DeleteNode (node->child[0]);
+      DeleteNode (node->child[1]);
+      delete node;
+    }
+}
+
+template <typename T>
+uint32_t
+Ipv4PrefixTrie<T>::GetMask (uint8_t length)
+{
+  return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+template <typename T>
+uint32_t
+Ipv4PrefixTrie<T>::GetBit (uint32_t key, uint8_t position)
+{
+  return (key >> (31 - position)) & 1;
+}
+
+template <typename T>
+uint8_t
+Ipv4PrefixTrie<T>::GetCommonLength (uint32_t a, uint32_t b, uint8_t maxLength)
+{
+  uint32_t diff = a ^ b;
+  uint8_t length = 0;
+  while (length < maxLength && GetBit (diff, length) == 0)
+    {
+      length++;
+    }
+  return length;
+}
+
+} // namespace ns3
+
+#endif /* IPV4_PREFIX_TRIE_H */
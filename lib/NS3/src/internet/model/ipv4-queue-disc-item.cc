@@ -18,6 +18,8 @@
 
 #include "ns3/log.h"
 #include "ipv4-queue-disc-item.h"
+#include "tcp-l4-protocol.h"
+#include "tcp-gso-tag.h"
 
 namespace ns3 {
 
@@ -109,4 +111,28 @@ Ipv4QueueDiscItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t& value)
   return ret;
 }
 
+std::vector<Ptr<QueueDiscItem> >
+Ipv4QueueDiscItem::Segment (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Ptr<QueueDiscItem> > items;
+  TcpGsoTag tag;
+  if (m_headerAdded || m_header.GetProtocol () != TcpL4Protocol::PROT_NUMBER
+      || !GetPacket ()->PeekPacketTag (tag))
+    {
+      return items;
+    }
+  std::vector<Ptr<Packet> > segments = TcpL4Protocol::Segment (GetPacket (),
+                                                               m_header.GetSource (),
+                                                               m_header.GetDestination ());
+  for (uint32_t i = 0; i < segments.size (); i++)
+    {
+      Ipv4Header header = m_header;
+      header.SetPayloadSize (segments[i]->GetSize ());
+      header.SetIdentification (m_header.GetIdentification () + i);
+      items.push_back (Create<Ipv4QueueDiscItem> (segments[i], GetAddress (), GetProtocol (), header));
+    }
+  return items;
+}
+
 } // namespace ns3
@@ -82,6 +82,16 @@ public:
    */
   virtual bool Mark (void);
 
+  /**
+   * \brief Split a TCP super-packet into IPv4 segments
+   *
+   * Each segment gets a copy of the IPv4 header with its own payload size and identification.
+   *
+   * \return the items of the segments, or an empty vector if this item is
+   *         not a TCP super-packet
+   */
+  virtual std::vector<Ptr<QueueDiscItem> > Segment (void);
+
 private:
   /**
    * \brief Default constructor
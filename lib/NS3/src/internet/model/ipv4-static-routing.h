@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-prefix-trie.h"
 
 namespace ns3 {
 
@@ -53,6 +54,9 @@ class Node;
  * This particular protocol is designed to be inserted into an 
  * Ipv4ListRouting protocol but can be used also as a standalone
  * protocol.
+ *
+ * The unicast routes are indexed by destination prefix, so that the
+ * cost of a lookup does not grow with the number of routes.
  * 
  * The Ipv4StaticRouting class inherits from the abstract base class 
  * Ipv4RoutingProtocol that defines the interface methods that a routing 
@@ -395,6 +399,23 @@ private:
   /// Iterator for container for the multicast routes
   typedef std::list<Ipv4MulticastRoutingTableEntry *>::iterator MulticastRoutesI;
 
+  /// Index of the network routes by destination prefix
+  typedef Ipv4PrefixTrie<std::pair <Ipv4RoutingTableEntry *, uint32_t> > NetworkRouteIndex;
+
+  /**
+   * \brief Append a route to the forwarding table for network.
+   * \param route the route
+   * \param metric metric of route
+   */
+  void AddRoute (Ipv4RoutingTableEntry *route, uint32_t metric);
+
+  /**
+   * \brief Remove a route from the forwarding table for network, and delete it.
+   * \param i the route
+   * \return the route following the removed one
+   */
+  NetworkRoutesI EraseRoute (NetworkRoutesI i);
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -418,6 +439,12 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the network routes by destination, unless their mask is not
+   * a prefix, in which case lookups scan m_networkRoutes.
+   */
+  NetworkRouteIndex m_networkRouteIndex;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -23,6 +23,9 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
+#include <unordered_map>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +37,11 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * The endpoints are also indexed by a hash table, so that Lookup only
+ * examines those which may match a packet: the connected endpoints (with
+ * both a peer address and a peer port) by local port, peer address and
+ * peer port, and the other ones by local port.
  */
 class Ipv6EndPointDemux
 {
@@ -153,6 +161,84 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief Lookup key of the endpoints which may receive packets from a peer.
+   */
+  struct EndPointKey
+  {
+    uint16_t localPort;      //!< the local port
+    Ipv6Address peerAddress; //!< the peer address, or any
+    uint16_t peerPort;       //!< the peer port, or 0
+
+    /**
+     * \brief Comparison operator.
+     * \param other the key to compare with
+     * \returns true if the keys are equal
+     */
+    bool operator == (const EndPointKey &other) const;
+  };
+
+  /**
+   * \brief Hash function class for the lookup keys.
+   */
+  class EndPointKeyHash
+  {
+  public:
+    /**
+     * \brief Unary operator to hash a lookup key.
+     * \param x the key to hash
+     * \returns the hash of the key
+     */
+    size_t operator () (const EndPointKey &x) const;
+  };
+
+  /**
+   * \brief Endpoints sharing a lookup key.
+   */
+  typedef std::vector<Ipv6EndPoint *> EndPointBucket;
+
+  /**
+   * \brief Get the lookup key of the endpoints which may receive packets
+   * from a peer.
+   *
+   * The connected endpoints are keyed by local port, peer address and peer
+   * port, the other ones only by local port.
+   *
+   * \param localPort the local port
+   * \param peerAddress the peer address, or any
+   * \param peerPort the peer port, or 0
+   * \returns the key
+   */
+  static EndPointKey GetKey (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Get the lookup key of an endpoint.
+   * \param endPoint the endpoint
+   * \returns the key
+   */
+  static EndPointKey GetKey (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add a new endpoint to the demux.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the lookup index and to the local port count.
+   * \param endPoint the endpoint
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the lookup index and from the local
+   * port count, before its peer or its local port changes.
+   * \param endPoint the endpoint
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -178,6 +264,16 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The IPv6 end points, by lookup key.
+   */
+  std::unordered_map<EndPointKey, EndPointBucket, EndPointKeyHash> m_index;
+
+  /**
+   * \brief The number of IPv6 end points using each local port.
+   */
+  std::map<uint16_t, uint32_t> m_localPorts;
 };
 
 } /* namespace ns3 */
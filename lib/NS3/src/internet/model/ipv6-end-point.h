@@ -34,6 +34,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \ingroup ipv6
@@ -97,6 +98,8 @@ public:
 
   /**
    * \brief Set the peer informations (address and port).
+   *
+   * The demux the endpoint was allocated by is updated.
    * \param addr peer address
    * \param port peer port
    */
@@ -236,6 +239,14 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  friend class Ipv6EndPointDemux;
+
+  /**
+   * \brief The demux the endpoint was allocated by, which indexes it by
+   * peer (if any).
+   */
+  Ipv6EndPointDemux *m_demux;
 };
 
 } /* namespace ns3 */
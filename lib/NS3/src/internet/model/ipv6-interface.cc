@@ -28,6 +28,7 @@
 
 #include "ipv6-interface.h"
 #include "ipv6-queue-disc-item.h"
+#include "tcp-gso-tag.h"
 #include "loopback-net-device.h"
 #include "ipv6-l3-protocol.h"
 #include "icmpv6-l4-protocol.h"
@@ -406,8 +407,11 @@ void Ipv6Interface::Send (Ptr<Packet> p, const Ipv6Header & hdr, Ipv6Address des
       /** \todo additional checks needed here (such as whether multicast
        * goes to loopback)?
        */
-      p->AddHeader (hdr);
-      m_device->Send (p, m_device->GetBroadcast (), Ipv6L3Protocol::PROT_NUMBER);
+      std::vector<Ptr<Packet> > packets = Segment (p, hdr);
+      for (std::vector<Ptr<Packet> >::iterator i = packets.begin (); i != packets.end (); i++)
+        {
+          m_device->Send (*i, m_device->GetBroadcast (), Ipv6L3Protocol::PROT_NUMBER);
+        }
       return;
     }
 
@@ -418,11 +422,14 @@ void Ipv6Interface::Send (Ptr<Packet> p, const Ipv6Header & hdr, Ipv6Address des
     {
       if (dest == it->first.GetAddress ())
         {
-          p->AddHeader (hdr);
-          m_tc->Receive (m_device, p, Ipv6L3Protocol::PROT_NUMBER,
-                         m_device->GetBroadcast (),
-                         m_device->GetBroadcast (),
-                         NetDevice::PACKET_HOST);
+          std::vector<Ptr<Packet> > packets = Segment (p, hdr);
+          for (std::vector<Ptr<Packet> >::iterator i = packets.begin (); i != packets.end (); i++)
+            {
+              m_tc->Receive (m_device, *i, Ipv6L3Protocol::PROT_NUMBER,
+                             m_device->GetBroadcast (),
+                             m_device->GetBroadcast (),
+                             NetDevice::PACKET_HOST);
+            }
           return;
         }
     }
@@ -464,6 +471,30 @@ void Ipv6Interface::Send (Ptr<Packet> p, const Ipv6Header & hdr, Ipv6Address des
     }
 }
 
+std::vector<Ptr<Packet> > Ipv6Interface::Segment (Ptr<Packet> p, const Ipv6Header &hdr)
+{
+  NS_LOG_FUNCTION (this << p);
+  std::vector<Ptr<Packet> > packets;
+  TcpGsoTag gsoTag;
+  if (p->PeekPacketTag (gsoTag))
+    {
+      Ptr<QueueDiscItem> item = Create<Ipv6QueueDiscItem> (p, m_device->GetBroadcast (), Ipv6L3Protocol::PROT_NUMBER, hdr);
+      std::vector<Ptr<QueueDiscItem> > segments = item->Segment ();
+      for (std::vector<Ptr<QueueDiscItem> >::iterator i = segments.begin (); i != segments.end (); i++)
+        {
+          (*i)->AddHeader ();
+          packets.push_back ((*i)->GetPacket ());
+        }
+      if (!packets.empty ())
+        {
+          return packets;
+        }
+    }
+  p->AddHeader (hdr);
+  packets.push_back (p);
+  return packets;
+}
+
 void Ipv6Interface::SetCurHopLimit (uint8_t curHopLimit)
 {
   NS_LOG_FUNCTION (this << curHopLimit);
@@ -22,6 +22,7 @@
 #define IPV6_INTERFACE_H
 
 #include <list>
+#include <vector>
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 #include "ipv6-interface-address.h"
@@ -316,6 +317,16 @@ private:
    */
   void DoSetup ();
 
+  /**
+   * \brief Add the IPv6 header to a packet which does not go through the
+   * traffic control layer, after splitting it into segments as that layer
+   * would if it is a TCP super-packet (see TcpGsoTag)
+   * \param p the packet
+   * \param hdr the IPv6 header
+   * \returns the packets to deliver
+   */
+  std::vector<Ptr<Packet> > Segment (Ptr<Packet> p, const Ipv6Header &hdr);
+
   /**
    * \brief The addresses assigned to this interface.
    */
@@ -18,6 +18,8 @@
 
 #include "ns3/log.h"
 #include "ipv6-queue-disc-item.h"
+#include "tcp-l4-protocol.h"
+#include "tcp-gso-tag.h"
 
 namespace ns3 {
 
@@ -108,4 +110,27 @@ Ipv6QueueDiscItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t& value)
   return ret;
 }
 
+std::vector<Ptr<QueueDiscItem> >
+Ipv6QueueDiscItem::Segment (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Ptr<QueueDiscItem> > items;
+  TcpGsoTag tag;
+  if (m_headerAdded || m_header.GetNextHeader () != TcpL4Protocol::PROT_NUMBER
+      || !GetPacket ()->PeekPacketTag (tag))
+    {
+      return items;
+    }
+  std::vector<Ptr<Packet> > segments = TcpL4Protocol::Segment (GetPacket (),
+                                                               m_header.GetSourceAddress (),
+                                                               m_header.GetDestinationAddress ());
+  for (uint32_t i = 0; i < segments.size (); i++)
+    {
+      Ipv6Header header = m_header;
+      header.SetPayloadLength (segments[i]->GetSize ());
+      items.push_back (Create<Ipv6QueueDiscItem> (segments[i], GetAddress (), GetProtocol (), header));
+    }
+  return items;
+}
+
 } // namespace ns3
@@ -94,9 +94,9 @@ NdiscCache::Entry* NdiscCache::Lookup (Ipv6Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
 
-  if (m_ndCache.find (dst) != m_ndCache.end ())
+  NdiscCache::Entry* entry = m_ndCache.Find (dst);
+  if (entry != 0)
     {
-      NdiscCache::Entry* entry = m_ndCache[dst];
       NS_LOG_LOGIC ("Found an entry:" << dst << " to " << entry->GetMacAddress ());
       return entry;
     }
@@ -109,12 +109,12 @@ std::list<NdiscCache::Entry*> NdiscCache::LookupInverse (Address dst)
   NS_LOG_FUNCTION (this << dst);
 
   std::list<NdiscCache::Entry *> entryList;
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  for (CacheI i = m_ndCache.GetSlots ().begin (); i != m_ndCache.GetSlots ().end (); i++)
     {
-      NdiscCache::Entry *entry = (*i).second;
-      if (entry->GetMacAddress () == dst)
+      NdiscCache::Entry *entry = i->value;
+      if (entry != 0 && entry->GetMacAddress () == dst)
         {
-          NS_LOG_LOGIC ("Found an entry:" << (*i).first << " to " << (*i).second);
+          NS_LOG_LOGIC ("Found an entry:" << i->key << " to " << entry);
           entryList.push_back (entry);
         }
     }
@@ -125,11 +125,11 @@ std::list<NdiscCache::Entry*> NdiscCache::LookupInverse (Address dst)
 NdiscCache::Entry* NdiscCache::Add (Ipv6Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  NS_ASSERT (m_ndCache.find (to) == m_ndCache.end ());
+  NS_ASSERT (m_ndCache.Find (to) == 0);
 
   NdiscCache::Entry* entry = new NdiscCache::Entry (this);
   entry->SetIpv6Address (to);
-  m_ndCache[to] = entry;
+  m_ndCache.Insert (to, entry);
   return entry;
 }
 
@@ -137,15 +137,11 @@ void NdiscCache::Remove (NdiscCache::Entry* entry)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  if (m_ndCache.Find (entry->GetIpv6Address ()) == entry)
     {
-      if ((*i).second == entry)
-        {
-          m_ndCache.erase (i);
-          entry->ClearWaitingPacket ();
-          delete entry;
-          return;
-        }
+      m_ndCache.Erase (entry->GetIpv6Address ());
+      entry->ClearWaitingPacket ();
+      delete entry;
     }
 }
 
@@ -153,12 +149,12 @@ void NdiscCache::Flush ()
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  for (CacheI i = m_ndCache.GetSlots ().begin (); i != m_ndCache.GetSlots ().end (); i++)
     {
-      delete (*i).second; /* delete the pointer NdiscCache::Entry */
+      delete i->value; /* delete the pointer NdiscCache::Entry */
     }
 
-  m_ndCache.erase (m_ndCache.begin (), m_ndCache.end ());
+  m_ndCache.Clear ();
 }
 
 void NdiscCache::SetUnresQlen (uint32_t unresQlen)
@@ -178,9 +174,13 @@ void NdiscCache::PrintNdiscCache (Ptr<OutputStreamWrapper> stream)
   NS_LOG_FUNCTION (this << stream);
   std::ostream* os = stream->GetStream ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  for (CacheI i = m_ndCache.GetSlots ().begin (); i != m_ndCache.GetSlots ().end (); i++)
     {
-      *os << i->first << " dev ";
+      if (i->value == 0)
+        {
+          continue;
+        }
+      *os << i->key << " dev ";
       std::string found = Names::FindName (m_device);
       if (Names::FindName (m_device) != "")
         {
@@ -191,29 +191,29 @@ void NdiscCache::PrintNdiscCache (Ptr<OutputStreamWrapper> stream)
           *os << static_cast<int> (m_device->GetIfIndex ());
         }
 
-      *os << " lladdr " << i->second->GetMacAddress ();
+      *os << " lladdr " << i->value->GetMacAddress ();
 
-      if (i->second->IsReachable ())
+      if (i->value->IsReachable ())
         {
           *os << " REACHABLE\n";
         }
-      else if (i->second->IsDelay ())
+      else if (i->value->IsDelay ())
         {
           *os << " DELAY\n";
         }
-      else if (i->second->IsIncomplete ())
+      else if (i->value->IsIncomplete ())
         {
           *os << " INCOMPLETE\n";
         }
-      else if (i->second->IsProbe ())
+      else if (i->value->IsProbe ())
         {
           *os << " PROBE\n";
         }
-      else if (i->second->IsStale ())
+      else if (i->value->IsStale ())
         {
           *os << " STALE\n";
         }
-      else if (i->second->IsPermanent ())
+      else if (i->value->IsPermanent ())
 	{
 	  *os << " PERMANENT\n";
 	}
@@ -408,6 +408,12 @@ void NdiscCache::Entry::SetIpv6Address (Ipv6Address ipv6Address)
   m_ipv6Address = ipv6Address;
 }
 
+Ipv6Address NdiscCache::Entry::GetIpv6Address () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_ipv6Address;
+}
+
 Time NdiscCache::Entry::GetLastReachabilityConfirmation () const
 {
   NS_LOG_FUNCTION_NOARGS ();
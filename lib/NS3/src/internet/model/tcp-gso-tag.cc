@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-gso-tag.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpGsoTag");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpGsoTag);
+
+TcpGsoTag::TcpGsoTag ()
+  : m_segmentSize (0),
+    m_segments (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpGsoTag::SetSegmentSize (uint16_t segmentSize)
+{
+  NS_LOG_FUNCTION (this << segmentSize);
+  m_segmentSize = segmentSize;
+}
+
+uint16_t
+TcpGsoTag::GetSegmentSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_segmentSize;
+}
+
+void
+TcpGsoTag::SetSegments (uint16_t segments)
+{
+  NS_LOG_FUNCTION (this << segments);
+  m_segments = segments;
+}
+
+uint16_t
+TcpGsoTag::GetSegments (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_segments;
+}
+
+TypeId
+TcpGsoTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpGsoTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpGsoTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+TcpGsoTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+TcpGsoTag::GetSerializedSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 4;
+}
+
+void
+TcpGsoTag::Serialize (TagBuffer i) const
+{
+  NS_LOG_FUNCTION (this << &i);
+  i.WriteU16 (m_segmentSize);
+  i.WriteU16 (m_segments);
+}
+
+void
+TcpGsoTag::Deserialize (TagBuffer i)
+{
+  NS_LOG_FUNCTION (this << &i);
+  m_segmentSize = i.ReadU16 ();
+  m_segments = i.ReadU16 ();
+}
+
+void
+TcpGsoTag::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "SegmentSize=" << m_segmentSize << " Segments=" << m_segments;
+}
+
+} // namespace ns3
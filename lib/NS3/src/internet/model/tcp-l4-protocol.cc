@@ -32,6 +32,7 @@
 
 #include "tcp-l4-protocol.h"
 #include "tcp-header.h"
+#include "tcp-gso-tag.h"
 #include "ipv4-end-point-demux.h"
 #include "ipv6-end-point-demux.h"
 #include "ipv4-end-point.h"
@@ -47,6 +48,7 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -535,6 +537,49 @@ TcpL4Protocol::Receive (Ptr<Packet> packet,
   return IpL4Protocol::RX_OK;
 }
 
+std::vector<Ptr<Packet> >
+TcpL4Protocol::Segment (Ptr<const Packet> packet, const Address &saddr,
+                        const Address &daddr)
+{
+  Ptr<Packet> payload = packet->Copy ();
+  TcpGsoTag tag;
+  bool found = payload->RemovePacketTag (tag);
+  NS_ASSERT (found && tag.GetSegmentSize () > 0);
+  TcpHeader header;
+  payload->RemoveHeader (header);
+
+  std::vector<Ptr<Packet> > segments;
+  uint32_t size = payload->GetSize ();
+  uint32_t offset = 0;
+  do
+    {
+      uint32_t length = std::min<uint32_t> (tag.GetSegmentSize (), size - offset);
+      Ptr<Packet> segment = payload->CreateFragment (offset, length);
+      TcpHeader segmentHeader = header;
+      segmentHeader.SetSequenceNumber (header.GetSequenceNumber () + SequenceNumber32 (offset));
+      uint8_t flags = header.GetFlags ();
+      if (offset > 0)
+        {
+          flags &= ~TcpHeader::CWR;
+        }
+      if (offset + length < size)
+        {
+          flags &= ~(TcpHeader::FIN | TcpHeader::PSH);
+        }
+      segmentHeader.SetFlags (flags);
+      if (Node::ChecksumEnabled ())
+        {
+          segmentHeader.EnableChecksums ();
+        }
+      segmentHeader.InitializeChecksum (saddr, daddr, PROT_NUMBER);
+      segment->AddHeader (segmentHeader);
+      segments.push_back (segment);
+      offset += length;
+    }
+  while (offset < size);
+  return segments;
+}
+
 void
 TcpL4Protocol::SendPacketV4 (Ptr<Packet> packet, const TcpHeader &outgoing,
                              const Ipv4Address &saddr, const Ipv4Address &daddr,
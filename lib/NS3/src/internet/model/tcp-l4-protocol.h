@@ -22,6 +22,7 @@
 #define TCP_L4_PROTOCOL_H
 
 #include <stdint.h>
+#include <vector>
 
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
@@ -205,6 +206,23 @@ public:
                    const Address &saddr, const Address &daddr,
                    Ptr<NetDevice> oif = 0) const;
 
+  /**
+   * \brief Split a super-packet into segments
+   *
+   * The super-packet carries a TcpGsoTag and a TCP header. Each segment
+   * gets a copy of the header, with its own sequence number and checksum;
+   * only the first segment keeps the CWR flag, and only the last one the
+   * FIN and PSH flags.
+   *
+   * \param packet The super-packet, with its TCP header
+   * \param saddr The source address, for the checksum
+   * \param daddr The destination address, for the checksum
+   * \return the segments, with their TCP headers
+   */
+  static std::vector<Ptr<Packet> > Segment (Ptr<const Packet> packet,
+                                            const Address &saddr,
+                                            const Address &daddr);
+
   /**
    * \brief Make a socket fully operational
    *
@@ -54,6 +54,7 @@
 #include "tcp-option-sack-permitted.h"
 #include "tcp-option-sack.h"
 #include "tcp-congestion-ops.h"
+#include "tcp-gso-tag.h"
 
 #include <math.h>
 #include <algorithm>
@@ -137,6 +138,13 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("GsoMaxSegments",
+                   "Maximum number of full segments of new data handed down "
+                   "as one super-packet, split into segments only by the "
+                   "traffic control layer (1 disables segmentation offload)",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpSocketBase::m_gsoMaxSegments),
+                   MakeUintegerChecker<uint16_t> (1))
     .AddTraceSource ("RTO",
                      "Retransmission timeout",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_rto),
@@ -357,6 +365,7 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_recover (sock.m_recover),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
+    m_gsoMaxSegments (sock.m_gsoMaxSegments),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace),
@@ -2658,7 +2667,19 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       isRetransmission = true;
     }
 
-  Ptr<Packet> p = m_txBuffer->CopyFromSequence (maxSize, seq);
+  // A super-packet is taken from the buffer a segment at a time, so that
+  // the sent list keeps tracking segments
+  Ptr<Packet> p = m_txBuffer->CopyFromSequence (std::min (maxSize, m_tcb->m_segmentSize), seq);
+  while (p->GetSize () < maxSize && p->GetSize () % m_tcb->m_segmentSize == 0)
+    {
+      Ptr<Packet> segment = m_txBuffer->CopyFromSequence (std::min (maxSize - p->GetSize (), m_tcb->m_segmentSize),
+                                                          seq + SequenceNumber32 (p->GetSize ()));
+      if (segment->GetSize () == 0)
+        {
+          break;
+        }
+      p->AddAtEnd (segment);
+    }
   uint32_t sz = p->GetSize (); // Size of packet
   uint8_t flags = withAck ? TcpHeader::ACK : 0;
   uint32_t remainingData = m_txBuffer->SizeFromSequence (seq + SequenceNumber32 (sz));
@@ -2686,6 +2707,14 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
 
   AddSocketTags (p);
 
+  if (sz > m_tcb->m_segmentSize)
+    {
+      TcpGsoTag gsoTag;
+      gsoTag.SetSegmentSize (m_tcb->m_segmentSize);
+      gsoTag.SetSegments ((sz + m_tcb->m_segmentSize - 1) / m_tcb->m_segmentSize);
+      p->AddPacketTag (gsoTag);
+    }
+
   if (m_closeOnEmpty && (remainingData == 0))
     {
       flags |= TcpHeader::FIN;
@@ -2746,7 +2775,11 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
                     ". Header " << header);
     }
 
-  UpdateRttHistory (seq, sz, isRetransmission);
+  for (uint32_t offset = 0; offset < sz; offset += m_tcb->m_segmentSize)
+    {
+      UpdateRttHistory (seq + SequenceNumber32 (offset),
+                        std::min (sz - offset, m_tcb->m_segmentSize), isRetransmission);
+    }
 
   // Notify the application of the data being sent unless this is a retransmit
   if (seq + sz > m_tcb->m_highTxMark)
@@ -2868,6 +2901,20 @@ TcpSocketBase::SendPendingData (bool withAck)
             }
 
           uint32_t s = std::min (availableWindow, m_tcb->m_segmentSize);
+          if (m_gsoMaxSegments > 1 && next == m_tcb->m_highTxMark)
+            {
+              // Hand down as many full segments of new data as the window
+              // allows, within the IP payload limit, as one super-packet.
+              // Segments sent one by one would leave the same partial
+              // segment to the checks above.
+              uint32_t segments = std::min (availableWindow, availableData) / m_tcb->m_segmentSize;
+              segments = std::min<uint32_t> (segments, m_gsoMaxSegments);
+              segments = std::min<uint32_t> (segments, GSO_MAX_SIZE / m_tcb->m_segmentSize);
+              if (segments > 1)
+                {
+                  s = segments * m_tcb->m_segmentSize;
+                }
+            }
 
           // (C.2) If any of the data octets sent in (C.1) are below HighData,
           //       HighRxt MUST be set to the highest sequence number of the
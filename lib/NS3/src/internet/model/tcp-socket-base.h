@@ -1224,6 +1224,15 @@ protected:
   uint32_t               m_retxThresh {3};   //!< Fast Retransmit threshold
   bool                   m_limitedTx  {true}; //!< perform limited transmit
 
+  // Generic segmentation offload
+  uint16_t m_gsoMaxSegments {1}; //!< Max segments handed down as one super-packet
+
+  /**
+   * Largest payload of a super-packet, so that it fits the 16-bit IP length
+   * fields with the largest IPv4 and TCP headers
+   */
+  static const uint32_t GSO_MAX_SIZE = 65535 - 60 - 60;
+
   // Transmission Control Block
   Ptr<TcpSocketState>    m_tcb {nullptr};               //!< Congestion control informations
   Ptr<TcpCongestionOps>  m_congestionControl {nullptr}; //!< Congestion control
@@ -96,7 +96,8 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n)
+  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n),
+    m_leftOutUpTo (n), m_highestLost (n)
 {
 }
 
@@ -169,6 +170,8 @@ TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
   // if you change the head with data already sent, something bad will happen
   NS_ASSERT (m_sentList.size () == 0);
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_leftOutUpTo = seq;
+  m_highestLost = seq;
 }
 
 bool
@@ -294,7 +297,7 @@ TcpTxBuffer::GetNewSegment (uint32_t numBytes)
   NS_ASSERT (it != m_appList.end ());
 
   m_appList.erase (it);
-  m_sentList.insert (m_sentList.end (), item);
+  IndexSentItem (m_sentList.insert (m_sentList.end (), item));
   m_sentSize += item->m_packet->GetSize ();
 
   return item;
@@ -308,36 +311,33 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
   NS_ASSERT (numBytes <= m_sentSize);
   NS_ASSERT (m_sentList.size () >= 1);
 
-  auto it = m_sentList.begin ();
   bool listEdited = false;
   uint32_t s = numBytes;
 
   // Avoid to merge different packet for this retransmission if flags are
   // different.
-  for (; it != m_sentList.end(); ++it)
+  SentIndex::const_iterator found = m_sentIndex.find (seq);
+  if (found != m_sentIndex.end ())
     {
-      if ((*it)->m_startSeq == seq)
+      auto it = found->second;
+      auto next = it;
+      next++;
+      if (next != m_sentList.end ())
         {
-          auto next = it;
-          next++;
-          if (next != m_sentList.end ())
+          // Next is not sacked... there is the possibility to merge
+          if (! (*next)->m_sacked)
             {
-              // Next is not sacked... there is the possibility to merge
-              if (! (*next)->m_sacked)
-                {
-                  s = std::min(s, (*it)->m_packet->GetSize () + (*next)->m_packet->GetSize ());
-                }
-              else
-                {
-                  // Next is sacked... better to retransmit only the first segment
-                  s = std::min(s, (*it)->m_packet->GetSize ());
-                }
+              s = std::min(s, (*it)->m_packet->GetSize () + (*next)->m_packet->GetSize ());
             }
           else
             {
+              // Next is sacked... better to retransmit only the first segment
               s = std::min(s, (*it)->m_packet->GetSize ());
             }
-          break;
+        }
+      else
+        {
+          s = std::min(s, (*it)->m_packet->GetSize ());
         }
     }
 
@@ -395,10 +395,28 @@ TcpTxBuffer::SplitItems (TcpTxItem *t1, TcpTxItem *t2, uint32_t size) const
   NS_LOG_INFO ("Split of size " << size << " result: t1 " << *t1 << " t2 " << *t2);
 }
 
+TcpTxBuffer::PacketList::iterator
+TcpTxBuffer::FindSentItem (const SequenceNumber32 &seq) const
+{
+  NS_ASSERT (!m_sentIndex.empty ());
+  SentIndex::const_iterator it = m_sentIndex.upper_bound (seq);
+  if (it != m_sentIndex.begin ())
+    {
+      --it;
+    }
+  return it->second;
+}
+
+void
+TcpTxBuffer::IndexSentItem (PacketList::iterator it)
+{
+  m_sentIndex[(*it)->m_startSeq] = it;
+}
+
 TcpTxItem*
 TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listStartFrom,
                                 uint32_t numBytes, const SequenceNumber32 &seq,
-                                bool *listEdited) const
+                                bool *listEdited)
 {
   NS_LOG_FUNCTION (this << numBytes << seq);
 
@@ -432,14 +450,22 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
   Ptr<Packet> currentPacket = nullptr;
   TcpTxItem *currentItem = nullptr;
   TcpTxItem *outItem = nullptr;
+  bool sentList = &list == &m_sentList;
   PacketList::iterator it = list.begin ();
   SequenceNumber32 beginOfCurrentPacket = listStartFrom;
 
+  if (sentList && seq > listStartFrom && !m_sentIndex.empty ())
+    {
+      // Start from the item containing seq
+      it = FindSentItem (seq);
+      beginOfCurrentPacket = (*it)->m_startSeq;
+    }
+
   while (it != list.end ())
     {
       currentItem = *it;
       currentPacket = currentItem->m_packet;
-      NS_ASSERT_MSG (list != m_sentList || currentItem->m_startSeq >= m_firstByteSeq,
+      NS_ASSERT_MSG (!sentList || currentItem->m_startSeq >= m_firstByteSeq,
                      "start: " << m_firstByteSeq << " currentItem start: " <<
                      currentItem->m_startSeq);
 
@@ -469,7 +495,12 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
               SplitItems (firstPart, currentItem, seq - beginOfCurrentPacket);
 
               // insert firstPart before currentItem
-              list.insert (it, firstPart);
+              PacketList::iterator firstPartIt = list.insert (it, firstPart);
+              if (sentList)
+                {
+                  IndexSentItem (firstPartIt);
+                  IndexSentItem (it);
+                }
               if (listEdited)
                 {
                   *listEdited = true;
@@ -535,7 +566,12 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
               SplitItems (firstPart, currentItem, numBytes);
 
               // insert firstPart before currentItem
-              list.insert (it, firstPart);
+              PacketList::iterator firstPartIt = list.insert (it, firstPart);
+              if (sentList)
+                {
+                  IndexSentItem (firstPartIt);
+                  IndexSentItem (it);
+                }
               if (listEdited)
                 {
                   *listEdited = true;
@@ -565,6 +601,10 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
 
           MergeItems (currentItem, next);
           list.erase (it);
+          if (sentList)
+            {
+              m_sentIndex.erase (next->m_startSeq);
+            }
 
           delete next;
 
@@ -693,6 +733,7 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 
           RemoveFromCounts (item, pktSize);
 
+          m_sentIndex.erase (item->m_startSeq);
           i = m_sentList.erase (i);
           NS_LOG_INFO ("Removed " << *item << " lost: " << m_lostOut <<
                        " retrans: " << m_retrans << " sacked: " << m_sackedOut <<
@@ -705,7 +746,9 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           NS_LOG_INFO (*item);
           // PacketTags are preserved when fragmenting
           item->m_packet = item->m_packet->CreateFragment (offset, pktSize);
+          m_sentIndex.erase (item->m_startSeq);
           item->m_startSeq += offset;
+          IndexSentItem (i);
           m_size -= offset;
           m_sentSize -= offset;
           m_firstByteSeq += offset;
@@ -723,6 +766,14 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
     {
       m_firstByteSeq = seq;
     }
+  if (m_leftOutUpTo < m_firstByteSeq)
+    {
+      m_leftOutUpTo = m_firstByteSeq;
+    }
+  if (m_highestLost < m_firstByteSeq)
+    {
+      m_highestLost = m_firstByteSeq;
+    }
 
   if (!m_sentList.empty ())
     {
@@ -736,8 +787,8 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           head->m_sacked = false;
           m_sackedOut -= head->m_packet->GetSize ();
           NS_LOG_INFO ("Moving the SACK flag from the HEAD to another segment");
-          AddRenoSack ();
           MarkHeadAsLost ();
+          AddRenoSack ();
         }
 
       NS_ASSERT_MSG (head->m_startSeq == seq,
@@ -777,6 +828,13 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
           return false;
         }
 
+      if ((*option_it).first > m_firstByteSeq && !m_sentIndex.empty ())
+        {
+          // Start from the item containing the beginning of the block
+          item_it = FindSentItem ((*option_it).first);
+          beginOfCurrentPacket = (*item_it)->m_startSeq;
+        }
+
       while (item_it != m_sentList.end ())
         {
           uint32_t pktSize = (*item_it)->m_packet->GetSize ();
@@ -865,6 +923,9 @@ TcpTxBuffer::UpdateLostCount ()
                    ", will start from item " << *(*m_highestSack.first));
     }
 
+  // Once the threshold is reached, every item down to the head is lost or
+  // sacked. Below m_leftOutUpTo, this is already the case.
+  SequenceNumber32 leftOutUpTo = m_leftOutUpTo;
   for (auto it = m_highestSack.first; it != m_sentList.begin(); --it)
     {
       TcpTxItem *item = *it;
@@ -875,10 +936,17 @@ TcpTxBuffer::UpdateLostCount ()
 
       if (sacked >= m_dupAckThresh)
         {
+          if (item->m_startSeq < m_leftOutUpTo)
+            {
+              break;
+            }
+          if (leftOutUpTo < item->m_startSeq + item->m_packet->GetSize ())
+            {
+              leftOutUpTo = item->m_startSeq + item->m_packet->GetSize ();
+            }
           if (!item->m_sacked && !item->m_lost)
             {
-              item->m_lost = true;
-              m_lostOut += item->m_packet->GetSize ();
+              MarkAsLost (item);
             }
         }
       beginOfCurrentPacket -= item->m_packet->GetSize ();
@@ -889,9 +957,9 @@ TcpTxBuffer::UpdateLostCount ()
       TcpTxItem *item = *m_sentList.begin ();
       if (!item->m_lost)
         {
-          item->m_lost = true;
-          m_lostOut += item->m_packet->GetSize ();
+          MarkAsLost (item);
         }
+      m_leftOutUpTo = leftOutUpTo;
     }
   NS_LOG_INFO ("Status after the update: " << *this);
   ConsistencyCheck ();
@@ -902,7 +970,6 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq) const
 {
   NS_LOG_FUNCTION (this << seq);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
   PacketList::const_iterator it;
 
   if (seq >= m_highestSack.second)
@@ -910,27 +977,26 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq) const
       return false;
     }
 
-  // In theory, using a map and hints when inserting elements can improve
-  // performance
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  // Start from the first item beginning at or after seq
+  SentIndex::const_iterator first = m_sentIndex.lower_bound (seq);
+  if (first == m_sentIndex.end ())
     {
-      // Search for the right iterator before calling IsLost()
-      if (beginOfCurrentPacket >= seq)
-        {
-          if ((*it)->m_lost == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
-              return true;
-            }
+      return false;
+    }
 
-          if ((*it)->m_sacked == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
-              return false;
-            }
+  for (it = first->second; it != m_sentList.end (); ++it)
+    {
+      if ((*it)->m_lost == true)
+        {
+          NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
+          return true;
         }
 
-      beginOfCurrentPacket += (*it)->m_packet->GetSize ();
+      if ((*it)->m_sacked == true)
+        {
+          NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
+          return false;
+        }
     }
 
   return false;
@@ -959,11 +1025,20 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
   SequenceNumber32 seqPerRule3;
   bool isSeqPerRule3Valid = false;
   SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
+  bool unsentData = SizeFromSequence (m_firstByteSeq + m_sentSize) > 0;
 
   for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
     {
       item = *it;
 
+      // No item from here on is lost; stop unless rule (3) still needs a
+      // sequence number.
+      if (beginOfCurrentPkt >= m_highestLost
+          && (!isRecovery || unsentData || (isSeqPerRule3Valid && seqPerRule3.GetValue () != 0)))
+        {
+          break;
+        }
+
       // Condition 1.a , 1.b , and 1.c
       if (item->m_retrans == false && item->m_sacked == false)
         {
@@ -991,7 +1066,7 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
    *     octets of previously unsent data starting with sequence number
    *     HighData+1 MUST be returned.
    */
-  if (SizeFromSequence (m_firstByteSeq + m_sentSize) > 0)
+  if (unsentData)
     {
       NS_LOG_INFO ("There is unsent data. Send it");
       *seq = m_firstByteSeq + m_sentSize;
@@ -1186,6 +1261,7 @@ TcpTxBuffer::ResetRenoSack ()
     }
 
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_leftOutUpTo = m_firstByteSeq;
 }
 
 void
@@ -1203,11 +1279,14 @@ TcpTxBuffer::ResetSentList ()
       m_sentList.pop_back ();
     }
 
+  m_sentIndex.clear ();
   m_sentSize = 0;
   m_lostOut = 0;
   m_retrans = 0;
   m_sackedOut = 0;
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_leftOutUpTo = m_firstByteSeq;
+  m_highestLost = m_firstByteSeq;
 }
 
 void
@@ -1219,6 +1298,11 @@ TcpTxBuffer::ResetLastSegmentSent ()
       TcpTxItem *item = m_sentList.back ();
 
       m_sentList.pop_back ();
+      m_sentIndex.erase (item->m_startSeq);
+      if (item->m_startSeq < m_leftOutUpTo)
+        {
+          m_leftOutUpTo = item->m_startSeq;
+        }
       m_sentSize -= item->m_packet->GetSize ();
       if (item->m_retrans)
         {
@@ -1271,6 +1355,13 @@ TcpTxBuffer::SetSentListLost (bool resetSack)
       (*it)->m_retrans = false;
     }
 
+  // Every item is now either lost or sacked
+  m_leftOutUpTo = m_firstByteSeq + m_sentSize;
+  if (m_highestLost < m_leftOutUpTo)
+    {
+      m_highestLost = m_leftOutUpTo;
+    }
+
   NS_LOG_INFO ("Set sent list lost, status: " << *this);
   NS_ASSERT_MSG (m_sentSize >= m_sackedOut + m_lostOut, *this);
   ConsistencyCheck ();
@@ -1329,13 +1420,24 @@ TcpTxBuffer::MarkHeadAsLost ()
 
       if (! m_sentList.front()->m_lost)
         {
-          m_sentList.front()->m_lost = true;
-          m_lostOut += m_sentList.front ()->m_packet->GetSize ();
+          MarkAsLost (m_sentList.front ());
         }
     }
   ConsistencyCheck ();
 }
 
+void
+TcpTxBuffer::MarkAsLost (TcpTxItem *item)
+{
+  NS_LOG_FUNCTION (this << *item);
+  item->m_lost = true;
+  m_lostOut += item->m_packet->GetSize ();
+  if (m_highestLost < item->m_startSeq + item->m_packet->GetSize ())
+    {
+      m_highestLost = item->m_startSeq + item->m_packet->GetSize ();
+    }
+}
+
 void
 TcpTxBuffer::AddRenoSack (void)
 {
@@ -1406,6 +1508,25 @@ TcpTxBuffer::ConsistencyCheck () const
                  " stored lost: " << m_lostOut);
   NS_ASSERT_MSG (retrans == m_retrans, " Counted retrans: " << retrans <<
                  " stored retrans: " << m_retrans);
+
+  NS_ASSERT_MSG (m_sentIndex.size () == m_sentList.size (), "Indexed " <<
+                 m_sentIndex.size () << " sent items out of " << m_sentList.size ());
+  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
+    {
+      SentIndex::const_iterator index = m_sentIndex.find ((*it)->m_startSeq);
+      NS_ASSERT_MSG (index != m_sentIndex.end () && index->second == it,
+                     "Sent item " << **it << " not indexed");
+      if ((*it)->m_startSeq < m_leftOutUpTo)
+        {
+          NS_ASSERT_MSG ((*it)->m_lost || (*it)->m_sacked, "Item " << **it <<
+                         " below " << m_leftOutUpTo << " neither lost nor sacked");
+        }
+      if ((*it)->m_lost)
+        {
+          NS_ASSERT_MSG ((*it)->m_startSeq + (*it)->m_packet->GetSize () <= m_highestLost,
+                         "Lost item " << **it << " above " << m_highestLost);
+        }
+    }
 }
 
 std::ostream &
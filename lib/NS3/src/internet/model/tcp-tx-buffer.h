@@ -28,6 +28,7 @@
 #include "ns3/nstime.h"
 #include "ns3/tcp-option-sack.h"
 #include "ns3/packet.h"
+#include <map>
 
 namespace ns3 {
 class Packet;
@@ -105,6 +106,13 @@ public:
  * documentation) and maintaining the scoreboard is a matter of travelling the
  * list and set the SACK flag on the corresponding segment sent.
  *
+ * The sent items are also indexed by their starting sequence number, so that
+ * a SACK block, a retransmission or a loss query starts from the right item
+ * instead of walking the list from SND.UNA. Two sequence numbers bound the
+ * remaining walks: every item starting below the first one is lost or sacked,
+ * so the lost count update stops there, and no item ending above the second
+ * one is lost, so NextSeg stops there.
+ *
  * Item properties
  * ---------------
  *
@@ -410,6 +418,28 @@ private:
   friend std::ostream & operator<< (std::ostream & os, TcpTxBuffer const & tcpTxBuf);
 
   typedef std::list<TcpTxItem*> PacketList; //!< container for data stored in the buffer
+  typedef std::map<SequenceNumber32, PacketList::iterator> SentIndex; //!< sent items by starting sequence number
+
+  /**
+   * \brief Find the sent item containing a sequence number
+   *
+   * \param seq the sequence number
+   * \return the item containing seq, the last item if seq is beyond SND.NXT,
+   * or the first item if seq is before SND.UNA
+   */
+  PacketList::iterator FindSentItem (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Add a sent item to the index
+   * \param it the item in the sent list
+   */
+  void IndexSentItem (PacketList::iterator it);
+
+  /**
+   * \brief Mark an item as lost, and account for it
+   * \param item the item, which is neither lost nor sacked
+   */
+  void MarkAsLost (TcpTxItem *item);
 
   /**
    * \brief Update the lost count
@@ -560,7 +590,7 @@ private:
    */
   TcpTxItem* GetPacketFromList (PacketList &list, const SequenceNumber32 &startingSeq,
                                 uint32_t numBytes, const SequenceNumber32 &requestedSeq,
-                                bool *listEdited = nullptr) const;
+                                bool *listEdited = nullptr);
 
   /**
    * \brief Merge two TcpTxItem
@@ -601,6 +631,7 @@ private:
 
   PacketList m_appList;  //!< Buffer for application data
   PacketList m_sentList; //!< Buffer for sent (but not acked) data
+  SentIndex m_sentIndex; //!< Index of the sent list
   uint32_t m_maxBuffer;  //!< Max number of data bytes in buffer (SND.WND)
   uint32_t m_size;       //!< Size of all data in this buffer
   uint32_t m_sentSize;   //!< Size of sent (and not discarded) segments
@@ -612,6 +643,9 @@ private:
   uint32_t m_sackedOut {0}; //!< Number of sacked bytes
   uint32_t m_retrans   {0}; //!< Number of retransmitted bytes
 
+  SequenceNumber32 m_leftOutUpTo; //!< Every sent item starting before it is lost or sacked
+  SequenceNumber32 m_highestLost; //!< No sent item ending after it is lost
+
   uint32_t m_dupAckThresh {0}; //!< Duplicate Ack threshold from TcpSocketBase
   uint32_t m_segmentSize {0}; //!< Segment size from TcpSocketBase
   bool     m_renoSack {false}; //!< Indicates if AddRenoSack was called
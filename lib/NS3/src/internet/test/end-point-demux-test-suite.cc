@@ -0,0 +1,260 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "../model/ipv4-end-point.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+#include "../model/ipv6-end-point-demux.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("EndPointDemuxTest");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4EndPointDemux lookups of connected and listening endpoints.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Look up the endpoint receiving a packet.
+   * \param demux the demux
+   * \param daddr the destination address
+   * \param dport the destination port
+   * \param saddr the source address
+   * \param sport the source port
+   * \returns the endpoint, or 0 if none matches
+   */
+  static Ipv4EndPoint *Lookup (Ipv4EndPointDemux &demux, Ipv4Address daddr, uint16_t dport,
+                               Ipv4Address saddr, uint16_t sport);
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Ipv4EndPointDemux lookups")
+{
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxTestCase::Lookup (Ipv4EndPointDemux &demux, Ipv4Address daddr, uint16_t dport,
+                                   Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints endPoints = demux.Lookup (daddr, dport, saddr, sport, 0);
+  return endPoints.empty () ? 0 : endPoints.front ();
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  Ipv4Address local ("10.0.0.1");
+
+  Ipv4EndPoint *listener = demux.Allocate (0, Ipv4Address::GetAny (), 80);
+  std::vector<Ipv4EndPoint *> connected;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      connected.push_back (demux.Allocate (0, local, 80, Ipv4Address (0x0a000100 + i), 1000 + i));
+    }
+  NS_TEST_ASSERT_MSG_NE (connected.back (), 0, "Connected endpoint not allocated");
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv4Address ("10.0.1.5"), 1005), connected[5],
+                         "Packet from a connected peer not demultiplexed to its endpoint");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv4Address ("10.0.1.5"), 2000), listener,
+                         "Packet from another port of the peer not demultiplexed to the listener");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv4Address ("10.0.2.1"), 0), listener,
+                         "Packet with source port 0 not demultiplexed to the listener");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 81, Ipv4Address ("10.0.1.5"), 1005), 0,
+                         "Packet to a closed port demultiplexed");
+
+  // A duplicate is detected whether or not the peer is a wildcard.
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 80, Ipv4Address ("10.0.1.7"), 1007), 0,
+                         "Duplicated connected endpoint allocated");
+  NS_TEST_ASSERT_MSG_NE (demux.Allocate (0, local, 82, Ipv4Address::GetAny (), 7), 0,
+                         "Endpoint with a wildcard peer address not allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 82, Ipv4Address::GetAny (), 7), 0,
+                         "Duplicated endpoint with a wildcard peer address allocated");
+
+  // An endpoint connected after its allocation, as TCP does, moves in the index.
+  Ipv4EndPoint *client = demux.Allocate (0, local, 90);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 90, Ipv4Address ("10.0.3.1"), 5000), client,
+                         "Packet not demultiplexed to the unconnected endpoint");
+  client->SetPeer (Ipv4Address ("10.0.3.1"), 5000);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 90, Ipv4Address ("10.0.3.1"), 5000), client,
+                         "Packet not demultiplexed to the endpoint after it connected");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 90, Ipv4Address ("10.0.3.2"), 5000), 0,
+                         "Packet from another peer demultiplexed to the connected endpoint");
+  connected[7]->SetPeer (Ipv4Address ("10.0.4.1"), 6000);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv4Address ("10.0.4.1"), 6000), connected[7],
+                         "Packet not demultiplexed to the endpoint after its peer changed");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv4Address ("10.0.1.7"), 1007), listener,
+                         "Packet from the former peer demultiplexed to the endpoint");
+  // No entry is left under the former peer once the endpoint is removed.
+  demux.DeAllocate (connected[7]);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv4Address ("10.0.1.7"), 1007), listener,
+                         "Packet from the former peer demultiplexed to a removed endpoint");
+  client->SetPeer (Ipv4Address::GetAny (), 0);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 90, Ipv4Address ("10.0.3.2"), 5000), client,
+                         "Packet not demultiplexed to the endpoint after it disconnected");
+
+  // Endpoints which can not receive are skipped.
+  connected[5]->SetRxEnabled (false);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv4Address ("10.0.1.5"), 1005), listener,
+                         "Packet demultiplexed to an endpoint which can not receive");
+
+  demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (90), false, "Port still in use after its endpoint was removed");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), true, "Port not in use");
+  demux.DeAllocate (listener);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv4Address ("10.0.2.1"), 1000), 0,
+                         "Packet demultiplexed to a removed endpoint");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv4Address ("10.0.1.99"), 1099), connected[99],
+                         "Packet not demultiplexed to its endpoint after the listener was removed");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv6EndPointDemux lookups of connected and listening endpoints.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Look up the endpoint receiving a packet.
+   * \param demux the demux
+   * \param daddr the destination address
+   * \param dport the destination port
+   * \param saddr the source address
+   * \param sport the source port
+   * \returns the endpoint, or 0 if none matches
+   */
+  static Ipv6EndPoint *Lookup (Ipv6EndPointDemux &demux, Ipv6Address daddr, uint16_t dport,
+                               Ipv6Address saddr, uint16_t sport);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Ipv6EndPointDemux lookups")
+{
+}
+
+Ipv6EndPoint *
+Ipv6EndPointDemuxTestCase::Lookup (Ipv6EndPointDemux &demux, Ipv6Address daddr, uint16_t dport,
+                                   Ipv6Address saddr, uint16_t sport)
+{
+  Ipv6EndPointDemux::EndPoints endPoints = demux.Lookup (daddr, dport, saddr, sport, 0);
+  return endPoints.empty () ? 0 : endPoints.front ();
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6EndPointDemux demux;
+  Ipv6Address local ("2001:db8::1");
+
+  Ipv6EndPoint *listener = demux.Allocate (0, Ipv6Address::GetAny (), 80);
+  std::vector<Ipv6EndPoint *> connected;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      uint8_t peer[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, static_cast<uint8_t> (i) };
+      connected.push_back (demux.Allocate (0, local, 80, Ipv6Address (peer), 1000 + i));
+    }
+  NS_TEST_ASSERT_MSG_NE (connected.back (), 0, "Connected endpoint not allocated");
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv6Address ("2001:db8:1::5"), 1005), connected[5],
+                         "Packet from a connected peer not demultiplexed to its endpoint");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv6Address ("2001:db8:1::5"), 2000), listener,
+                         "Packet from another port of the peer not demultiplexed to the listener");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 81, Ipv6Address ("2001:db8:1::5"), 1005), 0,
+                         "Packet to a closed port demultiplexed");
+
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 80, Ipv6Address ("2001:db8:1::7"), 1007), 0,
+                         "Duplicated connected endpoint allocated");
+  NS_TEST_ASSERT_MSG_NE (demux.Allocate (0, local, 82, Ipv6Address::GetAny (), 7), 0,
+                         "Endpoint with a wildcard peer address not allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 82, Ipv6Address::GetAny (), 7), 0,
+                         "Duplicated endpoint with a wildcard peer address allocated");
+
+  Ipv6EndPoint *client = demux.Allocate (0, local, 90);
+  client->SetPeer (Ipv6Address ("2001:db8:3::1"), 5000);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 90, Ipv6Address ("2001:db8:3::1"), 5000), client,
+                         "Packet not demultiplexed to the endpoint after it connected");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 90, Ipv6Address ("2001:db8:3::2"), 5000), 0,
+                         "Packet from another peer demultiplexed to the connected endpoint");
+  client->SetLocalPort (91);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 90, Ipv6Address ("2001:db8:3::1"), 5000), 0,
+                         "Packet to the former local port demultiplexed to the endpoint");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 91, Ipv6Address ("2001:db8:3::1"), 5000), client,
+                         "Packet not demultiplexed to the endpoint after its local port changed");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (90), false, "Former local port still in use");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (91), true, "New local port not in use");
+
+  connected[7]->SetPeer (Ipv6Address ("2001:db8:4::1"), 6000);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv6Address ("2001:db8:4::1"), 6000), connected[7],
+                         "Packet not demultiplexed to the endpoint after its peer changed");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv6Address ("2001:db8:1::7"), 1007), listener,
+                         "Packet from the former peer demultiplexed to the endpoint");
+  demux.DeAllocate (connected[7]);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv6Address ("2001:db8:1::7"), 1007), listener,
+                         "Packet from the former peer demultiplexed to a removed endpoint");
+
+  demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (91), false, "Port still in use after its endpoint was removed");
+  demux.DeAllocate (listener);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv6Address ("2001:db8:2::1"), 1000), 0,
+                         "Packet demultiplexed to a removed endpoint");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, Ipv6Address ("2001:db8:1::63"), 1099), connected[99],
+                         "Packet not demultiplexed to its endpoint after the listener was removed");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief End point demux TestSuite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
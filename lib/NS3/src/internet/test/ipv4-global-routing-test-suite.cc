@@ -15,6 +15,9 @@
  */
 
 #include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
 #include "ns3/inet-socket-address.h"
@@ -42,6 +45,7 @@
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/bridge-helper.h"
+#include "ns3/random-variable-stream.h"
 
 using namespace ns3;
 
@@ -1244,6 +1248,293 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting lookup test
+ *
+ * Checks that the route found by the prefix indexes is the first one of
+ * the routing table matching the destination, as when the table was
+ * scanned, while routes are added and removed.
+ */
+class Ipv4GlobalRoutingLookupTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Check the routes to random destinations.
+   * \param n The number of destinations.
+   */
+  void CheckLookups (uint32_t n);
+
+  Ptr<Ipv4> m_ipv4;                   //!< IPv4 of the node
+  Ptr<Ipv4GlobalRouting> m_routing;   //!< Global routing of the node
+  Ptr<UniformRandomVariable> m_rand;  //!< Random routes and destinations
+};
+
+Ipv4GlobalRoutingLookupTestCase::Ipv4GlobalRoutingLookupTestCase ()
+  : TestCase ("Global routing lookups match a scan of the routing table")
+{
+}
+
+void
+Ipv4GlobalRoutingLookupTestCase::CheckLookups (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ipv4Header header;
+      header.SetDestination (Ipv4Address (0x0a000000 | m_rand->GetInteger (0, 0x3ff)));
+      uint32_t oifIndex = m_rand->GetInteger (0, 3);
+      Ptr<NetDevice> oif = oifIndex == 0 ? 0 : m_ipv4->GetNetDevice (oifIndex);
+      Socket::SocketErrno sockerr;
+      Ptr<Ipv4Route> route = m_routing->RouteOutput (0, header, oif, sockerr);
+
+      // Host routes come first in the table, then network routes, then
+      // external ones.
+      Ipv4RoutingTableEntry *expected = 0;
+      for (uint32_t j = 0; j < m_routing->GetNRoutes () && expected == 0; j++)
+        {
+          Ipv4RoutingTableEntry *entry = m_routing->GetRoute (j);
+          if (entry->GetDestNetworkMask ().IsMatch (header.GetDestination (), entry->GetDestNetwork ())
+              && (oif == 0 || oif == m_ipv4->GetNetDevice (entry->GetInterface ())))
+            {
+              expected = entry;
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ ((route != 0), (expected != 0), "Wrong route existence to " << header.GetDestination ());
+      if (expected != 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), expected->GetGateway (), "Wrong route to " << header.GetDestination ());
+        }
+    }
+}
+
+void
+Ipv4GlobalRoutingLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  SimpleNetDeviceHelper devHelper;
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      devices.Add (devHelper.Install (node));
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("172.16.0.0", "255.255.255.0");
+  ipv4.Assign (devices);
+
+  m_ipv4 = node->GetObject<Ipv4> ();
+  m_routing = CreateObject<Ipv4GlobalRouting> ();
+  m_routing->SetIpv4 (m_ipv4);
+  m_rand = CreateObject<UniformRandomVariable> ();
+  m_rand->SetStream (1);
+
+  // Overlapping routes within 10.0.0.0/22, each with its own gateway.
+  uint32_t gateway = 0xc0a86400;
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      Ipv4Address dest (0x0a000000 | m_rand->GetInteger (0, 0x3ff));
+      Ipv4Mask mask (0xffffffff << (32 - m_rand->GetInteger (16, 31)));
+      switch (m_rand->GetInteger (0, 2))
+        {
+        case 0:
+          m_routing->AddHostRouteTo (dest, Ipv4Address (gateway++), m_rand->GetInteger (1, 3));
+          break;
+        case 1:
+          m_routing->AddNetworkRouteTo (dest, mask, Ipv4Address (gateway++), m_rand->GetInteger (1, 3));
+          break;
+        default:
+          m_routing->AddASExternalRouteTo (dest, mask, Ipv4Address (gateway++), m_rand->GetInteger (1, 3));
+          break;
+        }
+    }
+  CheckLookups (2000);
+
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      m_routing->RemoveRoute (m_rand->GetInteger (0, m_routing->GetNRoutes () - 1));
+    }
+  CheckLookups (2000);
+
+  // A mask which is not a prefix falls back to scanning the table.
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.0.0.7"), Ipv4Mask ("255.255.252.7"), Ipv4Address ("192.168.99.1"), 1);
+  CheckLookups (500);
+
+  m_routing->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting incremental SPF test
+ *
+ * Checks that recomputing the routes incrementally, on several threads,
+ * after a topology change gives the same routing tables as a full
+ * recomputation on a single thread.
+ */
+class Ipv4GlobalRoutingIncrementalSpfTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingIncrementalSpfTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Get the routes of all the nodes, in routing table order.
+   * \return The routes of each node.
+   */
+  std::vector<std::string> GetRoutes (void) const;
+  /**
+   * \brief Recompute the routes incrementally after a topology change,
+   * and compare them with a full recomputation.
+   * \param change The topology change.
+   */
+  void CheckRecompute (std::string change);
+
+  NodeContainer m_nodes; //!< Nodes used in the test.
+};
+
+Ipv4GlobalRoutingIncrementalSpfTestCase::Ipv4GlobalRoutingIncrementalSpfTestCase ()
+  : TestCase ("Incremental and threaded SPF match a full recomputation")
+{
+}
+
+std::vector<std::string>
+Ipv4GlobalRoutingIncrementalSpfTestCase::GetRoutes (void) const
+{
+  std::vector<std::string> tables;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = m_nodes.Get (i)->GetObject<Ipv4> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      std::vector<std::string> routes;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          std::ostringstream oss;
+          oss << *routing->GetRoute (j);
+          routes.push_back (oss.str ());
+        }
+      std::ostringstream table;
+      for (uint32_t j = 0; j < routes.size (); j++)
+        {
+          table << routes[j] << std::endl;
+        }
+      tables.push_back (table.str ());
+    }
+  return tables;
+}
+
+void
+Ipv4GlobalRoutingIncrementalSpfTestCase::CheckRecompute (std::string change)
+{
+  Config::SetGlobal ("GlobalRoutingIncrementalSpf", BooleanValue (true));
+  Config::SetGlobal ("GlobalRoutingSpfThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> incremental = GetRoutes ();
+
+  Config::SetGlobal ("GlobalRoutingIncrementalSpf", BooleanValue (false));
+  Config::SetGlobal ("GlobalRoutingSpfThreads", UintegerValue (1));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> full = GetRoutes ();
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (incremental[i], full[i], "Wrong routes of node " << i << " after " << change);
+    }
+
+  // Keep the trees of the new topology for the next change.
+  Config::SetGlobal ("GlobalRoutingIncrementalSpf", BooleanValue (true));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+}
+
+void
+Ipv4GlobalRoutingIncrementalSpfTestCase::DoRun (void)
+{
+  // A ring of 9 point-to-point links, a backup link across it, a LAN off
+  // the ring with a host hanging off it, and a diamond giving node 8 two
+  // equal-cost paths to node 14.  The odd ring and the metrics keep
+  // equal-cost paths away from the LAN, which SPF does not support beyond
+  // the first hop.
+  m_nodes.Create (15);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (m_nodes);
+
+  SimpleNetDeviceHelper p2pHelper;
+  p2pHelper.SetNetDevicePointToPointMode (true);
+  SimpleNetDeviceHelper lanHelper;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < 9; i++)
+    {
+      Ipv4InterfaceContainer link = ipv4.Assign (p2pHelper.Install (NodeContainer (m_nodes.Get (i), m_nodes.Get ((i + 1) % 9))));
+      link.Get (0).first->SetMetric (link.Get (0).second, 10);
+      link.Get (1).first->SetMetric (link.Get (1).second, 10);
+      ipv4.NewNetwork ();
+    }
+  Ipv4InterfaceContainer backup = ipv4.Assign (p2pHelper.Install (NodeContainer (m_nodes.Get (2), m_nodes.Get (6))));
+  backup.Get (0).first->SetMetric (backup.Get (0).second, 100);
+  backup.Get (1).first->SetMetric (backup.Get (1).second, 100);
+  ipv4.NewNetwork ();
+  Ipv4InterfaceContainer lan = ipv4.Assign (lanHelper.Install (NodeContainer (m_nodes.Get (0), m_nodes.Get (9), m_nodes.Get (10))));
+  ipv4.NewNetwork ();
+  ipv4.Assign (p2pHelper.Install (NodeContainer (m_nodes.Get (9), m_nodes.Get (11))));
+  ipv4.NewNetwork ();
+  uint32_t diamond[4][2] = { { 8, 12 }, { 8, 13 }, { 12, 14 }, { 13, 14 } };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ipv4InterfaceContainer link = ipv4.Assign (p2pHelper.Install (NodeContainer (m_nodes.Get (diamond[i][0]), m_nodes.Get (diamond[i][1]))));
+      link.Get (0).first->SetMetric (link.Get (0).second, 10);
+      link.Get (1).first->SetMetric (link.Get (1).second, i == 3 ? 11 : 10);
+      ipv4.NewNetwork ();
+    }
+
+  Config::SetGlobal ("GlobalRoutingIncrementalSpf", BooleanValue (true));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  // The backup link is on no shortest path, so most routers keep their trees.
+  backup.Get (0).first->SetMetric (backup.Get (0).second, 50);
+  CheckRecompute ("changing the metric of the backup link");
+  backup.Get (0).first->SetDown (backup.Get (0).second);
+  CheckRecompute ("bringing the backup link down");
+  backup.Get (0).first->SetUp (backup.Get (0).second);
+  CheckRecompute ("bringing the backup link up");
+  backup.Get (0).first->SetMetric (backup.Get (0).second, 15);
+  backup.Get (1).first->SetMetric (backup.Get (1).second, 15);
+  CheckRecompute ("making the backup link a shortcut");
+
+  // Interface 2 of nodes 4 and 5 leads to the next node of the ring.
+  m_nodes.Get (4)->GetObject<Ipv4> ()->SetMetric (2, 25);
+  CheckRecompute ("changing the metric of a ring link");
+  m_nodes.Get (5)->GetObject<Ipv4> ()->SetDown (2);
+  CheckRecompute ("bringing a ring link down");
+  lan.Get (2).first->SetDown (lan.Get (2).second);
+  CheckRecompute ("leaving the LAN");
+  m_nodes.Get (5)->GetObject<Ipv4> ()->SetUp (2);
+  lan.Get (2).first->SetUp (lan.Get (2).second);
+  CheckRecompute ("bringing the links back up");
+
+  // Interface 2 of node 14 leads to node 13, on no shortest path but those
+  // from node 14: the other routers replay their trees, and their routes
+  // to node 14 and beyond, through either side of the diamond, must come
+  // in the same order as after a full recomputation.
+  m_nodes.Get (14)->GetObject<Ipv4> ()->SetMetric (2, 12);
+  CheckRecompute ("changing the metric of the longer side of the diamond");
+
+  Config::SetGlobal ("GlobalRoutingIncrementalSpf", BooleanValue (false));
+  Config::SetGlobal ("GlobalRoutingSpfThreads", UintegerValue (1));
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -1267,6 +1558,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingLookupTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingIncrementalSpfTestCase, TestCase::QUICK);
   }
 
 static Ipv4GlobalRoutingTestSuite g_globalRoutingTestSuite; //!< Static variable for test initialization
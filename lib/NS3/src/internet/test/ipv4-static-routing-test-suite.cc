@@ -35,6 +35,8 @@
 #include "ns3/simple-net-device-helper.h"
 #include "ns3/socket-factory.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/random-variable-stream.h"
 
 using namespace ns3;
 
@@ -201,6 +203,181 @@ Ipv4StaticRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 StaticRouting lookup Test
+ *
+ * Checks that the routes found by the prefix index are the ones a scan
+ * of the whole table picks, while routes are added and removed.
+ */
+class Ipv4StaticRoutingLookupTestCase : public TestCase
+{
+public:
+  Ipv4StaticRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Add a random route.
+   */
+  void AddRandomRoute (void);
+  /**
+   * \brief Find the route to a destination by scanning the routing table.
+   * \param dest Destination address.
+   * \param oif Output device, or 0 for any.
+   * \param [out] gateway The gateway of the route.
+   * \param [out] interface The interface of the route.
+   * \return True if there is a route.
+   */
+  bool ScanRoutes (Ipv4Address dest, Ptr<NetDevice> oif, Ipv4Address &gateway, uint32_t &interface);
+  /**
+   * \brief Check the routes to random destinations.
+   * \param n The number of destinations.
+   */
+  void CheckLookups (uint32_t n);
+
+  Ptr<Ipv4> m_ipv4;                   //!< IPv4 of the node
+  Ptr<Ipv4StaticRouting> m_routing;   //!< Static routing of the node
+  Ptr<UniformRandomVariable> m_rand;  //!< Random routes and destinations
+  uint32_t m_nextGateway;             //!< Gateway of the next route
+};
+
+Ipv4StaticRoutingLookupTestCase::Ipv4StaticRoutingLookupTestCase ()
+  : TestCase ("Static routing lookups match a scan of the routing table"),
+    m_nextGateway (0)
+{
+}
+
+void
+Ipv4StaticRoutingLookupTestCase::AddRandomRoute (void)
+{
+  // Overlapping prefixes of 10.0.0.0/14, each with its own gateway.
+  uint8_t masklen = m_rand->GetInteger (12, 32);
+  Ipv4Mask mask (0xffffffff << (32 - masklen));
+  Ipv4Address network (0x0a000000 | m_rand->GetInteger (0, 0x3ffff));
+  Ipv4Address gateway (0xc0a86400 + m_nextGateway++);
+  m_routing->AddNetworkRouteTo (network, mask, gateway, m_rand->GetInteger (1, 3), m_rand->GetInteger (0, 2));
+}
+
+bool
+Ipv4StaticRoutingLookupTestCase::ScanRoutes (Ipv4Address dest, Ptr<NetDevice> oif, Ipv4Address &gateway, uint32_t &interface)
+{
+  bool found = false;
+  uint16_t longest_mask = 0;
+  uint32_t shortest_metric = 0xffffffff;
+  for (uint32_t i = 0; i < m_routing->GetNRoutes (); i++)
+    {
+      Ipv4RoutingTableEntry route = m_routing->GetRoute (i);
+      uint32_t metric = m_routing->GetMetric (i);
+      uint16_t masklen = route.GetDestNetworkMask ().GetPrefixLength ();
+      if (!route.GetDestNetworkMask ().IsMatch (dest, route.GetDestNetwork ())
+          || (oif != 0 && oif != m_ipv4->GetNetDevice (route.GetInterface ()))
+          || masklen < longest_mask)
+        {
+          continue;
+        }
+      if (masklen > longest_mask)
+        {
+          shortest_metric = 0xffffffff;
+        }
+      longest_mask = masklen;
+      if (metric > shortest_metric)
+        {
+          continue;
+        }
+      shortest_metric = metric;
+      found = true;
+      gateway = route.GetGateway ();
+      interface = route.GetInterface ();
+      if (masklen == 32)
+        {
+          break;
+        }
+    }
+  return found;
+}
+
+void
+Ipv4StaticRoutingLookupTestCase::CheckLookups (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ipv4Header header;
+      header.SetDestination (Ipv4Address (0x0a000000 | m_rand->GetInteger (0, 0x3ffff)));
+      uint32_t oifIndex = m_rand->GetInteger (0, 3);
+      Ptr<NetDevice> oif = oifIndex == 0 ? 0 : m_ipv4->GetNetDevice (oifIndex);
+      Socket::SocketErrno sockerr;
+      Ptr<Ipv4Route> route = m_routing->RouteOutput (0, header, oif, sockerr);
+      Ipv4Address gateway;
+      uint32_t interface = 0;
+      bool found = ScanRoutes (header.GetDestination (), oif, gateway, interface);
+      NS_TEST_ASSERT_MSG_EQ ((route != 0), found, "Wrong route existence to " << header.GetDestination ());
+      if (found)
+        {
+          NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), gateway, "Wrong route to " << header.GetDestination ());
+          NS_TEST_ASSERT_MSG_EQ (route->GetOutputDevice (), m_ipv4->GetNetDevice (interface),
+                                 "Wrong device to " << header.GetDestination ());
+        }
+    }
+}
+
+void
+Ipv4StaticRoutingLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  SimpleNetDeviceHelper devHelper;
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      devices.Add (devHelper.Install (node));
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("172.16.0.0", "255.255.255.0");
+  ipv4.Assign (devices);
+
+  m_ipv4 = node->GetObject<Ipv4> ();
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  m_routing = ipv4RoutingHelper.GetStaticRouting (m_ipv4);
+  m_rand = CreateObject<UniformRandomVariable> ();
+  m_rand->SetStream (1);
+
+  for (uint32_t i = 0; i < 400; i++)
+    {
+      AddRandomRoute ();
+    }
+  m_routing->SetDefaultRoute (Ipv4Address ("192.168.99.1"), 2, 1);
+  m_routing->SetDefaultRoute (Ipv4Address ("192.168.99.2"), 3, 0);
+  CheckLookups (2000);
+
+  // Remove routes from the middle, and add duplicates of the remaining
+  // ones so that equal prefixes tie on the metric.
+  for (uint32_t i = 0; i < 150; i++)
+    {
+      m_routing->RemoveRoute (m_rand->GetInteger (0, m_routing->GetNRoutes () - 1));
+    }
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Ipv4RoutingTableEntry route = m_routing->GetRoute (m_rand->GetInteger (0, m_routing->GetNRoutes () - 1));
+      m_routing->AddNetworkRouteTo (route.GetDestNetwork (), route.GetDestNetworkMask (),
+                                    Ipv4Address (0xc0a86400 + m_nextGateway++), m_rand->GetInteger (1, 3),
+                                    m_rand->GetInteger (0, 2));
+    }
+  CheckLookups (2000);
+
+  // A mask which is not a prefix falls back to scanning the table.
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.0.0.7"), Ipv4Mask ("255.252.0.255"), Ipv4Address ("192.168.99.3"), 1, 0);
+  CheckLookups (500);
+  m_routing->RemoveRoute (m_routing->GetNRoutes () - 1);
+  CheckLookups (500);
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -217,6 +394,7 @@ Ipv4StaticRoutingTestSuite::Ipv4StaticRoutingTestSuite ()
   : TestSuite ("ipv4-static-routing", UNIT)
 {
   AddTestCase (new Ipv4StaticRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4StaticRoutingLookupTestCase, TestCase::QUICK);
 }
 
 static Ipv4StaticRoutingTestSuite ipv4StaticRoutingTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/mac48-address.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/arp-cache.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief ArpCache test: pending packets and wait reply retransmissions.
+ */
+class ArpCacheTestCase : public TestCase
+{
+public:
+  ArpCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Record an ARP request retransmission.
+   * \param cache The ARP cache.
+   * \param address The address to resolve.
+   */
+  void ArpRequest (Ptr<const ArpCache> cache, Ipv4Address address);
+  /**
+   * \brief Record a dropped packet.
+   * \param packet The packet.
+   */
+  void Drop (Ptr<const Packet> packet);
+
+  std::vector<Ipv4Address> m_requests; //!< The retransmitted ARP requests.
+  uint32_t m_drops;                    //!< The number of dropped packets.
+};
+
+ArpCacheTestCase::ArpCacheTestCase ()
+  : TestCase ("ArpCache pending packets and retransmissions"),
+    m_drops (0)
+{
+}
+
+void
+ArpCacheTestCase::ArpRequest (Ptr<const ArpCache> cache, Ipv4Address address)
+{
+  m_requests.push_back (address);
+}
+
+void
+ArpCacheTestCase::Drop (Ptr<const Packet> packet)
+{
+  m_drops++;
+}
+
+void
+ArpCacheTestCase::DoRun (void)
+{
+  Ptr<ArpCache> cache = CreateObject<ArpCache> ();
+  cache->SetAttribute ("PendingQueueSize", UintegerValue (4));
+  cache->SetAttribute ("MaxRetries", UintegerValue (2));
+  cache->SetArpRequestCallback (MakeCallback (&ArpCacheTestCase::ArpRequest, this));
+  cache->TraceConnectWithoutContext ("Drop", MakeCallback (&ArpCacheTestCase::Drop, this));
+
+  // Pending packets come out in order, and the ring can be reused
+  Ipv4Address a ("10.0.0.1");
+  ArpCache::Entry *entry = cache->Add (a);
+  NS_TEST_ASSERT_MSG_EQ (cache->Lookup (a), entry, "Entry not found");
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      entry->MarkWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (100), Ipv4Header ()));
+      for (uint32_t i = 1; i < 4; i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (entry->UpdateWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (100 + i), Ipv4Header ())),
+                                 true, "Pending packet refused");
+        }
+      NS_TEST_ASSERT_MSG_EQ (entry->UpdateWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (200), Ipv4Header ())),
+                             false, "Pending queue overflow");
+      NS_TEST_ASSERT_MSG_EQ (entry->DequeuePending ().first->GetSize (), 100, "Wrong first pending packet");
+      NS_TEST_ASSERT_MSG_EQ (entry->UpdateWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (104), Ipv4Header ())),
+                             true, "Pending packet refused");
+
+      entry->MarkAlive (Mac48Address ("00:00:00:00:00:01"));
+      std::vector<ArpCache::Ipv4PayloadHeaderPair> pending;
+      entry->DequeueAllPending (pending);
+      NS_TEST_ASSERT_MSG_EQ (pending.size (), 4, "Wrong number of pending packets");
+      for (uint32_t i = 0; i < pending.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (pending[i].first->GetSize (), 101 + i, "Pending packets out of order");
+        }
+      NS_TEST_ASSERT_MSG_EQ (entry->DequeuePending ().first, 0, "Pending packets left");
+      entry->MarkDead ();
+    }
+  std::list<ArpCache::Entry *> inverse = cache->LookupInverse (Mac48Address ("00:00:00:00:00:01"));
+  NS_TEST_ASSERT_MSG_EQ (inverse.size (), 1, "Inverse lookup failed");
+
+  // Only the waiting entries are retried, in the order they started
+  // waiting, and dropped after the last retry
+  Ipv4Address b ("10.0.0.2");
+  Ipv4Address c ("10.0.0.3");
+  ArpCache::Entry *alive = cache->Add (b);
+  alive->MarkWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (10), Ipv4Header ()));
+  alive->MarkAlive (Mac48Address ("00:00:00:00:00:02"));
+  cache->Add (c)->MarkWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (10), Ipv4Header ()));
+  entry->MarkWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (10), Ipv4Header ()));
+  entry->UpdateWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (10), Ipv4Header ()));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_requests.size (), 4, "Wrong number of retransmissions");
+  NS_TEST_EXPECT_MSG_EQ (m_requests[0], c, "Retransmissions out of order");
+  NS_TEST_EXPECT_MSG_EQ (m_requests[1], a, "Retransmissions out of order");
+  NS_TEST_EXPECT_MSG_EQ (m_requests[2], c, "Retransmissions out of order");
+  NS_TEST_EXPECT_MSG_EQ (m_requests[3], a, "Retransmissions out of order");
+  NS_TEST_EXPECT_MSG_EQ (m_drops, 3, "Wrong number of dropped packets");
+  NS_TEST_EXPECT_MSG_EQ (entry->IsDead (), true, "Entry not dead");
+  NS_TEST_EXPECT_MSG_EQ (alive->IsAlive (), true, "Entry not alive");
+
+  // Removing an entry leaves the others reachable
+  cache->Remove (entry);
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup (a), 0, "Removed entry found");
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup (b), alive, "Entry lost");
+  NS_TEST_EXPECT_MSG_NE (cache->Lookup (c), 0, "Entry lost");
+
+  cache->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Neighbor cache TestSuite.
+ */
+class NeighborCacheTestSuite : public TestSuite
+{
+public:
+  NeighborCacheTestSuite ()
+    : TestSuite ("neighbor-cache", UNIT)
+  {
+    AddTestCase (new ArpCacheTestCase, TestCase::QUICK);
+  }
+};
+
+static NeighborCacheTestSuite g_neighborCacheTestSuite; //!< Static variable for test initialization
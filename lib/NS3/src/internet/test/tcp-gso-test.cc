@@ -0,0 +1,489 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/queue.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/tcp-header.h"
+#include "ns3/log.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TcpGsoTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload test.
+ *
+ * Runs a bulk transfer on a lossless link with checksums enabled, with and
+ * without segmentation offload. TCP must hand down super-packets, the
+ * device must only see packets of at most one segment, and the receiver
+ * must get the same data at the same times.
+ */
+class TcpGsoTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param useIpv6 Use IPv6 instead of IPv4.
+   */
+  TcpGsoTestCase (bool useIpv6);
+
+private:
+  virtual void DoRun (void);
+
+  /// Results of a transfer
+  struct Result
+  {
+    uint32_t rxBytes;      //!< bytes received
+    Time done;             //!< time the last byte was received
+    uint32_t maxTxSize;    //!< largest payload handed down by TCP
+    uint32_t devPackets;   //!< packets sent by the device
+    uint32_t maxDevSize;   //!< largest packet sent by the device
+  };
+
+  /**
+   * \brief Run a transfer.
+   * \param gsoMaxSegments The GsoMaxSegments attribute of the sender.
+   * \return the results of the transfer
+   */
+  Result RunTransfer (uint16_t gsoMaxSegments);
+
+  /**
+   * \brief Fill the send buffer of the sender.
+   * \param socket The sending socket.
+   * \param available The space available in the send buffer.
+   */
+  void Fill (Ptr<Socket> socket, uint32_t available);
+  /**
+   * \brief Receive data.
+   * \param socket The receiving socket.
+   */
+  void Receive (Ptr<Socket> socket);
+  /**
+   * \brief Accept a connection.
+   * \param socket The accepted socket.
+   * \param from The address of the peer.
+   */
+  void Accept (Ptr<Socket> socket, const Address &from);
+  /**
+   * \brief Trace the packets handed down by TCP.
+   * \param packet The payload.
+   * \param header The TCP header.
+   * \param socket The socket.
+   */
+  void Tx (Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket);
+  /**
+   * \brief Trace the packets sent by the device.
+   * \param packet The packet.
+   */
+  void DeviceEnqueue (Ptr<const Packet> packet);
+
+  bool m_useIpv6;      //!< Use IPv6 instead of IPv4.
+  uint32_t m_total;    //!< Bytes to transfer.
+  uint32_t m_sent;     //!< Bytes written to the sender.
+  Result m_result;     //!< Results of the current transfer.
+};
+
+TcpGsoTestCase::TcpGsoTestCase (bool useIpv6)
+  : TestCase (useIpv6 ? "TCP segmentation offload over IPv6" : "TCP segmentation offload over IPv4"),
+    m_useIpv6 (useIpv6),
+    m_total (200000),
+    m_sent (0)
+{
+}
+
+void
+TcpGsoTestCase::Fill (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_sent < m_total && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (std::min<uint32_t> (socket->GetTxAvailable (), 1400), m_total - m_sent);
+      int sent = socket->Send (Create<Packet> (size));
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_sent += sent;
+    }
+}
+
+void
+TcpGsoTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      m_result.rxBytes += packet->GetSize ();
+      m_result.done = Simulator::Now ();
+    }
+}
+
+void
+TcpGsoTestCase::Accept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpGsoTestCase::Receive, this));
+}
+
+void
+TcpGsoTestCase::Tx (Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket)
+{
+  m_result.maxTxSize = std::max (m_result.maxTxSize, packet->GetSize ());
+}
+
+void
+TcpGsoTestCase::DeviceEnqueue (Ptr<const Packet> packet)
+{
+  m_result.devPackets++;
+  m_result.maxDevSize = std::max (m_result.maxDevSize, packet->GetSize ());
+}
+
+TcpGsoTestCase::Result
+TcpGsoTestCase::RunTransfer (uint16_t gsoMaxSegments)
+{
+  m_result = Result ();
+  m_sent = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper devices;
+  devices.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (10)));
+  devices.SetDeviceAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+  NetDeviceContainer d = devices.Install (nodes);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  // Both transfers must draw the same ARP and neighbor discovery jitters
+  internet.AssignStreams (nodes, 0);
+
+  Address serverAddress;
+  Address anyAddress;
+  if (m_useIpv6)
+    {
+      Ipv6AddressHelper ipv6;
+      ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+      Ipv6InterfaceContainer interfaces = ipv6.Assign (d);
+      serverAddress = Inet6SocketAddress (interfaces.GetAddress (1, 1), 5000);
+      anyAddress = Inet6SocketAddress (Ipv6Address::GetAny (), 5000);
+    }
+  else
+    {
+      Ipv4AddressHelper ipv4;
+      ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+      Ipv4InterfaceContainer interfaces = ipv4.Assign (d);
+      serverAddress = InetSocketAddress (interfaces.GetAddress (1), 5000);
+      anyAddress = InetSocketAddress (Ipv4Address::GetAny (), 5000);
+    }
+
+  DynamicCast<SimpleNetDevice> (d.Get (0))->GetQueue ()
+    ->TraceConnectWithoutContext ("Enqueue", MakeCallback (&TcpGsoTestCase::DeviceEnqueue, this));
+
+  Ptr<Socket> server = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  server->Bind (anyAddress);
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpGsoTestCase::Accept, this));
+
+  Ptr<Socket> client = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  client->SetAttribute ("SegmentSize", UintegerValue (1000));
+  client->SetAttribute ("GsoMaxSegments", UintegerValue (gsoMaxSegments));
+  client->TraceConnectWithoutContext ("Tx", MakeCallback (&TcpGsoTestCase::Tx, this));
+  client->Bind (m_useIpv6 ? Address (Inet6SocketAddress (Ipv6Address::GetAny (), 0))
+                          : Address (InetSocketAddress (Ipv4Address::GetAny (), 0)));
+  client->SetSendCallback (MakeCallback (&TcpGsoTestCase::Fill, this));
+  // Leave time for the duplicate address detection of IPv6
+  Simulator::Schedule (Seconds (2), &Socket::Connect, client, serverAddress);
+  Simulator::Schedule (Seconds (2.5), &TcpGsoTestCase::Fill, this, client, 0);
+  Simulator::Stop (Seconds (30));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return m_result;
+}
+
+void
+TcpGsoTestCase::DoRun (void)
+{
+  BooleanValue checksumEnabled;
+  GlobalValue::GetValueByName ("ChecksumEnabled", checksumEnabled);
+  Config::SetGlobal ("ChecksumEnabled", BooleanValue (true));
+
+  Result segments = RunTransfer (1);
+  Result superPackets = RunTransfer (8);
+
+  Config::SetGlobal ("ChecksumEnabled", checksumEnabled);
+
+  NS_TEST_ASSERT_MSG_EQ (segments.rxBytes, m_total, "Transfer without offload did not complete");
+  NS_TEST_ASSERT_MSG_EQ (superPackets.rxBytes, m_total, "Transfer with offload did not complete");
+  NS_TEST_EXPECT_MSG_EQ (segments.maxTxSize, 1000, "TCP handed down more than one segment");
+  NS_TEST_EXPECT_MSG_GT (superPackets.maxTxSize, 1000, "TCP did not hand down super-packets");
+  NS_TEST_EXPECT_MSG_EQ (superPackets.maxDevSize, segments.maxDevSize, "Device got a packet larger than a segment");
+  NS_TEST_EXPECT_MSG_EQ (superPackets.devPackets, segments.devPackets, "Device sent a different number of packets");
+  NS_TEST_EXPECT_MSG_EQ (superPackets.done, segments.done, "Data received at a different time");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload test on local delivery.
+ *
+ * Runs a bulk transfer between two sockets of the same node, through the
+ * loopback device or through the address of another interface, with and
+ * without segmentation offload. Neither path goes through the traffic
+ * control layer, and the receiver must still get the same segments at the
+ * same times.
+ */
+class TcpGsoLocalTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param useIpv6 Use IPv6 instead of IPv4.
+   * \param loopback Connect to the loopback address.
+   */
+  TcpGsoLocalTestCase (bool useIpv6, bool loopback);
+
+private:
+  virtual void DoRun (void);
+
+  /// Results of a transfer
+  struct Result
+  {
+    uint32_t rxBytes;      //!< bytes received
+    Time done;             //!< time the last byte was received
+    uint32_t maxTxSize;    //!< largest payload handed down by TCP
+    uint32_t rxPackets;    //!< packets received by TCP
+    uint32_t maxRxSize;    //!< largest payload received by TCP
+  };
+
+  /**
+   * \brief Run a transfer.
+   * \param gsoMaxSegments The GsoMaxSegments attribute of the sender.
+   * \return the results of the transfer
+   */
+  Result RunTransfer (uint16_t gsoMaxSegments);
+
+  /**
+   * \brief Fill the send buffer of the sender.
+   * \param socket The sending socket.
+   * \param available The space available in the send buffer.
+   */
+  void Fill (Ptr<Socket> socket, uint32_t available);
+  /**
+   * \brief Receive data.
+   * \param socket The receiving socket.
+   */
+  void Receive (Ptr<Socket> socket);
+  /**
+   * \brief Accept a connection.
+   * \param socket The accepted socket.
+   * \param from The address of the peer.
+   */
+  void Accept (Ptr<Socket> socket, const Address &from);
+  /**
+   * \brief Trace the packets handed down by TCP.
+   * \param packet The payload.
+   * \param header The TCP header.
+   * \param socket The socket.
+   */
+  void Tx (Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket);
+  /**
+   * \brief Trace the packets received by TCP.
+   * \param packet The payload.
+   * \param header The TCP header.
+   * \param socket The socket.
+   */
+  void Rx (Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket);
+
+  bool m_useIpv6;      //!< Use IPv6 instead of IPv4.
+  bool m_loopback;     //!< Connect to the loopback address.
+  uint32_t m_total;    //!< Bytes to transfer.
+  uint32_t m_sent;     //!< Bytes written to the sender.
+  Result m_result;     //!< Results of the current transfer.
+};
+
+TcpGsoLocalTestCase::TcpGsoLocalTestCase (bool useIpv6, bool loopback)
+  : TestCase (std::string ("TCP segmentation offload over IPv") + (useIpv6 ? "6" : "4")
+              + (loopback ? " loopback" : " local delivery")),
+    m_useIpv6 (useIpv6),
+    m_loopback (loopback),
+    m_total (100000),
+    m_sent (0)
+{
+}
+
+void
+TcpGsoLocalTestCase::Fill (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_sent < m_total && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (std::min<uint32_t> (socket->GetTxAvailable (), 1400), m_total - m_sent);
+      int sent = socket->Send (Create<Packet> (size));
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_sent += sent;
+    }
+}
+
+void
+TcpGsoLocalTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      m_result.rxBytes += packet->GetSize ();
+      m_result.done = Simulator::Now ();
+    }
+}
+
+void
+TcpGsoLocalTestCase::Accept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpGsoLocalTestCase::Receive, this));
+}
+
+void
+TcpGsoLocalTestCase::Tx (Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket)
+{
+  m_result.maxTxSize = std::max (m_result.maxTxSize, packet->GetSize ());
+}
+
+void
+TcpGsoLocalTestCase::Rx (Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket)
+{
+  if (packet->GetSize () > 0)
+    {
+      m_result.rxPackets++;
+      m_result.maxRxSize = std::max (m_result.maxRxSize, packet->GetSize ());
+    }
+}
+
+TcpGsoLocalTestCase::Result
+TcpGsoLocalTestCase::RunTransfer (uint16_t gsoMaxSegments)
+{
+  m_result = Result ();
+  m_sent = 0;
+
+  Ptr<Node> node = CreateObject<Node> ();
+  SimpleNetDeviceHelper devices;
+  NetDeviceContainer d = devices.Install (node);
+  InternetStackHelper internet;
+  internet.Install (node);
+
+  Address serverAddress;
+  Address anyAddress;
+  if (m_useIpv6)
+    {
+      Ipv6AddressHelper ipv6;
+      ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+      Ipv6InterfaceContainer interfaces = ipv6.Assign (d);
+      serverAddress = Inet6SocketAddress (m_loopback ? Ipv6Address::GetLoopback () : interfaces.GetAddress (0, 1), 5000);
+      anyAddress = Inet6SocketAddress (Ipv6Address::GetAny (), 5000);
+    }
+  else
+    {
+      Ipv4AddressHelper ipv4;
+      ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+      Ipv4InterfaceContainer interfaces = ipv4.Assign (d);
+      serverAddress = InetSocketAddress (m_loopback ? Ipv4Address::GetLoopback () : interfaces.GetAddress (0), 5000);
+      anyAddress = InetSocketAddress (Ipv4Address::GetAny (), 5000);
+    }
+
+  Ptr<Socket> server = Socket::CreateSocket (node, TcpSocketFactory::GetTypeId ());
+  server->TraceConnectWithoutContext ("Rx", MakeCallback (&TcpGsoLocalTestCase::Rx, this));
+  server->Bind (anyAddress);
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpGsoLocalTestCase::Accept, this));
+
+  Ptr<Socket> client = Socket::CreateSocket (node, TcpSocketFactory::GetTypeId ());
+  client->SetAttribute ("SegmentSize", UintegerValue (1000));
+  client->SetAttribute ("GsoMaxSegments", UintegerValue (gsoMaxSegments));
+  client->TraceConnectWithoutContext ("Tx", MakeCallback (&TcpGsoLocalTestCase::Tx, this));
+  client->Bind (m_useIpv6 ? Address (Inet6SocketAddress (Ipv6Address::GetAny (), 0))
+                          : Address (InetSocketAddress (Ipv4Address::GetAny (), 0)));
+  client->SetSendCallback (MakeCallback (&TcpGsoLocalTestCase::Fill, this));
+  // Leave time for the duplicate address detection of IPv6
+  Simulator::Schedule (Seconds (2), &Socket::Connect, client, serverAddress);
+  Simulator::Schedule (Seconds (2.5), &TcpGsoLocalTestCase::Fill, this, client, 0);
+  Simulator::Stop (Seconds (30));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return m_result;
+}
+
+void
+TcpGsoLocalTestCase::DoRun (void)
+{
+  BooleanValue checksumEnabled;
+  GlobalValue::GetValueByName ("ChecksumEnabled", checksumEnabled);
+  Config::SetGlobal ("ChecksumEnabled", BooleanValue (true));
+
+  Result segments = RunTransfer (1);
+  Result superPackets = RunTransfer (8);
+
+  Config::SetGlobal ("ChecksumEnabled", checksumEnabled);
+
+  NS_TEST_ASSERT_MSG_GT (segments.rxBytes, 0, "Transfer without offload did not start");
+  NS_TEST_EXPECT_MSG_EQ (segments.maxRxSize, 1000, "TCP received more than one segment without offload");
+  NS_TEST_EXPECT_MSG_GT (superPackets.maxTxSize, 1000, "TCP did not hand down super-packets");
+  NS_TEST_EXPECT_MSG_EQ (superPackets.maxRxSize, segments.maxRxSize, "TCP received a packet larger than a segment");
+  NS_TEST_EXPECT_MSG_EQ (superPackets.rxPackets, segments.rxPackets, "TCP received a different number of packets");
+  NS_TEST_EXPECT_MSG_EQ (superPackets.rxBytes, segments.rxBytes, "Received a different amount of data");
+  NS_TEST_EXPECT_MSG_EQ (superPackets.done, segments.done, "Data received at a different time");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload TestSuite.
+ */
+class TcpGsoTestSuite : public TestSuite
+{
+public:
+  TcpGsoTestSuite ()
+    : TestSuite ("tcp-gso", UNIT)
+  {
+    AddTestCase (new TcpGsoTestCase (false), TestCase::QUICK);
+    AddTestCase (new TcpGsoTestCase (true), TestCase::QUICK);
+    AddTestCase (new TcpGsoLocalTestCase (false, false), TestCase::QUICK);
+    AddTestCase (new TcpGsoLocalTestCase (false, true), TestCase::QUICK);
+    AddTestCase (new TcpGsoLocalTestCase (true, false), TestCase::QUICK);
+  }
+};
+
+static TcpGsoTestSuite g_tcpGsoTestSuite; //!< Static variable for test initialization
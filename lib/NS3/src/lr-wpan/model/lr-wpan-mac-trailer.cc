@@ -140,19 +140,38 @@ LrWpanMacTrailer::IsFcsEnabled (void)
   return m_calcFcs;
 }
 
+/**
+ * Table of the CRC16-CCITT values of each byte, LSB first, to process the
+ * data a byte at a time.
+ */
+struct LrWpanCrc16Table
+{
+  LrWpanCrc16Table ()
+  {
+    for (int i = 0; i < 256; i++)
+      {
+        uint16_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+          {
+            // 0x8408 is the generator polynomial, bit-reversed
+            crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+          }
+        table[i] = crc;
+      }
+  }
+  uint16_t table[256]; //!< The table
+};
+
 uint16_t
 LrWpanMacTrailer::GenerateCrc16 (uint8_t *data, int length)
 {
+  static const LrWpanCrc16Table crc16;
   int i;
   uint16_t accumulator = 0;
 
   for (i = 0; i < length; ++i)
     {
-      accumulator ^= *data;
-      accumulator  = (accumulator >> 8) | (accumulator << 8);
-      accumulator ^= (accumulator & 0xff00) << 4;
-      accumulator ^= (accumulator >> 8) >> 4;
-      accumulator ^= (accumulator & 0xff00) >> 5;
+      accumulator = (accumulator >> 8) ^ crc16.table[(accumulator ^ *data) & 0xff];
       ++data;
     }
   return accumulator;
@@ -24,6 +24,8 @@
 #include <ns3/mac16-address.h>
 #include <ns3/mac64-address.h>
 #include <ns3/log.h>
+#include <ns3/random-variable-stream.h>
+#include <vector>
 
 
 using namespace ns3;
@@ -109,6 +111,94 @@ LrWpanPacketTestCase::DoRun (void)
 
 }
 
+/**
+ * \ingroup lr-wpan-test
+ * \ingroup tests
+ *
+ * \brief LrWpan FCS Test
+ */
+class LrWpanFcsTestCase : public TestCase
+{
+public:
+  LrWpanFcsTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compute the FCS of a frame through the MAC trailer.
+   * \param data the frame
+   * \return the FCS
+   */
+  uint16_t GetFcs (const std::vector<uint8_t> &data);
+  /**
+   * Compute the CRC16-CCITT of a frame a bit at a time.
+   * \param data the frame
+   * \return the CRC
+   */
+  uint16_t BitwiseCrc16 (const std::vector<uint8_t> &data);
+};
+
+LrWpanFcsTestCase::LrWpanFcsTestCase ()
+  : TestCase ("Test the 802.15.4 MAC trailer FCS")
+{
+}
+
+uint16_t
+LrWpanFcsTestCase::GetFcs (const std::vector<uint8_t> &data)
+{
+  Ptr<Packet> p = Create<Packet> (data.data (), data.size ());
+  LrWpanMacTrailer trailer;
+  trailer.EnableFcs (true);
+  trailer.SetFcs (p);
+  NS_TEST_EXPECT_MSG_EQ (trailer.CheckFcs (p), true, "FCS does not check");
+  return trailer.GetFcs ();
+}
+
+uint16_t
+LrWpanFcsTestCase::BitwiseCrc16 (const std::vector<uint8_t> &data)
+{
+  uint16_t accumulator = 0;
+  for (uint32_t i = 0; i < data.size (); i++)
+    {
+      accumulator ^= data[i];
+      for (int j = 0; j < 8; j++)
+        {
+          if (accumulator & 0x0001)
+            {
+              accumulator = (accumulator >> 1) ^ 0x8408;
+            }
+          else
+            {
+              accumulator >>= 1;
+            }
+        }
+    }
+  return accumulator;
+}
+
+void
+LrWpanFcsTestCase::DoRun (void)
+{
+  // CRC-16/KERMIT check value, which has the same parameters as the FCS
+  const char *check = "123456789";
+  std::vector<uint8_t> data (check, check + 9);
+  NS_TEST_EXPECT_MSG_EQ (GetFcs (data), 0x2189, "Wrong FCS of the check string");
+
+  data.clear ();
+  NS_TEST_EXPECT_MSG_EQ (GetFcs (data), 0, "Wrong FCS of an empty frame");
+
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  for (uint32_t n = 0; n < 200; n++)
+    {
+      data.resize (rand->GetInteger (1, 127));
+      for (uint32_t i = 0; i < data.size (); i++)
+        {
+          data[i] = rand->GetInteger (0, 255);
+        }
+      NS_TEST_EXPECT_MSG_EQ (GetFcs (data), BitwiseCrc16 (data), "Wrong FCS of a random frame");
+    }
+}
+
 /**
  * \ingroup lr-wpan-test
  * \ingroup tests
@@ -125,6 +215,7 @@ LrWpanPacketTestSuite::LrWpanPacketTestSuite ()
   : TestSuite ("lr-wpan-packet", UNIT)
 {
   AddTestCase (new LrWpanPacketTestCase, TestCase::QUICK);
+  AddTestCase (new LrWpanFcsTestCase, TestCase::QUICK);
 }
 
 static LrWpanPacketTestSuite g_lrWpanPacketTestSuite; //!< Static variable for test initialization
@@ -53,6 +53,7 @@ MobilityModel::GetTypeId (void)
 }
 
 MobilityModel::MobilityModel ()
+  : m_positionEpoch (0)
 {
 }
 
@@ -91,9 +92,16 @@ MobilityModel::GetRelativeSpeed (Ptr<const MobilityModel> other) const
   return (GetVelocity () - other->GetVelocity ()).GetLength ();
 }
 
+uint32_t
+MobilityModel::GetPositionEpoch (void) const
+{
+  return m_positionEpoch;
+}
+
 void
 MobilityModel::NotifyCourseChange (void) const
 {
+  m_positionEpoch++;
   m_courseChangeTrace (this);
 }
 
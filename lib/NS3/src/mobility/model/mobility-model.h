@@ -78,6 +78,15 @@ public:
    * \return the number of stream indices assigned by this model
    */
   int64_t AssignStreams (int64_t stream);
+  /**
+   * The epoch is incremented each time the model notifies a course
+   * change, so that values computed from the position can be cached as
+   * long as the epoch does not change.  The position of a model with a
+   * non-zero velocity changes between two course changes though.
+   *
+   * \return the position epoch of this model
+   */
+  uint32_t GetPositionEpoch (void) const;
 
   /**
    *  TracedCallback signature.
@@ -129,6 +138,11 @@ private:
    */
   ns3::TracedCallback<Ptr<const MobilityModel> > m_courseChangeTrace;
 
+  /**
+   * The number of course changes notified so far.
+   */
+  mutable uint32_t m_positionEpoch;
+
 };
 
 } // namespace ns3
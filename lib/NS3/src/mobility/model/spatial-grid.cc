@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "spatial-grid.h"
+#include "mobility-model.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SpatialGrid");
+
+SpatialGrid::SpatialGrid ()
+  : m_cellSize (0.0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SpatialGrid::~SpatialGrid ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+void
+SpatialGrid::SetCellSize (double size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT (size >= 0);
+  m_cells.clear ();
+  m_moving.clear ();
+  m_cellSize = size;
+  for (uint32_t i = 0; i < m_entries.size (); i++)
+    {
+      Place (i);
+    }
+}
+
+double
+SpatialGrid::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+uint32_t
+SpatialGrid::Add (Ptr<MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  NS_ASSERT (mobility != 0);
+  uint32_t index = m_entries.size ();
+  Entry entry;
+  entry.mobility = mobility;
+  entry.moving = false;
+  m_entries.push_back (entry);
+  mobility->TraceConnectWithoutContext ("CourseChange",
+                                        MakeBoundCallback (&SpatialGrid::CourseChanged, this, index));
+  Place (index);
+  return index;
+}
+
+uint32_t
+SpatialGrid::GetN (void) const
+{
+  return m_entries.size ();
+}
+
+Ptr<MobilityModel>
+SpatialGrid::Get (uint32_t index) const
+{
+  NS_ASSERT (index < m_entries.size ());
+  return m_entries[index].mobility;
+}
+
+void
+SpatialGrid::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_entries.size (); i++)
+    {
+      m_entries[i].mobility->TraceDisconnectWithoutContext ("CourseChange",
+                                                            MakeBoundCallback (&SpatialGrid::CourseChanged, this, i));
+    }
+  m_entries.clear ();
+  m_cells.clear ();
+  m_moving.clear ();
+}
+
+void
+SpatialGrid::Find (const Vector &position, double range, std::vector<uint32_t> &indices) const
+{
+  NS_LOG_FUNCTION (this << position << range);
+  indices.clear ();
+  FindInCell (m_moving, position, range, indices);
+  if (!m_cells.empty ())
+    {
+      Cell center = GetCell (position);
+      double span = std::ceil (range / m_cellSize);
+      if ((2 * span + 1) * (2 * span + 1) < m_cells.size ())
+        {
+          int64_t n = static_cast<int64_t> (span);
+          for (int64_t x = center.first - n; x <= center.first + n; x++)
+            {
+              for (int64_t y = center.second - n; y <= center.second + n; y++)
+                {
+                  Cells::const_iterator i = m_cells.find (Cell (x, y));
+                  if (i != m_cells.end ())
+                    {
+                      FindInCell (i->second, position, range, indices);
+                    }
+                }
+            }
+        }
+      else
+        {
+          // The range covers more cells than there are.
+          for (Cells::const_iterator i = m_cells.begin (); i != m_cells.end (); i++)
+            {
+              FindInCell (i->second, position, range, indices);
+            }
+        }
+    }
+  std::sort (indices.begin (), indices.end ());
+}
+
+void
+SpatialGrid::FindInCell (const std::vector<uint32_t> &cell, const Vector &position, double range,
+                         std::vector<uint32_t> &indices) const
+{
+  for (std::vector<uint32_t>::const_iterator i = cell.begin (); i != cell.end (); i++)
+    {
+      if (CalculateDistance (position, m_entries[*i].mobility->GetPosition ()) <= range)
+        {
+          indices.push_back (*i);
+        }
+    }
+}
+
+void
+SpatialGrid::Place (uint32_t index)
+{
+  Entry &entry = m_entries[index];
+  if (m_cellSize == 0 || entry.mobility->GetVelocity ().GetLength () > 0)
+    {
+      entry.moving = true;
+      m_moving.push_back (index);
+    }
+  else
+    {
+      entry.moving = false;
+      entry.cell = GetCell (entry.mobility->GetPosition ());
+      m_cells[entry.cell].push_back (index);
+    }
+}
+
+void
+SpatialGrid::Unplace (uint32_t index)
+{
+  Entry &entry = m_entries[index];
+  Cells::iterator cell = m_cells.end ();
+  std::vector<uint32_t> *list = &m_moving;
+  if (!entry.moving)
+    {
+      cell = m_cells.find (entry.cell);
+      NS_ASSERT (cell != m_cells.end ());
+      list = &cell->second;
+    }
+  std::vector<uint32_t>::iterator i = std::find (list->begin (), list->end (), index);
+  NS_ASSERT (i != list->end ());
+  *i = list->back ();
+  list->pop_back ();
+  if (list->empty () && cell != m_cells.end ())
+    {
+      m_cells.erase (cell);
+    }
+}
+
+SpatialGrid::Cell
+SpatialGrid::GetCell (const Vector &position) const
+{
+  return Cell (static_cast<int64_t> (std::floor (position.x / m_cellSize)),
+               static_cast<int64_t> (std::floor (position.y / m_cellSize)));
+}
+
+void
+SpatialGrid::CourseChanged (SpatialGrid *grid, uint32_t index, Ptr<const MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (grid << index << mobility);
+  grid->Unplace (index);
+  grid->Place (index);
+}
+
+} // namespace ns3
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include "ns3/ptr.h"
+#include "ns3/vector.h"
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+
+class MobilityModel;
+
+/**
+ * \ingroup mobility
+ *
+ * \brief Index of mobility models by position, to find the ones close
+ * to a point without visiting all of them.
+ *
+ * The models are kept in a uniform grid of square cells in the x-y
+ * plane, and moved between the cells when they notify a course change.
+ * The position of a model with a non-zero velocity changes without any
+ * notification, so the moving models are kept apart and checked by
+ * every search.  The grid is meant for searches within a range close to
+ * the cell size: a larger range visits more cells, a smaller one checks
+ * more models.
+ *
+ * The models are identified by their index, in the order they were
+ * added.
+ */
+class SpatialGrid
+{
+public:
+  SpatialGrid ();
+  ~SpatialGrid ();
+
+  /**
+   * Set the width of the cells, and rebuild the grid.
+   * \param size the width of the cells, in meters, or zero to check
+   *        every model in each search
+   */
+  void SetCellSize (double size);
+  /**
+   * \return the width of the cells, in meters
+   */
+  double GetCellSize (void) const;
+  /**
+   * Add a mobility model to the grid.
+   * \param mobility the mobility model
+   * \return the index of the model
+   */
+  uint32_t Add (Ptr<MobilityModel> mobility);
+  /**
+   * \return the number of models in the grid
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \param index the index of a model
+   * \return the mobility model
+   */
+  Ptr<MobilityModel> Get (uint32_t index) const;
+  /**
+   * Remove all the models.
+   */
+  void Clear (void);
+  /**
+   * Find the models within a distance of a position.
+   * \param position the position
+   * \param range the distance, in meters
+   * \param [out] indices the indices of the models in range, in increasing order
+   */
+  void Find (const Vector &position, double range, std::vector<uint32_t> &indices) const;
+
+private:
+  /**
+   * A cell of the grid, by its x and y indices.
+   */
+  typedef std::pair<int64_t, int64_t> Cell;
+  /**
+   * The indices of the static models of each cell.
+   */
+  typedef std::map<Cell, std::vector<uint32_t> > Cells;
+
+  /**
+   * The location of a model in the grid.
+   */
+  struct Entry
+  {
+    Ptr<MobilityModel> mobility; //!< the mobility model
+    Cell cell;                   //!< the cell of the model, if it is static
+    bool moving;                 //!< whether the model is in m_moving rather than in a cell
+  };
+
+  /**
+   * Copy constructor, not implemented: the course change callbacks
+   * refer to the original grid.
+   * \param o the grid to copy
+   */
+  SpatialGrid (const SpatialGrid &o);
+  /**
+   * Assignment operator, not implemented.
+   * \param o the grid to copy
+   * \return this grid
+   */
+  SpatialGrid &operator = (const SpatialGrid &o);
+
+  /**
+   * Put a model in its cell, or in the moving models.
+   * \param index the index of the model
+   */
+  void Place (uint32_t index);
+  /**
+   * Remove a model from its cell, or from the moving models.
+   * \param index the index of the model
+   */
+  void Unplace (uint32_t index);
+  /**
+   * \param position a position
+   * \return the cell containing the position
+   */
+  Cell GetCell (const Vector &position) const;
+  /**
+   * Append the models of a cell in range of a position.
+   * \param cell the cell
+   * \param position the position
+   * \param range the distance, in meters
+   * \param [out] indices the indices of the models in range
+   */
+  void FindInCell (const std::vector<uint32_t> &cell, const Vector &position, double range,
+                   std::vector<uint32_t> &indices) const;
+  /**
+   * Move a model when it changes course.
+   * \param grid the grid
+   * \param index the index of the model
+   * \param mobility the mobility model
+   */
+  static void CourseChanged (SpatialGrid *grid, uint32_t index, Ptr<const MobilityModel> mobility);
+
+  std::vector<Entry> m_entries;   //!< The models, by index
+  Cells m_cells;                  //!< The static models, by cell
+  std::vector<uint32_t> m_moving; //!< The moving models
+  double m_cellSize;              //!< The width of the cells, zero for no grid
+};
+
+} // namespace ns3
+
+#endif /* SPATIAL_GRID_H */
@@ -20,6 +20,8 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include <algorithm>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -43,6 +45,62 @@ static struct Zeroes
   const uint32_t size;  //!< buffer size
 } g_zeroes; //!< Zero-filled buffer
 
+/**
+ * \ingroup packet
+ * \brief Computes the one's complement sum of a contiguous area of a buffer.
+ *
+ * The area is added up as the little-endian 16-bit words that
+ * Buffer::Iterator::ReadU16 returns, with a trailing odd byte as the low
+ * byte of a word. The bulk of the area is added eight bytes at a time:
+ * the one's complement sum of wider words, folded to 16 bits, is the same
+ * (see RFC 1071), up to the byte order of the host.
+ *
+ * \param data the area
+ * \param size the size of the area
+ * \return the sum, folded to 16 bits
+ */
+uint32_t
+OnesComplementSum (const uint8_t *data, uint32_t size)
+{
+  uint64_t wide = 0;
+  while (size >= 8)
+    {
+      uint64_t word;
+      memcpy (&word, data, 8);
+      wide += word;
+      wide += (wide < word); // end-around carry
+      data += 8;
+      size -= 8;
+    }
+  wide = (wide & 0xffffffff) + (wide >> 32);
+  wide = (wide & 0xffffffff) + (wide >> 32);
+  uint32_t sum = static_cast<uint32_t> (wide);
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  const uint16_t one = 1;
+  if (*reinterpret_cast<const uint8_t *> (&one) == 0)
+    {
+      // big-endian host: the words were added with their bytes swapped
+      sum = ((sum & 0xff) << 8) | (sum >> 8);
+    }
+
+  for (; size >= 2; size -= 2, data += 2)
+    {
+      sum += data[0] | (data[1] << 8);
+    }
+  if (size == 1)
+    {
+      sum += data[0];
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return sum;
+}
+
 }
 
 namespace ns3 {
@@ -53,7 +111,7 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
+ * keep track of 3 possible states for the g_pool variable:
  *  - uninitialized means that no one has created a buffer yet
  *    so no one has created the associated free list (it is created
  *    on-demand when the first buffer is created)
@@ -70,28 +128,94 @@ uint32_t Buffer::g_recommendedStart = 0;
  * constructor orderings.
  */
 #define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
+#define IS_UNINITIALIZED(x) (x == (Buffer::Pool*)0)
+#define IS_DESTROYED(x) (x == (Buffer::Pool*)MAGIC_DESTROYED)
 #define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
+#define DESTROYED ((Buffer::Pool*)MAGIC_DESTROYED)
+#define UNINITIALIZED ((Buffer::Pool*)0)
+/// Number of size classes of the buffer data, from 32 bytes to 64 KiB
+static const uint32_t BUFFER_SIZE_CLASSES = 12;
+/// Binary logarithm of the data size of the smallest size class
+static const uint32_t BUFFER_SMALLEST_CLASS_SHIFT = 5;
+/// Number of data bytes kept in the free list of each size class
+static const uint32_t BUFFER_CLASS_CACHE_BYTES = 4 << 20;
+/// Size of the arena slabs
+static const uint32_t BUFFER_ARENA_SLAB_SIZE = 256 << 10;
+
+/**
+ * \ingroup packet
+ * \brief Free lists, statistics and arena of the buffer data.
+ */
+struct Buffer::Pool
+{
+  Pool ();
+  /// The recycled data of each size class
+  std::vector<struct Buffer::Data *> freeList[BUFFER_SIZE_CLASSES];
+  /// The statistics of each size class, then of the larger data
+  struct Buffer::AllocationStats stats[BUFFER_SIZE_CLASSES + 1];
+  bool arenaEnabled;            //!< true if new data is carved from the arena
+  std::vector<uint8_t *> slabs; //!< the arena slabs
+  uint32_t slabUsed;            //!< number of bytes used in the last slab
+  uint32_t arenaLive;           //!< number of arena data not in a free list
+  bool arenaReleasePending;     //!< release the slabs when arenaLive drops to zero
+  bool arenaReleaseScheduled;   //!< ReleaseArena is scheduled at Simulator::Destroy
+};
+
+Buffer::Pool::Pool ()
+  : arenaEnabled (false),
+    slabUsed (0),
+    arenaLive (0),
+    arenaReleasePending (false),
+    arenaReleaseScheduled (false)
+{
+  memset (stats, 0, sizeof (stats));
+  for (uint32_t i = 0; i < BUFFER_SIZE_CLASSES; i++)
+    {
+      stats[i].size = 1 << (i + BUFFER_SMALLEST_CLASS_SHIFT);
+    }
+}
+
 uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
+Buffer::Pool *Buffer::g_pool = 0;
 struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
+  if (IS_INITIALIZED (g_pool))
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
+      for (uint32_t i = 0; i < BUFFER_SIZE_CLASSES; i++)
         {
-          Buffer::Deallocate (*i);
+          for (std::vector<struct Buffer::Data *>::iterator j = g_pool->freeList[i].begin ();
+               j != g_pool->freeList[i].end (); j++)
+            {
+              Buffer::Deallocate (*j);
+            }
         }
-      delete g_freeList;
-      g_freeList = DESTROYED;
+      // The slabs still used by static buffers are leaked.
+      if (g_pool->arenaLive == 0)
+        {
+          for (std::vector<uint8_t *>::iterator i = g_pool->slabs.begin ();
+               i != g_pool->slabs.end (); i++)
+            {
+              delete [] *i;
+            }
+        }
+      delete g_pool;
+      g_pool = DESTROYED;
+    }
+}
+
+uint32_t
+Buffer::GetSizeClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  while (sizeClass < BUFFER_SIZE_CLASSES
+         && size > (1U << (sizeClass + BUFFER_SMALLEST_CLASS_SHIFT)))
+    {
+      sizeClass++;
     }
+  return sizeClass;
 }
 
 void
@@ -99,19 +223,43 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
+  NS_ASSERT (!IS_UNINITIALIZED (g_pool));
+  if (IS_DESTROYED (g_pool))
+    {
+      Buffer::Deallocate (data);
+      return;
+    }
+  uint32_t sizeClass = GetSizeClass (data->m_size);
+  struct Buffer::AllocationStats &stats = g_pool->stats[sizeClass];
+  if (sizeClass < BUFFER_SIZE_CLASSES && data->m_size > g_maxSize)
+    {
+      // New buffers are created at the maximum size ever used, so the
+      // smaller classes will not be used anymore.
+      g_maxSize = data->m_size;
+      ReleaseSmallerClasses (sizeClass);
+    }
+  if (data->m_arena)
+    {
+      g_pool->arenaLive--;
+    }
   /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  if (sizeClass == BUFFER_SIZE_CLASSES
+      || data->m_size < g_maxSize
+      || g_pool->freeList[sizeClass].size () * data->m_size >= BUFFER_CLASS_CACHE_BYTES)
     {
+      stats.freed++;
       Buffer::Deallocate (data);
     }
   else
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      NS_ASSERT (data->m_size == stats.size);
+      stats.recycled++;
+      stats.cached++;
+      g_pool->freeList[sizeClass].push_back (data);
+    }
+  if (g_pool->arenaReleasePending && g_pool->arenaLive == 0)
+    {
+      ReleaseArena ();
     }
 }
 
@@ -119,29 +267,179 @@ Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  if (IS_UNINITIALIZED (g_pool))
+    {
+      g_pool = new Buffer::Pool ();
+    }
+  else if (IS_DESTROYED (g_pool))
     {
-      g_freeList = new Buffer::FreeList ();
+      return Buffer::Allocate (dataSize);
     }
-  else if (IS_INITIALIZED (g_freeList))
+  /* Create buffers of the maximum size ever used, to minimize the
+   * number of resizes, and look for one in the free list of its class. */
+  uint32_t sizeClass = GetSizeClass (std::max (dataSize, g_maxSize));
+  struct Buffer::AllocationStats &stats = g_pool->stats[sizeClass];
+  stats.allocations++;
+  if (sizeClass == BUFFER_SIZE_CLASSES)
     {
-      while (!g_freeList->empty ()) 
+      return Buffer::Allocate (dataSize);
+    }
+  std::vector<struct Buffer::Data *> &freeList = g_pool->freeList[sizeClass];
+  if (!freeList.empty ())
+    {
+      struct Buffer::Data *data = freeList.back ();
+      freeList.pop_back ();
+      stats.hits++;
+      stats.cached--;
+      if (data->m_arena)
         {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
+          g_pool->arenaLive++;
         }
+      data->m_count = 1;
+      return data;
+    }
+  if (g_pool->arenaEnabled)
+    {
+      stats.arena++;
+      return AllocateFromArena (sizeClass);
     }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
+  struct Buffer::Data *data = Buffer::Allocate (stats.size);
   NS_ASSERT (data->m_count == 1);
   return data;
 }
+
+struct Buffer::Data *
+Buffer::AllocateFromArena (uint32_t sizeClass)
+{
+  NS_LOG_FUNCTION (sizeClass);
+  uint32_t size = 1 << (sizeClass + BUFFER_SMALLEST_CLASS_SHIFT);
+  // Keep the data structures aligned in the slabs.
+  uint32_t chunk = (size - 1 + sizeof (struct Buffer::Data) + 7) & ~7U;
+  if (g_pool->slabs.empty () || g_pool->slabUsed + chunk > BUFFER_ARENA_SLAB_SIZE)
+    {
+      g_pool->slabs.push_back (new uint8_t [std::max (chunk, BUFFER_ARENA_SLAB_SIZE)]);
+      g_pool->slabUsed = 0;
+      if (!g_pool->arenaReleaseScheduled)
+        {
+          Simulator::ScheduleDestroy (&Buffer::ReleaseArena);
+          g_pool->arenaReleaseScheduled = true;
+        }
+    }
+  uint8_t *b = g_pool->slabs.back () + g_pool->slabUsed;
+  g_pool->slabUsed += chunk;
+  g_pool->arenaLive++;
+  struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
+  data->m_size = size;
+  data->m_count = 1;
+  data->m_arena = 1;
+  return data;
+}
+
+void
+Buffer::ReleaseArena (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (!IS_INITIALIZED (g_pool))
+    {
+      return;
+    }
+  g_pool->arenaReleaseScheduled = false;
+  if (g_pool->arenaLive > 0)
+    {
+      NS_LOG_LOGIC ("release " << g_pool->slabs.size () << " slabs when " <<
+                    g_pool->arenaLive << " buffers are destroyed");
+      g_pool->arenaReleasePending = true;
+      return;
+    }
+  for (uint32_t i = 0; i < BUFFER_SIZE_CLASSES; i++)
+    {
+      std::vector<struct Buffer::Data *> &freeList = g_pool->freeList[i];
+      std::vector<struct Buffer::Data *>::iterator last = freeList.begin ();
+      for (std::vector<struct Buffer::Data *>::iterator j = freeList.begin ();
+           j != freeList.end (); j++)
+        {
+          if (!(*j)->m_arena)
+            {
+              *last++ = *j;
+            }
+        }
+      g_pool->stats[i].freed += freeList.end () - last;
+      g_pool->stats[i].cached -= freeList.end () - last;
+      freeList.erase (last, freeList.end ());
+    }
+  for (std::vector<uint8_t *>::iterator i = g_pool->slabs.begin ();
+       i != g_pool->slabs.end (); i++)
+    {
+      delete [] *i;
+    }
+  g_pool->slabs.clear ();
+  g_pool->slabUsed = 0;
+  g_pool->arenaReleasePending = false;
+}
+
+void
+Buffer::ReleaseSmallerClasses (uint32_t sizeClass)
+{
+  NS_LOG_FUNCTION (sizeClass);
+  for (uint32_t i = 0; i < sizeClass; i++)
+    {
+      std::vector<struct Buffer::Data *> &freeList = g_pool->freeList[i];
+      for (std::vector<struct Buffer::Data *>::iterator j = freeList.begin ();
+           j != freeList.end (); j++)
+        {
+          Buffer::Deallocate (*j);
+        }
+      g_pool->stats[i].freed += freeList.size ();
+      g_pool->stats[i].cached = 0;
+      freeList.clear ();
+    }
+}
+
+std::vector<struct Buffer::AllocationStats>
+Buffer::GetAllocationStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (!IS_INITIALIZED (g_pool))
+    {
+      Buffer::Pool pool;
+      return std::vector<struct Buffer::AllocationStats> (pool.stats, pool.stats + BUFFER_SIZE_CLASSES + 1);
+    }
+  return std::vector<struct Buffer::AllocationStats> (g_pool->stats, g_pool->stats + BUFFER_SIZE_CLASSES + 1);
+}
+
+void
+Buffer::ResetAllocationStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (!IS_INITIALIZED (g_pool))
+    {
+      return;
+    }
+  for (uint32_t i = 0; i <= BUFFER_SIZE_CLASSES; i++)
+    {
+      struct Buffer::AllocationStats &stats = g_pool->stats[i];
+      stats.allocations = 0;
+      stats.hits = 0;
+      stats.arena = 0;
+      stats.recycled = 0;
+      stats.freed = 0;
+    }
+}
+
+void
+Buffer::EnableArena (bool enable)
+{
+  NS_LOG_FUNCTION (enable);
+  if (IS_UNINITIALIZED (g_pool))
+    {
+      g_pool = new Buffer::Pool ();
+    }
+  else if (IS_DESTROYED (g_pool))
+    {
+      return;
+    }
+  g_pool->arenaEnabled = enable;
+}
 #else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
@@ -157,6 +455,22 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
+
+std::vector<struct Buffer::AllocationStats>
+Buffer::GetAllocationStats (void)
+{
+  return std::vector<struct Buffer::AllocationStats> ();
+}
+
+void
+Buffer::ResetAllocationStats (void)
+{
+}
+
+void
+Buffer::EnableArena (bool enable)
+{
+}
 #endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
@@ -173,6 +487,7 @@ Buffer::Allocate (uint32_t reqSize)
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
   data->m_size = reqSize;
   data->m_count = 1;
+  data->m_arena = 0;
   return data;
 }
 
@@ -181,6 +496,11 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
+  if (data->m_arena)
+    {
+      // The arena slabs are released all at once.
+      return;
+    }
   uint8_t *buf = reinterpret_cast<uint8_t *> (data);
   delete [] buf;
 }
@@ -1143,14 +1463,50 @@ uint16_t
 Buffer::Iterator::CalculateIpChecksum (uint16_t size, uint32_t initialChecksum)
 {
   NS_LOG_FUNCTION (this << size << initialChecksum);
+  NS_ASSERT_MSG (m_current >= m_dataStart && m_current + size <= m_dataEnd,
+                 GetReadErrorMessage ());
   /* see RFC 1071 to understand this code. */
   uint32_t sum = initialChecksum;
 
-  for (int j = 0; j < size/2; j++)
-    sum += ReadU16 ();
-
-  if (size & 1)
-    sum += ReadU8 ();
+  /* The contiguous parts of the data are added up separately, and the zero
+   * area adds nothing. A part which starts at an odd offset from the start
+   * of the checksum has its bytes swapped in the 16-bit words. */
+  uint32_t end = m_current + size;
+  bool odd = false;
+  while (m_current < end)
+    {
+      uint32_t partEnd;
+      const uint8_t *part;
+      if (m_current < m_zeroStart)
+        {
+          partEnd = std::min (end, m_zeroStart);
+          part = &m_data[m_current];
+        }
+      else if (m_current < m_zeroEnd)
+        {
+          partEnd = std::min (end, m_zeroEnd);
+          part = 0;
+        }
+      else
+        {
+          partEnd = end;
+          part = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+        }
+      if (part != 0)
+        {
+          uint32_t partSum = OnesComplementSum (part, partEnd - m_current);
+          if (odd)
+            {
+              partSum = ((partSum & 0xff) << 8) | (partSum >> 8);
+            }
+          sum += partSum;
+        }
+      if ((partEnd - m_current) & 1)
+        {
+          odd = !odd;
+        }
+      m_current = partEnd;
+    }
 
   while (sum >> 16)
     sum = (sum & 0xffff) + (sum >> 16);
@@ -611,6 +611,50 @@ private:
    */
   uint32_t CopyData (uint8_t *buffer, uint32_t size) const;
 
+  /**
+   * \brief Statistics of one size class of the buffer data allocator.
+   *
+   * The data of the buffers is allocated in size classes, powers of two
+   * from 32 bytes to 64 KiB, each of which keeps a free list of the
+   * recycled data.  Larger data is allocated and freed directly, and
+   * accounted for in a last class of size zero.
+   */
+  struct AllocationStats
+  {
+    uint32_t size;         //!< the data size of the class, zero for larger data
+    uint64_t allocations;  //!< number of data allocations
+    uint64_t hits;         //!< number of allocations served by the free list
+    uint64_t arena;        //!< number of allocations carved from the arena
+    uint64_t recycled;     //!< number of data put in the free list
+    uint64_t freed;        //!< number of data released instead of recycled
+    uint32_t cached;       //!< number of data currently in the free list
+  };
+
+  /**
+   * \brief Get the statistics of the buffer data allocator.
+   * \returns the statistics of each size class, by increasing size,
+   *          followed by those of the larger data.
+   */
+  static std::vector<struct AllocationStats> GetAllocationStats (void);
+  /**
+   * \brief Reset the counters of the buffer data allocator.
+   *
+   * The number of cached data is not reset.
+   */
+  static void ResetAllocationStats (void);
+  /**
+   * \brief Carve the new buffer data from large slabs.
+   *
+   * When enabled, the data of the size classes which cannot be served
+   * by the free lists is carved from 256 KiB slabs instead of being
+   * allocated one by one.  The slabs are all released together at
+   * Simulator::Destroy, or as soon as the last buffer which uses them
+   * is destroyed if it outlives the simulation.
+   *
+   * \param enable true to carve the new data from the arena.
+   */
+  static void EnableArena (bool enable);
+
   /**
    * \brief Copy constructor
    * \param o the buffer to copy
@@ -678,6 +722,10 @@ private:
      * end of the area in which user bytes were written.
      */
     uint32_t m_dirtyEnd;
+    /**
+     * non-zero if this instance was carved from the arena.
+     */
+    uint32_t m_arena;
     /**
      * The real data buffer holds _at least_ one byte.
      * Its real size is stored in the m_size field.
@@ -791,15 +839,39 @@ private:
   uint32_t m_end;
 
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
+  /// Free lists, statistics and arena of the buffer data
+  struct Pool;
   /// Local static destructor structure
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
+  /**
+   * \brief Get the size class of a data size
+   * \param size the data size
+   * \returns the size class, or BUFFER_SIZE_CLASSES if too large
+   */
+  static uint32_t GetSizeClass (uint32_t size);
+  /**
+   * \brief Carve a buffer data storage from the arena
+   * \param sizeClass the size class of the storage
+   * \returns a pointer to the buffer storage
+   */
+  static struct Buffer::Data *AllocateFromArena (uint32_t sizeClass);
+  /**
+   * \brief Release the arena slabs, if none of them is used anymore
+   *
+   * Otherwise, the slabs are released when the last data carved from
+   * them is recycled.
+   */
+  static void ReleaseArena (void);
+  /**
+   * \brief Release the free data of the size classes smaller than a class
+   * \param sizeClass the smallest size class to keep
+   */
+  static void ReleaseSmallerClasses (uint32_t sizeClass);
   static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
+  static struct Pool *g_pool; //!< Buffer data allocator
   static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
@@ -22,6 +22,7 @@
 #include <vector>
 #include <cstring>
 #include <limits>
+#include <algorithm>
 
 #define USE_FREE_LIST 1
 #define FREE_LIST_SIZE 1000
@@ -202,7 +203,13 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
   else if (m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
     {
-      struct ByteTagListData *newData = Allocate (spaceNeeded);
+      // grow geometrically, so that adding n tags copies O(n) bytes
+      uint32_t size = spaceNeeded;
+      if (m_data->size < spaceNeeded)
+        {
+          size = std::max (spaceNeeded, 2 * m_data->size);
+        }
+      struct ByteTagListData *newData = Allocate (size);
       std::memcpy (&newData->data, &m_data->data, m_used);
       Deallocate (m_data);
       m_data = newData;
@@ -359,10 +366,11 @@ ByteTagList::Allocate (uint32_t size)
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
     }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
+  uint32_t capacity = std::max (size, g_maxSize);
+  uint8_t *buffer = new uint8_t [capacity + sizeof (struct ByteTagListData) - 4];
   struct ByteTagListData *data = (struct ByteTagListData *)buffer;
   data->count = 1;
-  data->size = size;
+  data->size = capacity;
   data->dirty = 0;
   return data;
 }
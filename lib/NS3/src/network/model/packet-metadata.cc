@@ -33,6 +33,54 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
+bool PacketMetadata::m_enableLazy = false;
+uint32_t PacketMetadata::m_replaying = 0;
+PacketMetadata::LazyLogFreeList PacketMetadata::m_freeLogs;
+bool PacketMetadata::m_freeLogsDestroyed = false;
+
+/**
+ * \ingroup packet
+ * The operations recorded in a PacketMetadata::LazyLog.
+ */
+enum LazyLogType
+{
+  LAZY_ADD_HEADER,
+  LAZY_REMOVE_HEADER,
+  LAZY_ADD_TRAILER,
+  LAZY_REMOVE_TRAILER,
+  LAZY_ADD_AT_END,
+  LAZY_REMOVE_AT_START,
+  LAZY_REMOVE_AT_END
+};
+
+/**
+ * \ingroup packet
+ * The number of operations a PacketMetadata::LazyLog holds before it is
+ * replayed into the list of items.
+ */
+static const uint32_t LAZY_LOG_MAX_ENTRIES = 16;
+
+/**
+ * \ingroup packet
+ * An operation recorded in a PacketMetadata::LazyLog.
+ */
+struct LazyLogEntry
+{
+  uint8_t type;   //!< the LazyLogType
+  uint32_t uid;   //!< the header or trailer uid
+  uint32_t size;  //!< the header or trailer size, or the number of bytes
+};
+
+/**
+ * \ingroup packet
+ * The operations recorded lazily on a PacketMetadata.
+ */
+struct PacketMetadata::LazyLog
+{
+  uint32_t count;                        //!< number of metadata sharing this log
+  std::vector<struct LazyLogEntry> entries;  //!< the operations, in order
+  std::vector<PacketMetadata> appended;  //!< the metadata added at end, in order
+};
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
@@ -68,6 +116,178 @@ PacketMetadata::EnableChecking (void)
   NS_LOG_FUNCTION_NOARGS ();
   Enable ();
   m_enableChecking = true;
+  m_enableLazy = false;
+}
+
+void
+PacketMetadata::EnableLazy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Enable ();
+  NS_ASSERT_MSG (!m_enableChecking,
+                 "Packet metadata checking requires eager recording");
+  m_enableLazy = true;
+}
+
+void
+PacketMetadata::DisableLazy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_enableLazy = false;
+}
+
+PacketMetadata::LazyLogFreeList::~LazyLogFreeList ()
+{
+  NS_LOG_FUNCTION (this);
+  for (iterator i = begin (); i != end (); i++)
+    {
+      delete *i;
+    }
+  clear ();
+  PacketMetadata::m_freeLogsDestroyed = true;
+}
+
+bool
+PacketMetadata::IsLazy (void)
+{
+  return m_enableLazy && m_replaying == 0;
+}
+
+void
+PacketMetadata::AcquireLog (struct PacketMetadata::LazyLog *log)
+{
+  log->count++;
+}
+
+void
+PacketMetadata::ReleaseLog (struct PacketMetadata::LazyLog *log)
+{
+  log->count--;
+  if (log->count > 0)
+    {
+      return;
+    }
+  if (m_freeLogsDestroyed || m_freeLogs.size () > 1000)
+    {
+      delete log;
+      return;
+    }
+  log->entries.clear ();
+  log->appended.clear ();
+  m_freeLogs.push_back (log);
+}
+
+bool
+PacketMetadata::AppendLog (uint8_t type, uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (type) << uid << size);
+  if (m_log == 0 || m_log->count > 1)
+    {
+      // copy on write
+      struct LazyLog *log;
+      if (m_freeLogs.empty ())
+        {
+          log = new LazyLog;
+        }
+      else
+        {
+          log = m_freeLogs.back ();
+          m_freeLogs.pop_back ();
+        }
+      log->count = 1;
+      if (m_log != 0)
+        {
+          log->entries = m_log->entries;
+          log->appended = m_log->appended;
+          ReleaseLog (m_log);
+        }
+      m_log = log;
+    }
+  std::vector<struct LazyLogEntry> &entries = m_log->entries;
+  if (!entries.empty ())
+    {
+      struct LazyLogEntry &last = entries.back ();
+      if ((type == LAZY_REMOVE_HEADER && last.type == LAZY_ADD_HEADER) ||
+          (type == LAZY_REMOVE_TRAILER && last.type == LAZY_ADD_TRAILER))
+        {
+          if (last.uid == uid && last.size == size)
+            {
+              // removing the header or trailer which was just added
+              entries.pop_back ();
+              return true;
+            }
+        }
+      else if (type == last.type &&
+               (type == LAZY_REMOVE_AT_START || type == LAZY_REMOVE_AT_END))
+        {
+          last.size += size;
+          return true;
+        }
+    }
+  if (entries.size () >= LAZY_LOG_MAX_ENTRIES)
+    {
+      // A log this long is not going to be cancelled out: replaying it
+      // now bounds the memory and the work of a later replay.
+      Materialize ();
+      return false;
+    }
+  struct LazyLogEntry entry;
+  entry.type = type;
+  entry.uid = uid;
+  entry.size = size;
+  entries.push_back (entry);
+  return true;
+}
+
+void
+PacketMetadata::Materialize (void) const
+{
+  if (m_log == 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << m_log->entries.size ());
+  // The list of items is part of the value of this metadata, so
+  // building it does not change the metadata.
+  PacketMetadata *self = const_cast<PacketMetadata *> (this);
+  struct LazyLog *log = m_log;
+  self->m_log = 0;
+  m_replaying++;
+  uint32_t appended = 0;
+  for (std::vector<struct LazyLogEntry>::const_iterator i = log->entries.begin ();
+       i != log->entries.end (); i++)
+    {
+      switch (i->type)
+        {
+        case LAZY_ADD_HEADER:
+          self->DoAddHeader (i->uid, i->size);
+          break;
+        case LAZY_REMOVE_HEADER:
+          self->DoRemoveHeader (i->uid, i->size);
+          break;
+        case LAZY_ADD_TRAILER:
+          self->DoAddTrailer (i->uid, i->size);
+          break;
+        case LAZY_REMOVE_TRAILER:
+          self->DoRemoveTrailer (i->uid, i->size);
+          break;
+        case LAZY_ADD_AT_END:
+          self->AddAtEnd (log->appended[appended]);
+          appended++;
+          break;
+        case LAZY_REMOVE_AT_START:
+          self->RemoveAtStart (i->size);
+          break;
+        case LAZY_REMOVE_AT_END:
+          self->RemoveAtEnd (i->size);
+          break;
+        default:
+          NS_ASSERT_MSG (false, "Unknown lazy metadata operation");
+          break;
+        }
+    }
+  m_replaying--;
+  ReleaseLog (log);
 }
 
 void
@@ -668,6 +888,11 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (IsLazy () && AppendLog (LAZY_ADD_HEADER, uid, size))
+    {
+      return;
+    }
+  Materialize ();
 
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
@@ -684,12 +909,23 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &header << size);
+  DoRemoveHeader (uid, size);
+}
+void
+PacketMetadata::DoRemoveHeader (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
       m_metadataSkipped = true;
       return;
     }
+  if (IsLazy () && AppendLog (LAZY_REMOVE_HEADER, uid, size))
+    {
+      return;
+    }
+  Materialize ();
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -732,12 +968,23 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 {
   uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
+  DoAddTrailer (uid, size);
+}
+void
+PacketMetadata::DoAddTrailer (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable)
     {
       m_metadataSkipped = true;
       return;
     }
+  if (IsLazy () && AppendLog (LAZY_ADD_TRAILER, uid, size))
+    {
+      return;
+    }
+  Materialize ();
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
@@ -754,12 +1001,23 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
 {
   uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
+  DoRemoveTrailer (uid, size);
+}
+void 
+PacketMetadata::DoRemoveTrailer (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
       m_metadataSkipped = true;
       return;
     }
+  if (IsLazy () && AppendLog (LAZY_REMOVE_TRAILER, uid, size))
+    {
+      return;
+    }
+  Materialize ();
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -807,6 +1065,18 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       m_metadataSkipped = true;
       return;
     }
+  if (IsLazy ())
+    {
+      // copy o first: it may share our log
+      PacketMetadata appended = o;
+      if (AppendLog (LAZY_ADD_AT_END, 0, 0))
+        {
+          m_log->appended.push_back (appended);
+          return;
+        }
+    }
+  Materialize ();
+  o.Materialize ();
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -895,6 +1165,11 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       m_metadataSkipped = true;
       return;
     }
+  if (IsLazy () && AppendLog (LAZY_REMOVE_AT_START, 0, start))
+    {
+      return;
+    }
+  Materialize ();
   NS_ASSERT (m_data != 0);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
@@ -958,6 +1233,11 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       m_metadataSkipped = true;
       return;
     }
+  if (IsLazy () && AppendLog (LAZY_REMOVE_AT_END, 0, end))
+    {
+      return;
+    }
+  Materialize ();
   NS_ASSERT (m_data != 0);
 
   uint32_t leftToRemove = end;
@@ -1046,6 +1326,7 @@ PacketMetadata::ItemIterator
 PacketMetadata::BeginItem (Buffer buffer) const
 {
   NS_LOG_FUNCTION (this << &buffer);
+  Materialize ();
   return ItemIterator (this, buffer);
 }
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
@@ -1133,6 +1414,7 @@ uint32_t
 PacketMetadata::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  Materialize ();
   uint32_t totalSize = 0;
 
   // add 8 bytes for the packet uid
@@ -1178,6 +1460,7 @@ uint32_t
 PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  Materialize ();
   uint8_t* start = buffer;
 
   buffer = AddToRawU64 (m_packetUid, start, buffer, maxSize);
@@ -1279,6 +1562,7 @@ uint32_t
 PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
+  Materialize ();
   const uint8_t* start = buffer;
   uint32_t desSize = size - 4;
 
@@ -158,8 +158,33 @@ private:
   static void Enable (void);
   /**
    * \brief Enable the packet metadata checking
+   *
+   * Checking requires the eager recording of the metadata, so this
+   * disables the lazy recording.
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable the packet metadata, recorded lazily
+   *
+   * Instead of updating the list of items of a packet, the header and
+   * trailer operations are only appended to a compact per-packet log
+   * (type uid and size), where a header or trailer removed right after
+   * it was added cancels out.  The list of items is built by replaying
+   * that log the first time it is needed: by BeginItem, and thus
+   * Packet::Print, or by the serialization methods, or once the log
+   * holds a few operations which did not cancel out, so that the log of
+   * a long-lived packet stays short.  The results are those of the eager
+   * recording.
+   *
+   * This can be enabled at any time after Enable.
+   */
+  static void EnableLazy (void);
+  /**
+   * \brief Record the metadata eagerly again
+   *
+   * The logs recorded so far are still replayed when needed.
+   */
+  static void DisableLazy (void);
 
   /**
    * \brief Constructor
@@ -503,6 +528,18 @@ public:
     ~DataFreeList ();
   };
 
+  /// Operations recorded lazily
+  struct LazyLog;
+
+  /**
+   * \brief Class to hold the unused logs
+   */
+  class LazyLogFreeList : public std::vector<struct LazyLog *>
+  {
+public:
+    ~LazyLogFreeList ();
+  };
+
   friend DataFreeList::~DataFreeList ();
   /// Friend class
   friend class ItemIterator;
@@ -620,6 +657,55 @@ public:
    * \param size header serialized size
    */
   void DoAddHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Remove an header
+   * \param uid header's uid to remove
+   * \param size header serialized size
+   */
+  void DoRemoveHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add a trailer
+   * \param uid trailer's uid to add
+   * \param size trailer serialized size
+   */
+  void DoAddTrailer (uint32_t uid, uint32_t size);
+  /**
+   * \brief Remove a trailer
+   * \param uid trailer's uid to remove
+   * \param size trailer serialized size
+   */
+  void DoRemoveTrailer (uint32_t uid, uint32_t size);
+  /**
+   * \brief Check if the operations should be logged
+   * \returns true if the metadata is recorded lazily
+   */
+  static bool IsLazy (void);
+  /**
+   * \brief Append an operation to the log
+   *
+   * If the log is full, it is replayed instead and the operation must
+   * then be applied to the list of items.
+   *
+   * \param type the operation
+   * \param uid the header or trailer uid, or the appended metadata
+   * \param size the header or trailer size, or the number of bytes
+   * \returns true if the operation was logged
+   */
+  bool AppendLog (uint8_t type, uint32_t uid, uint32_t size);
+  /**
+   * \brief Replay the log, if any, to build the list of items
+   */
+  void Materialize (void) const;
+  /**
+   * \brief Take a reference to a log
+   * \param log the log
+   */
+  static void AcquireLog (struct PacketMetadata::LazyLog *log);
+  /**
+   * \brief Release a reference to a log
+   * \param log the log
+   */
+  static void ReleaseLog (struct PacketMetadata::LazyLog *log);
   /**
    * \brief Check if the metadata state is ok
    * \returns true if the internal state is ok
@@ -664,6 +750,10 @@ public:
   static DataFreeList m_freeList; //!< the metadata data storage
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
+  static bool m_enableLazy; //!< Enable the lazy recording of the metadata
+  static LazyLogFreeList m_freeLogs; //!< the unused logs
+  static bool m_freeLogsDestroyed; //!< m_freeLogs has been destroyed
+  static uint32_t m_replaying; //!< Number of logs being replayed
 
   /**
    * Set to true when adding metadata to a packet is skipped because
@@ -685,6 +775,11 @@ public:
   uint16_t m_tail; //!< list tail
   uint16_t m_used; //!< used portion
   uint64_t m_packetUid; //!< packet Uid
+  /**
+   * Operations not yet applied to the list of items, or zero.
+   * The log is shared, read-only, by the copies of this metadata.
+   */
+  struct LazyLog *m_log;
 };
 
 } // namespace ns3
@@ -696,7 +791,8 @@ PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
-    m_packetUid (uid)
+    m_packetUid (uid),
+    m_log (0)
 {
   memset (m_data->m_data, 0xff, 4);
   if (size > 0)
@@ -709,11 +805,16 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
-    m_packetUid (o.m_packetUid)
+    m_packetUid (o.m_packetUid),
+    m_log (o.m_log)
 {
   NS_ASSERT (m_data != 0);
   NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
   m_data->m_count++;
+  if (m_log != 0)
+    {
+      AcquireLog (m_log);
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -735,6 +836,18 @@ PacketMetadata::operator = (PacketMetadata const& o)
   m_tail = o.m_tail;
   m_used = o.m_used;
   m_packetUid = o.m_packetUid;
+  if (m_log != o.m_log)
+    {
+      if (o.m_log != 0)
+        {
+          AcquireLog (o.m_log);
+        }
+      if (m_log != 0)
+        {
+          ReleaseLog (m_log);
+        }
+      m_log = o.m_log;
+    }
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
@@ -745,6 +858,10 @@ PacketMetadata::~PacketMetadata ()
     {
       PacketMetadata::Recycle (m_data);
     }
+  if (m_log != 0)
+    {
+      ReleaseLog (m_log);
+    }
 }
 
 } // namespace ns3
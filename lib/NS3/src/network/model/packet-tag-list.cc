@@ -20,7 +20,7 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements a list of Packet tags, including copy-on-write semantics.
 */
 
 #include "packet-tag-list.h"
@@ -28,276 +28,201 @@
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
+#include <limits>
+#include <new>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
-PacketTagList::TagData *
-PacketTagList::CreateTagData (size_t dataSize)
+const uint32_t PacketTagList::INLINE_SIZE;
+
+uint32_t
+PacketTagList::GetRecordSize (uint32_t dataSize)
 {
   NS_ASSERT_MSG (dataSize
-                 < std::numeric_limits<decltype(TagData::size)>::max (),
-                 "Requested TagData size " << dataSize
-                 << " exceeds maximum "
-                 << std::numeric_limits<decltype(TagData::size)>::max () );
-
-  void * p = std::malloc (sizeof (TagData) + dataSize - 1);
-  // The matching frees are in RemoveAll and RemoveWriter
-
-  TagData * tag = new (p) TagData;
-  tag->size = dataSize;
-  return tag;
+                 < std::numeric_limits<uint32_t>::max () - sizeof (TagData),
+                 "Requested TagData size " << dataSize << " is too large");
+  uint32_t size = offsetof (TagData, data) + dataSize;
+  return (size + 3) & ~3U;
 }
 
-bool
-PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
+uint32_t
+PacketTagList::Find (TypeId tid) const
 {
-  TypeId tid = tag.GetInstanceTypeId ();
-  NS_LOG_FUNCTION (this << tid);
-  NS_LOG_INFO     ("looking for " << tid);
-
-  // trivial case when list is empty
-  if (m_next == 0)
-    {
-      return false;
-    }
-
-  bool found = false;
-
-  struct TagData ** prevNext = &m_next; // previous node's next pointer
-  struct TagData  * cur      =  m_next; // cursor to current node
-  struct TagData  * it = 0;             // utility
-
-  // Search from the head of the list until we find tid or a merge
-  while (cur != 0)
+  uint8_t *buffer = GetBuffer ();
+  uint32_t offset = 0;
+  while (offset < m_used)
     {
-      if (cur->count > 1)
-        {
-          // found merge
-          NS_LOG_INFO ("found initial merge before tid");
-          break;
-        }
-      else if (cur->tid == tid)
+      const struct TagData *cur = reinterpret_cast<const struct TagData *> (buffer + offset);
+      if (cur->tid == tid)
         {
-          NS_LOG_INFO ("found tid before initial merge, calling writer");
-          found = (this->*Writer)(tag, true, cur, prevNext);
           break;
         }
-      else
-        {
-          // no merge or tid found yet, move on
-          prevNext = &cur->next;
-          cur      =  cur->next;
-        }
-    }  // while !found && !cow
+      offset += GetRecordSize (cur->size);
+    }
+  return offset;
+}
 
-  // did we find it or run out of tags?
-  if (cur == 0 || found)
+void
+PacketTagList::Reserve (uint32_t size)
+{
+  if (m_data == 0 && size <= INLINE_SIZE)
     {
-      NS_LOG_INFO ("returning after header with found: " << found);
-      return found;
+      return;
     }
-
-  // From here on out, we have to copy the list
-  // until we find tid, then link past it
-
-  // Before we do all that work, let's make sure tid really exists
-  for (it = cur; it != 0; it = it->next)
+  if (m_data != 0 && m_data->count == 1 && m_data->size >= size)
     {
-      if (it->tid == tid)
-        {
-          break;
-        }
+      return;
     }
-  if (it == 0)
+  uint8_t *old = GetBuffer ();
+  struct Data *data = 0;
+  uint8_t *buffer;
+  if (size <= INLINE_SIZE)
     {
-      // got to end of list without finding tid
-      NS_LOG_INFO ("tid not found after first merge");
-      return found;
+      // unshare into the inline buffer
+      buffer = reinterpret_cast<uint8_t *> (m_inline);
     }
-
-  // At this point cur is a merge, but untested for tid
-  NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
-
-  /*
-     Walk the remainder of the list, copying, until we find tid
-     As we put a copy of the cur node onto our list,
-     we move the merge point down the list.
-
-     Starting position                  End position
-       T1 is a merge                     T1.count decremented
-                                         T2 is a merge
-                                         T1' is a copy of T1
-
-          other                             other
-               \                                 \
-      Prev  ->  T1  ->  T2  -> ...                T1  ->  T2  -> ...
-           /   /                                         /|
-      pNext cur                         Prev  ->  T1' --/ |
-                                                     /    |
-                                                pNext   cur
-
-     When we reach tid, we link past it, decrement count, and we're done.
-  */
-
-  // Should normally check for null cur pointer,
-  // but since we know tid exists, we'll skip this test
-  while ( /* cur && */ cur->tid != tid)
+  else
     {
-      NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
-      struct TagData * copy = CreateTagData (cur->size);
-      copy->tid = cur->tid;
-      copy->count = 1;
-      copy->size = cur->size;
-      memcpy (copy->data, cur->data, copy->size);
-      copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
-      *prevNext = copy;                   // point prior list at copy
-      prevNext = &copy->next;             // advance
-      cur      =  copy->next;
+      uint32_t capacity = size;
+      if (m_data != 0 && m_data->size >= size)
+        {
+          // unshare only
+          capacity = m_data->size;
+        }
+      else
+        {
+          capacity = std::max (size, 2 * std::max (m_used, INLINE_SIZE));
+        }
+      data = static_cast<struct Data *> (std::malloc (sizeof (struct Data) - 4 + capacity));
+      // The matching free is in RemoveAll
+      data->count = 1;
+      data->size = capacity;
+      buffer = data->data;
     }
-  // Sanity check:
-  NS_ASSERT (cur != 0);                 // cur should be non-zero
-  NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
-
-  // link around tid, removing it from our list
-  found = (this->*Writer)(tag, false, cur, prevNext);
-  return found;
-
+  std::memcpy (buffer, old, m_used);
+  uint32_t used = m_used;
+  RemoveAll ();
+  m_data = data;
+  m_used = used;
 }
 
 bool
 PacketTagList::Remove (Tag & tag)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
-}
-
-// COWWriter implementing Remove
-bool
-PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
-                             struct PacketTagList::TagData  * cur,
-                             struct PacketTagList::TagData ** prevNext)
-{
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
-  *prevNext = cur->next;            // link around cur
-
-  if (preMerge)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t offset = Find (tid);
+  if (offset == m_used)
     {
-      // found tid before first merge, so delete cur
-      cur->~TagData ();
-      std::free (cur);
+      NS_LOG_INFO ("tid not found");
+      return false;
     }
-  else
+  Reserve (m_used);
+  uint8_t *buffer = GetBuffer ();
+  struct TagData *cur = reinterpret_cast<struct TagData *> (buffer + offset);
+  tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
+  uint32_t next = offset + GetRecordSize (cur->size);
+  std::memmove (buffer + offset, buffer + next, m_used - next);
+  m_used -= next - offset;
+  if (m_used == 0)
     {
-      // cur is always a merge at this point
-      // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
-        {
-          // there's a next, so make it a merge
-          cur->next->count++;
-        }
+      RemoveAll ();
     }
-  return found;
+  return true;
 }
 
 bool
 PacketTagList::Replace (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
-  if (!found)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t offset = Find (tid);
+  if (offset == m_used)
     {
       Add (tag);
+      return false;
     }
-  return found;
-}
-
-// COWWriter implementing Replace
-bool
-PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
-                              struct PacketTagList::TagData  * cur,
-                              struct PacketTagList::TagData ** prevNext)
-{
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  if (preMerge)
-    {
-      // found tid before first merge, so just rewrite
-      tag.Serialize (TagBuffer (cur->data, cur->data + cur->size));
-    }
-  else
+  uint32_t size = tag.GetSerializedSize ();
+  uint32_t recordSize = GetRecordSize (reinterpret_cast<const struct TagData *> (GetBuffer () + offset)->size);
+  Reserve (m_used);
+  if (recordSize != GetRecordSize (size))
     {
-      // cur is always a merge at this point
-      // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
-      struct TagData * copy = CreateTagData (tag.GetSerializedSize ());
-      copy->tid = tag.GetInstanceTypeId ();
-      copy->count = 1;
-      tag.Serialize (TagBuffer (copy->data, copy->data + copy->size));
-      copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
-        {
-          copy->next->count++;          // mark new merge
-        }
-      *prevNext = copy;                 // point prior list at copy
+      // the record does not fit: remove it, and add the new value
+      uint8_t *buffer = GetBuffer ();
+      uint32_t next = offset + recordSize;
+      std::memmove (buffer + offset, buffer + next, m_used - next);
+      m_used -= next - offset;
+      Add (tag);
+      return true;
     }
-  return found;
+  struct TagData *cur = reinterpret_cast<struct TagData *> (GetBuffer () + offset);
+  cur->size = size;
+  tag.Serialize (TagBuffer (cur->data, cur->data + cur->size));
+  return true;
 }
 
 void 
 PacketTagList::Add (const Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
-    {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (),
-                     "Error: cannot add the same kind of tag twice.");
-    }
-  struct TagData * head = CreateTagData (tag.GetSerializedSize ());
-  head->count = 1;
-  head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
+  NS_ASSERT_MSG (Find (tid) == m_used,
+                 "Error: cannot add the same kind of tag twice.");
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  uint32_t dataSize = tag.GetSerializedSize ();
+  uint32_t recordSize = GetRecordSize (dataSize);
+  self->Reserve (m_used + recordSize);
+  uint8_t *buffer = GetBuffer ();
+  std::memmove (buffer + recordSize, buffer, m_used);
+  struct TagData *head = new (buffer) TagData;
+  head->tid = tid;
+  head->size = dataSize;
   tag.Serialize (TagBuffer (head->data, head->data + head->size));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_used += recordSize;
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t offset = Find (tid);
+  if (offset == m_used)
     {
-      if (cur->tid == tid) 
-        {
-          /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
-          return true;
-        }
+      /* no tag found */
+      return false;
     }
-  /* no tag found */
-  return false;
+  /* found tag */
+  struct TagData *cur = reinterpret_cast<struct TagData *> (GetBuffer () + offset);
+  tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
+  return true;
 }
 
 const struct PacketTagList::TagData *
 PacketTagList::Head (void) const
 {
-  return m_next;
+  if (m_used == 0)
+    {
+      return 0;
+    }
+  return reinterpret_cast<const struct TagData *> (GetBuffer ());
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::Next (const struct PacketTagList::TagData *cur) const
+{
+  const uint8_t *next = reinterpret_cast<const uint8_t *> (cur) + GetRecordSize (cur->size);
+  if (next >= GetBuffer () + m_used)
+    {
+      return 0;
+    }
+  return reinterpret_cast<const struct TagData *> (next);
 }
 
 } /* namespace ns3 */
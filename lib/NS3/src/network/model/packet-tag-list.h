@@ -22,10 +22,12 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines a list of Packet tags, including copy-on-write semantics.
 */
 
 #include <stdint.h>
+#include <cstdlib>
+#include <cstring>
 #include <ostream>
 #include "ns3/type-id.h"
 
@@ -35,96 +37,35 @@ class Tag;
 
 /**
  * \ingroup packet
- *
  * \brief List of the packet tags stored in a packet.
- *
  * This class is mostly private to the Packet implementation and users
  * should never have to access it directly.
- *
  * \internal
+ * The tags are stored in serialized form, one TagData record after the
+ * other in a contiguous buffer, the most recently added tag first.
+ * Finding a tag is a linear scan over this buffer.
  *
- * The implementation of this class is a bit tricky.  Refer to this
- * diagram in the discussion that follows.
- *
- * \dot
- *    digraph {
- *        rankdir = "LR";
- *        clusterrank = local;
- *        node [ shape = record, fontname="FreeSans", fontsize="10" ];
- *        oth  [ label="<l> Other branch | <n> next | <c> ..." ];
- *        PTL1 [ label="<l> PacketTagList A | <n> m_next" , shape=Mrecord];
- *        PTL2 [ label="<l> PacketTagList B | <n> m_next" , shape=Mrecord];
- *        oth:n  -> T7:l ;
- *        PTL2:n -> T6:l ;
- *        PTL1:n -> T5:l ;
- *        T1   [ label="<l> T1  | <n> next | <c> count = 1" ];
- *        T2   [ label="<l> T2  | <n> next | <c> count = 1" ];
- *        T3   [ label="<l> T3  | <n> next | <c> count = 2" ];
- *        T4   [ label="<l> T4  | <n> next | <c> count = 1" ];
- *        T5   [ label="<l> T5  | <n> next | <c> count = 2" ];
- *        T6   [ label="<l> T6  | <n> next | <c> count = 1" ];
- *        T7   [ label="<l> T7  | <n> next | <c> count = 1" ];
- *        NULL [ label="0", shape = ellipse ];
- *        subgraph cluster_list {
- *          penwidth = 0;
- *          T6:n -> T5:l ;
- *          T5:n -> T4:l ;
- *          T4:n -> T3:l ;
- *          T7:n -> T3:l ;
- *          T3:n -> T2:l ;
- *          T2:n -> T1:l ;
- *          T1:n -> NULL ;
- *        };
- *      }
- * \enddot
- *
- *   - Tags are stored in serialized form in a tree of TagData
- *     structures. (<tt>T1-T7</tt> in the diagram)
- *
- *   - Each TagData points (\c next pointers in the diagram)
- *     toward the root of the tree, which is a null pointer.
- *
- *   - \c count is the number of incoming pointers to this
- *     TagData.  Branch points, where branches merge or join, have
- *     <tt>count \> 1</tt> (\c T3, \c T5); successive links along
- *     a branch have <tt>count = 1</tt> (\c T1, \c T2, \c T4, \c T6, \c T7).
- *
- *   - Each PacketTagList points to a specific TagData,
- *     which is the most recent Tag added to the packet. (<tt>T5-T7</tt>)
- *
- *   - Conceptually, therefore, each Packet has a PacketTagList which
- *     points to a singly-linked list of TagData.
+ *   - Small lists are stored inline, in a buffer of #INLINE_SIZE bytes
+ *     which is part of the PacketTagList itself: a few small tags (such
+ *     as flow, priority or link quality tags) never allocate memory,
+ *     and copying the list, as in Packet::Copy, is a \c memcpy.
+ *   - Larger lists spill to a heap buffer which is reference counted
+ *     and shared by the copies of the list.
  *
  * \par <b> Copy-on-write </b> is implemented as follows:
- *
- *   - #Add prepends the new tag to the list (growing that branch of the tree,
- *     as \c T6). This is a constant time operation, and does not affect
- *     any other #PacketTagList's, hence this is a \c const function.
- *
  *   - Copy constructor (PacketTagList(const PacketTagList & o))
  *     and assignment (#operator=(const PacketTagList & o))
- *     simply join the tree at the same place as the original
- *     PacketTagList \c o, incrementing the \c count.
- *     For assignment, the old branch is deleted, up to
- *     the first branch point, which has its \c count decremented.
- *     (PacketTagList \c B started as a copy of PacketTagList \c A,
- *     before \c T6 was added to \c B).
- *
- *   - #Remove and #Replace are a little tricky, depending on where the
- *     target tag is found relative to the first branch point:
- *     - \e Target before <em> the first branch point: </em> \n
- *       The target is just dealt with in place (linked around and deleted,
- *       in the case of #Remove; rewritten in the case of #Replace).
- *     - \e Target at or after <em> the first branch point: </em> \n
- *       The portion of the list between the first branch and the target is
- *       shared. This portion is copied before the #Remove or #Replace is
- *       performed.
+ *     copy the inline buffer, or share the heap buffer of \c o,
+ *     incrementing its count.
+ *   - #Add, #Remove and #Replace first make sure that this list has a
+ *     buffer of its own: a shared heap buffer is copied, inline if the
+ *     list is small enough.
  */
 class PacketTagList 
 {
 public:
   /**
-   * Tree node for sharing serialized tags.
+   * Serialized tag record.
    *
    * See PacketTagList for a discussion of the data structure.
    *
@@ -134,19 +75,21 @@ public:
    * The Item nested class can't be forward declared, so friending isn't
    * possible.
    *
-   * We use placement new so we can allocate enough room for the Tag
-   * type which will be serialized into data.  See Object::Aggregates
-   * for a similar construction.
+   * The records are variable-sized through their last member: each
+   * record is followed by the next one, aligned on four bytes.
    */
   struct TagData
   {
-    struct TagData * next;      /**< Pointer to next in list */
-    uint32_t count;             /**< Number of incoming links */
     TypeId tid;                 /**< Type of the tag serialized into #data */
     uint32_t size;              /**< Size of the \c data buffer */
     uint8_t data[1];            /**< Serialization buffer */
   };  /* struct TagData */
 
+  /**
+   * Number of bytes of records stored inline, without memory allocation.
+   */
+  static const uint32_t INLINE_SIZE = 48;
+
   /**
    * Create a new PacketTagList.
    */
@@ -156,8 +99,8 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the inline records of \pname{o}, or shares its heap
+   * buffer.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -167,18 +110,18 @@ public:
    * \returns the copied object
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * copying the inline records of \pname{o}, or sharing its heap buffer.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
    * Destructor
    *
-   * #RemoveAll's the tags up to the first merge.
+   * #RemoveAll's the tags.
    */
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag to the head of this list.
    *
    * \param [in] tag The tag to add
    */
@@ -210,78 +153,68 @@ public:
    */
   bool Peek (Tag &tag) const;
   /**
-   * Remove all tags from this list (up to the first merge).
+   * Remove all tags from this list.
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns pointer to the first record, or zero if the list is empty
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \param [in] cur A record of this list.
+   * \returns pointer to the record after \pname{cur}, or zero if
+   *          \pname{cur} is the last one
+   */
+  const struct PacketTagList::TagData *Next (const struct PacketTagList::TagData *cur) const;
 
 private:
   /**
-   * Allocate and construct a TagData struct, sizing the data area
-   * large enough to serialize dataSize bytes from a Tag.
-   *
-   * \param [in] dataSize The serialized size of the Tag.
-   * \returns The newly constructed TagData object.
+   * Heap buffer of records, shared by copy-on-write.
    */
-  static
-  TagData * CreateTagData (size_t dataSize);
-  
+  struct Data
+  {
+    uint32_t count;             /**< Number of lists sharing this buffer */
+    uint32_t size;              /**< Size of the \c data buffer */
+    uint8_t data[4];            /**< Records */
+  };
+
   /**
-   * Typedef of method function pointer for copy-on-write operations
+   * Get the size of the record of a tag.
    *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True if operation successful, false otherwise
+   * \param [in] dataSize The serialized size of the Tag.
+   * \returns The size of its TagData record, padding included.
    */
-  typedef bool (PacketTagList::*COWWriter)
-    (Tag       & tag, bool         preMerge,
-    struct TagData * cur, struct TagData ** prevNext);
+  static uint32_t GetRecordSize (uint32_t dataSize);
   /**
-   * Traverse the list implementing copy-on-write, using \pname{Writer}.
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] Writer The copy-on-write function to use.
-   * \returns True if \pname{tag} found, false otherwise.
+   * \returns The records of this list.
    */
-  bool COWTraverse   (Tag & tag, PacketTagList::COWWriter Writer);
+  inline uint8_t * GetBuffer (void) const;
   /**
-   * Copy-on-write implementing Remove.
+   * Find the record of a tag type.
    *
-   * \param [in] tag The target tag type to remove.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag will definitely be removed.
+   * \param [in] tid The tag type.
+   * \returns The offset of its record, or #m_used if not found.
    */
-  bool RemoveWriter  (Tag & tag, bool preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  uint32_t Find (TypeId tid) const;
   /**
-   * Copy-on-write implementing Replace
+   * Make sure this list owns its buffer, with room for some records.
    *
-   * \param [in] tag The target tag type to replace
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *          false otherwise.
-   * \param [in] cur Pointer to the tag
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag value will definitely be replaced.
+   * \param [in] size The number of bytes of records needed.
    */
-  bool ReplaceWriter (Tag & tag, bool preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  void Reserve (uint32_t size);
 
   /**
-   * Pointer to first \ref TagData on the list
+   * Heap buffer, or zero if the records are inline
+   */
+  struct Data *m_data;
+  /**
+   * Number of bytes of records used
+   */
+  uint32_t m_used;
+  /**
+   * Inline records, used when #m_data is zero
    */
-  struct TagData *m_next;
+  uint32_t m_inline[INLINE_SIZE / 4];
 };
 
 } // namespace ns3
@@ -293,16 +226,22 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_data (0),
+    m_used (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_data (o.m_data),
+    m_used (o.m_used)
 {
-  if (m_next != 0)
+  if (m_data != 0)
     {
-      m_next->count++;
+      m_data->count++;
+    }
+  else
+    {
+      std::memcpy (m_inline, o.m_inline, m_used);
     }
 }
 
@@ -310,15 +249,20 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o) 
     {
       return *this;
     }
   RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  m_data = o.m_data;
+  m_used = o.m_used;
+  if (m_data != 0) 
     {
-      m_next->count++;
+      m_data->count++;
+    }
+  else
+    {
+      std::memcpy (m_inline, o.m_inline, m_used);
     }
   return *this;
 }
@@ -331,27 +275,26 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  if (m_data != 0)
     {
-      cur->count--;
-      if (cur->count > 0) 
+      m_data->count--;
+      if (m_data->count == 0)
         {
-          break;
+          std::free (m_data);
         }
-      if (prev != 0) 
-        {
-          prev->~TagData ();
-          std::free (prev);
-        }
-      prev = cur;
+      m_data = 0;
     }
-  if (prev != 0) 
+  m_used = 0;
+}
+
+uint8_t *
+PacketTagList::GetBuffer (void) const
+{
+  if (m_data != 0)
     {
-      prev->~TagData ();
-      std::free (prev);
+      return m_data->data;
     }
-  m_next = 0;
+  return reinterpret_cast<uint8_t *> (const_cast<uint32_t *> (m_inline));
 }
 
 } // namespace ns3
@@ -173,9 +173,10 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the packet tags
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
+  PacketTagIterator (const PacketTagList *list);
+  const PacketTagList *m_list;  //!< the packet tags
   const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
 };
 
@@ -199,7 +200,8 @@ private:
  * output from Packet::Print. If you wish to only enable
  * checking of metadata, and do not need any printing capability, you can
  * call Packet::EnableChecking: its runtime cost is lower than
- * Packet::EnablePrinting.
+ * Packet::EnablePrinting. Packet::EnableLazyPrinting defers most of the
+ * cost of the metadata to the packets which are actually printed.
  *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
@@ -530,6 +532,17 @@ public:
    * errors will be detected and will abort the program.
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable printing packets metadata, recorded lazily.
+   *
+   * Like EnablePrinting, but the packets only log the type and size of
+   * the headers and trailers added and removed; the metadata is built
+   * from that log when a packet is printed.  The cost of a traced
+   * simulation is then close to that of an untraced one when only a
+   * few packets are actually printed.  This mode stays selected when
+   * the trace helpers call EnablePrinting, but not with EnableChecking.
+   */
+  static void EnableLazyPrinting (void);
 
   /**
    * \brief Returns number of bytes required for packet
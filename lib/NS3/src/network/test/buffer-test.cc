@@ -19,8 +19,10 @@
  */
 
 #include "ns3/buffer.h"
+#include "ns3/crc32.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/double.h"
+#include "ns3/simulator.h"
 #include "ns3/test.h"
 
 using namespace ns3;
@@ -378,6 +380,267 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Buffer data allocator unit tests.
+ */
+class BufferAllocatorTest : public TestCase {
+private:
+  /**
+   * Sum the statistics of all the size classes.
+   * \returns The total statistics.
+   */
+  static Buffer::AllocationStats GetTotalStats (void);
+  /**
+   * Fill buffers with a pattern.
+   * \param buffers The buffers.
+   * \param size The number of bytes of each buffer.
+   */
+  static void Fill (std::vector<Buffer> &buffers, uint32_t size);
+  /**
+   * Check the pattern written by Fill.
+   * \param buffers The buffers.
+   * \returns true if all the buffers hold their pattern.
+   */
+  static bool Check (const std::vector<Buffer> &buffers);
+public:
+  virtual void DoRun (void);
+  BufferAllocatorTest ();
+};
+
+BufferAllocatorTest::BufferAllocatorTest ()
+  : TestCase ("Buffer data allocator")
+{
+}
+
+Buffer::AllocationStats
+BufferAllocatorTest::GetTotalStats (void)
+{
+  std::vector<Buffer::AllocationStats> stats = Buffer::GetAllocationStats ();
+  Buffer::AllocationStats total = Buffer::AllocationStats ();
+  for (std::vector<Buffer::AllocationStats>::const_iterator i = stats.begin (); i != stats.end (); i++)
+    {
+      total.allocations += i->allocations;
+      total.hits += i->hits;
+      total.arena += i->arena;
+      total.recycled += i->recycled;
+      total.freed += i->freed;
+      total.cached += i->cached;
+    }
+  return total;
+}
+
+void
+BufferAllocatorTest::Fill (std::vector<Buffer> &buffers, uint32_t size)
+{
+  for (uint32_t i = 0; i < buffers.size (); i++)
+    {
+      buffers[i].AddAtStart (size);
+      Buffer::Iterator it = buffers[i].Begin ();
+      for (uint32_t j = 0; j < size; j++)
+        {
+          it.WriteU8 ((i + j) & 0xff);
+        }
+    }
+}
+
+bool
+BufferAllocatorTest::Check (const std::vector<Buffer> &buffers)
+{
+  for (uint32_t i = 0; i < buffers.size (); i++)
+    {
+      Buffer::Iterator it = buffers[i].Begin ();
+      for (uint32_t j = 0; j < buffers[i].GetSize (); j++)
+        {
+          if (it.ReadU8 () != ((i + j) & 0xff))
+            {
+              return false;
+            }
+        }
+    }
+  return true;
+}
+
+void
+BufferAllocatorTest::DoRun (void)
+{
+  std::vector<Buffer::AllocationStats> stats = Buffer::GetAllocationStats ();
+  NS_TEST_ASSERT_MSG_GT (stats.size (), 1, "No size class");
+  NS_TEST_EXPECT_MSG_EQ (stats.front ().size, 32, "Wrong smallest size class");
+  NS_TEST_EXPECT_MSG_EQ (stats.back ().size, 0, "The last class is not for larger data");
+
+  // Once the size heuristics are warmed up, a steady stream of packets
+  // is served by the free lists without any resize.
+  for (uint32_t i = 0; i < 102; i++)
+    {
+      if (i == 2)
+        {
+          Buffer::ResetAllocationStats ();
+        }
+      Buffer buffer;
+      buffer.AddAtEnd (1000);
+      buffer.AddAtStart (100);
+    }
+  Buffer::AllocationStats total = GetTotalStats ();
+  NS_TEST_EXPECT_MSG_EQ (total.allocations, 100, "Buffers were resized");
+  NS_TEST_EXPECT_MSG_EQ (total.hits, total.allocations, "Buffers not recycled");
+  NS_TEST_EXPECT_MSG_EQ (total.recycled, 100, "Buffers not recycled");
+
+  // Data too large for the size classes is not cached.
+  Buffer::ResetAllocationStats ();
+  {
+    Buffer buffer;
+    buffer.AddAtEnd (100000);
+  }
+  stats = Buffer::GetAllocationStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.back ().allocations, 1, "Large data not accounted for");
+  NS_TEST_EXPECT_MSG_EQ (stats.back ().freed, 1, "Large data not freed");
+  NS_TEST_EXPECT_MSG_EQ (stats.back ().cached, 0, "Large data cached");
+
+  // Buffers which outnumber the free lists are carved from the arena.
+  Buffer::EnableArena (true);
+  Buffer::ResetAllocationStats ();
+  uint32_t count = GetTotalStats ().cached + 100;
+  std::vector<Buffer> buffers (count);
+  Fill (buffers, 200);
+  total = GetTotalStats ();
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (total.arena, 100, "Arena not used");
+  NS_TEST_EXPECT_MSG_EQ (Check (buffers), true, "Arena buffers overlap");
+
+  // The arena outlives the simulation while its buffers are alive.
+  std::vector<Buffer> kept (buffers.begin (), buffers.begin () + count / 2);
+  buffers.clear ();
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (Check (kept), true, "Arena released too early");
+  kept.clear ();
+
+  // The arena is used again by the next simulation.
+  Buffer::ResetAllocationStats ();
+  buffers.resize (count);
+  Fill (buffers, 200);
+  NS_TEST_EXPECT_MSG_EQ (GetTotalStats ().arena, 100, "Arena not released");
+  NS_TEST_EXPECT_MSG_EQ (Check (buffers), true, "Arena buffers overlap");
+  buffers.clear ();
+  Buffer::EnableArena (false);
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (GetTotalStats ().cached, count - 100, "Arena data still cached");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Buffer checksum and CRC-32 unit tests, against byte-wise computations.
+ */
+class BufferChecksumTest : public TestCase {
+private:
+  /**
+   * Computes the Internet checksum of an area a byte at a time.
+   * \param data The area.
+   * \param size The size of the area.
+   * \param initialChecksum The initial value.
+   * \returns The checksum.
+   */
+  static uint16_t IpChecksum (const uint8_t *data, uint32_t size, uint32_t initialChecksum);
+  /**
+   * Computes the CRC-32 of an area a bit at a time.
+   * \param data The area.
+   * \param size The size of the area.
+   * \returns The CRC-32.
+   */
+  static uint32_t Crc32 (const uint8_t *data, uint32_t size);
+public:
+  virtual void DoRun (void);
+  BufferChecksumTest ();
+};
+
+BufferChecksumTest::BufferChecksumTest ()
+  : TestCase ("Buffer checksums")
+{
+}
+
+uint16_t
+BufferChecksumTest::IpChecksum (const uint8_t *data, uint32_t size, uint32_t initialChecksum)
+{
+  uint32_t sum = initialChecksum;
+  for (uint32_t i = 0; i + 1 < size; i += 2)
+    {
+      sum += data[i] | (data[i + 1] << 8);
+    }
+  if (size & 1)
+    {
+      sum += data[size - 1];
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return ~sum;
+}
+
+uint32_t
+BufferChecksumTest::Crc32 (const uint8_t *data, uint32_t size)
+{
+  uint32_t crc = 0xffffffff;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      crc ^= data[i];
+      for (uint32_t bit = 0; bit < 8; bit++)
+        {
+          crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+  return ~crc;
+}
+
+void
+BufferChecksumTest::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  for (uint32_t n = 0; n < 500; n++)
+    {
+      // Data around a zero area of any parity
+      Buffer buffer (rand->GetInteger (0, 1500));
+      uint32_t front = rand->GetInteger (0, 100);
+      uint32_t back = rand->GetInteger (0, 100);
+      buffer.AddAtStart (front);
+      buffer.AddAtEnd (back);
+      Buffer::Iterator it = buffer.Begin ();
+      for (uint32_t i = 0; i < front; i++)
+        {
+          it.WriteU8 (rand->GetInteger (0, 255));
+        }
+      it = buffer.End ();
+      it.Prev (back);
+      for (uint32_t i = 0; i < back; i++)
+        {
+          it.WriteU8 (rand->GetInteger (0, 255));
+        }
+      std::vector<uint8_t> data (buffer.GetSize ());
+      buffer.CopyData (data.data (), data.size ());
+
+      uint32_t start = rand->GetInteger (0, data.size ());
+      uint32_t size = rand->GetInteger (0, data.size () - start);
+      uint32_t initialChecksum = rand->GetInteger (0, 0xffff);
+      it = buffer.Begin ();
+      it.Next (start);
+      uint16_t checksum = it.CalculateIpChecksum (size, initialChecksum);
+      NS_TEST_EXPECT_MSG_EQ (checksum, IpChecksum (data.data () + start, size, initialChecksum), "Wrong checksum");
+      NS_TEST_EXPECT_MSG_EQ (it.GetDistanceFrom (buffer.Begin ()), start + size, "Iterator not advanced");
+
+      NS_TEST_EXPECT_MSG_EQ (CRC32Calculate (data.data () + start, size), Crc32 (data.data () + start, size), "Wrong CRC-32");
+    }
+  uint8_t ones[64];
+  memset (ones, 0xff, sizeof (ones));
+  Buffer buffer (64);
+  NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().CalculateIpChecksum (64), 0xffff, "Wrong checksum of zeroes");
+  buffer.AddAtStart (sizeof (ones));
+  buffer.Begin ().Write (ones, sizeof (ones));
+  NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().CalculateIpChecksum (64), 0, "Wrong checksum of ones");
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -394,6 +657,8 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferAllocatorTest, TestCase::QUICK);
+  AddTestCase (new BufferChecksumTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/node-container.h"
+#include "ns3/mac48-address.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check that packets exchanged by nodes run with
+ * MultithreadedSimulatorImpl exactly as with DefaultSimulatorImpl.
+ *
+ * The nodes of a shared channel broadcast packets, and answer each
+ * of them with a longer copy, twice.  The receptions, with the packet
+ * uids and contents, must be the same with 1, 2 and 4 threads as with
+ * DefaultSimulatorImpl: since the packets are not thread-safe, the
+ * simulations which have nodes are not run in parallel.
+ */
+class MultithreadedPacketTestCase : public TestCase
+{
+public:
+  MultithreadedPacketTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Run the simulation with the current simulator implementation.
+   * \return The receptions, one per line.
+   */
+  std::string RunNodes (void);
+  /**
+   * Create a packet filled with a pattern.
+   * \param node The id of the node creating the packet.
+   * \param size The packet size.
+   * \return The packet.
+   */
+  static Ptr<Packet> CreatePayload (uint32_t node, uint32_t size);
+  /**
+   * Broadcast a packet.
+   * \param device The sending device.
+   * \param size The packet size.
+   */
+  void Send (Ptr<NetDevice> device, uint32_t size);
+  /**
+   * Record a packet and answer it with a longer copy.
+   * \param device The receiving device.
+   * \param packet The packet.
+   * \param protocol The protocol number.
+   * \param from The sender address.
+   * \return true.
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                uint16_t protocol, const Address &from);
+
+  std::ostringstream m_log; //!< The receptions of the current run
+  uint64_t m_firstUid;      //!< The uid of the first packet of the current run
+  Time m_lookAhead;         //!< The lookahead used by the current run
+};
+
+MultithreadedPacketTestCase::MultithreadedPacketTestCase ()
+  : TestCase ("Check the packets of MultithreadedSimulatorImpl against DefaultSimulatorImpl"),
+    m_firstUid (0)
+{
+}
+
+Ptr<Packet>
+MultithreadedPacketTestCase::CreatePayload (uint32_t node, uint32_t size)
+{
+  std::vector<uint8_t> data (size);
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      data[i] = static_cast<uint8_t> (node * 37 + i);
+    }
+  return Create<Packet> (data.data (), size);
+}
+
+void
+MultithreadedPacketTestCase::Send (Ptr<NetDevice> device, uint32_t size)
+{
+  device->Send (CreatePayload (device->GetNode ()->GetId (), size),
+                device->GetBroadcast (), 0x800);
+}
+
+bool
+MultithreadedPacketTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                      uint16_t protocol, const Address &from)
+{
+  std::vector<uint8_t> data (packet->GetSize ());
+  packet->CopyData (data.data (), data.size ());
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < data.size (); ++i)
+    {
+      sum = sum * 31 + data[i];
+    }
+  m_log << Simulator::Now ().GetTimeStep () << " " << device->GetNode ()->GetId ()
+        << " " << packet->GetUid () - m_firstUid << " " << packet->GetSize ()
+        << " " << sum << std::endl;
+  if (packet->GetSize () < 300)
+    {
+      Ptr<Packet> reply = packet->Copy ();
+      reply->AddAtEnd (CreatePayload (device->GetNode ()->GetId (), 100));
+      device->Send (reply, from, protocol);
+    }
+  return true;
+}
+
+std::string
+MultithreadedPacketTestCase::RunNodes (void)
+{
+  m_log.str ("");
+  m_firstUid = Create<Packet> ()->GetUid ();
+
+  NodeContainer nodes;
+  nodes.Create (6);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MicroSeconds (2)));
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      nodes.Get (i)->AddDevice (device);
+      device->SetChannel (channel);
+      device->SetReceiveCallback (MakeCallback (&MultithreadedPacketTestCase::Receive, this));
+      for (uint32_t j = 0; j < 3; ++j)
+        {
+          Simulator::ScheduleWithContext (i, MicroSeconds (1 + j * (i % 3)),
+                                          &MultithreadedPacketTestCase::Send, this,
+                                          device, 100 + i + j);
+        }
+    }
+  Simulator::Run ();
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  m_lookAhead = impl ? impl->GetLookAhead () : Seconds (0);
+  Simulator::Destroy ();
+  return m_log.str ();
+}
+
+void
+MultithreadedPacketTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  std::string expected = RunNodes ();
+  NS_TEST_ASSERT_MSG_EQ (expected.empty (), false, "No packet was received");
+
+  uint32_t threads[] = {1, 2, 4};
+  for (uint32_t t = 0; t < 3; ++t)
+    {
+      Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+      Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (threads[t]));
+      Config::SetDefault ("ns3::MultithreadedSimulatorImpl::LookAhead", TimeValue (MicroSeconds (1)));
+      std::string log = RunNodes ();
+      NS_TEST_EXPECT_MSG_EQ (m_lookAhead, Seconds (0), "The nodes ran in parallel");
+      NS_TEST_EXPECT_MSG_EQ (log, expected, "Different receptions with " << threads[t] << " threads");
+    }
+
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::Reset ();
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief MultithreadedSimulatorImpl packet TestSuite
+ */
+class MultithreadedPacketTestSuite : public TestSuite
+{
+public:
+  MultithreadedPacketTestSuite ()
+    : TestSuite ("multithreaded-packet", UNIT)
+  {
+    AddTestCase (new MultithreadedPacketTestCase (), TestCase::QUICK);
+  }
+};
+
+static MultithreadedPacketTestSuite g_multithreadedPacketTestSuite; //!< Static variable for test initialization
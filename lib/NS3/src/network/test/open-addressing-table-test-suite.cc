@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <map>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/open-addressing-table.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief OpenAddressingTable test: random insertions and removals, checked
+ * against a std::map.
+ */
+class OpenAddressingTableTestCase : public TestCase
+{
+public:
+  OpenAddressingTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// An entry
+  struct Entry
+  {
+    uint32_t id; //!< the entry identifier
+  };
+};
+
+OpenAddressingTableTestCase::OpenAddressingTableTestCase ()
+  : TestCase ("OpenAddressingTable against std::map")
+{
+}
+
+void
+OpenAddressingTableTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  std::vector<Entry> entries (512);
+  for (uint32_t i = 0; i < entries.size (); i++)
+    {
+      entries[i].id = i;
+    }
+
+  // Consecutive addresses, the worst case for a weak hash
+  OpenAddressingTable<Ipv4Address, Entry, Ipv4AddressHash> table4;
+  OpenAddressingTable<Ipv6Address, Entry, Ipv6AddressHash> table6;
+  OpenAddressingTable<uint64_t, Entry> table64;
+  std::map<uint32_t, Entry *> reference;
+
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      uint32_t id = rng->GetInteger (0, entries.size () - 1);
+      Ipv4Address address4 (0x0a000000 + id);
+      uint8_t buf[16];
+      Ipv6Address ("2001:db8::").GetBytes (buf);
+      buf[14] = id >> 8;
+      buf[15] = id & 0xff;
+      Ipv6Address address6 (buf);
+      // Keys differing in their high bits only, like the TIDs of the
+      // remote stations of a WifiRemoteStationManager
+      uint64_t key64 = (static_cast<uint64_t> (id & 0x7) << 48) | (id >> 3);
+
+      std::map<uint32_t, Entry *>::iterator it = reference.find (id);
+      if (it == reference.end ())
+        {
+          NS_TEST_ASSERT_MSG_EQ (table4.Find (address4), 0, "Found a removed IPv4 address");
+          NS_TEST_ASSERT_MSG_EQ (table6.Find (address6), 0, "Found a removed IPv6 address");
+          NS_TEST_ASSERT_MSG_EQ (table64.Find (key64), 0, "Found a removed 64-bit key");
+          NS_TEST_ASSERT_MSG_EQ (table4.Erase (address4), false, "Removed an absent IPv4 address");
+          table4.Insert (address4, &entries[id]);
+          table6.Insert (address6, &entries[id]);
+          table64.Insert (key64, &entries[id]);
+          reference[id] = &entries[id];
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (table4.Find (address4), it->second, "Wrong IPv4 entry");
+          NS_TEST_ASSERT_MSG_EQ (table6.Find (address6), it->second, "Wrong IPv6 entry");
+          NS_TEST_ASSERT_MSG_EQ (table64.Find (key64), it->second, "Wrong 64-bit key entry");
+          if (rng->GetValue () < 0.6)
+            {
+              NS_TEST_ASSERT_MSG_EQ (table4.Erase (address4), true, "Could not remove an IPv4 address");
+              NS_TEST_ASSERT_MSG_EQ (table6.Erase (address6), true, "Could not remove an IPv6 address");
+              NS_TEST_ASSERT_MSG_EQ (table64.Erase (key64), true, "Could not remove a 64-bit key");
+              reference.erase (it);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (table4.GetSize (), reference.size (), "Wrong IPv4 table size");
+      NS_TEST_ASSERT_MSG_EQ (table6.GetSize (), reference.size (), "Wrong IPv6 table size");
+      NS_TEST_ASSERT_MSG_EQ (table64.GetSize (), reference.size (), "Wrong 64-bit key table size");
+    }
+
+  // Every entry is in exactly one slot
+  uint32_t found = 0;
+  typedef OpenAddressingTable<Ipv4Address, Entry, Ipv4AddressHash>::Slot Slot;
+  for (std::vector<Slot>::const_iterator i = table4.GetSlots ().begin (); i != table4.GetSlots ().end (); i++)
+    {
+      if (i->value != 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (i->key, Ipv4Address (0x0a000000 + i->value->id), "Entry in the slot of another address");
+          NS_TEST_ASSERT_MSG_EQ (reference.count (i->value->id), 1, "Removed entry still in a slot");
+          found++;
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (found, reference.size (), "Wrong number of used slots");
+
+  table4.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (table4.GetSize (), 0, "Table not empty after Clear");
+  NS_TEST_ASSERT_MSG_EQ (table4.Find (Ipv4Address (0x0a000000)), 0, "Found an entry after Clear");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief OpenAddressingTable TestSuite.
+ */
+class OpenAddressingTableTestSuite : public TestSuite
+{
+public:
+  OpenAddressingTableTestSuite ()
+    : TestSuite ("open-addressing-table", UNIT)
+  {
+    AddTestCase (new OpenAddressingTableTestCase, TestCase::QUICK);
+  }
+};
+
+static OpenAddressingTableTestSuite g_openAddressingTableTestSuite; //!< Static variable for test initialization
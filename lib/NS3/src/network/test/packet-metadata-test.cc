@@ -318,7 +318,11 @@ HistoryTrailer<N>::Deserialize (Buffer::Iterator start)
  */
 class PacketMetadataTest : public TestCase {
 public:
-  PacketMetadataTest ();
+  /**
+   * Constructor
+   * \param lazy Record the metadata lazily.
+   */
+  PacketMetadataTest (bool lazy);
   virtual ~PacketMetadataTest ();
   /**
    * Checks the packet header and trailer history
@@ -330,7 +334,9 @@ public:
    */
   void CheckHistory (Ptr<Packet> p, const char *file, int line, uint32_t n, ...);
   virtual void DoRun (void);
+  virtual void DoTeardown (void);
 private:
+  bool m_lazy; //!< Record the metadata lazily
   /**
    * Adds an header to the packet
    * \param p The packet
@@ -339,8 +345,9 @@ private:
   Ptr<Packet> DoAddHeader (Ptr<Packet> p);
 };
 
-PacketMetadataTest::PacketMetadataTest ()
-  : TestCase ("Packet metadata")
+PacketMetadataTest::PacketMetadataTest (bool lazy)
+  : TestCase (lazy ? "Packet metadata, recorded lazily" : "Packet metadata"),
+    m_lazy (lazy)
 {
 }
 
@@ -478,6 +485,10 @@ void
 PacketMetadataTest::DoRun (void)
 {
   PacketMetadata::Enable ();
+  if (m_lazy)
+    {
+      PacketMetadata::EnableLazy ();
+    }
 
   Ptr<Packet> p = Create<Packet> (0);
   Ptr<Packet> p1 = Create<Packet> (0);
@@ -894,6 +905,17 @@ PacketMetadataTest::DoRun (void)
   REM_HEADER (p3, 2);
   CHECK_HISTORY (p3, 1, 11);
 
+  // more operations than a lazy log holds
+  p = Create<Packet> (40);
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      p->RemoveAtStart (1);
+      p->RemoveAtEnd (1);
+    }
+  ADD_HEADER (p, 2);
+  ADD_TRAILER (p, 3);
+  CHECK_HISTORY (p, 3, 2, 20, 3);
+
   uint8_t *buf = new uint8_t[p3->GetSize ()];
   p3->CopyData (buf, p3->GetSize ());
   std::string msg = std::string (reinterpret_cast<const char *>(buf),
@@ -902,6 +924,12 @@ PacketMetadataTest::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
 }
 
+void
+PacketMetadataTest::DoTeardown (void)
+{
+  PacketMetadata::DisableLazy ();
+}
+
 
 /**
  * \ingroup network-test
@@ -918,7 +946,8 @@ public:
 PacketMetadataTestSuite::PacketMetadataTestSuite ()
   : TestSuite ("packet-metadata", UNIT)
 {
-  AddTestCase (new PacketMetadataTest, TestCase::QUICK);
+  AddTestCase (new PacketMetadataTest (false), TestCase::QUICK);
+  AddTestCase (new PacketMetadataTest (true), TestCase::QUICK);
 }
 
 static PacketMetadataTestSuite g_packetMetadataTest; //!< Static variable for test initialization
@@ -994,6 +994,42 @@ PacketTagListTest::DoRun (void)
     ReplaceCheck (7);
   }
   
+  { // Inline and heap storage
+    std::cout << GetName () << "check copy-on-write of inline and heap storage"
+              << std::endl;
+    PacketTagList small;
+    small.Add (t1);
+    small.Add (t2);
+    PacketTagList grown = small;  // inline copy
+    grown.Add (t3);
+    grown.Add (t4);               // too large to be inline
+    PacketTagList shared = grown; // shares the heap buffer
+    shared.Remove (t4);           // small enough to be inline again
+
+    const char * msg = "inline, orig";
+    CheckRef (small, t1, msg, false);
+    CheckRef (small, t2, msg, false);
+    CheckRef (small, t3, msg, true);
+    msg = "heap, copy";
+    CheckRef (grown, t3, msg, false);
+    CheckRef (grown, t4, msg, false);
+    msg = "heap, unshared copy";
+    CheckRef (shared, t3, msg, false);
+    CheckRef (shared, t4, msg, true);
+
+    // Most recent tag first
+    TypeId order[] = { t4.GetInstanceTypeId (), t3.GetInstanceTypeId (),
+                       t2.GetInstanceTypeId (), t1.GetInstanceTypeId () };
+    int n = 0;
+    for (const PacketTagList::TagData *cur = grown.Head (); cur != 0; cur = grown.Next (cur))
+      {
+        NS_TEST_ASSERT_MSG_LT (n, 4, "too many tags");
+        NS_TEST_EXPECT_MSG_EQ (cur->tid, order[n], "tag " << n << " out of order");
+        ++n;
+      }
+    NS_TEST_EXPECT_MSG_EQ (n, 4, "missing tags");
+  }
+
   { // Timing
     std::cout << GetName () << "add+remove timing" << std::endl;
     int flm = std::numeric_limits<int>::max ();
@@ -0,0 +1,298 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef OPEN_ADDRESSING_TABLE_H
+#define OPEN_ADDRESSING_TABLE_H
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief A flat open-addressing hash table of pointers
+ *
+ * Maps keys to values, such as the layer 3 addresses of the entries of
+ * ArpCache and NdiscCache, or the MAC addresses and TIDs of the remote
+ * stations of WifiRemoteStationManager.  The slots are kept in a single
+ * vector whose size is a power of two and at least twice the number of
+ * values. Collisions are resolved by linear
+ * probing and removals shift the following slots back, so that lookups,
+ * insertions and removals only touch a few adjacent slots and the table
+ * never fills up with tombstones.
+ *
+ * The table does not own the values, whose addresses are thus stable.
+ *
+ * \tparam K the key type
+ * \tparam V the value type
+ * \tparam H the key hash functor
+ */
+template <typename K, typename V, typename H = std::hash<K> >
+class OpenAddressingTable
+{
+public:
+  /**
+   * \brief A slot of the table
+   */
+  struct Slot
+  {
+    K key;         //!< the key of the value
+    uint32_t hash; //!< the scrambled hash of the key
+    V *value;      //!< the value, or 0 if the slot is free
+  };
+
+  OpenAddressingTable ();
+
+  /**
+   * \brief Find the value of a key
+   * \param key the key
+   * \returns the value, or 0 if the key is not in the table
+   */
+  V *Find (const K &key) const;
+  /**
+   * \brief Insert a value
+   *
+   * The key must not be in the table already.
+   *
+   * \param key the key
+   * \param value the value
+   */
+  void Insert (const K &key, V *value);
+  /**
+   * \brief Remove the value of a key
+   * \param key the key
+   * \returns true if the key was in the table
+   */
+  bool Erase (const K &key);
+  /**
+   * \brief Remove all the values
+   */
+  void Clear (void);
+  /**
+   * \returns the number of values
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \brief Get the slots, to iterate over the values
+   *
+   * Free slots have a null value.
+   *
+   * \returns the slots of the table
+   */
+  const std::vector<Slot> & GetSlots (void) const;
+
+private:
+  /**
+   * \brief Hash a key
+   * \param key the key
+   * \returns the hash of the key, scrambled so that its high bits are
+   * usable as a slot index even for consecutive keys
+   */
+  uint32_t Hash (const K &key) const;
+  /**
+   * \brief Get the slot where the probe sequence of a hash starts
+   * \param hash the scrambled hash
+   * \returns the slot index
+   */
+  uint32_t Home (uint32_t hash) const;
+  /**
+   * \brief Double the number of slots and reinsert the values
+   */
+  void Grow (void);
+
+  std::vector<Slot> m_slots; //!< the slots
+  uint32_t m_bits;           //!< log2 of the number of slots
+  uint32_t m_size;           //!< the number of values
+  H m_hash;                  //!< the key hash functor
+};
+
+} // namespace ns3
+
+/****************************************************************
+ *  Implementation of the templates declared above.
+ ****************************************************************/
+
+namespace ns3 {
+
+template <typename K, typename V, typename H>
+OpenAddressingTable<K, V, H>::OpenAddressingTable ()
+  : m_bits (0),
+    m_size (0)
+{
+}
+
+template <typename K, typename V, typename H>
+uint32_t
+OpenAddressingTable<K, V, H>::Hash (const K &key) const
+{
+  // Fibonacci hashing: Ipv4AddressHash and std::hash<uint64_t> are the
+  // identity
+  uint64_t hash = m_hash (key);
+  return static_cast<uint32_t> ((hash * 0x9e3779b97f4a7c15ULL) >> 32);
+}
+
+template <typename K, typename V, typename H>
+uint32_t
+OpenAddressingTable<K, V, H>::Home (uint32_t hash) const
+{
+  return hash >> (32 - m_bits);
+}
+
+template <typename K, typename V, typename H>
+V *
+OpenAddressingTable<K, V, H>::Find (const K &key) const
+{
+  if (m_size == 0)
+    {
+      return 0;
+    }
+  uint32_t hash = Hash (key);
+  uint32_t mask = m_slots.size () - 1;
+  for (uint32_t i = Home (hash); ; i = (i + 1) & mask)
+    {
+      const Slot &slot = m_slots[i];
+      if (slot.value == 0)
+        {
+          return 0;
+        }
+      if (slot.hash == hash && slot.key == key)
+        {
+          return slot.value;
+        }
+    }
+}
+
+template <typename K, typename V, typename H>
+void
+OpenAddressingTable<K, V, H>::Insert (const K &key, V *value)
+{
+  NS_ASSERT (value != 0);
+  if (2 * (m_size + 1) > m_slots.size ())
+    {
+      Grow ();
+    }
+  uint32_t hash = Hash (key);
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t i = Home (hash);
+  while (m_slots[i].value != 0)
+    {
+      NS_ASSERT_MSG (m_slots[i].hash != hash || !(m_slots[i].key == key),
+                     "Key already in the table");
+      i = (i + 1) & mask;
+    }
+  m_slots[i].key = key;
+  m_slots[i].hash = hash;
+  m_slots[i].value = value;
+  m_size++;
+}
+
+template <typename K, typename V, typename H>
+bool
+OpenAddressingTable<K, V, H>::Erase (const K &key)
+{
+  if (m_size == 0)
+    {
+      return false;
+    }
+  uint32_t hash = Hash (key);
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t hole = Home (hash);
+  for (; ; hole = (hole + 1) & mask)
+    {
+      const Slot &slot = m_slots[hole];
+      if (slot.value == 0)
+        {
+          return false;
+        }
+      if (slot.hash == hash && slot.key == key)
+        {
+          break;
+        }
+    }
+  // Shift back the following values of the cluster that would not be
+  // found anymore past the hole
+  for (uint32_t j = (hole + 1) & mask; m_slots[j].value != 0; j = (j + 1) & mask)
+    {
+      if (((j - Home (m_slots[j].hash)) & mask) >= ((j - hole) & mask))
+        {
+          m_slots[hole] = m_slots[j];
+          hole = j;
+        }
+    }
+  m_slots[hole].key = K ();
+  m_slots[hole].hash = 0;
+  m_slots[hole].value = 0;
+  m_size--;
+  return true;
+}
+
+template <typename K, typename V, typename H>
+void
+OpenAddressingTable<K, V, H>::Clear (void)
+{
+  m_slots.clear ();
+  m_bits = 0;
+  m_size = 0;
+}
+
+template <typename K, typename V, typename H>
+uint32_t
+OpenAddressingTable<K, V, H>::GetSize (void) const
+{
+  return m_size;
+}
+
+template <typename K, typename V, typename H>
+const std::vector<typename OpenAddressingTable<K, V, H>::Slot> &
+OpenAddressingTable<K, V, H>::GetSlots (void) const
+{
+  return m_slots;
+}
+
+template <typename K, typename V, typename H>
+void
+OpenAddressingTable<K, V, H>::Grow (void)
+{
+  std::vector<Slot> old;
+  old.swap (m_slots);
+  m_bits = (m_bits == 0) ? 3 : m_bits + 1;
+  Slot free;
+  free.key = K ();
+  free.hash = 0;
+  free.value = 0;
+  m_slots.resize (1U << m_bits, free);
+  uint32_t mask = m_slots.size () - 1;
+  for (typename std::vector<Slot>::const_iterator it = old.begin (); it != old.end (); ++it)
+    {
+      if (it->value != 0)
+        {
+          uint32_t i = Home (it->hash);
+          while (m_slots[i].value != 0)
+            {
+              i = (i + 1) & mask;
+            }
+          m_slots[i] = *it;
+        }
+    }
+}
+
+} // namespace ns3
+
+#endif /* OPEN_ADDRESSING_TABLE_H */
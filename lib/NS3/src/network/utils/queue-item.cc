@@ -139,4 +139,11 @@ QueueDiscItem::Print (std::ostream& os) const
   ;
 }
 
+std::vector<Ptr<QueueDiscItem> >
+QueueDiscItem::Segment (void)
+{
+  NS_LOG_FUNCTION (this);
+  return std::vector<Ptr<QueueDiscItem> > ();
+}
+
 } // namespace ns3
@@ -24,6 +24,7 @@
 #include "ns3/simple-ref-count.h"
 #include <ns3/address.h>
 #include "ns3/nstime.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -215,6 +216,18 @@ public:
    */
   virtual bool Mark (void) = 0;
 
+  /**
+   * \brief Split a super-packet into the items to transmit
+   *
+   * Upper layers may hand down several packets as one super-packet (see
+   * TcpGsoTag), to be split when it reaches the device. The base class
+   * never splits the item.
+   *
+   * \return the items to transmit in place of this one, or an empty
+   *         vector if this item is not a super-packet
+   */
+  virtual std::vector<Ptr<QueueDiscItem> > Segment (void);
+
 private:
   /**
    * \brief Default constructor
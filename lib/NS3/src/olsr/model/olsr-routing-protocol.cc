@@ -48,6 +48,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-packet-info-tag.h"
+#include <algorithm>
 
 /********** Useful macros **********/
 
@@ -957,6 +958,106 @@ RoutingProtocol::RoutingTableComputation ()
   NS_LOG_DEBUG (Simulator::Now ().GetSeconds () << " s: Node " << m_mainAddress
                                                 << ": RoutingTableComputation begin...");
 
+  // Steps 1 to 4 only depend on the information repositories, so the
+  // routes they computed last time still hold if those did not change.
+  std::vector<uint32_t> inputs;
+  inputs.reserve (m_routingInputs.size ());
+  GetRoutingInputs (inputs);
+  if (inputs != m_routingInputs)
+    {
+      NodeRoutesComputation ();
+      m_routingInputs.swap (inputs);
+    }
+  else
+    {
+      NS_LOG_LOGIC ("Information repositories unchanged, keeping the routes to the nodes.");
+    }
+
+  // 5. For each tuple in the association set,
+  //    If there is no entry in the routing table with:
+  //        R_dest_addr     == A_network_addr/A_netmask
+  //   and if the announced network is not announced by the node itself,
+  //   then a new routing entry is created.
+  const AssociationSet &associationSet = m_state.GetAssociationSet ();
+
+  // Clear HNA routing table
+  for (uint32_t i = 0; i < m_hnaRoutingTable->GetNRoutes (); i++)
+    {
+      m_hnaRoutingTable->RemoveRoute (0);
+    }
+
+  for (AssociationSet::const_iterator it = associationSet.begin ();
+       it != associationSet.end (); it++)
+    {
+      AssociationTuple const &tuple = *it;
+
+      // Test if HNA associations received from other gateways
+      // are also announced by this node. In such a case, no route
+      // is created for this association tuple (go to the next one).
+      bool goToNextAssociationTuple = false;
+      const Associations &localHnaAssociations = m_state.GetAssociations ();
+      NS_LOG_DEBUG ("Nb local associations: " << localHnaAssociations.size ());
+      for (Associations::const_iterator assocIterator = localHnaAssociations.begin ();
+           assocIterator != localHnaAssociations.end (); assocIterator++)
+        {
+          Association const &localHnaAssoc = *assocIterator;
+          if (localHnaAssoc.networkAddr == tuple.networkAddr && localHnaAssoc.netmask == tuple.netmask)
+            {
+              NS_LOG_DEBUG ("HNA association received from another GW is part of local HNA associations: no route added for network "
+                            << tuple.networkAddr << "/" << tuple.netmask);
+              goToNextAssociationTuple = true;
+            }
+        }
+      if (goToNextAssociationTuple)
+        {
+          continue;
+        }
+
+      RoutingTableEntry gatewayEntry;
+
+      bool gatewayEntryExists = Lookup (tuple.gatewayAddr, gatewayEntry);
+      bool addRoute = false;
+
+      uint32_t routeIndex = 0;
+
+      for (routeIndex = 0; routeIndex < m_hnaRoutingTable->GetNRoutes (); routeIndex++)
+        {
+          Ipv4RoutingTableEntry route = m_hnaRoutingTable->GetRoute (routeIndex);
+          if (route.GetDestNetwork () == tuple.networkAddr
+              && route.GetDestNetworkMask () == tuple.netmask)
+            {
+              break;
+            }
+        }
+
+      if (routeIndex == m_hnaRoutingTable->GetNRoutes ())
+        {
+          addRoute = true;
+        }
+      else if (gatewayEntryExists && m_hnaRoutingTable->GetMetric (routeIndex) > gatewayEntry.distance)
+        {
+          m_hnaRoutingTable->RemoveRoute (routeIndex);
+          addRoute = true;
+        }
+
+      if (addRoute && gatewayEntryExists)
+        {
+          m_hnaRoutingTable->AddNetworkRouteTo (tuple.networkAddr,
+                                                tuple.netmask,
+                                                gatewayEntry.nextAddr,
+                                                gatewayEntry.interface,
+                                                gatewayEntry.distance);
+
+        }
+    }
+
+  NS_LOG_DEBUG ("Node " << m_mainAddress << ": RoutingTableComputation end.");
+  m_routingTableChanged (GetSize ());
+}
+
+void
+RoutingProtocol::NodeRoutesComputation ()
+{
   // 1. All the entries from the routing table are removed.
   Clear ();
 
@@ -1102,58 +1203,77 @@ RoutingProtocol::RoutingTableComputation ()
         }
     }
 
-  for (uint32_t h = 2;; h++)
+  // 3.1. For each topology entry in the topology table, if its
+  // T_dest_addr does not correspond to R_dest_addr of any
+  // route entry in the routing table AND its T_last_addr
+  // corresponds to R_dest_addr of a route entry whose R_dist
+  // is equal to h, then a new route entry MUST be recorded in
+  // the routing table (if it does not already exist).
+  //
+  // The entries of distance h are the ones the previous round added, so
+  // each round only looks at the topology tuples whose T_last_addr is one
+  // of them, in the order of the topology table.
+  const TopologySet &topology = m_state.GetTopologySet ();
+  std::map<Ipv4Address, std::vector<uint32_t> > topologyByLastAddr;
+  for (uint32_t i = 0; i < topology.size (); i++)
+    {
+      topologyByLastAddr[topology[i].lastAddr].push_back (i);
+    }
+  std::vector<Ipv4Address> lastAddrs;
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator it = m_table.begin ();
+       it != m_table.end (); it++)
+    {
+      if (it->second.distance == 2)
+        {
+          lastAddrs.push_back (it->first);
+        }
+    }
+  for (uint32_t h = 2; !lastAddrs.empty (); h++)
     {
-      bool added = false;
+      std::vector<uint32_t> candidates;
+      for (std::vector<Ipv4Address>::const_iterator it = lastAddrs.begin ();
+           it != lastAddrs.end (); it++)
+        {
+          std::map<Ipv4Address, std::vector<uint32_t> >::const_iterator tuples =
+            topologyByLastAddr.find (*it);
+          if (tuples != topologyByLastAddr.end ())
+            {
+              candidates.insert (candidates.end (), tuples->second.begin (), tuples->second.end ());
+            }
+        }
+      std::sort (candidates.begin (), candidates.end ());
 
-      // 3.1. For each topology entry in the topology table, if its
-      // T_dest_addr does not correspond to R_dest_addr of any
-      // route entry in the routing table AND its T_last_addr
-      // corresponds to R_dest_addr of a route entry whose R_dist
-      // is equal to h, then a new route entry MUST be recorded in
-      // the routing table (if it does not already exist)
-      const TopologySet &topology = m_state.GetTopologySet ();
-      for (TopologySet::const_iterator it = topology.begin ();
-           it != topology.end (); it++)
+      lastAddrs.clear ();
+      for (std::vector<uint32_t>::const_iterator it = candidates.begin ();
+           it != candidates.end (); it++)
         {
-          const TopologyTuple &topology_tuple = *it;
+          const TopologyTuple &topology_tuple = topology[*it];
           NS_LOG_LOGIC ("Looking at topology tuple: " << topology_tuple);
 
           RoutingTableEntry destAddrEntry, lastAddrEntry;
-          bool have_destAddrEntry = Lookup (topology_tuple.destAddr, destAddrEntry);
-          bool have_lastAddrEntry = Lookup (topology_tuple.lastAddr, lastAddrEntry);
-          if (!have_destAddrEntry && have_lastAddrEntry && lastAddrEntry.distance == h)
-            {
-              NS_LOG_LOGIC ("Adding routing table entry based on the topology tuple.");
-              // then a new route entry MUST be recorded in
-              //                the routing table (if it does not already exist) where:
-              //                     R_dest_addr  = T_dest_addr;
-              //                     R_next_addr  = R_next_addr of the recorded
-              //                                    route entry where:
-              //                                    R_dest_addr == T_last_addr
-              //                     R_dist       = h+1; and
-              //                     R_iface_addr = R_iface_addr of the recorded
-              //                                    route entry where:
-              //                                       R_dest_addr == T_last_addr.
-              AddEntry (topology_tuple.destAddr,
-                        lastAddrEntry.nextAddr,
-                        lastAddrEntry.interface,
-                        h + 1);
-              added = true;
-            }
-          else
+          if (Lookup (topology_tuple.destAddr, destAddrEntry))
             {
               NS_LOG_LOGIC ("NOT adding routing table entry based on the topology tuple: "
-                            "have_destAddrEntry=" << have_destAddrEntry
-                                                  << " have_lastAddrEntry=" << have_lastAddrEntry
-                                                  << " lastAddrEntry.distance=" << (int) lastAddrEntry.distance
-                                                  << " (h=" << h << ")");
+                            "have_destAddrEntry=1 (h=" << h << ")");
+              continue;
             }
-        }
-
-      if (!added)
-        {
-          break;
+          NS_LOG_LOGIC ("Adding routing table entry based on the topology tuple.");
+          // then a new route entry MUST be recorded in
+          //                the routing table (if it does not already exist) where:
+          //                     R_dest_addr  = T_dest_addr;
+          //                     R_next_addr  = R_next_addr of the recorded
+          //                                    route entry where:
+          //                                    R_dest_addr == T_last_addr
+          //                     R_dist       = h+1; and
+          //                     R_iface_addr = R_iface_addr of the recorded
+          //                                    route entry where:
+          //                                       R_dest_addr == T_last_addr.
+          Lookup (topology_tuple.lastAddr, lastAddrEntry);
+          AddEntry (topology_tuple.destAddr,
+                    lastAddrEntry.nextAddr,
+                    lastAddrEntry.interface,
+                    h + 1);
+          lastAddrs.push_back (topology_tuple.destAddr);
         }
     }
 
@@ -1184,87 +1304,60 @@ RoutingProtocol::RoutingTableComputation ()
                     entry1.distance);
         }
     }
+}
 
-  // 5. For each tuple in the association set,
-  //    If there is no entry in the routing table with:
-  //        R_dest_addr     == A_network_addr/A_netmask
-  //   and if the announced network is not announced by the node itself,
-  //   then a new routing entry is created.
-  const AssociationSet &associationSet = m_state.GetAssociationSet ();
+void
+RoutingProtocol::GetRoutingInputs (std::vector<uint32_t> &inputs) const
+{
+  Time now = Simulator::Now ();
+  inputs.push_back (m_mainAddress.Get ());
 
-  // Clear HNA routing table
-  for (uint32_t i = 0; i < m_hnaRoutingTable->GetNRoutes (); i++)
+  const NeighborSet &neighborSet = m_state.GetNeighbors ();
+  inputs.push_back (neighborSet.size ());
+  for (NeighborSet::const_iterator it = neighborSet.begin ();
+       it != neighborSet.end (); it++)
     {
-      m_hnaRoutingTable->RemoveRoute (0);
+      inputs.push_back (it->neighborMainAddr.Get ());
+      inputs.push_back (it->status);
+      inputs.push_back (it->willingness);
     }
 
-  for (AssociationSet::const_iterator it = associationSet.begin ();
-       it != associationSet.end (); it++)
+  const LinkSet &linkSet = m_state.GetLinks ();
+  inputs.push_back (linkSet.size ());
+  for (LinkSet::const_iterator it = linkSet.begin ();
+       it != linkSet.end (); it++)
     {
-      AssociationTuple const &tuple = *it;
-
-      // Test if HNA associations received from other gateways
-      // are also announced by this node. In such a case, no route
-      // is created for this association tuple (go to the next one).
-      bool goToNextAssociationTuple = false;
-      const Associations &localHnaAssociations = m_state.GetAssociations ();
-      NS_LOG_DEBUG ("Nb local associations: " << localHnaAssociations.size ());
-      for (Associations::const_iterator assocIterator = localHnaAssociations.begin ();
-           assocIterator != localHnaAssociations.end (); assocIterator++)
-        {
-          Association const &localHnaAssoc = *assocIterator;
-          if (localHnaAssoc.networkAddr == tuple.networkAddr && localHnaAssoc.netmask == tuple.netmask)
-            {
-              NS_LOG_DEBUG ("HNA association received from another GW is part of local HNA associations: no route added for network "
-                            << tuple.networkAddr << "/" << tuple.netmask);
-              goToNextAssociationTuple = true;
-            }
-        }
-      if (goToNextAssociationTuple)
-        {
-          continue;
-        }
-
-      RoutingTableEntry gatewayEntry;
-
-      bool gatewayEntryExists = Lookup (tuple.gatewayAddr, gatewayEntry);
-      bool addRoute = false;
-
-      uint32_t routeIndex = 0;
-
-      for (routeIndex = 0; routeIndex < m_hnaRoutingTable->GetNRoutes (); routeIndex++)
-        {
-          Ipv4RoutingTableEntry route = m_hnaRoutingTable->GetRoute (routeIndex);
-          if (route.GetDestNetwork () == tuple.networkAddr
-              && route.GetDestNetworkMask () == tuple.netmask)
-            {
-              break;
-            }
-        }
-
-      if (routeIndex == m_hnaRoutingTable->GetNRoutes ())
-        {
-          addRoute = true;
-        }
-      else if (gatewayEntryExists && m_hnaRoutingTable->GetMetric (routeIndex) > gatewayEntry.distance)
-        {
-          m_hnaRoutingTable->RemoveRoute (routeIndex);
-          addRoute = true;
-        }
+      inputs.push_back (it->neighborIfaceAddr.Get ());
+      inputs.push_back (it->localIfaceAddr.Get ());
+      inputs.push_back (it->time >= now);
+    }
 
-      if (addRoute && gatewayEntryExists)
-        {
-          m_hnaRoutingTable->AddNetworkRouteTo (tuple.networkAddr,
-                                                tuple.netmask,
-                                                gatewayEntry.nextAddr,
-                                                gatewayEntry.interface,
-                                                gatewayEntry.distance);
+  const TwoHopNeighborSet &twoHopNeighbors = m_state.GetTwoHopNeighbors ();
+  inputs.push_back (twoHopNeighbors.size ());
+  for (TwoHopNeighborSet::const_iterator it = twoHopNeighbors.begin ();
+       it != twoHopNeighbors.end (); it++)
+    {
+      inputs.push_back (it->neighborMainAddr.Get ());
+      inputs.push_back (it->twoHopNeighborAddr.Get ());
+    }
 
-        }
+  const TopologySet &topology = m_state.GetTopologySet ();
+  inputs.push_back (topology.size ());
+  for (TopologySet::const_iterator it = topology.begin ();
+       it != topology.end (); it++)
+    {
+      inputs.push_back (it->destAddr.Get ());
+      inputs.push_back (it->lastAddr.Get ());
     }
 
-  NS_LOG_DEBUG ("Node " << m_mainAddress << ": RoutingTableComputation end.");
-  m_routingTableChanged (GetSize ());
+  const IfaceAssocSet &ifaceAssocSet = m_state.GetIfaceAssocSet ();
+  inputs.push_back (ifaceAssocSet.size ());
+  for (IfaceAssocSet::const_iterator it = ifaceAssocSet.begin ();
+       it != ifaceAssocSet.end (); it++)
+    {
+      inputs.push_back (it->ifaceAddr.Get ());
+      inputs.push_back (it->mainAddr.Get ());
+    }
 }
 
 
@@ -3047,18 +3140,23 @@ bool RoutingProtocol::RouteInput  (Ptr<const Packet> p,
 void
 RoutingProtocol::NotifyInterfaceUp (uint32_t i)
 {
+  // The routes hold interface indices, so they must be recomputed
+  m_routingInputs.clear ();
 }
 void
 RoutingProtocol::NotifyInterfaceDown (uint32_t i)
 {
+  m_routingInputs.clear ();
 }
 void
 RoutingProtocol::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_routingInputs.clear ();
 }
 void
 RoutingProtocol::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_routingInputs.clear ();
 }
 
 
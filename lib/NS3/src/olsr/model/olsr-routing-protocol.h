@@ -219,6 +219,8 @@ private:
   OlsrState m_state;  //!< Internal state with all needed data structs.
   Ptr<Ipv4> m_ipv4;   //!< IPv4 object the routing is linked to.
 
+  std::vector<uint32_t> m_routingInputs; //!< Inputs of the last NodeRoutesComputation.
+
   /**
    * \brief Clears the routing table and frees the memory assigned to each one of its entries.
    */
@@ -350,9 +352,30 @@ private:
 
   /**
    * \brief Creates the routing table of the node following \RFC{3626} hints.
+   *
+   * The routes to the nodes of the network are only recomputed when
+   * the information repositories they depend on have changed since
+   * the last computation.
    */
   void RoutingTableComputation ();
 
+  /**
+   * \brief Computes the routes to the nodes of the network, i.e., steps
+   * 1 to 4 of the routing table calculation of \RFC{3626}.
+   */
+  void NodeRoutesComputation ();
+
+  /**
+   * \brief Gets the inputs of the routes to the nodes of the network.
+   *
+   * The inputs are the main address of the node and, in set order, the
+   * fields of the Neighbor, Link, 2-hop Neighbor, Topology and Interface
+   * Association tuples that NodeRoutesComputation reads.
+   *
+   * \param inputs The inputs, flattened.
+   */
+  void GetRoutingInputs (std::vector<uint32_t> &inputs) const;
+
   /**
    * \brief Gets the main address associated with a given interface address.
    * \param iface_addr the interface address.
@@ -27,11 +27,98 @@
 ///
 
 #include "olsr-state.h"
+#include "ns3/assert.h"
 
 
 namespace ns3 {
 namespace olsr {
 
+/**
+ * \brief Finds the first tuple of a set with a given key.
+ *
+ * The index of the set is rebuilt first if it is stale.
+ *
+ * \param set The set.
+ * \param index The index of the set.
+ * \param stale Whether the index of the set is stale.
+ * \param key The key.
+ * \param keyOf The function giving the key of a tuple.
+ * \returns The position of the tuple, or the size of the set if no match.
+ */
+template <typename T>
+static uint32_t
+FindFirst (const std::vector<T> &set, std::unordered_map<uint64_t, uint32_t> &index,
+           bool &stale, uint64_t key, uint64_t (*keyOf)(const T &))
+{
+  if (stale)
+    {
+      index.clear ();
+      for (uint32_t i = 0; i < set.size (); i++)
+        {
+          index.insert (std::make_pair (keyOf (set[i]), i));
+        }
+      stale = false;
+    }
+  std::unordered_map<uint64_t, uint32_t>::const_iterator it = index.find (key);
+  if (it == index.end ())
+    {
+      return set.size ();
+    }
+  return it->second;
+}
+
+/**
+ * \param tuple A link tuple.
+ * \returns The key of the tuple in the Link Set index.
+ */
+static uint64_t
+LinkTupleKey (const LinkTuple &tuple)
+{
+  return tuple.neighborIfaceAddr.Get ();
+}
+
+/**
+ * \param destAddr The destination address.
+ * \param lastAddr The address of the node previous to the destination.
+ * \returns The key of the tuple in the Topology Set index.
+ */
+static uint64_t
+TopologyKey (const Ipv4Address &destAddr, const Ipv4Address &lastAddr)
+{
+  return (static_cast<uint64_t> (destAddr.Get ()) << 32) | lastAddr.Get ();
+}
+
+/**
+ * \param tuple A topology tuple.
+ * \returns The key of the tuple in the Topology Set index.
+ */
+static uint64_t
+TopologyTupleKey (const TopologyTuple &tuple)
+{
+  return TopologyKey (tuple.destAddr, tuple.lastAddr);
+}
+
+/**
+ * \param tuple An interface association tuple.
+ * \returns The key of the tuple in the Interface Association Set index.
+ */
+static uint64_t
+IfaceAssocTupleKey (const IfaceAssocTuple &tuple)
+{
+  return tuple.ifaceAddr.Get ();
+}
+
+/**
+ * \param address The originator address.
+ * \param sequenceNumber The message sequence number.
+ * \returns The key of the tuple in the Duplicate Set index.
+ */
+static uint64_t
+DuplicateKey (const Ipv4Address &address, uint16_t sequenceNumber)
+{
+  return (static_cast<uint64_t> (address.Get ()) << 16) | sequenceNumber;
+}
+
 /********** MPR Selector Set Manipulation **********/
 
 MprSelectorTuple*
@@ -293,34 +380,40 @@ OlsrState::GetMprSet () const
 DuplicateTuple*
 OlsrState::FindDuplicateTuple (Ipv4Address const &addr, uint16_t sequenceNumber)
 {
-  for (DuplicateSet::iterator it = m_duplicateSet.begin ();
-       it != m_duplicateSet.end (); it++)
+  TupleIndex::const_iterator it = m_duplicateIndex.find (DuplicateKey (addr, sequenceNumber));
+  if (it == m_duplicateIndex.end ())
     {
-      if (it->address == addr && it->sequenceNumber == sequenceNumber)
-        {
-          return &(*it);
-        }
+      return NULL;
     }
-  return NULL;
+  return &m_duplicateSet[it->second];
 }
 
 void
 OlsrState::EraseDuplicateTuple (const DuplicateTuple &tuple)
 {
-  for (DuplicateSet::iterator it = m_duplicateSet.begin ();
-       it != m_duplicateSet.end (); it++)
+  TupleIndex::iterator it = m_duplicateIndex.find (DuplicateKey (tuple.address, tuple.sequenceNumber));
+  if (it == m_duplicateIndex.end ())
     {
-      if (*it == tuple)
-        {
-          m_duplicateSet.erase (it);
-          break;
-        }
+      return;
     }
+  // The order of the Duplicate Set does not matter, so the last tuple takes
+  // the place of the erased one
+  uint32_t i = it->second;
+  m_duplicateIndex.erase (it);
+  if (i != m_duplicateSet.size () - 1)
+    {
+      std::swap (m_duplicateSet[i], m_duplicateSet.back ());
+      m_duplicateIndex[DuplicateKey (m_duplicateSet[i].address, m_duplicateSet[i].sequenceNumber)] = i;
+    }
+  m_duplicateSet.pop_back ();
 }
 
 void
 OlsrState::InsertDuplicateTuple (DuplicateTuple const &tuple)
 {
+  bool inserted = m_duplicateIndex.insert (std::make_pair (DuplicateKey (tuple.address, tuple.sequenceNumber),
+                                                           m_duplicateSet.size ())).second;
+  NS_ASSERT_MSG (inserted, "Duplicate tuple " << tuple.address << " " << tuple.sequenceNumber << " already exists");
   m_duplicateSet.push_back (tuple);
 }
 
@@ -329,34 +422,21 @@ OlsrState::InsertDuplicateTuple (DuplicateTuple const &tuple)
 LinkTuple*
 OlsrState::FindLinkTuple (Ipv4Address const & ifaceAddr)
 {
-  for (LinkSet::iterator it = m_linkSet.begin ();
-       it != m_linkSet.end (); it++)
+  uint32_t i = FindFirst (m_linkSet, m_linkIndex, m_linkIndexStale, ifaceAddr.Get (), &LinkTupleKey);
+  if (i == m_linkSet.size ())
     {
-      if (it->neighborIfaceAddr == ifaceAddr)
-        {
-          return &(*it);
-        }
+      return NULL;
     }
-  return NULL;
+  return &m_linkSet[i];
 }
 
 LinkTuple*
 OlsrState::FindSymLinkTuple (Ipv4Address const &ifaceAddr, Time now)
 {
-  for (LinkSet::iterator it = m_linkSet.begin ();
-       it != m_linkSet.end (); it++)
+  LinkTuple *tuple = FindLinkTuple (ifaceAddr);
+  if (tuple != NULL && tuple->symTime > now)
     {
-      if (it->neighborIfaceAddr == ifaceAddr)
-        {
-          if (it->symTime > now)
-            {
-              return &(*it);
-            }
-          else
-            {
-              break;
-            }
-        }
+      return tuple;
     }
   return NULL;
 }
@@ -370,6 +450,7 @@ OlsrState::EraseLinkTuple (const LinkTuple &tuple)
       if (*it == tuple)
         {
           m_linkSet.erase (it);
+          m_linkIndexStale = true;
           break;
         }
     }
@@ -379,6 +460,7 @@ LinkTuple&
 OlsrState::InsertLinkTuple (LinkTuple const &tuple)
 {
   m_linkSet.push_back (tuple);
+  m_linkIndex.insert (std::make_pair (LinkTupleKey (tuple), m_linkSet.size () - 1));
   return m_linkSet.back ();
 }
 
@@ -388,15 +470,13 @@ TopologyTuple*
 OlsrState::FindTopologyTuple (Ipv4Address const &destAddr,
                               Ipv4Address const &lastAddr)
 {
-  for (TopologySet::iterator it = m_topologySet.begin ();
-       it != m_topologySet.end (); it++)
+  uint32_t i = FindFirst (m_topologySet, m_topologyIndex, m_topologyIndexStale,
+                          TopologyKey (destAddr, lastAddr), &TopologyTupleKey);
+  if (i == m_topologySet.size ())
     {
-      if (it->destAddr == destAddr && it->lastAddr == lastAddr)
-        {
-          return &(*it);
-        }
+      return NULL;
     }
-  return NULL;
+  return &m_topologySet[i];
 }
 
 TopologyTuple*
@@ -422,6 +502,7 @@ OlsrState::EraseTopologyTuple (const TopologyTuple &tuple)
       if (*it == tuple)
         {
           m_topologySet.erase (it);
+          m_topologyIndexStale = true;
           break;
         }
     }
@@ -436,6 +517,7 @@ OlsrState::EraseOlderTopologyTuples (const Ipv4Address &lastAddr, uint16_t ansn)
       if (it->lastAddr == lastAddr && it->sequenceNumber < ansn)
         {
           it = m_topologySet.erase (it);
+          m_topologyIndexStale = true;
         }
       else
         {
@@ -448,6 +530,7 @@ void
 OlsrState::InsertTopologyTuple (TopologyTuple const &tuple)
 {
   m_topologySet.push_back (tuple);
+  m_topologyIndex.insert (std::make_pair (TopologyTupleKey (tuple), m_topologySet.size () - 1));
 }
 
 /********** Interface Association Set Manipulation **********/
@@ -455,29 +538,25 @@ OlsrState::InsertTopologyTuple (TopologyTuple const &tuple)
 IfaceAssocTuple*
 OlsrState::FindIfaceAssocTuple (Ipv4Address const &ifaceAddr)
 {
-  for (IfaceAssocSet::iterator it = m_ifaceAssocSet.begin ();
-       it != m_ifaceAssocSet.end (); it++)
+  uint32_t i = FindFirst (m_ifaceAssocSet, m_ifaceAssocIndex, m_ifaceAssocIndexStale,
+                          ifaceAddr.Get (), &IfaceAssocTupleKey);
+  if (i == m_ifaceAssocSet.size ())
     {
-      if (it->ifaceAddr == ifaceAddr)
-        {
-          return &(*it);
-        }
+      return NULL;
     }
-  return NULL;
+  return &m_ifaceAssocSet[i];
 }
 
 const IfaceAssocTuple*
 OlsrState::FindIfaceAssocTuple (Ipv4Address const &ifaceAddr) const
 {
-  for (IfaceAssocSet::const_iterator it = m_ifaceAssocSet.begin ();
-       it != m_ifaceAssocSet.end (); it++)
+  uint32_t i = FindFirst (m_ifaceAssocSet, m_ifaceAssocIndex, m_ifaceAssocIndexStale,
+                          ifaceAddr.Get (), &IfaceAssocTupleKey);
+  if (i == m_ifaceAssocSet.size ())
     {
-      if (it->ifaceAddr == ifaceAddr)
-        {
-          return &(*it);
-        }
+      return NULL;
     }
-  return NULL;
+  return &m_ifaceAssocSet[i];
 }
 
 void
@@ -489,6 +568,7 @@ OlsrState::EraseIfaceAssocTuple (const IfaceAssocTuple &tuple)
       if (*it == tuple)
         {
           m_ifaceAssocSet.erase (it);
+          m_ifaceAssocIndexStale = true;
           break;
         }
     }
@@ -498,6 +578,7 @@ void
 OlsrState::InsertIfaceAssocTuple (const IfaceAssocTuple &tuple)
 {
   m_ifaceAssocSet.push_back (tuple);
+  m_ifaceAssocIndex.insert (std::make_pair (IfaceAssocTupleKey (tuple), m_ifaceAssocSet.size () - 1));
 }
 
 std::vector<Ipv4Address>
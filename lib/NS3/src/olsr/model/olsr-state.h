@@ -25,12 +25,18 @@
 #define OLSR_STATE_H
 
 #include "olsr-repositories.h"
+#include <unordered_map>
 
 namespace ns3 {
 namespace olsr {
 
 /// \ingroup olsr
 /// This class encapsulates all data structures needed for maintaining internal state of an OLSR node.
+///
+/// The Link, Topology, Interface Association and Duplicate Sets are indexed
+/// by the addresses their Find methods look up. Tuples are always appended to
+/// the sets, so the index of an ordered set only has to be rebuilt, on its
+/// next use, after a tuple was erased from it.
 class OlsrState
 {
   //  friend class Olsr;
@@ -49,6 +55,9 @@ protected:
 
 public:
   OlsrState ()
+    : m_linkIndexStale (false),
+      m_topologyIndexStale (false),
+      m_ifaceAssocIndexStale (false)
   {
   }
 
@@ -342,6 +351,7 @@ public:
    */
   IfaceAssocSet & GetIfaceAssocSetMutable ()
   {
+    m_ifaceAssocIndexStale = true;
     return m_ifaceAssocSet;
   }
 
@@ -427,6 +437,17 @@ public:
   std::vector<Ipv4Address>
   FindNeighborInterfaces (const Ipv4Address &neighborMainAddr) const;
 
+private:
+  /// Position in a set of the first tuple with each key.
+  typedef std::unordered_map<uint64_t, uint32_t> TupleIndex;
+
+  TupleIndex m_linkIndex; //!< Index of the Link Set by neighbor interface address.
+  bool m_linkIndexStale; //!< Whether a link tuple was erased since m_linkIndex was built.
+  TupleIndex m_topologyIndex; //!< Index of the Topology Set by destination and last address.
+  bool m_topologyIndexStale; //!< Whether a topology tuple was erased since m_topologyIndex was built.
+  mutable TupleIndex m_ifaceAssocIndex; //!< Index of the Interface Association Set by interface address.
+  mutable bool m_ifaceAssocIndexStale; //!< Whether the Interface Association Set changed since m_ifaceAssocIndex was built.
+  TupleIndex m_duplicateIndex; //!< Index of the Duplicate Set by originator address and sequence number.
 };
 
 }
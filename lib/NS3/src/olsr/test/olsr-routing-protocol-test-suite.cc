@@ -178,6 +178,92 @@ OlsrMprTestCase::DoRun ()
   NS_TEST_EXPECT_MSG_EQ ((mpr.find ("10.0.0.9") == mpr.end ()), true, "Node 1 must NOT select node 8 as MPR");
 }
 
+/**
+ * \ingroup olsr-test
+ * \ingroup tests
+ *
+ * Testcase for the lookups of the OLSR information repositories
+ */
+class OlsrStateLookupTestCase : public TestCase
+{
+public:
+  OlsrStateLookupTestCase ();
+  virtual void DoRun (void);
+};
+
+OlsrStateLookupTestCase::OlsrStateLookupTestCase ()
+  : TestCase ("Check OLSR information repositories lookups")
+{
+}
+void
+OlsrStateLookupTestCase::DoRun ()
+{
+  OlsrState state;
+
+  LinkTuple link;
+  link.localIfaceAddr = Ipv4Address ("10.0.0.1");
+  link.symTime = Seconds (10);
+  for (uint32_t i = 2; i < 6; i++)
+    {
+      link.neighborIfaceAddr = Ipv4Address (0x0a000000 + i);
+      state.InsertLinkTuple (link);
+    }
+  NS_TEST_EXPECT_MSG_EQ ((state.FindLinkTuple (Ipv4Address ("10.0.0.3")) != 0), true, "Link to 10.0.0.3 must be found");
+  NS_TEST_EXPECT_MSG_EQ ((state.FindSymLinkTuple (Ipv4Address ("10.0.0.3"), Seconds (20)) == 0), true, "Link to 10.0.0.3 must not be symmetric anymore");
+  link.neighborIfaceAddr = Ipv4Address ("10.0.0.3");
+  state.EraseLinkTuple (link);
+  NS_TEST_EXPECT_MSG_EQ ((state.FindLinkTuple (Ipv4Address ("10.0.0.3")) == 0), true, "Erased link must not be found");
+  LinkTuple *found = state.FindSymLinkTuple (Ipv4Address ("10.0.0.5"), Seconds (1));
+  NS_TEST_EXPECT_MSG_EQ ((found != 0 && found->neighborIfaceAddr == Ipv4Address ("10.0.0.5")), true, "Link to 10.0.0.5 must be found after an erase");
+  link.neighborIfaceAddr = Ipv4Address ("10.0.0.3");
+  state.InsertLinkTuple (link);
+  NS_TEST_EXPECT_MSG_EQ ((state.FindLinkTuple (Ipv4Address ("10.0.0.3")) == &state.GetLinks ().back ()), true, "Inserted link must be found");
+
+  TopologyTuple topology;
+  topology.sequenceNumber = 1;
+  topology.destAddr = Ipv4Address ("10.0.0.2");
+  topology.lastAddr = Ipv4Address ("10.0.0.3");
+  state.InsertTopologyTuple (topology);
+  topology.destAddr = Ipv4Address ("10.0.0.4");
+  state.InsertTopologyTuple (topology);
+  topology.lastAddr = Ipv4Address ("10.0.0.5");
+  topology.sequenceNumber = 2;
+  state.InsertTopologyTuple (topology);
+  state.EraseOlderTopologyTuples (Ipv4Address ("10.0.0.3"), 2);
+  NS_TEST_EXPECT_MSG_EQ ((state.FindTopologyTuple (Ipv4Address ("10.0.0.4"), Ipv4Address ("10.0.0.3")) == 0), true, "Older topology tuple must be erased");
+  TopologyTuple *topologyFound = state.FindTopologyTuple (Ipv4Address ("10.0.0.4"), Ipv4Address ("10.0.0.5"));
+  NS_TEST_EXPECT_MSG_EQ ((topologyFound != 0 && topologyFound->sequenceNumber == 2), true, "Newer topology tuple must be found");
+
+  IfaceAssocTuple ifaceAssoc;
+  ifaceAssoc.mainAddr = Ipv4Address ("10.0.0.2");
+  ifaceAssoc.ifaceAddr = Ipv4Address ("10.0.1.2");
+  state.InsertIfaceAssocTuple (ifaceAssoc);
+  ifaceAssoc.ifaceAddr = Ipv4Address ("10.0.2.2");
+  state.InsertIfaceAssocTuple (ifaceAssoc);
+  state.GetIfaceAssocSetMutable ().front ().ifaceAddr = Ipv4Address ("10.0.3.2");
+  const OlsrState &constState = state;
+  NS_TEST_EXPECT_MSG_EQ ((constState.FindIfaceAssocTuple (Ipv4Address ("10.0.1.2")) == 0), true, "Changed interface must not be found");
+  NS_TEST_EXPECT_MSG_EQ ((constState.FindIfaceAssocTuple (Ipv4Address ("10.0.3.2")) != 0), true, "Changed interface must be found");
+
+  DuplicateTuple duplicate;
+  duplicate.address = Ipv4Address ("10.0.0.2");
+  for (uint16_t i = 0; i < 4; i++)
+    {
+      duplicate.sequenceNumber = i;
+      state.InsertDuplicateTuple (duplicate);
+    }
+  duplicate.sequenceNumber = 1;
+  state.EraseDuplicateTuple (duplicate);
+  NS_TEST_EXPECT_MSG_EQ ((state.FindDuplicateTuple (Ipv4Address ("10.0.0.2"), 1) == 0), true, "Erased duplicate tuple must not be found");
+  for (uint16_t i = 0; i < 4; i += 2)
+    {
+      DuplicateTuple *duplicateFound = state.FindDuplicateTuple (Ipv4Address ("10.0.0.2"), i);
+      NS_TEST_EXPECT_MSG_EQ ((duplicateFound != 0 && duplicateFound->sequenceNumber == i), true, "Duplicate tuple must be found");
+    }
+  DuplicateTuple *duplicateFound = state.FindDuplicateTuple (Ipv4Address ("10.0.0.2"), 3);
+  NS_TEST_EXPECT_MSG_EQ ((duplicateFound != 0 && duplicateFound->sequenceNumber == 3), true, "Moved duplicate tuple must be found");
+}
+
 /**
  * \ingroup olsr-test
  * \ingroup tests
@@ -194,6 +280,7 @@ OlsrProtocolTestSuite::OlsrProtocolTestSuite ()
   : TestSuite ("routing-olsr", UNIT)
 {
   AddTestCase (new OlsrMprTestCase (), TestCase::QUICK);
+  AddTestCase (new OlsrStateLookupTestCase (), TestCase::QUICK);
 }
 
 static OlsrProtocolTestSuite g_olsrProtocolTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "caching-propagation-loss-model.h"
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CachingPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (CachingPropagationLossModel);
+
+TypeId
+CachingPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachingPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<CachingPropagationLossModel> ()
+    .AddAttribute ("Model",
+                   "The deterministic propagation loss model whose losses are cached.",
+                   PointerValue (),
+                   MakePointerAccessor (&CachingPropagationLossModel::SetModel,
+                                        &CachingPropagationLossModel::GetModel),
+                   MakePointerChecker<PropagationLossModel> ())
+    .AddAttribute ("Symmetric",
+                   "Whether the loss from a to b is also the loss from b to a.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&CachingPropagationLossModel::m_symmetric),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+CachingPropagationLossModel::CachingPropagationLossModel ()
+  : m_symmetric (true),
+    m_hits (0),
+    m_misses (0)
+{
+}
+
+CachingPropagationLossModel::~CachingPropagationLossModel ()
+{
+}
+
+void
+CachingPropagationLossModel::DoDispose (void)
+{
+  m_losses.clear ();
+  m_model = 0;
+  PropagationLossModel::DoDispose ();
+}
+
+void
+CachingPropagationLossModel::SetModel (Ptr<PropagationLossModel> model)
+{
+  m_model = model;
+  m_losses.clear ();
+}
+
+Ptr<PropagationLossModel>
+CachingPropagationLossModel::GetModel (void) const
+{
+  return m_model;
+}
+
+void
+CachingPropagationLossModel::Clear (void)
+{
+  m_losses.clear ();
+}
+
+uint64_t
+CachingPropagationLossModel::GetHits (void) const
+{
+  return m_hits;
+}
+
+uint64_t
+CachingPropagationLossModel::GetMisses (void) const
+{
+  return m_misses;
+}
+
+double
+CachingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                            Ptr<MobilityModel> a,
+                                            Ptr<MobilityModel> b) const
+{
+  NS_ASSERT_MSG (m_model != 0, "No propagation loss model to cache");
+  // The position of a moving model changes without any course change,
+  // and querying the velocity first lets lazy models notify theirs.
+  if (a->GetVelocity ().GetLength () != 0 || b->GetVelocity ().GetLength () != 0)
+    {
+      m_misses++;
+      return m_model->CalcRxPower (txPowerDbm, a, b);
+    }
+  Link link;
+  link.a = PeekPointer (a);
+  link.b = PeekPointer (b);
+  if (m_symmetric && link.b < link.a)
+    {
+      std::swap (link.a, link.b);
+    }
+  uint32_t epochA = link.a->GetPositionEpoch ();
+  uint32_t epochB = link.b->GetPositionEpoch ();
+  std::unordered_map<Link, Loss, LinkHash>::iterator it = m_losses.find (link);
+  if (it != m_losses.end ())
+    {
+      Loss &loss = it->second;
+      if (loss.epochA == epochA && loss.epochB == epochB)
+        {
+          m_hits++;
+          if (loss.txPowerDbm == txPowerDbm)
+            {
+              return loss.rxPowerDbm;
+            }
+          return txPowerDbm + (loss.rxPowerDbm - loss.txPowerDbm);
+        }
+    }
+  else
+    {
+      Loss loss;
+      loss.a = link.a;
+      loss.b = link.b;
+      it = m_losses.insert (std::make_pair (link, loss)).first;
+    }
+  m_misses++;
+  double rxPowerDbm = m_model->CalcRxPower (txPowerDbm, a, b);
+  NS_LOG_DEBUG ("link " << link.a << "-" << link.b << " loss=" << txPowerDbm - rxPowerDbm << "dB");
+  Loss &loss = it->second;
+  loss.epochA = epochA;
+  loss.epochB = epochB;
+  loss.txPowerDbm = txPowerDbm;
+  loss.rxPowerDbm = rxPowerDbm;
+  return rxPowerDbm;
+}
+
+int64_t
+CachingPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  if (m_model == 0)
+    {
+      return 0;
+    }
+  return m_model->AssignStreams (stream);
+}
+
+} // namespace ns3
@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CACHING_PROPAGATION_LOSS_MODEL_H
+#define CACHING_PROPAGATION_LOSS_MODEL_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include "ns3/propagation-loss-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Caches the loss of another propagation loss model per link
+ *
+ * The loss of the wrapped model, and of the models chained after it with
+ * SetNext, is computed once per pair of mobility models and reused as long
+ * as neither model changes course, as told by
+ * MobilityModel::GetPositionEpoch.  The links involving a model with a
+ * non-zero velocity are never cached.  Since this model is itself a
+ * PropagationLossModel, it can be inserted anywhere in a chain:
+ *
+ * \code
+ *   Ptr<LogDistancePropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+ *   Ptr<CachingPropagationLossModel> caching = CreateObject<CachingPropagationLossModel> ();
+ *   caching->SetAttribute ("Model", PointerValue (logDistance));
+ *   caching->SetNext (CreateObject<NakagamiPropagationLossModel> ());
+ * \endcode
+ *
+ * This is only correct if the wrapped models are deterministic, and if
+ * their loss does not depend on the transmission power, which is also what
+ * chaining models assumes.  Call Clear after changing the attributes of
+ * the wrapped models.
+ *
+ * By default, the links are symmetric: the loss from a to b is reused from
+ * b to a.  This holds for the models depending only on the distance, such
+ * as Friis, LogDistance, ThreeLogDistance, Cost231 or Kun2600Mhz, and for
+ * those taking the highest node as the base station such as OkumuraHata,
+ * but not for ItuR1411NlosOverRooftop or a MatrixPropagationLossModel
+ * with asymmetric losses, for which the Symmetric attribute must be false.
+ */
+class CachingPropagationLossModel : public PropagationLossModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  CachingPropagationLossModel ();
+  virtual ~CachingPropagationLossModel ();
+
+  /**
+   * \param model the propagation loss model whose losses are cached
+   */
+  void SetModel (Ptr<PropagationLossModel> model);
+  /**
+   * \returns the propagation loss model whose losses are cached
+   */
+  Ptr<PropagationLossModel> GetModel (void) const;
+  /**
+   * \brief Forget all the cached losses
+   */
+  void Clear (void);
+  /**
+   * \returns the number of losses found in the cache
+   */
+  uint64_t GetHits (void) const;
+  /**
+   * \returns the number of losses computed by the wrapped model
+   */
+  uint64_t GetMisses (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  CachingPropagationLossModel (const CachingPropagationLossModel &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  CachingPropagationLossModel & operator = (const CachingPropagationLossModel &);
+
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  /// The mobility models of a link
+  struct Link
+  {
+    const MobilityModel *a; //!< the first model
+    const MobilityModel *b; //!< the second model
+
+    /**
+     * \param other the other link
+     * \returns true if both links have the same models, in the same order
+     */
+    bool operator == (const Link &other) const
+    {
+      return a == other.a && b == other.b;
+    }
+  };
+
+  /// Hash functor of the links
+  struct LinkHash
+  {
+    /**
+     * \param link the link
+     * \returns the hash of the link
+     */
+    size_t operator () (const Link &link) const
+    {
+      uint64_t a = reinterpret_cast<uintptr_t> (link.a);
+      uint64_t b = reinterpret_cast<uintptr_t> (link.b);
+      return static_cast<size_t> ((a * 0x9e3779b97f4a7c15ULL) ^ (b + (b >> 29)));
+    }
+  };
+
+  /// The cached loss of a link
+  struct Loss
+  {
+    Ptr<const MobilityModel> a; //!< the first model, kept alive so that its address is not reused
+    Ptr<const MobilityModel> b; //!< the second model, kept alive so that its address is not reused
+    uint32_t epochA;            //!< the position epoch of the first model
+    uint32_t epochB;            //!< the position epoch of the second model
+    double txPowerDbm;          //!< the transmission power the loss was computed for
+    double rxPowerDbm;          //!< the reception power computed by the wrapped model
+  };
+
+  Ptr<PropagationLossModel> m_model; //!< the wrapped model
+  bool m_symmetric;                  //!< whether the loss from a to b is also the loss from b to a
+  mutable std::unordered_map<Link, Loss, LinkHash> m_losses; //!< the cached losses
+  mutable uint64_t m_hits;           //!< the number of cache hits
+  mutable uint64_t m_misses;         //!< the number of cache misses
+};
+
+} // namespace ns3
+
+#endif /* CACHING_PROPAGATION_LOSS_MODEL_H */
@@ -174,6 +174,31 @@ Cost231PropagationLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel
   return txPowerDbm + GetLoss (a, b);
 }
 
+void
+Cost231PropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                             const std::vector<Ptr<MobilityModel> > &b,
+                                             const RxPositions &positions,
+                                             double *rxPowerDbm) const
+{
+  const double *distance = &positions.distance[0];
+  // The terms of GetLoss that do not depend on the distance, summed in
+  // the same order
+  double frequency_MHz = m_frequency * 1e-6;
+  double C_H = 0.8 + ((1.11 * std::log10 (frequency_MHz)) - 0.7) * m_SSAntennaHeight - (1.56 * std::log10 (frequency_MHz));
+  double constant = 46.3 + (33.9 * std::log10 (frequency_MHz)) - (13.82 * std::log10 (m_BSAntennaHeight)) - C_H;
+  double slope = 44.9 - 6.55 * std::log10 (m_BSAntennaHeight);
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      if (distance[i] <= m_minDistance)
+        {
+          continue;
+        }
+      double distance_km = distance[i] * 1e-3;
+      double loss_in_db = constant + (slope * std::log10 (distance_km)) + m_shadowing;
+      rxPowerDbm[i] += (0 - loss_in_db);
+    }
+}
+
 int64_t
 Cost231PropagationLossModel::DoAssignStreams (int64_t stream)
 {
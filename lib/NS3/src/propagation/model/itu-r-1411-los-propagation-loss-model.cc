@@ -102,6 +102,42 @@ ItuR1411LosPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return (txPowerDbm - GetLoss (a, b));
 }
 
+void
+ItuR1411LosPropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                                 const std::vector<Ptr<MobilityModel> > &b,
+                                                 const RxPositions &positions,
+                                                 double *rxPowerDbm) const
+{
+  NS_LOG_FUNCTION (this);
+  const double *distance = &positions.distance[0];
+  const double *z = &positions.z[0];
+  NS_ASSERT_MSG (positions.tx.z > 0, "nodes' height must be greater than 0");
+  // The factors of GetLoss that only depend on the transmitter, in the same
+  // order of evaluation
+  double lambda2 = m_lambda * m_lambda;
+  double bpFactor = 8 * M_PI * positions.tx.z;
+  double rbpFactor = 4 * positions.tx.z;
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      NS_ASSERT_MSG (z[i] > 0, "nodes' height must be greater than 0");
+      double Lbp = std::fabs (20 * std::log10 (lambda2 / (bpFactor * z[i])));
+      double Rbp = (rbpFactor * z[i]) / m_lambda;
+      double lossLow;
+      double lossUp;
+      if (distance[i] <= Rbp)
+        {
+          lossLow = Lbp + 20 * std::log10 (distance[i] / Rbp);
+          lossUp = Lbp + 20 + 25 * std::log10 (distance[i] / Rbp);
+        }
+      else
+        {
+          lossLow = Lbp + 40 * std::log10 (distance[i] / Rbp);
+          lossUp = Lbp + 20 + 40 * std::log10 (distance[i] / Rbp);
+        }
+      rxPowerDbm[i] -= (lossUp + lossLow) / 2;
+    }
+}
+
 int64_t
 ItuR1411LosPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -71,6 +71,19 @@ Kun2600MhzPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return (txPowerDbm - GetLoss (a, b));
 }
 
+void
+Kun2600MhzPropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                                const std::vector<Ptr<MobilityModel> > &b,
+                                                const RxPositions &positions,
+                                                double *rxPowerDbm) const
+{
+  const double *distance = &positions.distance[0];
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      rxPowerDbm[i] -= 36 + 26 * std::log10 (distance[i]);
+    }
+}
+
 int64_t
 Kun2600MhzPropagationLossModel::DoAssignStreams (int64_t stream)
 {
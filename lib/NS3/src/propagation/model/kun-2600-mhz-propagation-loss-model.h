@@ -79,6 +79,10 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowers (Ptr<MobilityModel> a,
+                               const std::vector<Ptr<MobilityModel> > &b,
+                               const RxPositions &positions,
+                               double *rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
   
 };
@@ -82,6 +82,61 @@ PropagationLossModel::CalcRxPower (double txPowerDbm,
   return self;
 }
 
+void
+PropagationLossModel::CalcRxPowers (double txPowerDbm,
+                                    Ptr<MobilityModel> a,
+                                    const std::vector<Ptr<MobilityModel> > &b,
+                                    std::vector<double> &rxPowerDbm) const
+{
+  uint32_t n = b.size ();
+  rxPowerDbm.assign (n, txPowerDbm);
+  if (n == 0)
+    {
+      return;
+    }
+  // Gather the positions once for the whole chain
+  RxPositions positions;
+  positions.tx = a->GetPosition ();
+  positions.x.resize (n);
+  positions.y.resize (n);
+  positions.z.resize (n);
+  positions.distance.resize (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Vector position = b[i]->GetPosition ();
+      positions.x[i] = position.x;
+      positions.y[i] = position.y;
+      positions.z[i] = position.z;
+    }
+  const double *x = &positions.x[0];
+  const double *y = &positions.y[0];
+  const double *z = &positions.z[0];
+  double *distance = &positions.distance[0];
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double dx = x[i] - positions.tx.x;
+      double dy = y[i] - positions.tx.y;
+      double dz = z[i] - positions.tx.z;
+      distance[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+    }
+  for (const PropagationLossModel *model = this; model != 0; model = PeekPointer (model->m_next))
+    {
+      model->DoCalcRxPowers (a, b, positions, &rxPowerDbm[0]);
+    }
+}
+
+void
+PropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                      const std::vector<Ptr<MobilityModel> > &b,
+                                      const RxPositions &positions,
+                                      double *rxPowerDbm) const
+{
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      rxPowerDbm[i] = DoCalcRxPower (rxPowerDbm[i], a, b[i]);
+    }
+}
+
 int64_t
 PropagationLossModel::AssignStreams (int64_t stream)
 {
@@ -271,6 +326,30 @@ FriisPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - std::max (lossDb, m_minLoss);
 }
 
+void
+FriisPropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                           const std::vector<Ptr<MobilityModel> > &b,
+                                           const RxPositions &positions,
+                                           double *rxPowerDbm) const
+{
+  // Same computation as DoCalcRxPower, with the constant factors hoisted
+  // in the same order of evaluation so that the results are identical
+  const double *distance = &positions.distance[0];
+  double numerator = m_lambda * m_lambda;
+  double factor = 16 * M_PI * M_PI;
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      if (distance[i] <= 0)
+        {
+          rxPowerDbm[i] -= m_minLoss;
+          continue;
+        }
+      double denominator = factor * distance[i] * distance[i] * m_systemLoss;
+      double lossDb = -10 * log10 (numerator / denominator);
+      rxPowerDbm[i] -= std::max (lossDb, m_minLoss);
+    }
+}
+
 int64_t
 FriisPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -445,6 +524,43 @@ TwoRayGroundPropagationLossModel::DoCalcRxPower (double txPowerDbm,
     }
 }
 
+void
+TwoRayGroundPropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                                  const std::vector<Ptr<MobilityModel> > &b,
+                                                  const RxPositions &positions,
+                                                  double *rxPowerDbm) const
+{
+  const double *distance = &positions.distance[0];
+  const double *z = &positions.z[0];
+  double numerator = m_lambda * m_lambda;
+  double txAntHeight = positions.tx.z + m_heightAboveZ;
+  double crossFactor = 4 * M_PI * txAntHeight;
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      if (distance[i] <= m_minDistance)
+        {
+          continue;
+        }
+      double rxAntHeight = z[i] + m_heightAboveZ;
+      double dCross = (crossFactor * rxAntHeight) / m_lambda;
+      double tmp;
+      if (distance[i] <= dCross)
+        {
+          tmp = M_PI * distance[i];
+          double denominator = 16 * tmp * tmp * m_systemLoss;
+          rxPowerDbm[i] += 10 * std::log10 (numerator / denominator);
+        }
+      else
+        {
+          tmp = txAntHeight * rxAntHeight;
+          double rayNumerator = tmp * tmp;
+          tmp = distance[i] * distance[i];
+          double rayDenominator = tmp * tmp * m_systemLoss;
+          rxPowerDbm[i] += 10 * std::log10 (rayNumerator / rayDenominator);
+        }
+    }
+}
+
 int64_t
 TwoRayGroundPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -534,6 +650,26 @@ LogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm + rxc;
 }
 
+void
+LogDistancePropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                                 const std::vector<Ptr<MobilityModel> > &b,
+                                                 const RxPositions &positions,
+                                                 double *rxPowerDbm) const
+{
+  const double *distance = &positions.distance[0];
+  double factor = 10 * m_exponent;
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      if (distance[i] <= m_referenceDistance)
+        {
+          rxPowerDbm[i] -= m_referenceLoss;
+          continue;
+        }
+      double pathLossDb = factor * std::log10 (distance[i] / m_referenceDistance);
+      rxPowerDbm[i] += -m_referenceLoss - pathLossDb;
+    }
+}
+
 int64_t
 LogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -636,6 +772,42 @@ ThreeLogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - pathLossDb;
 }
 
+void
+ThreeLogDistancePropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                                      const std::vector<Ptr<MobilityModel> > &b,
+                                                      const RxPositions &positions,
+                                                      double *rxPowerDbm) const
+{
+  const double *distance = &positions.distance[0];
+  // The losses of the nearer fields, summed in the same order as in
+  // DoCalcRxPower
+  double loss1 = m_referenceLoss + 10 * m_exponent0 * std::log10 (m_distance1 / m_distance0);
+  double loss2 = loss1 + 10 * m_exponent1 * std::log10 (m_distance2 / m_distance1);
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      NS_ASSERT (distance[i] >= 0);
+      double pathLossDb;
+      if (distance[i] < m_distance0)
+        {
+          pathLossDb = 0;
+        }
+      else if (distance[i] < m_distance1)
+        {
+          pathLossDb = m_referenceLoss
+            + 10 * m_exponent0 * std::log10 (distance[i] / m_distance0);
+        }
+      else if (distance[i] < m_distance2)
+        {
+          pathLossDb = loss1 + 10 * m_exponent1 * std::log10 (distance[i] / m_distance1);
+        }
+      else
+        {
+          pathLossDb = loss2 + 10 * m_exponent2 * std::log10 (distance[i] / m_distance2);
+        }
+      rxPowerDbm[i] -= pathLossDb;
+    }
+}
+
 int64_t
 ThreeLogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -924,6 +1096,23 @@ RangePropagationLossModel::DoCalcRxPower (double txPowerDbm,
     }
 }
 
+void
+RangePropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                           const std::vector<Ptr<MobilityModel> > &b,
+                                           const RxPositions &positions,
+                                           double *rxPowerDbm) const
+{
+  const double *distance = &positions.distance[0];
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      if (distance[i] <= m_range)
+        {
+          continue;
+        }
+      rxPowerDbm[i] = -1000;
+    }
+}
+
 int64_t
 RangePropagationLossModel::DoAssignStreams (int64_t stream)
 {
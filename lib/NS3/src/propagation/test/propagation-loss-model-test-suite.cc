@@ -21,9 +21,19 @@
 #include "ns3/test.h"
 #include "ns3/config.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
 #include "ns3/propagation-loss-model.h"
+#include "ns3/caching-propagation-loss-model.h"
+#include "ns3/cost231-propagation-loss-model.h"
+#include "ns3/itu-r-1411-los-propagation-loss-model.h"
+#include "ns3/kun-2600-mhz-propagation-loss-model.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
 #include "ns3/simulator.h"
+#include <cmath>
+#include <vector>
 
 using namespace ns3;
 
@@ -436,6 +446,183 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class CachingPropagationLossModelTestCase : public TestCase
+{
+public:
+  CachingPropagationLossModelTestCase ();
+  virtual ~CachingPropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CachingPropagationLossModelTestCase::CachingPropagationLossModelTestCase ()
+  : TestCase ("Test CachingPropagationLossModel")
+{
+}
+
+CachingPropagationLossModelTestCase::~CachingPropagationLossModelTestCase ()
+{
+}
+
+void
+CachingPropagationLossModelTestCase::DoRun (void)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0,0,0));
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  b->SetPosition (Vector (100,0,0));
+  Ptr<ConstantVelocityMobilityModel> c = CreateObject<ConstantVelocityMobilityModel> ();
+  c->SetPosition (Vector (0,50,0));
+  c->SetVelocity (Vector (1,0,0));
+
+  Ptr<LogDistancePropagationLossModel> reference = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<CachingPropagationLossModel> caching = CreateObject<CachingPropagationLossModel> ();
+  caching->SetAttribute ("Model", PointerValue (CreateObject<LogDistancePropagationLossModel> ()));
+  // The models chained after the cache are still applied
+  Ptr<RandomPropagationLossModel> next = CreateObject<RandomPropagationLossModel> ();
+  next->SetAttribute ("Variable", StringValue ("ns3::ConstantRandomVariable[Constant=5.0]"));
+  caching->SetNext (next);
+
+  double txPowerDbm = 16.0;
+  double expected = reference->CalcRxPower (txPowerDbm, a, b) - 5;
+  NS_TEST_EXPECT_MSG_EQ (caching->CalcRxPower (txPowerDbm, a, b), expected, "Wrong loss a -> b");
+  NS_TEST_EXPECT_MSG_EQ (caching->CalcRxPower (txPowerDbm, a, b), expected, "Wrong cached loss a -> b");
+  NS_TEST_EXPECT_MSG_EQ (caching->CalcRxPower (txPowerDbm, b, a), expected, "Wrong cached loss b -> a");
+  double rxPowerDbm = caching->CalcRxPower (txPowerDbm + 3, a, b);
+  NS_TEST_EXPECT_MSG_EQ_TOL (rxPowerDbm, expected + 3, 1e-9, "Wrong cached loss at another transmission power");
+  NS_TEST_EXPECT_MSG_EQ (caching->GetHits (), 3, "Wrong number of hits");
+  NS_TEST_EXPECT_MSG_EQ (caching->GetMisses (), 1, "Wrong number of misses");
+
+  // A course change invalidates the links of the model
+  b->SetPosition (Vector (200,0,0));
+  expected = reference->CalcRxPower (txPowerDbm, a, b) - 5;
+  NS_TEST_EXPECT_MSG_EQ (caching->CalcRxPower (txPowerDbm, b, a), expected, "Stale loss after a course change");
+  NS_TEST_EXPECT_MSG_EQ (caching->CalcRxPower (txPowerDbm, a, b), expected, "Wrong cached loss a -> b");
+  NS_TEST_EXPECT_MSG_EQ (caching->GetHits (), 4, "Wrong number of hits");
+  NS_TEST_EXPECT_MSG_EQ (caching->GetMisses (), 2, "Wrong number of misses");
+
+  // The links of a moving model are never cached
+  NS_TEST_EXPECT_MSG_EQ (caching->CalcRxPower (txPowerDbm, a, c), reference->CalcRxPower (txPowerDbm, a, c) - 5,
+                         "Wrong loss a -> c");
+  NS_TEST_EXPECT_MSG_EQ (caching->CalcRxPower (txPowerDbm, a, c), reference->CalcRxPower (txPowerDbm, a, c) - 5,
+                         "Wrong loss a -> c");
+  NS_TEST_EXPECT_MSG_EQ (caching->GetHits (), 4, "Moving model cached");
+  NS_TEST_EXPECT_MSG_EQ (caching->GetMisses (), 4, "Wrong number of misses");
+
+  // Asymmetric links
+  Ptr<MatrixPropagationLossModel> matrix = CreateObject<MatrixPropagationLossModel> ();
+  matrix->SetLoss (a, b, 30, /*symmetric = */ false);
+  matrix->SetLoss (b, a, 100, /*symmetric = */ false);
+  caching = CreateObject<CachingPropagationLossModel> ();
+  caching->SetAttribute ("Model", PointerValue (matrix));
+  caching->SetAttribute ("Symmetric", BooleanValue (false));
+  for (int i = 0; i < 2; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (caching->CalcRxPower (0, a, b), -30, "Loss a -> b incorrect");
+      NS_TEST_EXPECT_MSG_EQ (caching->CalcRxPower (0, b, a), -100, "Loss b -> a incorrect");
+    }
+  NS_TEST_EXPECT_MSG_EQ (caching->GetHits (), 2, "Wrong number of hits");
+  Simulator::Destroy ();
+}
+
+class BatchPropagationLossModelTestCase : public TestCase
+{
+public:
+  BatchPropagationLossModelTestCase ();
+  virtual ~BatchPropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check that CalcRxPowers gives the same powers as CalcRxPower
+   * \param model the model computing the powers in batches
+   * \param reference the same model, computing the powers one at a time
+   */
+  void Check (Ptr<PropagationLossModel> model, Ptr<PropagationLossModel> reference);
+
+  Ptr<MobilityModel> m_tx;                //!< the transmitter
+  std::vector<Ptr<MobilityModel> > m_rx;  //!< the receivers
+};
+
+BatchPropagationLossModelTestCase::BatchPropagationLossModelTestCase ()
+  : TestCase ("Test CalcRxPowers against CalcRxPower")
+{
+}
+
+BatchPropagationLossModelTestCase::~BatchPropagationLossModelTestCase ()
+{
+}
+
+void
+BatchPropagationLossModelTestCase::Check (Ptr<PropagationLossModel> model, Ptr<PropagationLossModel> reference)
+{
+  double txPowerDbm = 16.0206;
+  std::vector<double> rxPowerDbm;
+  model->CalcRxPowers (txPowerDbm, m_tx, m_rx, rxPowerDbm);
+  NS_TEST_ASSERT_MSG_EQ (rxPowerDbm.size (), m_rx.size (), "Wrong number of powers");
+  for (uint32_t i = 0; i < m_rx.size (); i++)
+    {
+      // The same operations in the same order: the results are identical
+      NS_TEST_EXPECT_MSG_EQ (rxPowerDbm[i], reference->CalcRxPower (txPowerDbm, m_tx, m_rx[i]),
+                             model->GetInstanceTypeId ().GetName () << " differs at receiver " << i);
+    }
+}
+
+void
+BatchPropagationLossModelTestCase::DoRun (void)
+{
+  m_tx = CreateObject<ConstantPositionMobilityModel> ();
+  m_tx->SetPosition (Vector (10,20,1.5));
+  double distances[] = { 0, 0.3, 1, 7, 150, 199.9, 200, 350, 500, 1200, 5000 };
+  for (uint32_t i = 0; i < sizeof (distances) / sizeof (distances[0]); i++)
+    {
+      Ptr<MobilityModel> rx = CreateObject<ConstantPositionMobilityModel> ();
+      // Receivers in every direction, at heights between 1.5 m and 31.5 m
+      double angle = 0.7 * i;
+      double height = (i % 4) * 10.0;
+      double horizontal = std::sqrt (std::max (0.0, distances[i] * distances[i] - height * height));
+      rx->SetPosition (Vector (10 + horizontal * std::cos (angle), 20 + horizontal * std::sin (angle), 1.5 + height));
+      m_rx.push_back (rx);
+    }
+
+  Ptr<PropagationLossModel> model = CreateObject<FriisPropagationLossModel> ();
+  Check (model, model);
+  model->SetAttribute ("MinLoss", DoubleValue (60));
+  Check (model, model);
+  model = CreateObject<TwoRayGroundPropagationLossModel> ();
+  Check (model, model);
+  model = CreateObject<LogDistancePropagationLossModel> ();
+  Check (model, model);
+  model = CreateObject<ThreeLogDistancePropagationLossModel> ();
+  Check (model, model);
+  model = CreateObject<RangePropagationLossModel> ();
+  Check (model, model);
+  model = CreateObject<Cost231PropagationLossModel> ();
+  Check (model, model);
+  model = CreateObject<Kun2600MhzPropagationLossModel> ();
+  Check (model, model);
+
+  // Without the receiver at distance 0, where the loss is not finite
+  model = CreateObject<ItuR1411LosPropagationLossModel> ();
+  m_rx.erase (m_rx.begin ());
+  Check (model, model);
+
+  // Chains mixing deterministic and random models draw the same values
+  Ptr<PropagationLossModel> chains[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      chains[i] = CreateObject<LogDistancePropagationLossModel> ();
+      Ptr<PropagationLossModel> nakagami = CreateObject<NakagamiPropagationLossModel> ();
+      chains[i]->SetNext (nakagami);
+      nakagami->SetNext (CreateObject<RangePropagationLossModel> ());
+      chains[i]->AssignStreams (1);
+    }
+  Check (chains[0], chains[1]);
+
+  Simulator::Destroy ();
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +637,8 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new CachingPropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new BatchPropagationLossModelTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;
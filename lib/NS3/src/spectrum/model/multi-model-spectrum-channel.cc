@@ -26,6 +26,7 @@
 #include <ns3/net-device.h>
 #include <ns3/node.h>
 #include <ns3/double.h>
+#include <ns3/boolean.h>
 #include <ns3/mobility-model.h>
 #include <ns3/spectrum-phy.h>
 #include <ns3/spectrum-converter.h>
@@ -34,6 +35,7 @@
 #include <ns3/propagation-delay-model.h>
 #include <ns3/antenna-model.h>
 #include <ns3/angles.h>
+#include <algorithm>
 #include <iostream>
 #include <utility>
 #include "multi-model-spectrum-channel.h"
@@ -81,7 +83,26 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 }
 
 
+/**
+ * \brief Order the receivers as MultiModelSpectrumChannel::StartTx
+ * visits them without the spatial grid: by RX SpectrumModel, then in
+ * the order of the SpectrumPhy sets.
+ * \param a a receiver
+ * \param b another receiver
+ * \return true if a comes first
+ */
+static bool
+CompareReceivers (Ptr<SpectrumPhy> a, Ptr<SpectrumPhy> b)
+{
+  SpectrumModelUid_t aUid = a->GetRxSpectrumModel ()->GetUid ();
+  SpectrumModelUid_t bUid = b->GetRxSpectrumModel ()->GetUid ();
+  return aUid < bUid || (aUid == bUid && a < b);
+}
+
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
+  : m_numDevices (0),
+    m_maxRange (0.0),
+    m_cacheLinkGains (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -95,6 +116,18 @@ MultiModelSpectrumChannel::DoDispose ()
   m_spectrumPropagationLoss = 0;
   m_txSpectrumModelInfoMap.clear ();
   m_rxSpectrumModelInfoMap.clear ();
+  for (std::set<Ptr<MobilityModel> >::iterator i = m_trackedMobilities.begin ();
+       i != m_trackedMobilities.end ();
+       ++i)
+    {
+      (*i)->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&MultiModelSpectrumChannel::CourseChanged, this));
+    }
+  m_trackedMobilities.clear ();
+  m_linkGains.clear ();
+  m_grid.Clear ();
+  m_gridPhys.clear ();
+  m_griddedPhys.clear ();
+  m_ungriddedPhys.clear ();
   SpectrumChannel::DoDispose ();
 }
 
@@ -119,6 +152,26 @@ MultiModelSpectrumChannel::GetTypeId (void)
                    DoubleValue (1.0e9),
                    MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxLossDb),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxRange",
+                   "If non-zero, the maximum distance in meters for which "
+                   "transmissions will be passed to the receiving PHY.  The "
+                   "receivers are then kept in a grid so that the receivers "
+                   "beyond this distance are never visited.  This parameter "
+                   "is to be used along with MaxLossDb, with the distance "
+                   "beyond which the loss exceeds MaxLossDb for all the "
+                   "antenna orientations.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("CacheLinkGains",
+                   "If true, the loss due to the antennas and to the "
+                   "single-frequency PropagationLossModel between two static "
+                   "devices is computed once, and again only after either "
+                   "device changes course.  Only enable this with "
+                   "deterministic propagation loss models and fixed antennas.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MultiModelSpectrumChannel::m_cacheLinkGains),
+                   MakeBooleanChecker ())
     .AddTraceSource ("PathLoss",
                      "This trace is fired whenever a new path loss value "
                      "is calculated. The first and second parameters "
@@ -213,6 +266,10 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
       NS_ASSERT (ret2.second);
     }
 
+  if (m_griddedPhys.find (phy) == m_griddedPhys.end ())
+    {
+      m_ungriddedPhys.insert (phy);
+    }
 }
 
 
@@ -282,6 +339,38 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   NS_LOG_LOGIC ("converter map size: " << txInfoIteratorerator->second.m_spectrumConverterMap.size ());
   NS_LOG_LOGIC ("converter map first element: " << txInfoIteratorerator->second.m_spectrumConverterMap.begin ()->first);
 
+  if (m_maxRange > 0 && txMobility)
+    {
+      UpdateGrid ();
+      std::vector<uint32_t> indices;
+      m_grid.Find (txMobility->GetPosition (), m_maxRange, indices);
+      std::vector<Ptr<SpectrumPhy> > receivers (m_ungriddedPhys.begin (), m_ungriddedPhys.end ());
+      for (std::vector<uint32_t>::const_iterator i = indices.begin (); i != indices.end (); ++i)
+        {
+          receivers.push_back (m_gridPhys[*i]);
+        }
+      std::sort (receivers.begin (), receivers.end (), &CompareReceivers);
+
+      std::map<SpectrumModelUid_t, Ptr<SpectrumValue> > convertedTxPowerSpectra;
+      for (std::vector<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = receivers.begin ();
+           rxPhyIterator != receivers.end ();
+           ++rxPhyIterator)
+        {
+          SpectrumModelUid_t rxSpectrumModelUid = (*rxPhyIterator)->GetRxSpectrumModel ()->GetUid ();
+          std::map<SpectrumModelUid_t, Ptr<SpectrumValue> >::iterator converted = convertedTxPowerSpectra.find (rxSpectrumModelUid);
+          if (converted == convertedTxPowerSpectra.end ())
+            {
+              Ptr<SpectrumValue> convertedTxPowerSpectrum = ConvertTxPsd (txInfoIteratorerator->second, txParams->psd, rxSpectrumModelUid);
+              converted = convertedTxPowerSpectra.insert (std::make_pair (rxSpectrumModelUid, convertedTxPowerSpectrum)).first;
+            }
+          if (converted->second != 0)
+            {
+              StartTxToReceiver (txParams, txMobility, converted->second, *rxPhyIterator);
+            }
+        }
+      return;
+    }
+
   for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
        rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
@@ -289,105 +378,203 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
       SpectrumModelUid_t rxSpectrumModelUid = rxInfoIterator->second.m_rxSpectrumModel->GetUid ();
       NS_LOG_LOGIC (" rxSpectrumModelUids " << rxSpectrumModelUid);
 
-      Ptr <SpectrumValue> convertedTxPowerSpectrum;
-      if (txSpectrumModelUid == rxSpectrumModelUid)
-        {
-          NS_LOG_LOGIC ("no spectrum conversion needed");
-          convertedTxPowerSpectrum = txParams->psd;
-        }
-      else
+      Ptr <SpectrumValue> convertedTxPowerSpectrum = ConvertTxPsd (txInfoIteratorerator->second, txParams->psd, rxSpectrumModelUid);
+      if (convertedTxPowerSpectrum == 0)
         {
-          NS_LOG_LOGIC (" converting txPowerSpectrum SpectrumModelUids" << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
-          SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfoIteratorerator->second.m_spectrumConverterMap.find (rxSpectrumModelUid);
-          if (rxConverterIterator == txInfoIteratorerator->second.m_spectrumConverterMap.end ())
-            {
-              // No converter means TX SpectrumModel is orthogonal to RX SpectrumModel
-              continue;
-            }
-          convertedTxPowerSpectrum = rxConverterIterator->second.Convert (txParams->psd);
+          // No converter means TX SpectrumModel is orthogonal to RX SpectrumModel
+          continue;
         }
 
-
       for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxInfoIterator->second.m_rxPhySet.begin ();
            rxPhyIterator != rxInfoIterator->second.m_rxPhySet.end ();
            ++rxPhyIterator)
         {
           NS_ASSERT_MSG ((*rxPhyIterator)->GetRxSpectrumModel ()->GetUid () == rxSpectrumModelUid,
                          "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
+          StartTxToReceiver (txParams, txMobility, convertedTxPowerSpectrum, *rxPhyIterator);
+        }
+    }
+}
+
+Ptr<SpectrumValue>
+MultiModelSpectrumChannel::ConvertTxPsd (const TxSpectrumModelInfo &txInfo, Ptr<SpectrumValue> txPsd,
+                                         SpectrumModelUid_t rxSpectrumModelUid) const
+{
+  SpectrumModelUid_t txSpectrumModelUid = txPsd->GetSpectrumModelUid ();
+  if (txSpectrumModelUid == rxSpectrumModelUid)
+    {
+      NS_LOG_LOGIC ("no spectrum conversion needed");
+      return txPsd;
+    }
+  NS_LOG_LOGIC (" converting txPowerSpectrum SpectrumModelUids" << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
+  SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfo.m_spectrumConverterMap.find (rxSpectrumModelUid);
+  if (rxConverterIterator == txInfo.m_spectrumConverterMap.end ())
+    {
+      return 0;
+    }
+  return rxConverterIterator->second.Convert (txPsd);
+}
+
+void
+MultiModelSpectrumChannel::StartTxToReceiver (Ptr<SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                                              Ptr<SpectrumValue> convertedTxPowerSpectrum, Ptr<SpectrumPhy> receiver)
+{
+  if (receiver == txParams->txPhy)
+    {
+      return;
+    }
+
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ();
+  double pathLossDb = 0;
+  if (txMobility && receiverMobility)
+    {
+      // check the range before copying anything
+      pathLossDb = GetPathLossDb (txParams, txMobility, receiver, receiverMobility);
+      NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
+      m_pathLossTrace (txParams->txPhy, receiver, pathLossDb);
+      if ( pathLossDb > m_maxLossDb)
+        {
+          // beyond range
+          return;
+        }
+    }
+
+  NS_LOG_LOGIC (" copying signal parameters " << txParams);
+  Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+  rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
+  Time delay = MicroSeconds (0);
 
-          if ((*rxPhyIterator) != txParams->txPhy)
+  if (txMobility && receiverMobility)
+    {
+      double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+      *(rxParams->psd) *= pathGainLinear;
+
+      if (m_spectrumPropagationLoss)
+        {
+          rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
+        }
+
+      if (m_propagationDelay)
+        {
+          delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
+        }
+    }
+
+  Ptr<NetDevice> netDev = receiver->GetDevice ();
+  if (netDev)
+    {
+      // the receiver has a NetDevice, so we expect that it is attached to a Node
+      uint32_t dstNode =  netDev->GetNode ()->GetId ();
+      Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
+                                      rxParams, receiver);
+    }
+  else
+    {
+      // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+      Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
+                           rxParams, receiver);
+    }
+}
+
+double
+MultiModelSpectrumChannel::GetPathLossDb (Ptr<const SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                                          Ptr<SpectrumPhy> receiver, Ptr<MobilityModel> receiverMobility)
+{
+  Ptr<AntennaModel> txAntenna = txParams->txAntenna;
+  Ptr<AntennaModel> rxAntenna = receiver->GetRxAntenna ();
+  // The position of a moving model changes without any notification.
+  bool cacheable = m_cacheLinkGains
+    && txMobility->GetVelocity ().GetLength () == 0
+    && receiverMobility->GetVelocity ().GetLength () == 0;
+  if (cacheable)
+    {
+      LinkGainMap::const_iterator tx = m_linkGains.find (txMobility);
+      if (tx != m_linkGains.end ())
+        {
+          RxLinkGainMap::const_iterator rx = tx->second.find (receiverMobility);
+          if (rx != tx->second.end ()
+              && rx->second.txAntenna == txAntenna
+              && rx->second.rxAntenna == rxAntenna)
+            {
+              NS_LOG_LOGIC ("cached pathLoss = " << rx->second.lossDb << " dB");
+              return rx->second.lossDb;
+            }
+        }
+    }
+
+  double pathLossDb = 0;
+  if (txAntenna != 0)
+    {
+      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
+      double txAntennaGain = txAntenna->GetGainDb (txAngles);
+      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+      pathLossDb -= txAntennaGain;
+    }
+  if (rxAntenna != 0)
+    {
+      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
+      double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
+      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+      pathLossDb -= rxAntennaGain;
+    }
+  if (m_propagationLoss)
+    {
+      double propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
+      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+      pathLossDb -= propagationGainDb;
+    }
+
+  if (cacheable)
+    {
+      Ptr<MobilityModel> mobilities[] = { txMobility, receiverMobility };
+      for (uint32_t i = 0; i < 2; i++)
+        {
+          if (m_trackedMobilities.insert (mobilities[i]).second)
             {
-              NS_LOG_LOGIC (" copying signal parameters " << txParams);
-              Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
-              rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
-              Time delay = MicroSeconds (0);
-
-              Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
-
-              if (txMobility && receiverMobility)
-                {
-                  double pathLossDb = 0;
-                  if (rxParams->txAntenna != 0)
-                    {
-                      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
-                      double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                      pathLossDb -= txAntennaGain;
-                    }
-                  Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-                  if (rxAntenna != 0)
-                    {
-                      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
-                      double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                      pathLossDb -= rxAntennaGain;
-                    }
-                  if (m_propagationLoss)
-                    {
-                      double propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
-                      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                      pathLossDb -= propagationGainDb;
-                    }                    
-                  NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
-                  m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
-                  if ( pathLossDb > m_maxLossDb)
-                    {
-                      // beyond range
-                      continue;
-                    }
-                  double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-                  *(rxParams->psd) *= pathGainLinear;              
-
-                  if (m_spectrumPropagationLoss)
-                    {
-                      rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
-                    }
-
-                  if (m_propagationDelay)
-                    {
-                      delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
-                    }
-                }
-
-              Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
-              if (netDev)
-                {
-                  // the receiver has a NetDevice, so we expect that it is attached to a Node
-                  uint32_t dstNode =  netDev->GetNode ()->GetId ();
-                  Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
-                                                  rxParams, *rxPhyIterator);
-                }
-              else
-                {
-                  // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
-                  Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
-                                       rxParams, *rxPhyIterator);
-                }
+              mobilities[i]->TraceConnectWithoutContext ("CourseChange", MakeCallback (&MultiModelSpectrumChannel::CourseChanged, this));
             }
         }
+      LinkGain &linkGain = m_linkGains[txMobility][receiverMobility];
+      linkGain.txAntenna = txAntenna;
+      linkGain.rxAntenna = rxAntenna;
+      linkGain.lossDb = pathLossDb;
+    }
+  return pathLossDb;
+}
 
+void
+MultiModelSpectrumChannel::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  m_linkGains.erase (mobility);
+  for (LinkGainMap::iterator i = m_linkGains.begin (); i != m_linkGains.end (); ++i)
+    {
+      i->second.erase (mobility);
     }
+}
 
+void
+MultiModelSpectrumChannel::UpdateGrid (void)
+{
+  if (m_grid.GetCellSize () != m_maxRange)
+    {
+      m_grid.SetCellSize (m_maxRange);
+    }
+  std::set<Ptr<SpectrumPhy> >::iterator i = m_ungriddedPhys.begin ();
+  while (i != m_ungriddedPhys.end ())
+    {
+      Ptr<MobilityModel> mobility = (*i)->GetMobility ();
+      if (mobility == 0)
+        {
+          // always a candidate, as it is never out of range
+          ++i;
+          continue;
+        }
+      m_grid.Add (mobility);
+      m_gridPhys.push_back (*i);
+      m_griddedPhys.insert (*i);
+      m_ungriddedPhys.erase (i++);
+    }
 }
 
 void
@@ -450,6 +637,7 @@ MultiModelSpectrumChannel::AddPropagationLossModel (Ptr<PropagationLossModel> lo
       loss->SetNext (m_propagationLoss);
     }
   m_propagationLoss = loss;
+  m_linkGains.clear ();
 }
 
 void
@@ -27,11 +27,15 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/spatial-grid.h>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace ns3 {
 
+class AntennaModel;
+class MobilityModel;
 
 /**
  * \ingroup spectrum
@@ -102,6 +106,16 @@ typedef std::map<SpectrumModelUid_t, RxSpectrumModelInfo> RxSpectrumModelInfoMap
  * for this to work is that, after the SpectrumPhy switched its
  * SpectrumModel,  MultiModelSpectrumChannel::AddRx () is
  * called again passing the pointer to that SpectrumPhy.
+ *
+ * Two optional shortcuts reduce the cost of a transmission in large
+ * static scenarios.  When the MaxRange attribute is set, the receivers
+ * are kept in a ns3::SpatialGrid and those farther than this distance
+ * from the transmitter are never visited: they behave as if their loss
+ * was above MaxLossDb.  When the CacheLinkGains attribute is set, the
+ * loss due to the antennas and to the single-frequency
+ * PropagationLossModel is computed once per pair of static mobility
+ * models, and computed again only after either of them notifies a
+ * course change; this is only correct with deterministic loss models.
  */
 class MultiModelSpectrumChannel : public SpectrumChannel
 {
@@ -164,6 +178,80 @@ private:
    */
   virtual void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
 
+  /**
+   * Convert the power spectral density of a transmission to the
+   * SpectrumModel of a receiver.
+   *
+   * @param txInfo The TX SpectrumModel information.
+   * @param txPsd The power spectral density of the transmission.
+   * @param rxSpectrumModelUid The RX SpectrumModel.
+   *
+   * @return The converted power spectral density, or 0 if the models are orthogonal.
+   */
+  Ptr<SpectrumValue> ConvertTxPsd (const TxSpectrumModelInfo &txInfo, Ptr<SpectrumValue> txPsd,
+                                   SpectrumModelUid_t rxSpectrumModelUid) const;
+
+  /**
+   * Schedule the reception of a transmission by a receiver, unless it
+   * is the transmitter or out of range.
+   *
+   * @param txParams The signal parameters of the transmitter.
+   * @param txMobility The mobility model of the transmitter.
+   * @param convertedTxPowerSpectrum The transmitted power spectral density,
+   *        in the SpectrumModel of the receiver.
+   * @param receiver The receiver.
+   */
+  void StartTxToReceiver (Ptr<SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                          Ptr<SpectrumValue> convertedTxPowerSpectrum, Ptr<SpectrumPhy> receiver);
+
+  /**
+   * Get the loss between a transmitter and a receiver due to the
+   * antennas and to the single-frequency PropagationLossModel, from
+   * the cache if enabled.
+   *
+   * @param txParams The signal parameters of the transmitter.
+   * @param txMobility The mobility model of the transmitter.
+   * @param receiver The receiver.
+   * @param receiverMobility The mobility model of the receiver.
+   *
+   * @return The loss, in dB.
+   */
+  double GetPathLossDb (Ptr<const SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                        Ptr<SpectrumPhy> receiver, Ptr<MobilityModel> receiverMobility);
+
+  /**
+   * Forget the cached losses of a mobility model when it changes course.
+   *
+   * @param mobility The mobility model.
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+
+  /**
+   * Add the receivers added since the last call to the grid, and set
+   * its cell size to MaxRange.
+   */
+  void UpdateGrid (void);
+
+  /**
+   * The cached loss between two static mobility models.
+   */
+  struct LinkGain
+  {
+    Ptr<AntennaModel> txAntenna; //!< The TX antenna the loss was computed with.
+    Ptr<AntennaModel> rxAntenna; //!< The RX antenna the loss was computed with.
+    double lossDb;               //!< The loss, in dB.
+  };
+
+  /**
+   * Container: RX mobility model, cached loss
+   */
+  typedef std::map<Ptr<const MobilityModel>, LinkGain> RxLinkGainMap;
+
+  /**
+   * Container: TX mobility model, cached losses to each RX mobility model
+   */
+  typedef std::map<Ptr<const MobilityModel>, RxLinkGainMap> LinkGainMap;
+
   /**
    * Propagation delay model to be used with this channel.
    */
@@ -207,6 +295,51 @@ private:
    */
   double m_maxLossDb;
 
+  /**
+   * Maximum range [m].
+   *
+   * Any device farther than this distance is considered out of range,
+   * zero for no limit.
+   */
+  double m_maxRange;
+
+  /**
+   * Whether to cache the loss between static mobility models.
+   */
+  bool m_cacheLinkGains;
+
+  /**
+   * The cached losses, by TX and RX mobility model.
+   */
+  LinkGainMap m_linkGains;
+
+  /**
+   * The mobility models whose course changes are tracked to invalidate
+   * m_linkGains.
+   */
+  std::set<Ptr<MobilityModel> > m_trackedMobilities;
+
+  /**
+   * The receivers with a mobility model, in the order of m_grid.
+   */
+  std::vector<Ptr<SpectrumPhy> > m_gridPhys;
+
+  /**
+   * The receivers not yet in m_grid, because they were added since the
+   * last transmission or have no mobility model.
+   */
+  std::set<Ptr<SpectrumPhy> > m_ungriddedPhys;
+
+  /**
+   * The receivers in m_grid.
+   */
+  std::set<Ptr<SpectrumPhy> > m_griddedPhys;
+
+  /**
+   * The positions of the receivers, when MaxRange is set.
+   */
+  SpatialGrid m_grid;
+
   /**
    * \deprecated The non-const \c Ptr<SpectrumPhy> argument
    * is deprecated and will be changed to \c Ptr<const SpectrumPhy>
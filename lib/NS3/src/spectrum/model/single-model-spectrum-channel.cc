@@ -134,6 +134,26 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
   Ptr<MobilityModel> senderMobility = txParams->txPhy->GetMobility ();
 
+  // Each propagation loss model of the chain computes the gains of all the
+  // receivers at once
+  std::vector<double> propagationGainsDb;
+  if (senderMobility && m_propagationLoss)
+    {
+      std::vector<Ptr<MobilityModel> > receiverMobilities;
+      for (PhyList::const_iterator rxPhyIterator = m_phyList.begin ();
+           rxPhyIterator != m_phyList.end ();
+           ++rxPhyIterator)
+        {
+          Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+          if ((*rxPhyIterator) != txParams->txPhy && receiverMobility)
+            {
+              receiverMobilities.push_back (receiverMobility);
+            }
+        }
+      m_propagationLoss->CalcRxPowers (0, senderMobility, receiverMobilities, propagationGainsDb);
+    }
+  std::vector<double>::const_iterator propagationGainDb = propagationGainsDb.begin ();
+
   for (PhyList::const_iterator rxPhyIterator = m_phyList.begin ();
        rxPhyIterator != m_phyList.end ();
        ++rxPhyIterator)
@@ -166,9 +186,8 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
                 }
               if (m_propagationLoss)
                 {
-                  double propagationGainDb = m_propagationLoss->CalcRxPower (0, senderMobility, receiverMobility);
-                  NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                  pathLossDb -= propagationGainDb;
+                  NS_LOG_LOGIC ("propagationGainDb = " << *propagationGainDb << " dB");
+                  pathLossDb -= *propagationGainDb++;
                 }                    
               NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
               m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
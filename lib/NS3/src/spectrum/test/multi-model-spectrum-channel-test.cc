@@ -0,0 +1,271 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/object.h>
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/double.h>
+#include <ns3/boolean.h>
+#include <ns3/net-device.h>
+#include <ns3/antenna-model.h>
+#include <ns3/spectrum-phy.h>
+#include <ns3/spectrum-value.h>
+#include <ns3/spectrum-signal-parameters.h>
+#include <ns3/multi-model-spectrum-channel.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("MultiModelSpectrumChannelTest");
+
+/**
+ * \ingroup spectrum
+ *
+ * SpectrumPhy summing the power it receives.
+ */
+class MultiModelSpectrumChannelTestPhy : public SpectrumPhy
+{
+public:
+  /**
+   * Constructor.
+   * \param model the RX SpectrumModel
+   * \param mobility the mobility model
+   */
+  MultiModelSpectrumChannelTestPhy (Ptr<const SpectrumModel> model, Ptr<MobilityModel> mobility)
+    : m_model (model),
+      m_mobility (mobility),
+      m_rxCount (0),
+      m_rxPower (0)
+  {
+  }
+
+  // inherited from SpectrumPhy
+  virtual void SetDevice (Ptr<NetDevice> d)
+  {
+  }
+  virtual Ptr<NetDevice> GetDevice () const
+  {
+    return 0;
+  }
+  virtual void SetMobility (Ptr<MobilityModel> m)
+  {
+    m_mobility = m;
+  }
+  virtual Ptr<MobilityModel> GetMobility ()
+  {
+    return m_mobility;
+  }
+  virtual void SetChannel (Ptr<SpectrumChannel> c)
+  {
+  }
+  virtual Ptr<const SpectrumModel> GetRxSpectrumModel () const
+  {
+    return m_model;
+  }
+  virtual Ptr<AntennaModel> GetRxAntenna ()
+  {
+    return 0;
+  }
+  virtual void StartRx (Ptr<SpectrumSignalParameters> params)
+  {
+    m_rxCount++;
+    m_rxPower += Sum (*params->psd);
+  }
+
+  Ptr<const SpectrumModel> m_model;  //!< the RX SpectrumModel
+  Ptr<MobilityModel> m_mobility;     //!< the mobility model
+  uint32_t m_rxCount;                //!< the number of signals received
+  double m_rxPower;                  //!< the total power received
+};
+
+/**
+ * \ingroup spectrum
+ *
+ * Propagation loss model counting its evaluations.
+ */
+class CountingPropagationLossModel : public PropagationLossModel
+{
+public:
+  CountingPropagationLossModel ()
+    : m_loss (CreateObject<LogDistancePropagationLossModel> ()),
+      m_count (0)
+  {
+  }
+
+  Ptr<PropagationLossModel> m_loss; //!< the actual loss model
+  mutable uint32_t m_count;         //!< the number of evaluations
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    m_count++;
+    return m_loss->CalcRxPower (txPowerDbm, a, b);
+  }
+  virtual int64_t DoAssignStreams (int64_t stream)
+  {
+    return 0;
+  }
+};
+
+/**
+ * \ingroup spectrum
+ *
+ * Check that a MultiModelSpectrumChannel with a MaxRange and a link gain
+ * cache delivers the same signals as one without.
+ */
+class MultiModelSpectrumChannelShortcutsTestCase : public TestCase
+{
+public:
+  MultiModelSpectrumChannelShortcutsTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Transmit from a PHY on both channels.
+   * \param index the index of the transmitting PHY
+   */
+  void Transmit (uint32_t index);
+  /**
+   * Check that the PHYs of both channels received the same signals.
+   */
+  void Compare (void);
+
+  Ptr<MultiModelSpectrumChannel> m_channels[2];                     //!< plain and optimized channels
+  std::vector<Ptr<MultiModelSpectrumChannelTestPhy> > m_phys[2];    //!< the PHYs of each channel
+  Ptr<SpectrumModel> m_model;                                       //!< the spectrum model
+};
+
+MultiModelSpectrumChannelShortcutsTestCase::MultiModelSpectrumChannelShortcutsTestCase ()
+  : TestCase ("Check the MaxRange and CacheLinkGains shortcuts")
+{
+}
+
+void
+MultiModelSpectrumChannelShortcutsTestCase::Transmit (uint32_t index)
+{
+  for (uint32_t c = 0; c < 2; c++)
+    {
+      Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+      params->txPhy = m_phys[c][index];
+      params->psd = Create<SpectrumValue> (m_model);
+      (*params->psd) = 1e-3;
+      params->duration = MilliSeconds (1);
+      m_channels[c]->StartTx (params);
+    }
+}
+
+void
+MultiModelSpectrumChannelShortcutsTestCase::Compare (void)
+{
+  for (uint32_t i = 0; i < m_phys[0].size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_phys[1][i]->m_rxCount, m_phys[0][i]->m_rxCount,
+                             "PHY " << i << " received a different number of signals at " << Simulator::Now ());
+      NS_TEST_EXPECT_MSG_EQ_TOL (m_phys[1][i]->m_rxPower, m_phys[0][i]->m_rxPower, 1e-20,
+                                 "PHY " << i << " received a different power at " << Simulator::Now ());
+    }
+}
+
+void
+MultiModelSpectrumChannelShortcutsTestCase::DoRun (void)
+{
+  std::vector<double> freqs;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      freqs.push_back (2.4e9 + i * 1e6);
+    }
+  m_model = Create<SpectrumModel> (freqs);
+
+  Ptr<CountingPropagationLossModel> losses[2];
+  for (uint32_t c = 0; c < 2; c++)
+    {
+      m_channels[c] = CreateObject<MultiModelSpectrumChannel> ();
+      losses[c] = CreateObject<CountingPropagationLossModel> ();
+      m_channels[c]->AddPropagationLossModel (losses[c]);
+      m_channels[c]->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+      // 100 dB is reached at 59.95 m with the default log distance model.
+      m_channels[c]->SetAttribute ("MaxLossDb", DoubleValue (100.0));
+    }
+  m_channels[1]->SetAttribute ("MaxRange", DoubleValue (60.0));
+  m_channels[1]->SetAttribute ("CacheLinkGains", BooleanValue (true));
+
+  // Both channels share the mobility models of their PHYs.
+  std::vector<Ptr<ConstantPositionMobilityModel> > mobilities;
+  for (uint32_t i = 0; i < 30; i++)
+    {
+      mobilities.push_back (CreateObject<ConstantPositionMobilityModel> ());
+      mobilities.back ()->SetPosition (Vector (10.0 * i, 0.0, 0.0));
+      for (uint32_t c = 0; c < 2; c++)
+        {
+          m_phys[c].push_back (CreateObject<MultiModelSpectrumChannelTestPhy> (m_model, mobilities.back ()));
+          m_channels[c]->AddRx (m_phys[c].back ());
+        }
+    }
+
+  Simulator::Schedule (Seconds (1.0), &MultiModelSpectrumChannelShortcutsTestCase::Transmit, this, 0);
+  Simulator::Schedule (Seconds (1.5), &MultiModelSpectrumChannelShortcutsTestCase::Compare, this);
+  Simulator::Schedule (Seconds (2.0), &ConstantPositionMobilityModel::SetPosition, mobilities[3], Vector (155.0, 3.0, 0.0));
+  Simulator::Schedule (Seconds (3.0), &MultiModelSpectrumChannelShortcutsTestCase::Transmit, this, 0);
+  Simulator::Schedule (Seconds (3.5), &MultiModelSpectrumChannelShortcutsTestCase::Compare, this);
+  Simulator::Schedule (Seconds (4.0), &MultiModelSpectrumChannelShortcutsTestCase::Transmit, this, 15);
+  Simulator::Schedule (Seconds (4.5), &MultiModelSpectrumChannelShortcutsTestCase::Compare, this);
+  Simulator::Schedule (Seconds (5.0), &MultiModelSpectrumChannelShortcutsTestCase::Transmit, this, 15);
+  Simulator::Schedule (Seconds (5.5), &MultiModelSpectrumChannelShortcutsTestCase::Compare, this);
+  Simulator::Schedule (Seconds (6.0), &ConstantPositionMobilityModel::SetPosition, mobilities[3], Vector (25.0, 0.0, 0.0));
+  Simulator::Schedule (Seconds (7.0), &MultiModelSpectrumChannelShortcutsTestCase::Transmit, this, 0);
+  Simulator::Schedule (Seconds (7.5), &MultiModelSpectrumChannelShortcutsTestCase::Compare, this);
+  Simulator::Run ();
+
+  // Every transmission visits all the other PHYs of the plain channel.
+  NS_TEST_EXPECT_MSG_EQ (losses[0]->m_count, 5 * 29, "Wrong number of loss evaluations without the shortcuts");
+  // From PHY 0: the 6 PHYs within 60 m, then PHY 3 out of range and the
+  // others cached.  From PHY 15: the 12 PHYs within 60 m and PHY 3 next
+  // to it, then all cached.  From PHY 0 again: PHY 3, back in range.
+  NS_TEST_EXPECT_MSG_EQ (losses[1]->m_count, 6 + 13 + 1, "Wrong number of loss evaluations with the shortcuts");
+  NS_TEST_EXPECT_MSG_EQ (m_phys[0][3]->m_rxCount, 4, "PHY 3 did not receive the expected signals");
+
+  Simulator::Destroy ();
+  for (uint32_t c = 0; c < 2; c++)
+    {
+      m_channels[c]->Dispose ();
+      m_channels[c] = 0;
+      m_phys[c].clear ();
+    }
+}
+
+/**
+ * \ingroup spectrum
+ *
+ * MultiModelSpectrumChannel TestSuite
+ */
+class MultiModelSpectrumChannelTestSuite : public TestSuite
+{
+public:
+  MultiModelSpectrumChannelTestSuite ();
+};
+
+MultiModelSpectrumChannelTestSuite::MultiModelSpectrumChannelTestSuite ()
+  : TestSuite ("multi-model-spectrum-channel", UNIT)
+{
+  AddTestCase (new MultiModelSpectrumChannelShortcutsTestCase, TestCase::QUICK);
+}
+
+static MultiModelSpectrumChannelTestSuite g_multiModelSpectrumChannelTestSuite; ///< the test suite
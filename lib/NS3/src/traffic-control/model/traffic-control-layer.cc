@@ -320,6 +320,19 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
   NS_LOG_DEBUG ("Send packet to device " << device << " protocol number " <<
                 item->GetProtocol ());
 
+  // a super-packet is split here, so that queue discs and devices only
+  // handle the packets actually transmitted
+  std::vector<Ptr<QueueDiscItem> > segments = item->Segment ();
+  if (!segments.empty ())
+    {
+      NS_LOG_DEBUG ("Split super-packet into " << segments.size () << " packets");
+      for (std::vector<Ptr<QueueDiscItem> >::iterator i = segments.begin (); i != segments.end (); i++)
+        {
+          Send (device, *i);
+        }
+      return;
+    }
+
   std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi = m_netDevices.find (device);
   NS_ASSERT (ndi != m_netDevices.end ());
   Ptr<NetDeviceQueueInterface> devQueueIface = ndi->second.m_ndqi;
@@ -190,6 +190,9 @@ public:
   /**
    * \brief Called from upper layer to queue a packet for the transmission.
    *
+   * A super-packet (see QueueDiscItem::Segment) is first split into the
+   * packets it carries, each of which is then queued.
+   *
    * \param device the device the packet must be sent to
    * \param item a queue item including a packet and additional information
    */
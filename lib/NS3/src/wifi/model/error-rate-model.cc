@@ -18,21 +18,51 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
+#include <cmath>
 #include "error-rate-model.h"
+#include "wifi-utils.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
 
 namespace ns3 {
 
+NS_LOG_COMPONENT_DEFINE ("ErrorRateModel");
+
 NS_OBJECT_ENSURE_REGISTERED (ErrorRateModel);
 
+const double ErrorRateModel::TABLE_MIN_SNR_DB = -20.0;
+const double ErrorRateModel::TABLE_MAX_SNR_DB = 60.0;
+const double ErrorRateModel::TABLE_STEP_DB = 0.02;
+
+std::mutex ErrorRateModel::m_tablesMutex;
+
 TypeId ErrorRateModel::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::ErrorRateModel")
     .SetParent<Object> ()
     .SetGroupName ("Wifi")
+    .AddAttribute ("Tabulated",
+                   "If true, the chunk success rates are interpolated in tables "
+                   "of SNR values from -20 dB to 60 dB with a step of 0.02 dB, "
+                   "built the first time each mode is used. The absolute error on "
+                   "the success rate of a chunk is below 1e-4. The tables are "
+                   "shared by all the error rate models of the same type, whose "
+                   "success rates must only depend on the mode and the TXVECTOR.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ErrorRateModel::m_tabulated),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
+ErrorRateModel::ErrorRateModel ()
+  : m_tabulated (false),
+    m_lastKey (0),
+    m_lastTable (0)
+{
+}
+
 double
 ErrorRateModel::CalculateSnr (WifiTxVector txVector, double ber) const
 {
@@ -57,4 +87,95 @@ ErrorRateModel::CalculateSnr (WifiTxVector txVector, double ber) const
   return low;
 }
 
+bool
+ErrorRateModel::IsTabulated (void) const
+{
+  return m_tabulated;
+}
+
+double
+ErrorRateModel::GetTabulatedChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint64_t nbits) const
+{
+  const Table &table = GetTable (mode, txVector);
+  double x = (RatioToDb (snr) - TABLE_MIN_SNR_DB) / TABLE_STEP_DB;
+  if (!(x >= 0) || x >= table.size () - 1)
+    {
+      return GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  std::size_t i = static_cast<std::size_t> (x);
+  if (!table[i].interpolate)
+    {
+      return GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  double logBer = table[i].logBer + (x - i) * (table[i + 1].logBer - table[i].logBer);
+  return std::pow (1.0 - std::exp (logBer), static_cast<double> (nbits));
+}
+
+double
+ErrorRateModel::GetLogBer (WifiMode mode, WifiTxVector txVector, double snrDb) const
+{
+  double ber = 1.0 - GetChunkSuccessRate (mode, txVector, DbToRatio (snrDb), 1);
+  // The floor gives a success rate of exactly 1 and keeps the
+  // interpolation finite
+  return (ber > 0) ? std::log (ber) : -800.0;
+}
+
+const ErrorRateModel::Table &
+ErrorRateModel::GetTable (WifiMode mode, WifiTxVector txVector) const
+{
+  TableKey key = (static_cast<TableKey> (GetInstanceTypeId ().GetUid ()) << 48)
+    | (static_cast<TableKey> (mode.GetUid () & 0xffff) << 32)
+    | (static_cast<TableKey> (txVector.GetChannelWidth ()) << 24)
+    | (static_cast<TableKey> (txVector.GetGuardInterval ()) << 8)
+    | txVector.GetNss ();
+  if (m_lastTable != 0 && m_lastKey == key)
+    {
+      return *m_lastTable;
+    }
+  // The tables are only added and filled under the lock, and never
+  // modified afterwards
+  std::lock_guard<std::mutex> lock (m_tablesMutex);
+  Table &table = GetTables ()[key];
+  if (table.empty ())
+    {
+      BuildTable (mode, txVector, table);
+    }
+  m_lastKey = key;
+  m_lastTable = &table;
+  return table;
+}
+
+void
+ErrorRateModel::BuildTable (WifiMode mode, WifiTxVector txVector, Table &table) const
+{
+  NS_LOG_FUNCTION (this << mode << txVector);
+  uint32_t size = static_cast<uint32_t> (std::floor ((TABLE_MAX_SNR_DB - TABLE_MIN_SNR_DB) / TABLE_STEP_DB + 0.5)) + 1;
+  table.resize (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      table[i].logBer = GetLogBer (mode, txVector, TABLE_MIN_SNR_DB + i * TABLE_STEP_DB);
+    }
+  for (uint32_t i = 0; i + 1 < size; i++)
+    {
+      // An error e on the logarithm of the bit error rate q changes the
+      // success rate of a chunk of n bits by n * q * (1 - q)^(n - 1) * e,
+      // which is below e, and below n * q * e. Bound it in the middle
+      // of the interval, where the error of the linear interpolation is
+      // the largest, for chunks of up to 1e8 bits. The intervals across
+      // the kinks and the discontinuities of the analytic formulas fail
+      // the check and use the analytic formulas.
+      double logBer = GetLogBer (mode, txVector, TABLE_MIN_SNR_DB + (i + 0.5) * TABLE_STEP_DB);
+      double error = std::abs (logBer - 0.5 * (table[i].logBer + table[i + 1].logBer));
+      table[i].interpolate = error * std::min (1.0, 1e8 * std::exp (logBer)) < 1e-4;
+    }
+  table[size - 1].interpolate = false;
+}
+
+ErrorRateModel::Tables &
+ErrorRateModel::GetTables (void)
+{
+  static Tables tables;
+  return tables;
+}
+
 } //namespace ns3
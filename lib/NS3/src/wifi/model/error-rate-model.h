@@ -21,6 +21,9 @@
 #ifndef ERROR_RATE_MODEL_H
 #define ERROR_RATE_MODEL_H
 
+#include <map>
+#include <mutex>
+#include <vector>
 #include "wifi-tx-vector.h"
 #include "ns3/object.h"
 
@@ -29,6 +32,21 @@ namespace ns3 {
  * \ingroup wifi
  * \brief the interface for Wifi's error models
  *
+ * When the Tabulated attribute is set, the callers use
+ * GetTabulatedChunkSuccessRate, which interpolates the chunk success rates
+ * in tables built the first time a mode is used, instead of
+ * GetChunkSuccessRate, which evaluates the analytic formulas of the
+ * subclass. For every combination of mode, channel width, guard interval
+ * and number of spatial streams, the table holds the logarithm of the
+ * error rate of one bit \f$q = 1 - p(1)\f$ on a grid of SNR values in dB,
+ * and the success rate of a chunk of \f$n\f$ bits is \f$(1 - q)^n\f$. The
+ * logarithm of the error rate is smooth enough in dB for a linear
+ * interpolation, except across the kinks and the discontinuities of the
+ * analytic formulas, such as the bound of the coded error rates or the
+ * thresholds of the CCK model used without GSL. The intervals of the grid
+ * where the interpolation is not accurate enough are found when building
+ * the tables, and use the analytic formulas.  The tables are shared by
+ * all the models of the same type, and built under a lock.
  */
 class ErrorRateModel : public Object
 {
@@ -39,6 +57,8 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  ErrorRateModel ();
+
   /**
    * \param txVector a specific transmission vector including WifiMode
    * \param ber a target ber
@@ -71,6 +91,94 @@ public:
    * \return probability of successfully receiving the chunk
    */
   virtual double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint64_t nbits) const = 0;
+
+  /**
+   * \return true if the Tabulated attribute is set, and the callers should
+   * use GetTabulatedChunkSuccessRate rather than GetChunkSuccessRate
+   */
+  bool IsTabulated (void) const;
+
+  /**
+   * This method returns the probability that the given 'chunk' of the
+   * packet will be successfully received by the PHY, interpolated in the
+   * table of the mode, or computed by GetChunkSuccessRate where the table
+   * is not accurate enough.
+   *
+   * \param mode the Wi-Fi mode applicable to this chunk
+   * \param txVector TXVECTOR of the overall transmission
+   * \param snr the SNR of the chunk
+   * \param nbits the number of bits in this chunk
+   *
+   * \return probability of successfully receiving the chunk
+   */
+  double GetTabulatedChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint64_t nbits) const;
+
+
+private:
+  /**
+   * Get the logarithm of the error rate of one bit.
+   *
+   * \param mode the Wi-Fi mode applicable to the chunk
+   * \param txVector TXVECTOR of the overall transmission
+   * \param snrDb the SNR in dB
+   *
+   * \return the logarithm of the error rate of one bit, computed by
+   * GetChunkSuccessRate
+   */
+  double GetLogBer (WifiMode mode, WifiTxVector txVector, double snrDb) const;
+
+  /// A point of a table
+  struct TablePoint
+  {
+    double logBer;    //!< the logarithm of the error rate of one bit at this SNR
+    bool interpolate; //!< whether the interpolation up to the next point is accurate
+  };
+  /// A table: one point per SNR of the grid
+  typedef std::vector<TablePoint> Table;
+  /// The table key: model type, mode, channel width, guard interval and number of spatial streams
+  typedef uint64_t TableKey;
+  /// The tables of all the models, which only depend on the type of the model
+  typedef std::map<TableKey, Table> Tables;
+
+  /**
+   * Get the table of a mode, building it if needed.
+   *
+   * \param mode the Wi-Fi mode applicable to the chunk
+   * \param txVector TXVECTOR of the overall transmission
+   *
+   * \return the table
+   */
+  const Table & GetTable (WifiMode mode, WifiTxVector txVector) const;
+
+  /**
+   * Build the table of a mode.
+   *
+   * \param mode the Wi-Fi mode applicable to the chunk
+   * \param txVector TXVECTOR of the overall transmission
+   * \param table the empty table to fill
+   */
+  void BuildTable (WifiMode mode, WifiTxVector txVector, Table &table) const;
+
+  /**
+   * \return the tables of all the models
+   */
+  static Tables & GetTables (void);
+
+  /// The lowest SNR of the tables, in dB
+  static const double TABLE_MIN_SNR_DB;
+  /// The highest SNR of the tables, in dB
+  static const double TABLE_MAX_SNR_DB;
+  /// The step of the tables, in dB
+  static const double TABLE_STEP_DB;
+
+  /// Serializes the lookup and the lazy construction of the tables shared
+  /// by all the models.  The simulations run the wifi models on a single
+  /// thread, so it is never contended.
+  static std::mutex m_tablesMutex;
+
+  bool m_tabulated; //!< Interpolate the chunk success rates in tables
+  mutable TableKey m_lastKey; //!< The key of the last table used
+  mutable const Table *m_lastTable; //!< The last table used, or 0
 };
 
 } //namespace ns3
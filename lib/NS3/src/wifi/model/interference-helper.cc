@@ -216,8 +216,10 @@ InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
                          GetNextPosition (event->GetStartTime ()));
     }
   auto first = AddNiChangeEvent (event->GetStartTime (), NiChange (previousPowerStart, event));
+  // The end is inserted after the start, which keeps its index
+  auto firstIndex = first - m_niChanges.begin ();
   auto last = AddNiChangeEvent (event->GetEndTime (), NiChange (previousPowerEnd, event));
-  for (auto i = first; i != last; ++i)
+  for (auto i = m_niChanges.begin () + firstIndex; i != last; ++i)
     {
       i->second.AddPower (event->GetRxPowerW ());
     }
@@ -242,17 +244,18 @@ double
 InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event> event, NiChanges *ni) const
 {
   double noiseInterference = m_firstPower;
-  auto it = m_niChanges.find (event->GetStartTime ());
+  auto it = Find (event->GetStartTime ());
   for (; it != m_niChanges.end () && it->second.GetEvent () != event; ++it)
     {
       noiseInterference = it->second.GetPower ();
     }
-  ni->emplace (event->GetStartTime (), NiChange (0, event));
+  // The changes are copied in time order
+  ni->push_back (std::make_pair (event->GetStartTime (), NiChange (0, event)));
   while (++it != m_niChanges.end () && it->second.GetEvent () != event)
     {
-      ni->insert (*it);
+      ni->push_back (*it);
     }
-  ni->emplace (event->GetEndTime (), NiChange (0, event));
+  ni->push_back (std::make_pair (event->GetEndTime (), NiChange (0, event)));
   return noiseInterference;
 }
 
@@ -274,7 +277,15 @@ InterferenceHelper::CalculateChunkSuccessRate (double snir, Time duration, WifiM
                     ", SNIR improvement=+" << 10 * std::log10 (gain) << "dB");
       snir *= gain;
     }
-  double csr = m_errorRateModel->GetChunkSuccessRate (mode, txVector, snir, nbits);
+  double csr;
+  if (m_errorRateModel->IsTabulated ())
+    {
+      csr = m_errorRateModel->GetTabulatedChunkSuccessRate (mode, txVector, snir, nbits);
+    }
+  else
+    {
+      csr = m_errorRateModel->GetChunkSuccessRate (mode, txVector, snir, nbits);
+    }
   return csr;
 }
 
@@ -791,10 +802,23 @@ InterferenceHelper::EraseEvents (void)
   m_firstPower = 0;
 }
 
+InterferenceHelper::NiChanges::const_iterator
+InterferenceHelper::Find (Time moment) const
+{
+  auto it = std::lower_bound (m_niChanges.begin (), m_niChanges.end (), moment,
+                              [] (const std::pair<Time, NiChange> &change, Time t) { return change.first < t; });
+  if (it != m_niChanges.end () && it->first != moment)
+    {
+      return m_niChanges.end ();
+    }
+  return it;
+}
+
 InterferenceHelper::NiChanges::const_iterator
 InterferenceHelper::GetNextPosition (Time moment) const
 {
-  return m_niChanges.upper_bound (moment);
+  return std::upper_bound (m_niChanges.begin (), m_niChanges.end (), moment,
+                           [] (Time t, const std::pair<Time, NiChange> &change) { return t < change.first; });
 }
 
 InterferenceHelper::NiChanges::const_iterator
@@ -826,7 +850,7 @@ InterferenceHelper::NotifyRxEnd ()
   NS_LOG_FUNCTION (this);
   m_rxing = false;
   //Update m_firstPower for frame capture
-  auto it = m_niChanges.find (Simulator::Now ());
+  auto it = Find (Simulator::Now ());
   it--;
   m_firstPower = it->second.GetPower ();
 }
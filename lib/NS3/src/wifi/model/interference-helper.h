@@ -25,7 +25,7 @@
 #include "ns3/packet.h"
 #include "wifi-tx-vector.h"
 #include "error-rate-model.h"
-#include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -243,9 +243,10 @@ private:
   };
 
   /**
-   * typedef for a multimap of NiChanges
+   * typedef for a vector of NiChanges sorted by time, changes at the same
+   * time being kept in insertion order
    */
-  typedef std::multimap<Time, NiChange> NiChanges;
+  typedef std::vector<std::pair<Time, NiChange> > NiChanges;
 
   /**
    * Append the given Event.
@@ -309,7 +310,12 @@ private:
   double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel; ///< error rate model
   uint8_t m_numRxAntennas; /**< the number of RX antennas in the corresponding receiver */
-  /// Experimental: needed for energy duration calculation
+  /**
+   * Experimental: needed for energy duration calculation.
+   * Each NiChange holds the total power from its time on. The changes
+   * before a signal that arrives outside of a reception are pruned, so that
+   * only the signals overlapping the current reception are kept.
+   */
   NiChanges m_niChanges;
   double m_firstPower; ///< first power
   bool m_rxing; ///< flag whether it is in receiving state
@@ -321,6 +327,14 @@ private:
    * \returns an iterator to the list of NiChanges
    */
   NiChanges::const_iterator GetNextPosition (Time moment) const;
+  /**
+   * Returns an iterator to the first nichange at moment
+   *
+   * \param moment time to check from
+   * \returns an iterator to the list of NiChanges, or the end of the list
+   * if there is no nichange at moment
+   */
+  NiChanges::const_iterator Find (Time moment) const;
   /**
    * Returns an iterator to the first nichange that is later than moment
    *
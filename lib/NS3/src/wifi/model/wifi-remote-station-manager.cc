@@ -377,6 +377,17 @@ WifiRemoteStationManager::GetTypeId (void)
                                      &WifiRemoteStationManager::GetHtProtectionMode),
                    MakeEnumChecker (WifiRemoteStationManager::RTS_CTS, "Rts-Cts",
                                     WifiRemoteStationManager::CTS_TO_SELF, "Cts-To-Self"))
+    .AddAttribute ("StationTimeout",
+                   "The time after which the state of a remote station that was "
+                   "neither heard from nor sent to is removed, so that the memory "
+                   "stays bounded when many stations come and go, or 0 to keep "
+                   "the remote stations forever. The state, including the "
+                   "association state and the rate control statistics, starts "
+                   "over if the station shows up again, so this is meant for "
+                   "ad hoc networks.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WifiRemoteStationManager::m_stationTimeout),
+                   MakeTimeChecker (Seconds (0)))
     .AddTraceSource ("MacTxRtsFailed",
                      "The transmission of a RTS by the MAC layer has failed",
                      MakeTraceSourceAccessor (&WifiRemoteStationManager::m_macTxRtsFailed),
@@ -1652,15 +1663,19 @@ WifiRemoteStationState *
 WifiRemoteStationManager::LookupState (Mac48Address address) const
 {
   NS_LOG_FUNCTION (this << address);
-  for (StationStates::const_iterator i = m_states.begin (); i != m_states.end (); i++)
+  uint64_t key = GetKey (address, 0);
+  WifiRemoteStationState *state = m_states.Find (key);
+  if (state != 0)
     {
-      if ((*i)->m_address == address)
-        {
-          NS_LOG_DEBUG ("WifiRemoteStationManager::LookupState returning existing state");
-          return (*i);
-        }
+      NS_LOG_DEBUG ("WifiRemoteStationManager::LookupState returning existing state");
+      state->m_lastUsed = Simulator::Now ();
+      return state;
+    }
+  if (!m_stationTimeout.IsZero () && Simulator::Now () >= m_nextIdleCheck)
+    {
+      const_cast<WifiRemoteStationManager *> (this)->RemoveIdleStations ();
     }
-  WifiRemoteStationState *state = new WifiRemoteStationState ();
+  state = new WifiRemoteStationState ();
   state->m_state = WifiRemoteStationState::BRAND_NEW;
   state->m_address = address;
   state->m_operationalRateSet.push_back (GetDefaultMode ());
@@ -1678,7 +1693,8 @@ WifiRemoteStationManager::LookupState (Mac48Address address) const
   state->m_htSupported = false;
   state->m_vhtSupported = false;
   state->m_heSupported = false;
-  const_cast<WifiRemoteStationManager *> (this)->m_states.push_back (state);
+  state->m_lastUsed = Simulator::Now ();
+  const_cast<WifiRemoteStationManager *> (this)->m_states.Insert (key, state);
   NS_LOG_DEBUG ("WifiRemoteStationManager::LookupState returning new state");
   return state;
 }
@@ -1702,25 +1718,75 @@ WifiRemoteStation *
 WifiRemoteStationManager::Lookup (Mac48Address address, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << address << +tid);
-  for (Stations::const_iterator i = m_stations.begin (); i != m_stations.end (); i++)
+  uint64_t key = GetKey (address, tid);
+  WifiRemoteStation *station = m_stations.Find (key);
+  if (station != 0)
     {
-      if ((*i)->m_tid == tid
-          && (*i)->m_state->m_address == address)
-        {
-          return (*i);
-        }
+      station->m_state->m_lastUsed = Simulator::Now ();
+      return station;
     }
   WifiRemoteStationState *state = LookupState (address);
 
-  WifiRemoteStation *station = DoCreateStation ();
+  station = DoCreateStation ();
   station->m_state = state;
   station->m_tid = tid;
   station->m_ssrc = 0;
   station->m_slrc = 0;
-  const_cast<WifiRemoteStationManager *> (this)->m_stations.push_back (station);
+  const_cast<WifiRemoteStationManager *> (this)->m_stations.Insert (key, station);
   return station;
 }
 
+uint64_t
+WifiRemoteStationManager::GetKey (Mac48Address address, uint8_t tid)
+{
+  uint8_t buffer[6];
+  address.CopyTo (buffer);
+  uint64_t key = tid;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      key = (key << 8) | buffer[i];
+    }
+  return key;
+}
+
+void
+WifiRemoteStationManager::RemoveIdleStations (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Only called when a new remote station shows up, so that the stations
+  // looked up by the callers, which were all used just now, stay alive
+  Time now = Simulator::Now ();
+  std::vector<uint64_t> keys;
+  for (const Stations::Slot &slot : m_stations.GetSlots ())
+    {
+      if (slot.value != 0 && slot.value->m_state->m_lastUsed + m_stationTimeout <= now)
+        {
+          keys.push_back (slot.key);
+        }
+    }
+  for (uint64_t key : keys)
+    {
+      delete m_stations.Find (key);
+      m_stations.Erase (key);
+    }
+  keys.clear ();
+  for (const StationStates::Slot &slot : m_states.GetSlots ())
+    {
+      if (slot.value != 0 && slot.value->m_lastUsed + m_stationTimeout <= now)
+        {
+          keys.push_back (slot.key);
+        }
+    }
+  for (uint64_t key : keys)
+    {
+      NS_LOG_DEBUG ("Removing idle station " << m_states.Find (key)->m_address);
+      delete m_states.Find (key);
+      m_states.Erase (key);
+    }
+  // Idle stations are removed after one to two timeouts
+  m_nextIdleCheck = now + m_stationTimeout;
+}
+
 void
 WifiRemoteStationManager::SetQosSupport (Mac48Address from, bool qosSupported)
 {
@@ -1865,16 +1931,16 @@ void
 WifiRemoteStationManager::Reset (void)
 {
   NS_LOG_FUNCTION (this);
-  for (StationStates::const_iterator i = m_states.begin (); i != m_states.end (); i++)
+  for (const StationStates::Slot &slot : m_states.GetSlots ())
     {
-      delete (*i);
+      delete slot.value;
     }
-  m_states.clear ();
-  for (Stations::const_iterator i = m_stations.begin (); i != m_stations.end (); i++)
+  m_states.Clear ();
+  for (const Stations::Slot &slot : m_stations.GetSlots ())
     {
-      delete (*i);
+      delete slot.value;
     }
-  m_stations.clear ();
+  m_stations.Clear ();
   m_bssBasicRateSet.clear ();
   m_bssBasicMcsSet.clear ();
 }
@@ -30,6 +30,7 @@
 #include "ht-capabilities.h"
 #include "vht-capabilities.h"
 #include "he-capabilities.h"
+#include "ns3/open-addressing-table.h"
 
 namespace ns3 {
 
@@ -1394,6 +1395,20 @@ private:
    * \return WifiRemoteStation corresponding to the address
    */
   WifiRemoteStation* Lookup (Mac48Address address, const WifiMacHeader *header) const;
+  /**
+   * Remove the states and the stations of the remote stations that were
+   * not looked up for StationTimeout.
+   */
+  void RemoveIdleStations (void);
+  /**
+   * Get the key of a remote station in the tables of states and stations.
+   *
+   * \param address the MAC address of the station
+   * \param tid the TID
+   *
+   * \return the key
+   */
+  static uint64_t GetKey (Mac48Address address, uint8_t tid);
 
   /**
    * Return whether the modulation class of the selected mode for the
@@ -1441,13 +1456,13 @@ private:
   uint32_t GetNFragments (const WifiMacHeader *header, Ptr<const Packet> packet);
 
   /**
-   * A vector of WifiRemoteStations
+   * A table of WifiRemoteStations, keyed by address and TID
    */
-  typedef std::vector <WifiRemoteStation *> Stations;
+  typedef OpenAddressingTable<uint64_t, WifiRemoteStation> Stations;
   /**
-   * A vector of WifiRemoteStationStates
+   * A table of WifiRemoteStationStates, keyed by address
    */
-  typedef std::vector <WifiRemoteStationState *> StationStates;
+  typedef OpenAddressingTable<uint64_t, WifiRemoteStationState> StationStates;
 
   /**
    * This is a pointer to the WifiPhy associated with this
@@ -1480,6 +1495,8 @@ private:
 
   StationStates m_states;  //!< States of known stations
   Stations m_stations;     //!< Information for each known stations
+  Time m_stationTimeout;   //!< Time after which idle stations are removed, or 0
+  Time m_nextIdleCheck;    //!< Time of the next check for idle stations
 
   WifiMode m_defaultTxMode; //!< The default transmission mode
   WifiMode m_defaultTxMcs;   //!< The default transmission modulation-coding scheme (MCS)
@@ -1569,6 +1586,7 @@ struct WifiRemoteStationState
   bool m_htSupported;         //!< Flag if HT is supported by the station
   bool m_vhtSupported;        //!< Flag if VHT is supported by the station
   bool m_heSupported;         //!< Flag if HE is supported by the station
+  Time m_lastUsed;            //!< Last time the remote station was looked up
 };
 
 /**
@@ -21,9 +21,12 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/double.h"
 #include "yans-wifi-channel.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
+#include "ns3/caching-propagation-loss-model.h"
+#include "ns3/constant-position-mobility-model.h"
 #include "wifi-utils.h"
 
 namespace ns3 {
@@ -32,6 +35,47 @@ NS_LOG_COMPONENT_DEFINE ("YansWifiChannel");
 
 NS_OBJECT_ENSURE_REGISTERED (YansWifiChannel);
 
+/**
+ * \param loss the first model of a chain of propagation loss models
+ * \return the name of the first model of the chain which draws random
+ *         variables, or an empty string if they are all deterministic
+ */
+static std::string
+FindRandomLossModel (Ptr<PropagationLossModel> loss)
+{
+  // The models of other modules are looked up by name, so that this
+  // module does not depend on them.
+  static const char *randomModels[] = {
+    "ns3::RandomPropagationLossModel",
+    "ns3::NakagamiPropagationLossModel",
+    "ns3::JakesPropagationLossModel",
+    "ns3::BuildingsPropagationLossModel"
+  };
+  for (; loss != 0; loss = loss->GetNext ())
+    {
+      TypeId tid = loss->GetInstanceTypeId ();
+      for (uint32_t i = 0; i < sizeof (randomModels) / sizeof (randomModels[0]); i++)
+        {
+          TypeId randomTid;
+          if (TypeId::LookupByNameFailSafe (randomModels[i], &randomTid)
+              && (tid == randomTid || tid.IsChildOf (randomTid)))
+            {
+              return tid.GetName ();
+            }
+        }
+      Ptr<CachingPropagationLossModel> caching = DynamicCast<CachingPropagationLossModel> (loss);
+      if (caching != 0)
+        {
+          std::string name = FindRandomLossModel (caching->GetModel ());
+          if (!name.empty ())
+            {
+              return name;
+            }
+        }
+    }
+  return "";
+}
+
 TypeId
 YansWifiChannel::GetTypeId (void)
 {
@@ -47,11 +91,18 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("MaxRange", "The distance beyond which the receivers do not see the transmissions at all, "
+                   "neither as frames nor as interference, in meters. Zero delivers every transmission "
+                   "to all the receivers of the channel.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_maxRange (0.0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -62,6 +113,14 @@ YansWifiChannel::~YansWifiChannel ()
   m_phyList.clear ();
 }
 
+void
+YansWifiChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_grid.Clear ();
+  Channel::DoDispose ();
+}
+
 void
 YansWifiChannel::SetPropagationLossModel (const Ptr<PropagationLossModel> loss)
 {
@@ -76,44 +135,153 @@ YansWifiChannel::SetPropagationDelayModel (const Ptr<PropagationDelayModel> dela
   m_delay = delay;
 }
 
+double
+YansWifiChannel::SetMaxRangeFromLossModel (double txPowerDbm, double rxSensitivityDbm)
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << rxSensitivityDbm);
+  NS_ASSERT (m_loss != 0);
+  // Probing a random model would draw from its random variables, and
+  // change the rest of the simulation.
+  std::string random = FindRandomLossModel (m_loss);
+  if (!random.empty ())
+    {
+      NS_LOG_WARN ("The loss of " << random << " is random, no maximum range");
+      m_maxRange = 0.0;
+      return m_maxRange;
+    }
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  double near = 0.0;
+  double far = 1.0;
+  b->SetPosition (Vector (far, 0.0, 0.0));
+  while (m_loss->CalcRxPower (txPowerDbm, a, b) >= rxSensitivityDbm)
+    {
+      if (far > 1e9)
+        {
+          NS_LOG_WARN ("The signal never falls below " << rxSensitivityDbm << "dBm, no maximum range");
+          m_maxRange = 0.0;
+          return m_maxRange;
+        }
+      near = far;
+      far *= 2;
+      b->SetPosition (Vector (far, 0.0, 0.0));
+    }
+  while (far - near > 0.01)
+    {
+      double middle = (near + far) / 2;
+      b->SetPosition (Vector (middle, 0.0, 0.0));
+      if (m_loss->CalcRxPower (txPowerDbm, a, b) >= rxSensitivityDbm)
+        {
+          near = middle;
+        }
+      else
+        {
+          far = middle;
+        }
+    }
+  NS_LOG_DEBUG ("maximum range " << far << "m");
+  m_maxRange = far;
+  return m_maxRange;
+}
+
 void
 YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm, Time duration) const
 {
   NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << duration.GetSeconds ());
   Ptr<MobilityModel> senderMobility = sender->GetMobility ();
   NS_ASSERT (senderMobility != 0);
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+  PhyList receivers;
+  if (m_maxRange == 0)
     {
-      if (sender != (*i))
+      for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
         {
-          //For now don't account for inter channel interference nor channel bonding
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
+          if (IsReceiver (sender, *i))
             {
-              continue;
+              receivers.push_back (*i);
             }
-
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<NetDevice> dstNetDevice = (*i)->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
-            {
-              dstNode = 0xffffffff;
-            }
-          else
+        }
+    }
+  else
+    {
+      UpdateGrid ();
+      std::vector<uint32_t> indices;
+      m_grid.Find (senderMobility->GetPosition (), m_maxRange, indices);
+      // The receivers come in the order of m_phyList, so that the receptions
+      // starting at the same time are scheduled in the same order as without
+      // the grid.
+      for (std::vector<uint32_t>::const_iterator i = indices.begin (); i != indices.end (); i++)
+        {
+          if (IsReceiver (sender, m_phyList[*i]))
             {
-              dstNode = dstNetDevice->GetNode ()->GetId ();
+              receivers.push_back (m_phyList[*i]);
             }
-
-          Simulator::ScheduleWithContext (dstNode,
-                                          delay, &YansWifiChannel::Receive,
-                                          (*i), copy, rxPowerDbm, duration);
         }
     }
+  if (receivers.empty ())
+    {
+      return;
+    }
+
+  // Each loss model of the chain handles all the receivers at once
+  std::vector<Ptr<MobilityModel> > receiverMobilities;
+  receiverMobilities.reserve (receivers.size ());
+  for (PhyList::const_iterator i = receivers.begin (); i != receivers.end (); i++)
+    {
+      receiverMobilities.push_back ((*i)->GetMobility ()->GetObject<MobilityModel> ());
+    }
+  std::vector<double> rxPowerDbm;
+  m_loss->CalcRxPowers (txPowerDbm, senderMobility, receiverMobilities, rxPowerDbm);
+  for (uint32_t i = 0; i < receivers.size (); i++)
+    {
+      Deliver (senderMobility, receivers[i], receiverMobilities[i], packet, txPowerDbm, rxPowerDbm[i], duration);
+    }
+}
+
+bool
+YansWifiChannel::IsReceiver (Ptr<YansWifiPhy> sender, Ptr<YansWifiPhy> receiver) const
+{
+  //For now don't account for inter channel interference nor channel bonding
+  return receiver != sender && receiver->GetChannelNumber () == sender->GetChannelNumber ();
+}
+
+void
+YansWifiChannel::Deliver (Ptr<MobilityModel> senderMobility, Ptr<YansWifiPhy> receiver,
+                          Ptr<MobilityModel> receiverMobility, Ptr<const Packet> packet,
+                          double txPowerDbm, double rxPowerDbm, Time duration) const
+{
+  Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+  Ptr<Packet> copy = packet->Copy ();
+  Ptr<NetDevice> dstNetDevice = receiver->GetDevice ();
+  uint32_t dstNode;
+  if (dstNetDevice == 0)
+    {
+      dstNode = 0xffffffff;
+    }
+  else
+    {
+      dstNode = dstNetDevice->GetNode ()->GetId ();
+    }
+
+  Simulator::ScheduleWithContext (dstNode,
+                                  delay, &YansWifiChannel::Receive,
+                                  receiver, copy, rxPowerDbm, duration);
+}
+
+void
+YansWifiChannel::UpdateGrid (void) const
+{
+  if (m_grid.GetCellSize () != m_maxRange)
+    {
+      m_grid.SetCellSize (m_maxRange);
+    }
+  while (m_grid.GetN () < m_phyList.size ())
+    {
+      Ptr<MobilityModel> mobility = m_phyList[m_grid.GetN ()]->GetMobility ();
+      NS_ASSERT_MSG (mobility != 0, "The PHYs of a channel with a MaxRange need a mobility model");
+      m_grid.Add (mobility);
+    }
 }
 
 void
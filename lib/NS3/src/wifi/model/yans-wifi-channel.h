@@ -22,11 +22,13 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include "ns3/channel.h"
+#include "ns3/spatial-grid.h"
 #include "yans-wifi-phy.h"
 
 namespace ns3 {
 
 class NetDevice;
+class MobilityModel;
 class PropagationLossModel;
 class PropagationDelayModel;
 
@@ -38,6 +40,16 @@ class PropagationDelayModel;
  * class and supports an ns3::PropagationLossModel and an 
  * ns3::PropagationDelayModel.  By default, no propagation models are set; 
  * it is the caller's responsibility to set them before using the channel.
+ *
+ * By default, every transmission is delivered to all the other PHYs of
+ * the channel, however weak the received signal.  When the MaxRange
+ * attribute is set, the receivers farther than this distance from the
+ * sender are skipped entirely: they neither receive the frame nor see
+ * it as interference.  The channel then keeps the PHYs in a
+ * ns3::SpatialGrid of MaxRange-wide cells, so that a transmission only
+ * visits the PHYs of the neighbouring cells and those which are moving.
+ * The range can be derived from the propagation loss model with
+ * SetMaxRangeFromLossModel.
  */
 class YansWifiChannel : public Channel
 {
@@ -70,6 +82,30 @@ public:
    * \param delay the new propagation delay model.
    */
   void SetPropagationDelayModel (const Ptr<PropagationDelayModel> delay);
+  /**
+   * Set the MaxRange attribute to the distance beyond which a signal
+   * transmitted at the given power is received below the given
+   * sensitivity, according to the propagation loss model.
+   *
+   * The distance is searched for by evaluating the loss model between
+   * two positions along the x axis, so this is only meaningful for loss
+   * models which are deterministic and decrease with distance (such as
+   * ns3::FriisPropagationLossModel or ns3::LogDistancePropagationLossModel).
+   * If the chain of loss models includes a random model, such as
+   * ns3::NakagamiPropagationLossModel, the range is left unbounded
+   * without evaluating the models, so that their random variables are
+   * not drawn from.  Lower the sensitivity to keep a margin for the
+   * receive gains.
+   *
+   * \param txPowerDbm the highest transmit power of the PHYs, including
+   *        their transmit gain, in dBm
+   * \param rxSensitivityDbm the lowest signal power of interest to the
+   *        receivers, in dBm, typically their energy detection threshold
+   * \return the new maximum range, in meters, or zero (no cutoff) if the
+   *         signal stays above the sensitivity at any distance or if the
+   *         loss is random
+   */
+  double SetMaxRangeFromLossModel (double txPowerDbm, double rxSensitivityDbm);
 
   /**
    * \param sender the phy object from which the packet is originating.
@@ -102,6 +138,35 @@ private:
    */
   typedef std::vector<Ptr<YansWifiPhy> > PhyList;
 
+  virtual void DoDispose (void);
+
+  /**
+   * \param sender the phy object from which the packet is originating
+   * \param receiver a phy object of the channel
+   * \return true unless the receiver is the sender or it is tuned to
+   *         another channel
+   */
+  bool IsReceiver (Ptr<YansWifiPhy> sender, Ptr<YansWifiPhy> receiver) const;
+  /**
+   * Deliver a transmission to one receiver.
+   *
+   * \param senderMobility the mobility model of the sender
+   * \param receiver the receiver
+   * \param receiverMobility the mobility model of the receiver
+   * \param packet the packet to send
+   * \param txPowerDbm the tx power associated to the packet, in dBm
+   * \param rxPowerDbm the rx power of the packet at the receiver, in dBm
+   * \param duration the transmission duration associated with the packet
+   */
+  void Deliver (Ptr<MobilityModel> senderMobility, Ptr<YansWifiPhy> receiver,
+                Ptr<MobilityModel> receiverMobility, Ptr<const Packet> packet,
+                double txPowerDbm, double rxPowerDbm, Time duration) const;
+  /**
+   * Add the PHYs added to the channel since the last call to the grid,
+   * and rebuild the grid if MaxRange has changed.
+   */
+  void UpdateGrid (void) const;
+
   /**
    * This method is scheduled by Send for each associated YansWifiPhy.
    * The method then calls the corresponding YansWifiPhy that the first
@@ -117,6 +182,9 @@ private:
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+  double m_maxRange;                   //!< Distance beyond which the receivers are skipped, zero for none
+
+  mutable SpatialGrid m_grid;          //!< Positions of the first PHYs of m_phyList, by index
 };
 
 } //namespace ns3
@@ -21,6 +21,8 @@
 #include <cmath>
 #include "ns3/test.h"
 #include "ns3/nist-error-rate-model.h"
+#include "ns3/yans-error-rate-model.h"
+#include "ns3/boolean.h"
 
 using namespace ns3;
 
@@ -289,6 +291,108 @@ WifiErrorRateModelsTestCaseNist::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (ps, 0.999, 0.001, "Not equal within tolerance");
 }
 
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Wifi Error Rate Models Test Case Tabulated
+ *
+ * Checks the interpolated chunk success rates against the analytic ones,
+ * for every modulation and code rate, at a dense sample of SNR values
+ * off the grid of the tables.
+ */
+class WifiErrorRateModelsTestCaseTabulated : public TestCase
+{
+public:
+  WifiErrorRateModelsTestCaseTabulated ();
+  virtual ~WifiErrorRateModelsTestCaseTabulated ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Compare the tabulated and analytic chunk success rates of a model
+   *
+   * \param analytic the model computing the analytic success rates
+   * \param tabulated the same model with tabulated success rates
+   * \param modeName the name of the mode
+   */
+  void CheckMode (Ptr<ErrorRateModel> analytic, Ptr<ErrorRateModel> tabulated, std::string modeName);
+};
+
+WifiErrorRateModelsTestCaseTabulated::WifiErrorRateModelsTestCaseTabulated ()
+  : TestCase ("WifiErrorRateModel test case tabulated")
+{
+}
+
+WifiErrorRateModelsTestCaseTabulated::~WifiErrorRateModelsTestCaseTabulated ()
+{
+}
+
+void
+WifiErrorRateModelsTestCaseTabulated::CheckMode (Ptr<ErrorRateModel> analytic, Ptr<ErrorRateModel> tabulated, std::string modeName)
+{
+  WifiMode mode (modeName);
+  WifiTxVector txVector;
+  txVector.SetMode (mode);
+  if (mode.GetModulationClass () == WIFI_MOD_CLASS_VHT || mode.GetModulationClass () == WIFI_MOD_CLASS_HE)
+    {
+      // VHT MCS 9 is not allowed at 20 MHz
+      txVector.SetChannelWidth (40);
+    }
+  uint64_t chunkSizes[] = {1, 24, 200, 2000 * 8, 65535 * 8};
+  double maxError = 0;
+  double maxErrorSnr = 0;
+  // Seven points in every 0.02 dB interval of the grid, none of them on
+  // the grid, from 5 dB below to 5 dB above the tables
+  for (uint32_t j = 0; j < 4500 * 7; j++)
+    {
+      double snr = -25.0 + (j + 0.5) * 0.02 / 7;
+      for (uint32_t i = 0; i < sizeof (chunkSizes) / sizeof (chunkSizes[0]); i++)
+        {
+          double expected = analytic->GetChunkSuccessRate (mode, txVector, std::pow (10.0, snr / 10.0), chunkSizes[i]);
+          double actual = tabulated->GetTabulatedChunkSuccessRate (mode, txVector, std::pow (10.0, snr / 10.0), chunkSizes[i]);
+          if (std::abs (actual - expected) > maxError)
+            {
+              maxError = std::abs (actual - expected);
+              maxErrorSnr = snr;
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_LT (maxError, 1e-4, "Tabulated success rate too far from the analytic one for " << modeName << " at " << maxErrorSnr << " dB");
+}
+
+void
+WifiErrorRateModelsTestCaseTabulated::DoRun (void)
+{
+  const char *modes[] = {
+    "DsssRate1Mbps", "DsssRate2Mbps", "DsssRate5_5Mbps", "DsssRate11Mbps",
+    "OfdmRate6Mbps", "OfdmRate9Mbps", "OfdmRate12Mbps", "OfdmRate18Mbps",
+    "OfdmRate24Mbps", "OfdmRate36Mbps", "OfdmRate48Mbps", "OfdmRate54Mbps",
+    "HtMcs5", "VhtMcs8", "VhtMcs9", "HeMcs10", "HeMcs11"
+  };
+
+  Ptr<ErrorRateModel> nist = CreateObject<NistErrorRateModel> ();
+  Ptr<ErrorRateModel> tabulatedNist = CreateObject<NistErrorRateModel> ();
+  tabulatedNist->SetAttribute ("Tabulated", BooleanValue (true));
+  Ptr<ErrorRateModel> yans = CreateObject<YansErrorRateModel> ();
+  Ptr<ErrorRateModel> tabulatedYans = CreateObject<YansErrorRateModel> ();
+  tabulatedYans->SetAttribute ("Tabulated", BooleanValue (true));
+  NS_TEST_EXPECT_MSG_EQ (nist->IsTabulated (), false, "Tabulated by default");
+  NS_TEST_EXPECT_MSG_EQ (tabulatedNist->IsTabulated (), true, "Tabulated attribute ignored");
+  for (uint32_t i = 0; i < sizeof (modes) / sizeof (modes[0]); i++)
+    {
+      CheckMode (nist, tabulatedNist, modes[i]);
+      CheckMode (yans, tabulatedYans, modes[i]);
+    }
+
+  // A perfect chunk stays perfect
+  WifiTxVector txVector;
+  txVector.SetMode (WifiMode ("OfdmRate54Mbps"));
+  NS_TEST_EXPECT_MSG_EQ (tabulatedNist->GetTabulatedChunkSuccessRate (txVector.GetMode (), txVector, 1e5, 12000), 1.0,
+                         "Success rate of a perfect chunk not equal to 1");
+}
+
 /**
  * \ingroup wifi-test
  * \ingroup tests
@@ -306,6 +410,7 @@ WifiErrorRateModelsTestSuite::WifiErrorRateModelsTestSuite ()
 {
   AddTestCase (new WifiErrorRateModelsTestCaseDsss, TestCase::QUICK);
   AddTestCase (new WifiErrorRateModelsTestCaseNist, TestCase::QUICK);
+  AddTestCase (new WifiErrorRateModelsTestCaseTabulated, TestCase::QUICK);
 }
 
 static WifiErrorRateModelsTestSuite wifiErrorRateModelsTestSuite; ///< the test suite
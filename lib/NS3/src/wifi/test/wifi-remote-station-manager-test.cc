@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/constant-rate-wifi-manager.h"
+#include "ns3/wifi-mac-header.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Remote station lookup and removal of idle stations
+ */
+class WifiRemoteStationManagerTestCase : public TestCase
+{
+public:
+  WifiRemoteStationManagerTestCase ();
+  virtual ~WifiRemoteStationManagerTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Create a remote station manager
+   * \param stationTimeout the StationTimeout attribute
+   * \return the remote station manager
+   */
+  Ptr<WifiRemoteStationManager> CreateManager (Time stationTimeout);
+  /**
+   * Get the address of a remote station
+   * \param i the index of the station
+   * \return the address of the station
+   */
+  static Mac48Address GetAddress (uint32_t i);
+  /**
+   * Get a QoS data header
+   * \param tid the TID
+   * \return the header
+   */
+  static WifiMacHeader GetHeader (uint8_t tid);
+  /**
+   * Check the state of the stations after the timeout
+   * \param manager the remote station manager
+   */
+  void CheckIdleStations (Ptr<WifiRemoteStationManager> manager);
+  /**
+   * Use a station before the timeout
+   * \param manager the remote station manager
+   * \param address the address of the station
+   */
+  void UseStation (Ptr<WifiRemoteStationManager> manager, Mac48Address address);
+};
+
+WifiRemoteStationManagerTestCase::WifiRemoteStationManagerTestCase ()
+  : TestCase ("WifiRemoteStationManager lookups and idle stations")
+{
+}
+
+WifiRemoteStationManagerTestCase::~WifiRemoteStationManagerTestCase ()
+{
+}
+
+Ptr<WifiRemoteStationManager>
+WifiRemoteStationManagerTestCase::CreateManager (Time stationTimeout)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  Ptr<WifiRemoteStationManager> manager = CreateObject<ConstantRateWifiManager> ();
+  manager->SetAttribute ("MaxSlrc", UintegerValue (2));
+  manager->SetAttribute ("StationTimeout", TimeValue (stationTimeout));
+  manager->SetupPhy (phy);
+  return manager;
+}
+
+Mac48Address
+WifiRemoteStationManagerTestCase::GetAddress (uint32_t i)
+{
+  uint8_t buffer[6] = {0, 0, 0, 0, static_cast<uint8_t> (i >> 8), static_cast<uint8_t> (i & 0xff)};
+  Mac48Address address;
+  address.CopyFrom (buffer);
+  return address;
+}
+
+WifiMacHeader
+WifiRemoteStationManagerTestCase::GetHeader (uint8_t tid)
+{
+  WifiMacHeader header;
+  header.SetType (WIFI_MAC_QOSDATA);
+  header.SetQosTid (tid);
+  return header;
+}
+
+void
+WifiRemoteStationManagerTestCase::UseStation (Ptr<WifiRemoteStationManager> manager, Mac48Address address)
+{
+  NS_TEST_EXPECT_MSG_EQ (manager->IsAssociated (address), true, "Station lost before the timeout");
+}
+
+void
+WifiRemoteStationManagerTestCase::CheckIdleStations (Ptr<WifiRemoteStationManager> manager)
+{
+  // A new station triggers the removal of the idle ones
+  NS_TEST_EXPECT_MSG_EQ (manager->IsBrandNew (GetAddress (1000)), true, "New station not brand new");
+  NS_TEST_EXPECT_MSG_EQ (manager->IsAssociated (GetAddress (1)), true, "Used station removed");
+  NS_TEST_EXPECT_MSG_EQ (manager->IsBrandNew (GetAddress (2)), true, "Idle station not removed");
+  WifiMacHeader header = GetHeader (1);
+  Ptr<Packet> packet = Create<Packet> (100);
+  NS_TEST_EXPECT_MSG_EQ (manager->NeedDataRetransmission (GetAddress (2), &header, packet), true,
+                         "Retry count of an idle station not reset");
+}
+
+void
+WifiRemoteStationManagerTestCase::DoRun (void)
+{
+  // Many stations, each with several TIDs, without timeout
+  Ptr<WifiRemoteStationManager> manager = CreateManager (Seconds (0));
+  Ptr<Packet> packet = Create<Packet> (100);
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (manager->IsBrandNew (GetAddress (i)), true, "New station not brand new");
+      if (i % 2 == 0)
+        {
+          manager->RecordGotAssocTxOk (GetAddress (i));
+        }
+      for (uint8_t tid = 0; tid < 3; tid++)
+        {
+          WifiMacHeader header = GetHeader (tid);
+          for (uint8_t j = 0; j < tid; j++)
+            {
+              manager->ReportDataFailed (GetAddress (i), &header);
+            }
+        }
+    }
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (manager->IsAssociated (GetAddress (i)), (i % 2 == 0), "Wrong station state");
+      for (uint8_t tid = 0; tid < 3; tid++)
+        {
+          // MaxSlrc is 2: only TID 2 failed twice
+          WifiMacHeader header = GetHeader (tid);
+          NS_TEST_EXPECT_MSG_EQ (manager->NeedDataRetransmission (GetAddress (i), &header, packet), (tid < 2),
+                                 "Wrong station for address " << GetAddress (i) << " and TID " << +tid);
+        }
+    }
+  // A negative timeout would remove the stations in use
+  NS_TEST_EXPECT_MSG_EQ (manager->SetAttributeFailSafe ("StationTimeout", TimeValue (Seconds (-1))), false,
+                         "Negative station timeout accepted");
+  manager->Dispose ();
+
+  // Stations neither heard from nor sent to are removed after the timeout
+  manager = CreateManager (Seconds (1));
+  for (uint32_t i = 1; i <= 2; i++)
+    {
+      manager->RecordGotAssocTxOk (GetAddress (i));
+      WifiMacHeader header = GetHeader (1);
+      manager->ReportDataFailed (GetAddress (i), &header);
+      manager->ReportDataFailed (GetAddress (i), &header);
+    }
+  Simulator::Schedule (Seconds (0.5), &WifiRemoteStationManagerTestCase::UseStation, this, manager, GetAddress (2));
+  Simulator::Schedule (Seconds (1.5), &WifiRemoteStationManagerTestCase::UseStation, this, manager, GetAddress (1));
+  Simulator::Schedule (Seconds (2), &WifiRemoteStationManagerTestCase::CheckIdleStations, this, manager);
+  Simulator::Run ();
+  manager->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Remote station manager TestSuite
+ */
+class WifiRemoteStationManagerTestSuite : public TestSuite
+{
+public:
+  WifiRemoteStationManagerTestSuite ();
+};
+
+WifiRemoteStationManagerTestSuite::WifiRemoteStationManagerTestSuite ()
+  : TestSuite ("wifi-remote-station-manager", UNIT)
+{
+  AddTestCase (new WifiRemoteStationManagerTestCase, TestCase::QUICK);
+}
+
+static WifiRemoteStationManagerTestSuite g_wifiRemoteStationManagerTestSuite; ///< the test suite
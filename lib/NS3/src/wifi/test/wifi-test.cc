@@ -42,6 +42,9 @@
 #include "ns3/multi-model-spectrum-channel.h"
 #include "ns3/wifi-spectrum-signal-parameters.h"
 #include "ns3/wifi-phy-tag.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/wifi-mac-trailer.h"
+#include <algorithm>
 #include <tuple>
 #include <vector>
 
@@ -1514,6 +1517,207 @@ Bug2831TestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_countOperationalChannelWidth40, 20, "Incorrect operational channel width after channel change");
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Propagation loss model recording the receivers it is evaluated for
+ */
+class RecordingPropagationLossModel : public PropagationLossModel
+{
+public:
+  std::vector<Ptr<MobilityModel> > m_receivers; ///< receivers since the last clear
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    const_cast<RecordingPropagationLossModel *> (this)->m_receivers.push_back (b);
+    return txPowerDbm - 200;
+  }
+  virtual int64_t DoAssignStreams (int64_t stream)
+  {
+    return 0;
+  }
+};
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Make sure that a YansWifiChannel with a MaxRange delivers the
+ * transmissions to the receivers in range only, as they move.
+ */
+class YansWifiChannelMaxRangeTest : public TestCase
+{
+public:
+  YansWifiChannelMaxRangeTest ();
+
+  virtual void DoRun (void);
+
+
+private:
+  /**
+   * Create one PHY on the channel
+   * \param mobility the mobility model of the PHY
+   * \returns the PHY
+   */
+  Ptr<YansWifiPhy> CreatePhy (Ptr<MobilityModel> mobility);
+  /**
+   * Send a frame from the first PHY and check which PHYs it is delivered to
+   * \param expected the indices of the PHYs expected to receive the frame
+   */
+  void SendAndCheck (std::vector<uint32_t> expected);
+  /**
+   * Set the maximum range of the channel
+   * \param range the range, in meters
+   */
+  void SetMaxRange (double range);
+
+  Ptr<YansWifiChannel> m_channel; ///< the channel
+  Ptr<RecordingPropagationLossModel> m_loss; ///< the loss model
+  std::vector<Ptr<YansWifiPhy> > m_phys; ///< the PHYs
+};
+
+YansWifiChannelMaxRangeTest::YansWifiChannelMaxRangeTest ()
+  : TestCase ("YansWifiChannel maximum range")
+{
+}
+
+Ptr<YansWifiPhy>
+YansWifiChannelMaxRangeTest::CreatePhy (Ptr<MobilityModel> mobility)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+  phy->SetChannel (m_channel);
+  phy->SetMobility (mobility);
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  m_phys.push_back (phy);
+  return phy;
+}
+
+void
+YansWifiChannelMaxRangeTest::SendAndCheck (std::vector<uint32_t> expected)
+{
+  WifiTxVector txVector = WifiTxVector (WifiPhy::GetOfdmRate6Mbps (), 0, WIFI_PREAMBLE_LONG, false, 1, 1, 0, 20, false, false);
+  Ptr<Packet> packet = Create<Packet> (1000);
+  packet->AddPacketTag (WifiPhyTag (txVector, NORMAL_MPDU, 1));
+
+  m_loss->m_receivers.clear ();
+  m_channel->Send (m_phys[0], packet, 16.0, MicroSeconds (100));
+  NS_TEST_EXPECT_MSG_EQ (m_loss->m_receivers.size (), expected.size (), "Wrong number of receivers at " << Simulator::Now ());
+  for (std::vector<uint32_t>::const_iterator i = expected.begin (); i != expected.end (); i++)
+    {
+      Ptr<MobilityModel> mobility = m_phys[*i]->GetMobility ();
+      NS_TEST_EXPECT_MSG_EQ ((std::find (m_loss->m_receivers.begin (), m_loss->m_receivers.end (), mobility) != m_loss->m_receivers.end ()),
+                             true, "PHY " << *i << " missed the frame at " << Simulator::Now ());
+    }
+}
+
+void
+YansWifiChannelMaxRangeTest::SetMaxRange (double range)
+{
+  m_channel->SetAttribute ("MaxRange", DoubleValue (range));
+}
+
+void
+YansWifiChannelMaxRangeTest::DoRun (void)
+{
+  m_channel = CreateObject<YansWifiChannel> ();
+  m_loss = CreateObject<RecordingPropagationLossModel> ();
+  m_channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  m_channel->SetPropagationLossModel (m_loss);
+
+  Vector positions[] = {
+    Vector (0.0, 0.0, 0.0),
+    Vector (50.0, 0.0, 0.0),
+    Vector (0.0, -99.0, 0.0),
+    Vector (60.0, 0.0, 90.0),
+    Vector (250.0, 0.0, 0.0)
+  };
+  std::vector<Ptr<ConstantPositionMobilityModel> > mobilities;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      mobilities.push_back (CreateObject<ConstantPositionMobilityModel> ());
+      mobilities.back ()->SetPosition (positions[i]);
+      CreatePhy (mobilities.back ());
+    }
+  // Moving towards the sender, without any course change, from 400 m at 100 m/s.
+  Ptr<ConstantVelocityMobilityModel> moving = CreateObject<ConstantVelocityMobilityModel> ();
+  moving->SetPosition (Vector (400.0, 0.0, 0.0));
+  moving->SetVelocity (Vector (-100.0, 0.0, 0.0));
+  CreatePhy (moving);
+
+  std::vector<uint32_t> all;
+  for (uint32_t i = 1; i < m_phys.size (); i++)
+    {
+      all.push_back (i);
+    }
+  Simulator::Schedule (Seconds (0.5), &YansWifiChannelMaxRangeTest::SendAndCheck, this, all);
+
+  std::vector<uint32_t> inRange;
+  inRange.push_back (1);
+  inRange.push_back (2);
+  Simulator::Schedule (Seconds (1.0), &YansWifiChannelMaxRangeTest::SetMaxRange, this, 100.0);
+  Simulator::Schedule (Seconds (1.0), &YansWifiChannelMaxRangeTest::SendAndCheck, this, inRange);
+
+  Simulator::Schedule (Seconds (2.0), &ConstantPositionMobilityModel::SetPosition, mobilities[4],
+                       Vector (-30.0, 10.0, 0.0));
+  inRange.push_back (4);
+  Simulator::Schedule (Seconds (2.5), &YansWifiChannelMaxRangeTest::SendAndCheck, this, inRange);
+
+  inRange.push_back (5);
+  Simulator::Schedule (Seconds (3.5), &YansWifiChannelMaxRangeTest::SendAndCheck, this, inRange);
+
+  // Stop moving 10 m past the sender: the PHY is back in the grid.
+  Simulator::Schedule (Seconds (4.1), &ConstantVelocityMobilityModel::SetVelocity, moving,
+                       Vector (0.0, 0.0, 0.0));
+  Simulator::Schedule (Seconds (5.0), &YansWifiChannelMaxRangeTest::SendAndCheck, this, inRange);
+
+  // A smaller range rebuilds the grid.
+  inRange.clear ();
+  inRange.push_back (4);
+  inRange.push_back (5);
+  Simulator::Schedule (Seconds (6.0), &YansWifiChannelMaxRangeTest::SetMaxRange, this, 40.0);
+  Simulator::Schedule (Seconds (6.0), &YansWifiChannelMaxRangeTest::SendAndCheck, this, inRange);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // 46.6777 dB at 1 m, then 30 dB per decade, down from 16 dBm to -96 dBm.
+  Ptr<LogDistancePropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  m_channel->SetPropagationLossModel (logDistance);
+  double range = m_channel->SetMaxRangeFromLossModel (16.0, -96.0);
+  NS_TEST_EXPECT_MSG_EQ_TOL (range, std::pow (10.0, (112.0 - 46.6777) / 30), 0.01, "Wrong range for the log distance model");
+  DoubleValue maxRange;
+  m_channel->GetAttribute ("MaxRange", maxRange);
+  NS_TEST_EXPECT_MSG_EQ (maxRange.Get (), range, "MaxRange not set");
+
+  // A random model leaves the range unbounded, and its random variables
+  // draw the same values as those of an identical model left untouched.
+  Ptr<NakagamiPropagationLossModel> nakagami = CreateObject<NakagamiPropagationLossModel> ();
+  Ptr<NakagamiPropagationLossModel> reference = CreateObject<NakagamiPropagationLossModel> ();
+  logDistance->SetNext (nakagami);
+  nakagami->AssignStreams (10);
+  reference->AssignStreams (10);
+  range = m_channel->SetMaxRangeFromLossModel (16.0, -96.0);
+  NS_TEST_EXPECT_MSG_EQ (range, 0.0, "No range expected for a random model");
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  b->SetPosition (Vector (30.0, 0.0, 0.0));
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (nakagami->CalcRxPower (16.0, a, b), reference->CalcRxPower (16.0, a, b),
+                             "The random variables were drawn from");
+    }
+
+  m_phys.clear ();
+  m_channel->Dispose ();
+  m_channel = 0;
+  m_loss = 0;
+}
+
+//-----------------------------------------------------------------------------
 /**
  * \ingroup wifi-test
  * \ingroup tests
@@ -1538,6 +1742,7 @@ WifiTestSuite::WifiTestSuite ()
   AddTestCase (new Bug2222TestCase, TestCase::QUICK); //Bug 2222
   AddTestCase (new Bug2483TestCase, TestCase::QUICK); //Bug 2483
   AddTestCase (new Bug2831TestCase, TestCase::QUICK); //Bug 2831
+  AddTestCase (new YansWifiChannelMaxRangeTest, TestCase::QUICK);
 }
 
 static WifiTestSuite g_wifiTestSuite; ///< the test suite
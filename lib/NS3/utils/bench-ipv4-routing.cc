@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the unicast route lookups of
+// Ipv4StaticRouting and Ipv4GlobalRouting against the size of the routing
+// table, with the prefix index and with a scan of the whole table.
+// Sample usage:  ./waf --run 'bench-ipv4-routing --n=100000 --max-routes=10000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-route.h"
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Fill a routing table with random routes to the subnets of 10.0.0.0/8.
+ * \param routing the routing protocol, either static or global
+ * \param rand the random variable
+ * \param n the number of routes
+ * \param scan whether to add a route whose mask is not a prefix, so that
+ *        lookups scan the whole table
+ */
+template <typename T>
+static void
+fillTable (Ptr<T> routing, Ptr<UniformRandomVariable> rand, uint32_t n, bool scan)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ipv4Address network (0x0a000000 | rand->GetInteger (0, 0xffffff));
+      Ipv4Mask mask (0xffffffff << (32 - rand->GetInteger (16, 32)));
+      routing->AddNetworkRouteTo (network, mask, Ipv4Address ("172.16.0.2"), 1);
+    }
+  if (scan)
+    {
+      routing->AddNetworkRouteTo (Ipv4Address ("11.0.0.0"), Ipv4Mask ("255.0.255.0"), Ipv4Address ("172.16.0.2"), 1);
+    }
+}
+
+/**
+ * Look up the routes to a set of destinations.
+ * \param routing the routing protocol
+ * \param destinations the destinations
+ * \param n the number of lookups
+ * \return the elapsed time, in milliseconds
+ */
+template <typename T>
+static uint64_t
+runLookups (Ptr<T> routing, const std::vector<Ipv4Address> &destinations, uint32_t n)
+{
+  Ipv4Header header;
+  Socket::SocketErrno sockerr;
+  uint32_t found = 0;
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      header.SetDestination (destinations[i % destinations.size ()]);
+      if (routing->RouteOutput (0, header, 0, sockerr) != 0)
+        {
+          found++;
+        }
+    }
+  uint64_t deltaMs = time.End ();
+  // Keep the lookups from being optimized away.
+  if (found > n)
+    {
+      std::cout << found << std::endl;
+    }
+  return std::max<uint64_t> (deltaMs, 1);
+}
+
+/**
+ * Benchmark one routing protocol with one table size.
+ * \param routing the routing protocol, with an empty table
+ * \param nRoutes the number of routes
+ * \param scan whether lookups scan the whole table
+ * \param n the number of lookups
+ * \param minIterations the number of iterations to minimize the time over
+ * \param name the name of the benchmark
+ */
+template <typename T>
+static void
+runBench (Ptr<T> routing, uint32_t nRoutes, bool scan, uint32_t n, uint32_t minIterations, char const *name)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+  fillTable (routing, rand, nRoutes, scan);
+  std::vector<Ipv4Address> destinations;
+  for (uint32_t i = 0; i < 4096; i++)
+    {
+      destinations.push_back (Ipv4Address (0x0a000000 | rand->GetInteger (0, 0xffffff)));
+    }
+
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      minDelay = std::min (minDelay, runLookups (routing, destinations, n));
+    }
+  double ps = n;
+  ps *= 1000;
+  ps /= minDelay;
+  std::cout << ps << " lookups/s"
+            << " (" << minDelay << " ms elapsed)\t"
+            << name << ", " << nRoutes << " routes"
+            << (scan ? ", scanned" : ", indexed")
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 100000;
+  uint32_t minIterations = 1;
+  uint32_t maxRoutes = 10000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark IPv4 unicast route lookups");
+  cmd.AddValue ("n", "number of lookups", n);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.AddValue ("max-routes", "largest routing table, starting from 10 routes and growing tenfold", maxRoutes);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of lookups must be specified " <<
+        "(e.g. bench-ipv4-routing --n=100000)" << std::endl;
+      exit (1);
+    }
+
+  // The routes go through the only interface of a node.
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("172.16.0.0", "255.255.255.0");
+  ipv4.Assign (devHelper.Install (node));
+  Ptr<Ipv4> ip = node->GetObject<Ipv4> ();
+
+  for (uint32_t nRoutes = 10; nRoutes <= maxRoutes; nRoutes *= 10)
+    {
+      for (uint32_t scan = 0; scan < 2; scan++)
+        {
+          Ptr<Ipv4StaticRouting> staticRouting = CreateObject<Ipv4StaticRouting> ();
+          staticRouting->SetIpv4 (ip);
+          runBench (staticRouting, nRoutes, scan, n, minIterations, "Ipv4StaticRouting");
+          staticRouting->Dispose ();
+
+          Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting> ();
+          globalRouting->SetIpv4 (ip);
+          runBench (globalRouting, nRoutes, scan, n, minIterations, "Ipv4GlobalRouting");
+          globalRouting->Dispose ();
+        }
+    }
+
+  return 0;
+}
@@ -26,12 +26,14 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/buffer.h"
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <stdlib.h> // for exit ()
 #include <limits>
 #include <algorithm>
+#include <vector>
 
 using namespace ns3;
 
@@ -339,9 +341,47 @@ runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 }
 
 
+/**
+ * Print the buffer data allocations since the last reset.
+ * \param perClass print the statistics of each size class
+ */
+static void
+printAllocationStats (bool perClass)
+{
+  std::vector<Buffer::AllocationStats> stats = Buffer::GetAllocationStats ();
+  Buffer::AllocationStats total = Buffer::AllocationStats ();
+  for (std::vector<Buffer::AllocationStats>::const_iterator i = stats.begin (); i != stats.end (); i++)
+    {
+      if (perClass && i->allocations > 0)
+        {
+          std::cout << "\t  ";
+          if (i->size)
+            {
+              std::cout << i->size << " bytes: ";
+            }
+          else
+            {
+              std::cout << "larger: ";
+            }
+          std::cout << i->allocations << " allocations, " << i->hits << " recycled, "
+                    << i->arena << " from arena, " << i->freed << " freed, "
+                    << i->cached << " cached" << std::endl;
+        }
+      total.allocations += i->allocations;
+      total.hits += i->hits;
+      total.arena += i->arena;
+      total.freed += i->freed;
+    }
+  std::cout << "\tbuffer data: " << total.allocations << " allocations, "
+            << total.hits << " recycled, " << total.arena << " from arena, "
+            << total.allocations - total.hits - total.arena << " from the heap, "
+            << total.freed << " freed" << std::endl;
+}
+
 static void
 runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
 {
+  Buffer::ResetAllocationStats ();
   uint64_t minDelay = std::numeric_limits<uint64_t>::max();
   for (uint32_t i = 0; i < minIterations; i++)
     {
@@ -362,12 +402,18 @@ int main (int argc, char *argv[])
   uint32_t n = 0;
   uint32_t minIterations = 1;
   bool enablePrinting = false;
+  bool lazyPrinting = false;
+  bool arena = false;
+  bool allocationStats = false;
 
   CommandLine cmd;
   cmd.Usage ("Benchmark Packet class");
   cmd.AddValue ("n", "number of iterations", n);
   cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
   cmd.AddValue ("enable-printing", "enable packet printing", enablePrinting);
+  cmd.AddValue ("lazy-printing", "record the packet printing metadata lazily", lazyPrinting);
+  cmd.AddValue ("arena", "carve the buffer data from an arena", arena);
+  cmd.AddValue ("allocation-stats", "print the buffer data allocations of each size class", allocationStats);
   cmd.Parse (argc, argv);
 
   if (n == 0)
@@ -378,13 +424,28 @@ int main (int argc, char *argv[])
     }
   std::cout << "Running bench-packets with n=" << n << std::endl;
   std::cout << "All tests begin by adding UDP and IPv4 headers." << std::endl;
+  Buffer::EnableArena (arena);
+  if (lazyPrinting)
+    {
+      Packet::EnableLazyPrinting ();
+    }
+  else if (enablePrinting)
+    {
+      Packet::EnablePrinting ();
+    }
 
   runBench (&benchA, n, minIterations, "Copy packet, remove headers");
+  printAllocationStats (allocationStats);
   runBench (&benchB, n, minIterations, "Just add headers");
+  printAllocationStats (allocationStats);
   runBench (&benchC, n, minIterations, "Remove by func call");
+  printAllocationStats (allocationStats);
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
+  printAllocationStats (allocationStats);
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
+  printAllocationStats (allocationStats);
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  printAllocationStats (allocationStats);
 
   return 0;
 }
@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
@@ -82,8 +83,11 @@ public:
     m_total = total;
   }
 
-  /// Run function
-  void RunBench (void);
+  /**
+   * Run function
+   * \return the simulation rate, in events per second
+   */
+  double RunBench (void);
 private:
   /// callback function
   void Cb (void);
@@ -94,7 +98,7 @@ private:
   uint32_t m_count; ///< count 
 };
 
-void
+double
 Bench::RunBench (void)
 {
   SystemWallClockMs time;
@@ -128,6 +132,7 @@ Bench::RunBench (void)
        std::setw (g_fwidth) << (m_count / simu) <<
        std::setw (g_fwidth) << (simu / m_count));
 
+  return m_count / simu;
 }
 
 void
@@ -146,12 +151,31 @@ Bench::Cb (void)
 
 
 Ptr<RandomVariableStream>
-GetRandomStream (std::string filename)
+GetRandomStream (std::string filename, std::string dist)
 {
   Ptr<RandomVariableStream> stream = 0;
 
-  if (filename == "")
+  if (filename == "" && dist == "uniform")
     {
+      LOGME ("using uniform distribution");
+      Ptr<UniformRandomVariable> urv = CreateObject<UniformRandomVariable> ();
+      urv->SetAttribute ("Min", DoubleValue (0));
+      urv->SetAttribute ("Max", DoubleValue (200));
+      stream = urv;
+    }
+  else if (filename == "" && dist == "burst")
+    {
+      LOGME ("using bursty, long tail distribution");
+      Ptr<EmpiricalRandomVariable> erv = CreateObject<EmpiricalRandomVariable> ();
+      erv->CDF (0, 0.0);
+      erv->CDF (1000, 0.9);
+      erv->CDF (1e6, 0.99);
+      erv->CDF (1e9, 1.0);
+      stream = erv;
+    }
+  else if (filename == "")
+    {
+      NS_ABORT_MSG_UNLESS (dist == "exp", "unknown distribution " << dist);
       LOGME ("using default exponential distribution");
       Ptr<ExponentialRandomVariable> erv = CreateObject<ExponentialRandomVariable> ();
       erv->SetAttribute ("Mean", DoubleValue (100));
@@ -200,30 +224,143 @@ GetRandomStream (std::string filename)
 
 
 
+/// Print the header of the table of runs
+void
+PrintHeader (void)
+{
+  LOG ("");
+  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
+       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
+       std::left << std::setw (3 * g_fwidth) << "Simulation:");
+  LOG (std::left << std::setw (g_fwidth) << "" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+  LOG (std::setfill ('-') <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::setfill (' ')
+       );
+}
+
+/**
+ * Run every scheduler with every distribution, and print the best
+ * simulation rate of each combination.
+ * \param pop the event population size
+ * \param total the total number of events to run
+ * \param runs the number of runs of each combination
+ * \return the process exit code
+ */
+int
+RunAll (uint32_t pop, uint32_t total, uint32_t runs)
+{
+  // ListScheduler is left out: it is quadratic in the population.
+  std::string schedulers[] = {
+    "ns3::MapScheduler",
+    "ns3::HeapScheduler",
+    "ns3::CalendarScheduler",
+    "ns3::LadderScheduler"
+  };
+  std::string dists[] = { "exp", "uniform", "burst" };
+  const uint32_t nSchedulers = sizeof (schedulers) / sizeof (schedulers[0]);
+  const uint32_t nDists = sizeof (dists) / sizeof (dists[0]);
+  double rates[nDists][nSchedulers];
+
+  LOGME (std::setprecision (g_fwidth - 6));
+  LOGME ("population: " << pop);
+  LOGME ("total events: " << total);
+  LOGME ("runs: " << runs);
+
+  for (uint32_t d = 0; d < nDists; ++d)
+    {
+      for (uint32_t s = 0; s < nSchedulers; ++s)
+        {
+          LOG ("");
+          LOGME ("scheduler: " << schedulers[s]);
+          Simulator::SetScheduler (ObjectFactory (schedulers[s]));
+          Bench bench (pop, total);
+          bench.SetRandomStream (GetRandomStream ("", dists[d]));
+          PrintHeader ();
+          std::cout << std::left << std::setw (g_fwidth) << "(prime)";
+          bench.RunBench ();
+          rates[d][s] = 0;
+          for (uint32_t i = 0; i < runs; i++)
+            {
+              std::cout << std::setw (g_fwidth) << i;
+              rates[d][s] = std::max (rates[d][s], bench.RunBench ());
+            }
+          Simulator::Destroy ();
+        }
+    }
+
+  // summary table, in events per second
+  LOG ("");
+  LOGME ("best simulation rates (ev/s):");
+  // wide enough for the scheduler names
+  int width = std::max (g_fwidth, 20);
+  std::cout << std::left << std::setw (g_fwidth) << "";
+  for (uint32_t s = 0; s < nSchedulers; ++s)
+    {
+      // strip the "ns3::" prefix
+      std::cout << std::left << std::setw (width) << schedulers[s].substr (5);
+    }
+  std::cout << std::endl;
+  for (uint32_t d = 0; d < nDists; ++d)
+    {
+      std::cout << std::left << std::setw (g_fwidth) << dists[d];
+      for (uint32_t s = 0; s < nSchedulers; ++s)
+        {
+          std::cout << std::left << std::setw (width) << rates[d][s];
+        }
+      std::cout << std::endl;
+    }
+  return 0;
+}
+
+
 int main (int argc, char *argv[])
 {
 
   bool schedCal  = false;
   bool schedHeap = false;
+  bool schedLadder = false;
   bool schedList = false;
   bool schedMap  = true;
+  bool all = false;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
   uint32_t runs  =       1;
   std::string filename = "";
+  std::string dist = "exp";
 
   CommandLine cmd;
   cmd.Usage ("Benchmark the simulator scheduler.\n"
              "\n"
              "Event intervals are taken from one of:\n"
-             "  an exponential distribution, with mean 100 ns,\n"
+             "  an exponential distribution, with mean 100 ns (--dist=exp),\n"
+             "  a uniform distribution on [0, 200] ns (--dist=uniform),\n"
+             "  a bursty, long tail distribution (--dist=burst): 90% of the\n"
+             "    intervals below 1 us, 9% below 1 ms, the rest up to 1 s,\n"
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "\n"
+             "With --all, every scheduler except ListScheduler is run\n"
+             "with every distribution, and the simulation rates are\n"
+             "summarized in a final table.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
@@ -231,11 +368,18 @@ int main (int argc, char *argv[])
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
   cmd.AddValue ("file",  "file of relative event times",  filename);
+  cmd.AddValue ("dist",  "event interval distribution: exp, uniform or burst", dist);
+  cmd.AddValue ("all",   "compare all the schedulers and distributions", all);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
   cmd.Parse (argc, argv);
   g_me = cmd.GetName () + ": ";
   g_fwidth += 6;  // 5 extra chars in '2.000002e+07 ': . e+0 _
 
+  if (all)
+    {
+      return RunAll (pop, total, runs);
+    }
+
   ObjectFactory factory ("ns3::MapScheduler");
   if (schedCal)
     {
@@ -245,6 +389,10 @@ int main (int argc, char *argv[])
     {
       factory.SetTypeId ("ns3::HeapScheduler");
     }
+  if (schedLadder)
+    {
+      factory.SetTypeId ("ns3::LadderScheduler");
+    }
   if (schedList)
     {
       factory.SetTypeId ("ns3::ListScheduler");
@@ -260,30 +408,10 @@ int main (int argc, char *argv[])
   LOGME ("runs: " << runs);
 
   Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
+  bench->SetRandomStream (GetRandomStream (filename, dist));
 
   // table header
-  LOG ("");
-  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
-       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
-  LOG (std::left << std::setw (g_fwidth) << "" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
-  LOG (std::setfill ('-') <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::setfill (' ')
-       );
+  PrintHeader ();
 
   // prime
   DEB ("priming");